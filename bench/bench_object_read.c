@@ -0,0 +1,205 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief: Microbenchmark for object_read, compares the single pass reader with
+ *         the legacy reader which inflates the header prefix, then inflates the
+ *         whole object again and copies the content out of the scratch buffer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <object/object.h>
+#include <object/repository.h>
+#include <object/cache.h>
+#include <util/error.h>
+#include <util/files.h>
+#include <global/config.h>
+
+#define HEADER_MAX_SIZE         OBJECT_HEADER_MAX_SIZE
+// total bytes read by each benchmark case
+#define BENCH_TOTAL_BYTES       (256ULL * 1024 * 1024)
+
+/**
+ * @brief: The legacy object reader kept as the baseline of the benchmark
+ * @param obj: The object to store the result
+ * @param oid: The id of the object
+ */
+static void legacy_object_read(struct object * obj, const struct object_id * oid){
+    char sha1[OBJECT_ID_HEX_SIZE + 1];
+    oid_to_hex(sha1, oid);
+
+    char _file_buffer[PATH_MAX];
+    memset(_file_buffer, 0, PATH_MAX);
+    if (getcwd(_file_buffer, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+    size_t _length = strlen(_file_buffer);
+    snprintf(_file_buffer + _length, PATH_MAX - _length, "/.gitlet/objects/%.2s/%.38s", sha1, sha1 + 2);
+
+    FILE * _file = fopen(_file_buffer, "rb");
+    if (_file == NULL){
+        gitlet_panic("Failed to open object file: %s", _file_buffer);
+    }
+
+    // inflate the compressed prefix to parse the header
+    size_t _compressed_size = file_size(_file);
+    size_t _prefix_size = _compressed_size < HEADER_MAX_SIZE ? _compressed_size : HEADER_MAX_SIZE;
+    char _prefix[HEADER_MAX_SIZE];
+    char _header[HEADER_MAX_SIZE * 2];
+    memset(_header, 0, sizeof(_header));
+    if (fread(_prefix, 1, _prefix_size, _file) != _prefix_size){
+        gitlet_panic("Failed to read object header: %s", _file_buffer);
+    }
+    uLongf _header_size = sizeof(_header);
+    uncompress((Bytef *)_header, &_header_size, (Bytef *)_prefix, _prefix_size);
+
+    char * _size_ptr = strchr(_header, ' ');
+    if (_size_ptr == NULL){
+        gitlet_panic("Invalid object header: %s", sha1);
+    }
+    obj->type = OBJECT_TYPE_BLOB;
+    obj->file_size = strtoull(_size_ptr + 1, NULL, 10);
+
+    // read and inflate the whole object again from the beginning
+    char * _compressed = (char *)malloc(_compressed_size);
+    size_t _scratch_size = HEADER_MAX_SIZE + obj->file_size + 1;
+    char * _scratch = (char *)malloc(_scratch_size);
+    if (_compressed == NULL || _scratch == NULL){
+        gitlet_panic("Failed to allocate memory for the legacy reader");
+    }
+    fseek(_file, 0, SEEK_SET);
+    if (fread(_compressed, 1, _compressed_size, _file) != _compressed_size){
+        gitlet_panic("Failed to read object content: %s", _file_buffer);
+    }
+    uLongf _inflated_size = _scratch_size;
+    if (uncompress((Bytef *)_scratch, &_inflated_size, (Bytef *)_compressed, _compressed_size) != Z_OK){
+        gitlet_panic("Failed to decompress the object: %s", sha1);
+    }
+
+    // copy the content out of the scratch buffer
+    char * _content = (char *)memchr(_scratch, '\0', HEADER_MAX_SIZE) + 1;
+    obj->content = (unsigned char *)malloc(obj->file_size + 1);
+    if (obj->content == NULL){
+        gitlet_panic("Failed to allocate memory for object content");
+    }
+    memcpy(obj->content, _content, obj->file_size);
+    obj->content[obj->file_size] = '\0';
+
+    free(_compressed);
+    free(_scratch);
+    fclose(_file);
+}
+
+/**
+ * @brief: Get the current monotonic time in seconds
+ */
+static double now_seconds(void){
+    struct timespec _time;
+    clock_gettime(CLOCK_MONOTONIC, &_time);
+    return (double)_time.tv_sec + (double)_time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief: Write a blob with the given size and some redundancy into the repository
+ * @param oid: The object id to store the id of the blob
+ * @param size: The size of the blob
+ */
+static void write_blob(struct object_id * oid, size_t size){
+    static const char * words[] = {"gitlet ", "object ", "stream ", "inflate ", "buffer\n", "tree "};
+    FILE * _file = fopen("blob.tmp", "wb");
+    if (_file == NULL){
+        gitlet_panic("Failed to create the benchmark blob");
+    }
+    unsigned int _seed = (unsigned int)size;
+    for (size_t _written = 0; _written < size; ){
+        const char * _word = words[rand_r(&_seed) % 6];
+        size_t _length = strlen(_word);
+        if (_length > size - _written){
+            _length = size - _written;
+        }
+        fwrite(_word, 1, _length, _file);
+        _written += _length;
+    }
+    fclose(_file);
+    object_write(oid, "blob.tmp", true);
+    remove_file("blob.tmp");
+}
+
+/**
+ * @brief: Release the object read by the legacy reader
+ */
+static void legacy_object_release(struct object * obj){
+    free(obj->content);
+}
+
+/**
+ * @brief: Time the reader over the object and return the throughput in MB/s
+ */
+static double bench_reader(void (*reader)(struct object *, const struct object_id *), void (*release)(struct object *),
+    const struct object_id * oid, size_t size, size_t iterations){
+    double _start = now_seconds();
+    for (size_t i = 0; i < iterations; i++){
+        struct object _obj;
+        reader(&_obj, oid);
+        release(&_obj);
+    }
+    double _elapsed = now_seconds() - _start;
+    return (double)size * (double)iterations / _elapsed / (1024.0 * 1024.0);
+}
+
+int main(void){
+    char _repo_path[] = "/tmp/gitlet-bench-XXXXXX";
+    if (mkdtemp(_repo_path) == NULL || chdir(_repo_path) != 0){
+        gitlet_panic("Failed to create the benchmark repository");
+    }
+    repository_create(_repo_path);
+
+    const size_t sizes[] = {1024, 16 * 1024, 256 * 1024, 4 * 1024 * 1024, 32 * 1024 * 1024};
+
+    printf("%12s %10s %14s %16s %9s %14s\n", "size", "iterations", "legacy MB/s", "object_read MB/s", "speedup", "cached MB/s");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+        struct object_id _oid;
+        write_blob(&_oid, sizes[i]);
+
+        size_t _iterations = (size_t)(BENCH_TOTAL_BYTES / sizes[i]);
+        double _legacy = bench_reader(legacy_object_read, legacy_object_release, &_oid, sizes[i], _iterations);
+        // the disk path is measured with the object cache disabled
+        object_cache_set_budget(0);
+        double _current = bench_reader(object_read, object_release, &_oid, sizes[i], _iterations);
+        object_cache_set_budget(OBJECT_CACHE_DEFAULT_BUDGET);
+        double _cached = bench_reader(object_read, object_release, &_oid, sizes[i], _iterations);
+        printf("%12zu %10zu %14.1f %16.1f %8.2fx %14.1f\n", sizes[i], _iterations, _legacy, _current, 
+            _current / _legacy, _cached);
+    }
+
+    char _command[PATH_MAX + 16];
+    snprintf(_command, sizeof(_command), "rm -rf %s", _repo_path);
+    return system(_command) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
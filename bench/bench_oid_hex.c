@@ -0,0 +1,123 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @brief: Benchmark of the object id hex conversion, the table-driven 
+ *         oid_to_hex and oid_from_hex against the sprintf and sscanf loops.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <object/oid.h>
+#include <util/error.h>
+
+// number of the object ids converted by each case
+#define BENCH_OID_COUNT         (1000 * 1000)
+
+/**
+ * @brief: Get the monotonic time in seconds
+ */
+static double now_seconds(void){
+    struct timespec _time;
+    clock_gettime(CLOCK_MONOTONIC, &_time);
+    return (double)_time.tv_sec + (double)_time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief: The sprintf encoder kept as the baseline of the benchmark
+ */
+static void legacy_to_hex(char * buffer, const struct object_id * oid){
+    for (size_t i = 0; i < OBJECT_ID_RAW_SIZE; i++){
+        sprintf(buffer + i * 2, "%02x", oid->hash[i]);
+    }
+}
+
+/**
+ * @brief: The sscanf decoder kept as the baseline of the benchmark
+ */
+static bool legacy_from_hex(struct object_id * oid, const char * hex){
+    for (size_t i = 0; i < OBJECT_ID_RAW_SIZE; i++){
+        unsigned int _byte = 0;
+        if (sscanf(hex + i * 2, "%2x", &_byte) != 1){
+            return false;
+        }
+        oid->hash[i] = (unsigned char)_byte;
+    }
+    return true;
+}
+
+int main(void){
+    struct object_id * _oids = (struct object_id *)malloc(BENCH_OID_COUNT * sizeof(struct object_id));
+    char * _hex = (char *)malloc((size_t)BENCH_OID_COUNT * (OBJECT_ID_HEX_SIZE + 1));
+    if (_oids == NULL || _hex == NULL){
+        gitlet_panic("Failed to allocate memory for the benchmark");
+    }
+    unsigned int _seed = 1;
+    for (size_t i = 0; i < BENCH_OID_COUNT; i++){
+        for (size_t j = 0; j < OBJECT_ID_RAW_SIZE; j++){
+            _oids[i].hash[j] = (unsigned char)rand_r(&_seed);
+        }
+    }
+
+    double _start = now_seconds();
+    for (size_t i = 0; i < BENCH_OID_COUNT; i++){
+        legacy_to_hex(_hex + i * (OBJECT_ID_HEX_SIZE + 1), &_oids[i]);
+    }
+    double _legacy_encode = now_seconds() - _start;
+
+    _start = now_seconds();
+    for (size_t i = 0; i < BENCH_OID_COUNT; i++){
+        oid_to_hex(_hex + i * (OBJECT_ID_HEX_SIZE + 1), &_oids[i]);
+    }
+    double _encode = now_seconds() - _start;
+
+    struct object_id _oid;
+    _start = now_seconds();
+    for (size_t i = 0; i < BENCH_OID_COUNT; i++){
+        if (!legacy_from_hex(&_oid, _hex + i * (OBJECT_ID_HEX_SIZE + 1)) || !oid_equals(&_oid, &_oids[i])){
+            gitlet_panic("Legacy decode mismatch");
+        }
+    }
+    double _legacy_decode = now_seconds() - _start;
+
+    _start = now_seconds();
+    for (size_t i = 0; i < BENCH_OID_COUNT; i++){
+        if (!oid_from_hex(&_oid, _hex + i * (OBJECT_ID_HEX_SIZE + 1)) || !oid_equals(&_oid, &_oids[i])){
+            gitlet_panic("Decode mismatch");
+        }
+    }
+    double _decode = now_seconds() - _start;
+
+    printf("%8s %14s %14s %9s\n", "case", "legacy ns/id", "oid ns/id", "speedup");
+    printf("%8s %14.1f %14.1f %8.2fx\n", "encode", _legacy_encode * 1e9 / BENCH_OID_COUNT, 
+        _encode * 1e9 / BENCH_OID_COUNT, _legacy_encode / _encode);
+    printf("%8s %14.1f %14.1f %8.2fx\n", "decode", _legacy_decode * 1e9 / BENCH_OID_COUNT, 
+        _decode * 1e9 / BENCH_OID_COUNT, _legacy_decode / _decode);
+
+    free(_oids);
+    free(_hex);
+    return EXIT_SUCCESS;
+}
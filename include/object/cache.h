@@ -0,0 +1,120 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_CACHE_H
+#define GITLET_OBJECT_CACHE_H
+
+/**
+ * @brief: This header provide the in-process cache of the object contents,
+ *         keyed by the object id and bounded by a byte budget with 
+ *         the least recently used objects evicted first.
+ * @note: The content of the object is reference counted and shared between 
+ *        the cache and every reader, so the content must be treated as read 
+ *        only and given back with object_release.
+ * @note: The cache is guarded by a lock and the reference counts are atomic,
+ *        so the readers on the worker threads may share it.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <object/object.h>
+
+// the byte budget of the cache when core.objectCacheSize is not set
+#define OBJECT_CACHE_DEFAULT_BUDGET     (32 * 1024 * 1024)
+
+/**
+ * @brief: The counters of the object cache
+ * @param hits: The number of the lookups served from the cache
+ * @param misses: The number of the lookups not found in the cache
+ * @param evictions: The number of the objects evicted to stay in the budget
+ * @param entries: The number of the objects in the cache
+ * @param bytes: The total size of the object contents in the cache
+ * @param budget: The byte budget of the cache
+ */
+struct object_cache_stats{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t entries;
+    uint64_t bytes;
+    uint64_t budget;
+};
+
+/**
+ * @brief: Set the byte budget of the cache, the objects over the budget are
+ *         evicted right away, 0 disables the cache.
+ * @param budget: The byte budget
+ * @note: Without this call the budget is read from core.objectCacheSize on the first use.
+ */
+extern void object_cache_set_budget(uint64_t budget);
+
+/**
+ * @brief: Get the counters of the object cache
+ * @param stats: The pointer to store the counters
+ */
+extern void object_cache_get_stats(struct object_cache_stats * stats);
+
+/**
+ * @brief: Look up the object in the cache
+ * @param obj: The object to store the result, the content holds a new reference
+ * @param oid: The id of the object
+ * @return: true if the object is in the cache, false otherwise
+ */
+extern bool object_cache_get(struct object * obj, const struct object_id * oid);
+
+/**
+ * @brief: Put the object into the cache, the cache takes its own reference 
+ *         of the content, objects larger than the budget are not cached.
+ * @param oid: The id of the object
+ * @param obj: The object with the content from object_content_alloc
+ */
+extern void object_cache_put(const struct object_id * oid, const struct object * obj);
+
+/**
+ * @brief: Drop all the objects from the cache, the contents still referenced 
+ *         by the readers stay valid until they are released.
+ */
+extern void object_cache_clear(void);
+
+/**
+ * @brief: Allocate the reference counted content with one reference
+ * @param size: The size of the content, one extra byte is allocated for the null terminator
+ * @return: The content
+ */
+extern unsigned char * object_content_alloc(uint64_t size);
+
+/**
+ * @brief: Take a new reference of the content
+ * @param content: The content from object_content_alloc
+ */
+extern void object_content_retain(unsigned char * content);
+
+/**
+ * @brief: Drop a reference of the content, the content is freed with the last reference
+ * @param content: The content from object_content_alloc, can be NULL
+ */
+extern void object_content_release(unsigned char * content);
+
+#endif // GITLET_OBJECT_CACHE_H
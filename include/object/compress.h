@@ -0,0 +1,80 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_COMPRESS_H
+#define GITLET_OBJECT_COMPRESS_H
+
+/**
+ * @brief: This header provide the compression policy of the objects, which
+ *         picks the zlib level of every loose object and pack entry from 
+ *         the config, the size of the object and a probe of its first block.
+ * @note: The policy is read from the config once per process, read it on the
+ *        main thread before the objects are compressed on other threads.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// the leading bytes of the object compressed to probe whether it is compressible
+#define COMPRESS_PROBE_SIZE             (64 * 1024)
+// the probed block is incompressible when it shrinks to no less than this percentage
+#define COMPRESS_PROBE_RATIO            95
+
+/**
+ * @brief: The compression policy of the objects
+ * @param loose_level: The zlib level of the loose objects, from core.looseCompression 
+ *                     and then core.compression
+ * @param pack_level: The zlib level of the pack entries, from pack.compression 
+ *                    and then core.compression
+ * @param store_threshold: The objects larger than it are stored without compression, 
+ *                         from core.storeThreshold, 0 to disable
+ * @param probe: Whether to store the objects whose first block is incompressible, 
+ *               from core.compressionProbe
+ */
+struct compress_policy{
+    int loose_level;
+    int pack_level;
+    uint64_t store_threshold;
+    bool probe;
+};
+
+/**
+ * @brief: Get the compression policy of the gitlet repository
+ * @return: The compression policy
+ */
+extern const struct compress_policy * compress_policy_get(void);
+
+/**
+ * @brief: Pick the zlib level to compress the object with
+ * @param level: The level of the policy for the kind of the object
+ * @param size: The size of the object
+ * @param block: The leading bytes of the object, can be NULL when not available
+ * @param block_size: The size of the leading bytes
+ * @return: The zlib level, Z_NO_COMPRESSION when the object is stored
+ * @note: Only the objects larger than COMPRESS_PROBE_SIZE are probed, the 
+ *        smaller objects cost about the same to compress as to probe.
+ */
+extern int compress_choose_level(int level, uint64_t size, const unsigned char * block, size_t block_size);
+
+#endif // GITLET_OBJECT_COMPRESS_H
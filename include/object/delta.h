@@ -0,0 +1,94 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_DELTA_H
+#define GITLET_OBJECT_DELTA_H
+
+/**
+ * @brief: This header provide the copy/insert delta encoding used inside
+ *         the packs, the encoding follows the git pack delta format.
+ *         A delta starts with the size of the base and the size of the result,
+ *         then a list of instructions which either copy a range of the base
+ *         or insert the literal bytes that follow the instruction.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief: The index of the blocks of the base object, built once for a base 
+ *         and reused to create the deltas of many targets against it.
+ */
+struct delta_index;
+
+/**
+ * @brief: Create the index of the base object
+ * @param base: The content of the base object, must outlive the index
+ * @param base_size: The size of the base object
+ * @return: The index of the base object
+ */
+extern struct delta_index * delta_index_create(const unsigned char * base, size_t base_size);
+
+/**
+ * @brief: Release the index of the base object
+ * @param index: The index to be released
+ */
+extern void delta_index_free(struct delta_index * index);
+
+/**
+ * @brief: Create the delta which rebuilds the target from the indexed base
+ * @param index: The index of the base object
+ * @param target: The content of the target object
+ * @param target_size: The size of the target object
+ * @param max_delta_size: The delta is dropped once it grows past this size
+ * @param delta_size: The pointer to store the size of the delta
+ * @return: The delta allocated with malloc, NULL if the delta is not smaller than max_delta_size
+ */
+extern unsigned char * delta_create(const struct delta_index * index, const unsigned char * target, 
+    size_t target_size, size_t max_delta_size, size_t * delta_size);
+
+/**
+ * @brief: Apply the delta to the base object
+ * @param base: The content of the base object
+ * @param base_size: The size of the base object
+ * @param delta: The delta
+ * @param delta_size: The size of the delta
+ * @param result_size: The pointer to store the size of the result
+ * @return: The result allocated with malloc, with an extra null terminator after the content
+ */
+extern unsigned char * delta_apply(const unsigned char * base, size_t base_size, 
+    const unsigned char * delta, size_t delta_size, size_t * result_size);
+
+/**
+ * @brief: Parse the size of the base and the result from the delta header
+ * @param delta: The delta
+ * @param delta_size: The number of the available bytes of the delta
+ * @param base_size: The pointer to store the size of the base
+ * @param result_size: The pointer to store the size of the result
+ * @return: true if the header is complete, false otherwise
+ */
+extern bool delta_header(const unsigned char * delta, size_t delta_size, 
+    uint64_t * base_size, uint64_t * result_size);
+
+#endif // GITLET_OBJECT_DELTA_H
@@ -0,0 +1,111 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_FSMONITOR_H
+#define GITLET_OBJECT_FSMONITOR_H
+
+/**
+ * @brief: This header provide the client of the fsmonitor daemon, which 
+ *         watches the working tree and tells the paths changed since a token.
+ * @note: The daemon listens on a unix socket in the repository. A request is
+ *        one line, "query <token>" or "quit". The reply to a query is the new
+ *        token on the first line, then the line "full" when the old token is
+ *        stale or unknown, or the line "dirty" followed by the changed paths, 
+ *        every one ending with NUL. A changed directory stands for everything
+ *        under it. The client closes its side after the request, the daemon
+ *        closes its side after the reply.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <object/index.h>
+
+// the socket of the daemon relative to the working tree, short enough for sun_path
+#define FSMONITOR_SOCKET_PATH       ".gitlet/fsmonitor.sock"
+// the log of the daemon started in the background, relative to the working tree
+#define FSMONITOR_LOG_PATH          ".gitlet/fsmonitor.log"
+// the longest token of the daemon, including the null terminator
+#define FSMONITOR_TOKEN_MAX         128
+
+#define FSMONITOR_REQUEST_QUERY     "query"
+#define FSMONITOR_REQUEST_QUIT      "quit"
+#define FSMONITOR_REPLY_FULL        "full"
+#define FSMONITOR_REPLY_DIRTY       "dirty"
+
+/**
+ * @brief: The paths changed since the token, from the reply of the daemon
+ * @param token: The token the next query starts from
+ * @param full: Whether the old token is stale, so every path may have changed
+ * @param paths: The changed paths relative to the working tree, sorted
+ * @param count: The number of the paths
+ * @note: The fields start with '_' are private to the fsmonitor module.
+ */
+struct fsmonitor_changes{
+    char token[FSMONITOR_TOKEN_MAX];
+    bool full;
+    char ** paths;
+    size_t count;
+
+    char * _reply;
+};
+
+/**
+ * @brief: Check whether the fsmonitor is enabled by the core.fsmonitor config
+ */
+extern bool fsmonitor_enabled(void);
+
+/**
+ * @brief: Ask the daemon of the repository in the current working directory 
+ *         for the paths changed since the token
+ * @param token: The token from the last query, NULL for the first query
+ * @param changes: The changes to store the reply
+ * @return: true if the daemon replied, false if it is not running
+ */
+extern bool fsmonitor_query(const char * token, struct fsmonitor_changes * changes);
+
+/**
+ * @brief: Ask the daemon of the repository in the current working directory to exit
+ * @return: true if the daemon is stopped, false if it is not running
+ */
+extern bool fsmonitor_stop(void);
+
+/**
+ * @brief: Release the changes from fsmonitor_query
+ * @param changes: The changes
+ */
+extern void fsmonitor_changes_release(struct fsmonitor_changes * changes);
+
+/**
+ * @brief: Bring the fsmonitor state of the index up to date, the entries under
+ *         the changed paths are no longer valid, and the index gets the new token.
+ * @param index: The index
+ * @return: true if the daemon replied, so the entries still valid need no lstat
+ *          and the entries found clean from now on can be marked valid
+ * @note: When the fsmonitor is disabled or the daemon is not running, every
+ *        entry is invalidated and the token is dropped, every path is then
+ *        checked like without the fsmonitor.
+ */
+extern bool fsmonitor_refresh_index(struct index * index);
+
+#endif // GITLET_OBJECT_FSMONITOR_H
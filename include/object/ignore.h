@@ -0,0 +1,163 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_IGNORE_H
+#define GITLET_OBJECT_IGNORE_H
+
+/**
+ * @brief: This header provide the ignore rules of the working tree, read from
+ *         .gitlet/info/exclude and the .gitletignore file of every directory
+ *         in the syntax of gitignore: '#' comments, '!' negations, a trailing
+ *         '/' for the directories only, and the patterns with a '/' anchored
+ *         to the directory of the file, where "**" matches any directories.
+ * @note: The rules of a deeper directory take precedence over the ones of
+ *        its parents, and within a file the last matching pattern wins. 
+ *        Nothing under an ignored directory is included again.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <object/oid.h>
+
+// the name of the file holding the ignore rules of its directory
+#define IGNORE_FILE_NAME            ".gitletignore"
+// the file of the ignore rules of the repository, not in the working tree
+#define IGNORE_EXCLUDE_PATH         ".gitlet/info/exclude"
+
+/**
+ * @brief: The pattern of an ignore rule
+ * @param pattern: The pattern without the '!', the leading and the trailing '/'
+ * @param line: The line number in the file, from 1
+ * @param negative: Whether the pattern starts with '!', a match is then not ignored
+ * @param directory_only: Whether the pattern ends with '/', matching only the directories
+ * @param anchored: Whether the pattern has a '/', it is matched against the path
+ *                  relative to the directory of the file, otherwise the name
+ * @param text: The line as written in the file, for check-ignore -v
+ */
+struct ignore_pattern{
+    const char * pattern;
+    size_t line;
+    bool negative;
+    bool directory_only;
+    bool anchored;
+    const char * text;
+};
+
+/**
+ * @brief: The ignore rules of one file, linked to the ones of the parent directory
+ * @param parent: The rules of the parent directory, NULL for the exclude file
+ * @param directory: The directory the patterns are relative to, "" for the top
+ * @param directory_length: The length of the directory
+ * @param source: The path of the file the rules are read from
+ * @param patterns: The patterns in the order of the file
+ * @param count: The number of the patterns
+ * @param oid: The blob id of the file content, all zero without the file
+ * @note: The fields start with '_' are private to the ignore module.
+ */
+struct ignore_rules{
+    const struct ignore_rules * parent;
+    char * directory;
+    size_t directory_length;
+    char * source;
+    struct ignore_pattern * patterns;
+    size_t count;
+    struct object_id oid;
+
+    char * _text;
+};
+
+/**
+ * @brief: The ignore rules of the whole working tree, the rules of every
+ *         directory are read once when a path under it is checked
+ * @note: The fields start with '_' are private to the ignore module. It is
+ *        not thread safe, the parallel scans link the ignore_rules themselves.
+ */
+struct ignore{
+    struct ignore_rules * exclude;
+    struct _ignore_directory * _root;
+};
+
+/**
+ * @brief: Read the rules of .gitlet/info/exclude, the root of every chain of rules
+ * @return: The rules allocated on the heap, without patterns if the file is missing
+ */
+extern struct ignore_rules * ignore_rules_load_exclude(void);
+
+/**
+ * @brief: Read the rules of the .gitletignore file of the directory
+ * @param parent: The rules of the parent directory, or of the exclude file for the top
+ * @param directory: The path of the directory relative to the working tree, "" for the top
+ * @param length: The length of the path
+ * @return: The rules allocated on the heap, without patterns if the file is missing
+ */
+extern struct ignore_rules * ignore_rules_load(const struct ignore_rules * parent, const char * directory, size_t length);
+
+/**
+ * @brief: Free the rules, but not the rules of the parent
+ * @param rules: The rules, NULL is ignored
+ */
+extern void ignore_rules_free(struct ignore_rules * rules);
+
+/**
+ * @brief: Check the path against the chain of the rules of its directory
+ * @param rules: The rules of the directory holding the path
+ * @param path: The null terminated path relative to the working tree
+ * @param length: The length of the path
+ * @param is_directory: Whether the path is a directory
+ * @param matched_rules: The pointer to store the rules of the deciding pattern, maybe NULL
+ * @param matched: The pointer to store the deciding pattern, NULL if none matches, maybe NULL
+ * @return: true if the path is ignored
+ * @note: The parent directories of the path are not checked, the walks do 
+ *        not go into an ignored directory in the first place.
+ */
+extern bool ignore_rules_match(const struct ignore_rules * rules, const char * path, size_t length, 
+    bool is_directory, const struct ignore_rules ** matched_rules, const struct ignore_pattern ** matched);
+
+/**
+ * @brief: Initialize the ignore rules of the working tree in the current working directory
+ * @param ignore: The ignore rules
+ */
+extern void ignore_init(struct ignore * ignore);
+
+/**
+ * @brief: Check whether the path is ignored, by the rules of its directory 
+ *         or because one of its parent directories is ignored
+ * @param ignore: The ignore rules
+ * @param path: The null terminated path relative to the working tree
+ * @param length: The length of the path
+ * @param is_directory: Whether the path is a directory
+ * @param matched_rules: The pointer to store the rules of the deciding pattern, maybe NULL
+ * @param matched: The pointer to store the deciding pattern, NULL if none matches, maybe NULL
+ * @return: true if the path is ignored
+ */
+extern bool ignore_is_excluded(struct ignore * ignore, const char * path, size_t length, bool is_directory, 
+    const struct ignore_rules ** matched_rules, const struct ignore_pattern ** matched);
+
+/**
+ * @brief: Release the ignore rules
+ * @param ignore: The ignore rules
+ */
+extern void ignore_release(struct ignore * ignore);
+
+#endif // GITLET_OBJECT_IGNORE_H
@@ -0,0 +1,341 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_INDEX_H
+#define GITLET_OBJECT_INDEX_H
+
+/**
+ * @brief: This header provide the index of the working tree, the binary file
+ *         .gitlet/index in the format of the git index version 2 or 4. Every entry
+ *         caches the stat data of the file along with its mode and object id,
+ *         so an unchanged file is detected by lstat alone without reading it.
+ * @note: A file modified in the same second the index is written keeps the
+ *        same mtime, so such a racily clean entry is only trusted after its
+ *        content is hashed again, like git.
+ * @note: With core.splitIndex the entries live in a shared index file,
+ *        .gitlet/sharedindex.<checksum>, and .gitlet/index only holds the
+ *        entries changed since then, so a write is in the size of the changes.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include <object/object.h>
+
+struct untracked_cache;
+
+// the signature at the beginning of the index file
+#define INDEX_SIGNATURE             "DIRC"
+// the version of the index file written, unless index.version says otherwise
+#define INDEX_VERSION               2
+/**
+ * The version of the index file with the prefix compressed paths, like git.
+ * An entry stores the number of the bytes to strip from the end of the path
+ * before it and the suffix to append, and it is not padded.
+ */
+#define INDEX_VERSION_COMPRESSED    4
+// the bits of the entry flags holding the length of the path
+#define INDEX_ENTRY_NAME_MASK       0x0fff
+
+/**
+ * The extension holding the fsmonitor token and the bitmap of the entries
+ * known clean as of it. It is not the FSMN extension of git, whose bitmap is
+ * EWAH compressed, and its upper case first letter makes git skip it.
+ */
+#define INDEX_EXTENSION_FSMONITOR   "FSMG"
+
+/**
+ * The extension holding the untracked cache, see object/untracked.h. It is
+ * not the UNTR extension of git either, git skips it like the one above.
+ */
+#define INDEX_EXTENSION_UNTRACKED   "UNTG"
+
+/**
+ * The extension linking the index to its shared index, the checksum of the
+ * shared index and the positions of its entries removed since. It is not the
+ * link extension of git, whose bitmaps are EWAH compressed, and its lower
+ * case first letter makes git refuse the index instead of misreading it.
+ */
+#define INDEX_EXTENSION_SPLIT       "lnkg"
+// the prefix of the name of the shared index file, followed by its checksum
+#define INDEX_SHARED_PREFIX         "sharedindex."
+// the percent of the entries changed since the shared index to write a new one
+#define INDEX_SPLIT_MAX_PERCENT     20
+
+// the modes of the entries, the same as the tree entries
+#define INDEX_MODE_FILE             0100644
+#define INDEX_MODE_EXECUTABLE       0100755
+#define INDEX_MODE_SYMLINK          0120000
+
+/**
+ * @brief: The entry of the index, one for every tracked file
+ * @param ctime_sec, ctime_nsec: The time the file status changed
+ * @param mtime_sec, mtime_nsec: The time the file content changed
+ * @param dev, ino: The device and the inode of the file
+ * @param mode: The mode of the entry, one of the INDEX_MODE_*
+ * @param uid, gid: The owner of the file
+ * @param size: The size of the file, truncated to 32 bits
+ * @param oid: The id of the blob of the file content
+ * @param flags: The flags stored in the file, the length of the path in the low bits
+ * @param uptodate: Whether the content was hashed by this process after the
+ *                  stat data was taken, it is never written to the file
+ * @param removed: Whether the entry is to be dropped by index_remove_marked,
+ *                 it is never written to the file
+ * @param fsmonitor_valid: Whether the file is known clean as of the fsmonitor
+ *                         token of the index, so it needs no lstat until the 
+ *                         fsmonitor reports it
+ * @param shared_position: The position of the entry of the same path in the
+ *                         shared index plus one, 0 if there is none, it is
+ *                         never written to the file
+ * @param path_length: The length of the path
+ * @param path: The path relative to the working tree, separated by '/'
+ */
+struct index_entry{
+    uint32_t ctime_sec;
+    uint32_t ctime_nsec;
+    uint32_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t dev;
+    uint32_t ino;
+    uint32_t mode;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t size;
+    struct object_id oid;
+    uint16_t flags;
+    bool uptodate;
+    bool removed;
+    bool fsmonitor_valid;
+    uint32_t shared_position;
+    size_t path_length;
+    char path[];
+};
+
+/**
+ * @brief: The index in memory, the entries are sorted by the bytes of the paths
+ * @param entries: The entries
+ * @param count: The number of the entries
+ * @param capacity: The capacity of the entries
+ * @param timestamp_sec, timestamp_nsec: The mtime of the index file when it
+ *        was read or written last, an entry modified at or after it is racy
+ * @param changed: Whether the entries differ from the index file
+ * @param fsmonitor_token: The fsmonitor token the valid entries are clean as of, 
+ *                         NULL without the fsmonitor, owned by the index
+ * @param untracked: The untracked cache, NULL without one, owned by the index
+ * @note: The fields start with '_' are private to the index module. The 
+ *        entries read from the file live in one block of memory, and so do
+ *        the ones read from the shared index. The shared index stays mapped
+ *        to tell the entries changed since it when the index is written.
+ */
+struct index{
+    struct index_entry ** entries;
+    size_t count;
+    size_t capacity;
+    uint32_t timestamp_sec;
+    uint32_t timestamp_nsec;
+    bool changed;
+    char * fsmonitor_token;
+    struct untracked_cache * untracked;
+
+    void * _arena;
+    size_t _arena_size;
+    void * _shared_arena;
+    size_t _shared_arena_size;
+    const unsigned char * _shared_map;
+    size_t _shared_map_size;
+    size_t * _shared_offsets;
+    size_t _shared_count;
+    struct object_id _shared_oid;
+};
+
+/**
+ * @brief: Read the index of the gitlet repository in the current working
+ *         directory, a missing index file is read as an empty index.
+ * @param index: The index to store the entries
+ * @note: A broken index file, or one with a bad checksum, is a fatal error.
+ */
+extern void index_read(struct index * index);
+
+/**
+ * @brief: Write the index to the gitlet repository through index.lock, the 
+ *         lock file is renamed over the index once it is complete.
+ * @param index: The index
+ * @note: It is a fatal error if another process holds index.lock.
+ * @note: The version of the file is index.version, 2 or 4, the default is 2.
+ * @note: With core.splitIndex only the entries changed since the shared index
+ *        are written, a new shared index is written once they are more than
+ *        splitIndex.maxPercentChange percent of the entries. The shared index
+ *        no longer linked is removed.
+ */
+extern void index_write(struct index * index);
+
+/**
+ * @brief: Write the index like index_write, but give up when it is locked
+ * @param index: The index
+ * @return: true if the index is written, false if index.lock already exists
+ * @note: Used to save the refreshed stat data, which is only an optimization.
+ */
+extern bool index_try_write(struct index * index);
+
+/**
+ * @brief: Set the fsmonitor token of the index, the index is marked as changed
+ *         when the token is different
+ * @param index: The index
+ * @param token: The token, NULL to drop the token
+ */
+extern void index_set_fsmonitor_token(struct index * index, const char * token);
+
+/**
+ * @brief: Release the entries of the index
+ * @param index: The index
+ */
+extern void index_release(struct index * index);
+
+/**
+ * @brief: Find the position of the path in the index by binary search
+ * @param index: The index
+ * @param path: The path
+ * @param length: The length of the path
+ * @param found: The pointer to store whether the entry exists
+ * @return: The position of the entry, or where it would be inserted
+ */
+extern size_t index_position(const struct index * index, const char * path, size_t length, bool * found);
+
+/**
+ * @brief: Find the entry of the path
+ * @param index: The index
+ * @param path: The null terminated path
+ * @return: The entry, NULL if the path is not in the index
+ */
+extern struct index_entry * index_find(const struct index * index, const char * path);
+
+/**
+ * @brief: Create the entry of the file, to be added with index_add_entry
+ * @param path: The path of the file relative to the working tree
+ * @param length: The length of the path
+ * @param oid: The id of the blob of the content
+ * @param status: The lstat result of the file
+ * @return: The entry allocated on the heap
+ * @note: The entry is up to date, the content is expected to be hashed after
+ *        the lstat which gives the stat data.
+ */
+extern struct index_entry * index_entry_create(const char * path, size_t length, 
+    const struct object_id * oid, const struct stat * status);
+
+/**
+ * @brief: Add the entry to the index, or replace the entry of the same path
+ * @param index: The index, which takes the ownership of the entry
+ * @param entry: The entry from index_entry_create
+ * @note: A new path invalidates the untracked cache along it, and so does
+ *        the removal of a path by index_remove_marked.
+ */
+extern void index_add_entry(struct index * index, struct index_entry * entry);
+
+/**
+ * @brief: Add the entries to the index in one merge, the entries replace the
+ *         ones of the same paths. Adding many entries one by one moves the
+ *         entries after each of them, this is linear in the size of the index.
+ * @param index: The index, which takes the ownership of the entries
+ * @param entries: The entries from index_entry_create, sorted by the paths without duplicates
+ * @param count: The number of the entries
+ */
+extern void index_add_entries(struct index * index, struct index_entry ** entries, size_t count);
+
+/**
+ * @brief: Drop the entries marked as removed, in one pass over the index
+ * @param index: The index
+ */
+extern void index_remove_marked(struct index * index);
+
+/**
+ * @brief: Get the mode of the entry for the file
+ * @param status: The lstat result of the file
+ * @return: The mode, 0 if the file is neither a regular file nor a symbolic link
+ */
+extern uint32_t index_mode_from_stat(const struct stat * status);
+
+/**
+ * @brief: Store the stat data of the file in the entry
+ * @param entry: The entry
+ * @param status: The lstat result of the file
+ */
+extern void index_entry_fill_stat(struct index_entry * entry, const struct stat * status);
+
+/**
+ * @brief: Check whether the stat data of the file is the one cached in the entry
+ * @param entry: The entry
+ * @param status: The lstat result of the file
+ * @return: true if nothing in the stat data changed
+ */
+extern bool index_entry_stat_matches(const struct index_entry * entry, const struct stat * status);
+
+/**
+ * @brief: Check whether the entry is racily clean, modified in the same second
+ *         as or after the index was written, so its stat data cannot be trusted
+ * @param index: The index
+ * @param entry: The entry
+ */
+extern bool index_entry_is_racy(const struct index * index, const struct index_entry * entry);
+
+/**
+ * @brief: Hash the file as a blob, the target of a symbolic link is hashed
+ *         instead of the file it points to.
+ * @param writer: The object writer, which writes the blob if it is set to write
+ * @param oid: The object id to store the result
+ * @param path: The path of the file
+ * @param status: The lstat result of the file
+ */
+extern void index_hash_path(struct object_writer * writer, struct object_id * oid, 
+    const char * path, const struct stat * status);
+
+/**
+ * @brief: The state of the file compared with its entry
+ * @param INDEX_ENTRY_CLEAN: The stat data of the entry tells the file is unchanged
+ * @param INDEX_ENTRY_REFRESHED: The content is hashed and unchanged, and the 
+ *                               entry got the new stat data of the file
+ * @param INDEX_ENTRY_MODIFIED: The content or the mode of the file changed
+ */
+enum index_entry_state{
+    INDEX_ENTRY_CLEAN,
+    INDEX_ENTRY_REFRESHED,
+    INDEX_ENTRY_MODIFIED,
+};
+
+/**
+ * @brief: Compare the file with the entry, the content is only hashed when 
+ *         the stat data changed but the size did not, or when the entry is racy.
+ * @param index: The index
+ * @param entry: The entry, which gets the new stat data when it is refreshed
+ * @param status: The lstat result of the file
+ * @param writer: The object writer to hash the content, which is not written
+ * @return: The state of the file
+ * @note: The index is only read, so the different entries can be checked on
+ *        the different threads with their own writers. The caller marks the
+ *        index as changed for a refreshed entry.
+ */
+extern enum index_entry_state index_entry_check(const struct index * index, struct index_entry * entry, 
+    const struct stat * status, struct object_writer * writer);
+
+#endif // GITLET_OBJECT_INDEX_H
@@ -31,6 +31,16 @@
  */
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+#include <zlib.h>
+#include <openssl/evp.h>
+
+#include <object/oid.h>
+
+// size of the header of the object, include the type, size and the null terminator
+#define OBJECT_HEADER_MAX_SIZE      128
 
 /**
  * @brief: The type of the object
@@ -61,20 +71,294 @@ struct object{
 };
 
 /**
- * @brief: Read the object from the gitlet repository
+ * @brief: The streaming reader of the object, the content is inflated chunk
+ *         by chunk so the object never needs to be materialized in memory.
+ * @param type: The type of the object
+ * @param file_size: The size of the object content
+ * @note: The fields start with '_' are private to the object module
+ */
+struct object_stream{
+    enum object_type type;
+    uint64_t file_size;
+
+    int _fd;
+    uint64_t _file_offset;
+    void * _map;
+    size_t _map_size;
+    z_stream _zstream;
+    unsigned char * _input_buffer;
+    size_t _input_size;
+    const unsigned char * _input_map;
+    size_t _input_map_size;
+    unsigned char * _content;
+    unsigned char _pending[OBJECT_HEADER_MAX_SIZE];
+    size_t _pending_offset;
+    size_t _pending_size;
+    uint64_t _total_read;
+    bool _finished;
+};
+
+/**
+ * @brief: Get the name of the object type used in the object header
+ * @param type: The type of the object
+ * @return: The name of the type, NULL for an unknown type
+ */
+extern const char * object_type_name(enum object_type type);
+
+/**
+ * @brief: Open the streaming reader of the object, the header of the object
+ *         is parsed and the type and size of the object are available after open.
+ * @param stream: The stream to be opened
+ * @param oid: The id of the object
+ */
+extern void object_stream_open(struct object_stream * stream, const struct object_id * oid);
+
+/**
+ * @brief: Read the next chunk of the object content
+ * @param stream: The opened stream
+ * @param buffer: The buffer to store the content
+ * @param size: The size of the buffer
+ * @return: The number of bytes read, 0 when the end of the content is reached
+ */
+extern size_t object_stream_read(struct object_stream * stream, void * buffer, size_t size);
+
+/**
+ * @brief: Close the streaming reader and release the resources
+ * @param stream: The stream to be closed
+ */
+extern void object_stream_close(struct object_stream * stream);
+
+/**
+ * @brief: Read only the header of the object, the type and the size of the
+ *         object are stored and the content is left as NULL.
+ * @param obj: The object to be store the result
+ * @param oid: The id of the object
+ */
+extern void object_read_header(struct object * obj, const struct object_id * oid);
+
+/**
+ * @brief: Check if the object exists in the gitlet repository
+ * @param oid: The id of the object
+ * @return: true if the object exists, false otherwise
+ */
+extern bool object_exists(const struct object_id * oid);
+
+/**
+ * @brief: The callback of the object enumeration
+ * @param oid: The id of the object
+ * @param data: The user data passed to the enumeration
+ */
+typedef void (*object_each_callback)(const struct object_id * oid, void * data);
+
+/**
+ * @brief: Call the callback for every loose object in the gitlet repository
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ */
+extern void object_for_each_loose(object_each_callback callback, void * data);
+
+/**
+ * @brief: List the ids of all the loose objects in the gitlet repository, the
+ *         256 fan-out directories are scanned in parallel.
+ * @param count: The pointer to store the number of the ids
+ * @param sorted: Whether to sort the ids, unsorted ids are grouped by the fan-out directory
+ * @return: The ids allocated with malloc
+ */
+extern struct object_id * object_list_loose(size_t * count, bool sorted);
+
+/**
+ * @brief: Delete the loose objects which are packed or no longer needed, along
+ *         with the temporary object files left behind by the writers, the 
+ *         256 fan-out directories are pruned in parallel.
+ * @param kept: The sorted ids of the objects to keep when they are not packed
+ * @param kept_count: The number of the kept ids
+ * @param expire: The other loose objects and temporary files last modified before it are deleted, 0 for none
+ * @return: The number of the loose objects deleted
+ * @note: A loose object found in a pack is always deleted, the pack holds it.
+ */
+extern size_t object_prune_loose(const struct object_id * kept, size_t kept_count, time_t expire);
+
+/**
+ * @brief: The result of the object name resolution
+ * @param OBJECT_NAME_FOUND: The name is a full id, or the prefix of exactly one object
+ * @param OBJECT_NAME_NOT_FOUND: The name is not a valid id, or no object starts with it
+ * @param OBJECT_NAME_AMBIGUOUS: More than one object starts with the name
+ */
+enum object_name_result{
+    OBJECT_NAME_FOUND,
+    OBJECT_NAME_NOT_FOUND,
+    OBJECT_NAME_AMBIGUOUS,
+};
+
+/**
+ * @brief: Resolve the full or abbreviated hex object id
+ * @param oid: The object id to store the result
+ * @param name: The hex id, at least OBJECT_ID_MIN_ABBREV characters
+ * @return: The result of the resolution
+ * @note: A full id is returned as is even if the object does not exist. A 
+ *        prefix is searched in the pack indexes and in the sorted ids of the 
+ *        matching fan-out directory only, both in O(log n).
+ */
+extern enum object_name_result object_resolve_name(struct object_id * oid, const char * name);
+
+/**
+ * @brief: Get the shortest prefix of the object id which names no other object
+ * @param buffer: The buffer to store the prefix, at least OBJECT_ID_HEX_SIZE + 1 bytes
+ * @param oid: The object id
+ * @param min_length: The shortest length of the prefix
+ * @return: The length of the prefix
+ */
+extern size_t object_abbreviate(char * buffer, const struct object_id * oid, size_t min_length);
+
+/**
+ * @brief: Call the callback for every object in the gitlet repository, both
+ *         the packed and the loose objects, and every object only once.
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ * @param sorted: Whether to report the objects in the order of the ids, otherwise
+ *                the packed objects are reported first in the order of the packs
+ */
+extern void object_for_each(object_each_callback callback, void * data, bool sorted);
+
+/**
+ * @brief: Read the object from the gitlet repository, the object cache is 
+ *         consulted first and the object read from disk is put into it.
  * @param obj: The object to be store the result
- * @param sha1: The sha1 of the object
+ * @param oid: The id of the object
+ * @note: The content is shared with the cache and must not be modified, 
+ *        give it back with object_release instead of free.
+ * @note: Safe to call from the worker threads, the cache is shared under its lock.
+ */
+extern void object_read(struct object * obj, const struct object_id * oid);
+
+/**
+ * @brief: Release the content of the object from object_read
+ * @param obj: The object to be released
+ */
+extern void object_release(struct object * obj);
+
+/**
+ * @brief: The result of the object verification
+ * @param OBJECT_VERIFY_OK: The object inflates to a valid object with the id
+ * @param OBJECT_VERIFY_MISSING: The object is in neither the packs nor the loose objects
+ * @param OBJECT_VERIFY_CORRUPT: The data does not inflate to a valid header and content
+ * @param OBJECT_VERIFY_MISMATCH: The header and content do not hash to the id
+ */
+enum object_verify_result{
+    OBJECT_VERIFY_OK,
+    OBJECT_VERIFY_MISSING,
+    OBJECT_VERIFY_CORRUPT,
+    OBJECT_VERIFY_MISMATCH,
+};
+
+/**
+ * @brief: Inflate the object and hash its header and content again, without
+ *         the object cache and without panicking on the broken data.
+ * @param obj: The object to store the type, the size and the content
+ * @param oid: The id of the object
+ * @return: The result of the verification
+ * @note: Only a tree, commit or tag keeps its content, release it with 
+ *        object_release. A blob is hashed chunk by chunk and its content 
+ *        is NULL. The delta chain of a packed object is still resolved by
+ *        the pack module, which panics on a broken pack.
  */
-extern void object_read(struct object * obj, const char * sha1);
+extern enum object_verify_result object_verify(struct object * obj, const struct object_id * oid);
 
 
+/**
+ * @brief: How the object files are made durable before they are published,
+ *         selected by the core.fsyncMethod config ("none", "fsync" or "batch").
+ * @note: The objects are always written to a temporary file and renamed to
+ *        their final path, so a reader never sees a truncated object.
+ */
+enum object_fsync_method{
+    OBJECT_FSYNC_NONE,      // leave the write back to the kernel
+    OBJECT_FSYNC_FSYNC,     // fsync every object file before the rename
+    OBJECT_FSYNC_BATCH      // one barrier for the whole batch, the renames wait for it
+};
+
+/**
+ * @brief: Get the fsync method of the object files from the core.fsyncMethod config
+ * @return: The fsync method, none when the config is not set
+ */
+extern enum object_fsync_method object_get_fsync_method(void);
+
+/**
+ * @brief: The reusable writer of the objects, the SHA1 context, the deflate
+ *         stream and the buffers are set up once and reset for every object.
+ * @param write_to_repo: Whether to write the objects to the gitlet repository
+ * @param fsync_method: How the object files are synced, read from the config
+ * @note: The fields start with '_' are private to the object module. One writer
+ *        is used by one thread at a time, the writers on different threads
+ *        can write at the same time once they are all initialized. In the
+ *        batch mode the objects only show up after object_writer_flush.
+ */
+struct object_writer{
+    bool write_to_repo;
+    enum object_fsync_method fsync_method;
+
+    EVP_MD_CTX * _sha1_context;
+    z_stream _zstream;
+    int _level;
+    unsigned char * _input_buffer;
+    unsigned char * _output_buffer;
+    unsigned char _fanout_ready[256 / 8];
+
+    char ** _pending_paths;
+    size_t _pending_count;
+    size_t _pending_capacity;
+};
+
+/**
+ * @brief: Initialize the object writer
+ * @param writer: The object writer
+ * @param write_to_repo: Whether to write the objects to the gitlet repository
+ */
+extern void object_writer_init(struct object_writer * writer, bool write_to_repo);
+
+/**
+ * @brief: Hash the file as a blob, and write it to the gitlet repository 
+ *         when the writer is set to write.
+ * @param writer: The object writer
+ * @param oid: The object id to store the hash of the object
+ * @param file: The file to be hashed
+ * @note: The object is compressed at the level picked by the compression 
+ *        policy, see object/compress.h.
+ */
+extern void object_writer_write(struct object_writer * writer, struct object_id * oid, const char * file);
+
+/**
+ * @brief: Hash the content of the opened file as a blob, like object_writer_write
+ * @param writer: The object writer
+ * @param oid: The object id to store the hash of the object
+ * @param input: The file opened for reading from its beginning, closed by the writer, 
+ *               it can be a memory stream such as the target of a symbolic link
+ * @param file: The name of the file in the error messages
+ */
+extern void object_writer_write_file(struct object_writer * writer, struct object_id * oid, FILE * input, const char * file);
+
+/**
+ * @brief: Publish the objects held back by the batch mode of the writers, the
+ *         object files of all the writers are synced with a single barrier.
+ * @param writers: The object writers
+ * @param count: The number of the writers
+ */
+extern void object_writer_flush(struct object_writer * writers, size_t count);
+
+/**
+ * @brief: Release the resources of the object writer, the objects held back
+ *         by the batch mode are flushed first.
+ * @param writer: The object writer
+ */
+extern void object_writer_release(struct object_writer * writer);
+
 /**
  * @brief: Write the object to the gitlet repository
- * @param buffer: The buffer to store the hash the length of the buffer is 40 bytes
+ * @param oid: The object id to store the hash of the object
  * @param file: The file to be hashed
  * @param write_to_repo: Whether to write the object to the gitlet repository
  */
-extern void object_write(char * buffer, const char * file, bool write_to_repo);
+extern void object_write(struct object_id * oid, const char * file, bool write_to_repo);
 
 
 
@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_OID_H
+#define GITLET_OBJECT_OID_H
+
+/**
+ * @brief: This header provide the object id, the raw 20 bytes of the SHA1 
+ *         of the object. The ids are compared and hashed in the binary form,
+ *         and only converted to hex at the I/O boundary.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// size of the raw object id
+#define OBJECT_ID_RAW_SIZE      20
+// size of the hex object id, without the null terminator
+#define OBJECT_ID_HEX_SIZE      40
+// the shortest abbreviated hex object id accepted, like git
+#define OBJECT_ID_MIN_ABBREV    4
+
+/**
+ * @brief: The object id
+ * @param hash: The raw SHA1 of the object
+ */
+struct object_id{
+    unsigned char hash[OBJECT_ID_RAW_SIZE];
+};
+
+/**
+ * @brief: Compare two object ids in the byte order
+ * @return: negative, zero or positive like memcmp
+ */
+static inline int oid_compare(const struct object_id * left, const struct object_id * right){
+    return memcmp(left->hash, right->hash, OBJECT_ID_RAW_SIZE);
+}
+
+/**
+ * @brief: Check whether two object ids are the same
+ */
+static inline bool oid_equals(const struct object_id * left, const struct object_id * right){
+    return memcmp(left->hash, right->hash, OBJECT_ID_RAW_SIZE) == 0;
+}
+
+/**
+ * @brief: Get the hash of the object id for the hash tables, the id is 
+ *         already uniformly distributed so its first bytes are used as is.
+ */
+static inline uint32_t oid_hash(const struct object_id * oid){
+    uint32_t _hash = 0;
+    memcpy(&_hash, oid->hash, sizeof(uint32_t));
+    return _hash;
+}
+
+/**
+ * @brief: Check whether the object id starts with the hex prefix
+ * @param oid: The object id
+ * @param prefix: The prefix from oid_from_hex_prefix
+ * @param hex_length: The number of the hex characters of the prefix
+ */
+static inline bool oid_has_prefix(const struct object_id * oid, const struct object_id * prefix, size_t hex_length){
+    if (memcmp(oid->hash, prefix->hash, hex_length / 2) != 0){
+        return false;
+    }
+    // the odd prefix ends in the high half of the byte
+    return hex_length % 2 == 0 || (oid->hash[hex_length / 2] & 0xf0) == prefix->hash[hex_length / 2];
+}
+
+/**
+ * @brief: Encode the object id as the lower case hex string
+ * @param buffer: The buffer to store the hex string, at least OBJECT_ID_HEX_SIZE + 1 bytes
+ * @param oid: The object id
+ * @return: The buffer
+ */
+extern char * oid_to_hex(char * buffer, const struct object_id * oid);
+
+/**
+ * @brief: Decode the hex string of exactly OBJECT_ID_HEX_SIZE characters
+ * @param oid: The object id to store the result
+ * @param hex: The null terminated hex string
+ * @return: true if the hex string is a valid object id, false otherwise
+ */
+extern bool oid_from_hex(struct object_id * oid, const char * hex);
+
+/**
+ * @brief: Decode the hex prefix of an object id, the rest of the id is zero
+ *         so the prefix is also the smallest id starting with it.
+ * @param prefix: The object id to store the prefix
+ * @param hex: The hex string
+ * @param hex_length: The number of the hex characters, at most OBJECT_ID_HEX_SIZE
+ * @return: true if the hex string is valid, false otherwise
+ */
+extern bool oid_from_hex_prefix(struct object_id * prefix, const char * hex, size_t hex_length);
+
+#endif // GITLET_OBJECT_OID_H
@@ -0,0 +1,174 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_PACK_H
+#define GITLET_OBJECT_PACK_H
+
+/**
+ * @brief: This header provide the packfile storage of the gitlet objects.
+ *         A pack stores many objects in a single data file (.pack) next to 
+ *         an index (.idx) with a 256-entry fanout table and the sorted object ids.
+ * @note: The on-disk layout follows the git pack version 2 and index version 2,
+ *        similar objects are stored as deltas against a base in the same pack.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <object/object.h>
+
+// the default number of the objects a delta base is searched among
+#define PACK_DEFAULT_WINDOW         10
+// the default longest delta chain written into the pack
+#define PACK_DEFAULT_DEPTH          50
+
+struct pack;
+
+/**
+ * @brief: The callback for the pack found broken
+ * @param path: The path of the pack data file
+ * @param data: The user data
+ */
+typedef void (*pack_broken_callback)(const char * path, void * data);
+
+/**
+ * @brief: The object located inside a pack
+ * @param type: The type of the object
+ * @param file_size: The size of the object content
+ * @param data: The compressed content of the object inside the mapped pack, NULL for a delta
+ * @param data_size: The number of bytes available from data to the end of the pack
+ * @param is_delta: true if the object is stored as a delta, use pack_object_unpack to get the content
+ * @note: The fields start with '_' are private to the pack module
+ */
+struct pack_object{
+    enum object_type type;
+    uint64_t file_size;
+    const unsigned char * data;
+    size_t data_size;
+    bool is_delta;
+
+    const struct pack * _pack;
+    uint64_t _offset;
+};
+
+/**
+ * @brief: Map all the packs in the pack directory, only done once per process
+ * @note: The first call scans the directory under a lock, so the packs may
+ *        be searched from several threads right away, the lookups after it
+ *        only read the packs.
+ */
+extern void pack_prepare(void);
+
+/**
+ * @brief: Find the object in the packs of the gitlet repository, the pack
+ *         indexes are mapped into memory on the first lookup.
+ * @param obj: The pack object to store the result, can be NULL when only 
+ *             the existence of the object is needed
+ * @param oid: The id of the object
+ * @return: true if the object is found in a pack, false otherwise
+ */
+extern bool pack_find_object(struct pack_object * obj, const struct object_id * oid);
+
+/**
+ * @brief: Update the mtime of a pack holding the object, so a gc running 
+ *         later counts the object as recent like it was written again.
+ * @param oid: The id of the object
+ * @return: true if a pack holding the object is freshened, false if there is
+ *          none or none of them can be touched, then the object is written loose.
+ * @note: A pack is touched once per process, however many objects are found in it.
+ */
+extern bool pack_freshen_object(const struct object_id * oid);
+
+/**
+ * @brief: Find the objects whose ids start with the prefix in the packs, with
+ *         a binary search in the fanout range of every pack index.
+ * @param prefix: The prefix from oid_from_hex_prefix
+ * @param hex_length: The number of the hex characters of the prefix
+ * @param matches: The ids found so far, the new ids are appended
+ * @param count: The number of the ids in matches
+ * @param max_count: The capacity of matches, the search stops once it is full
+ */
+extern void pack_find_prefix(const struct object_id * prefix, size_t hex_length, struct object_id * matches, 
+    size_t * count, size_t max_count);
+
+/**
+ * @brief: Call the callback for every object in the packs, an object stored
+ *         in more than one pack is reported once.
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ * @note: The objects are reported pack by pack, in the order of the ids inside a pack.
+ */
+extern void pack_for_each_object(object_each_callback callback, void * data);
+
+/**
+ * @brief: Rebuild the content of the packed object by applying its delta chain
+ * @param obj: The pack object found by pack_find_object
+ * @return: The content allocated with malloc, with an extra null terminator after the content
+ * @note: The chain depth is bounded, a longer or broken chain will panic.
+ */
+extern unsigned char * pack_object_unpack(const struct pack_object * obj);
+
+/**
+ * @brief: Write the objects into a new pack and its index in the pack 
+ *         directory of the gitlet repository.
+ * @param pack_id: The object id to store the checksum of the pack, which also names the pack
+ * @param oid_list: The ids of the objects to be packed, duplicates are packed once
+ * @param count: The number of the objects
+ * @param window: The number of the preceding objects searched for a delta base, 0 to disable deltas
+ * @param depth: The longest delta chain to be written
+ * @note: The objects are ordered by type and size so that similar objects sit 
+ *        close to each other, and every object is compared against the objects 
+ *        in the sliding window before it.
+ */
+extern void pack_write(struct object_id * pack_id, const struct object_id * oid_list, size_t count, 
+    unsigned int window, unsigned int depth);
+
+/**
+ * @brief: Verify the trailing checksums of every pack and its index, the
+ *         packs are hashed in parallel. A broken pack is reported and then
+ *         dropped, so its objects are never read by the lookups after it.
+ *         The packs with a bad header, never listed, are reported first.
+ * @param callback: The callback for every broken pack
+ * @param data: The user data passed to the callback
+ * @return: The number of the broken packs
+ */
+extern size_t pack_verify(pack_broken_callback callback, void * data);
+
+/**
+ * @brief: Delete the packs made redundant by a new pack, along with the 
+ *         temporary pack files left behind by the writers.
+ * @param keep_pack: The id of the pack to keep, NULL to consider every pack
+ * @param kept: The sorted ids of the objects held by the kept pack
+ * @param kept_count: The number of the kept ids
+ * @param expire: The packs and temporary files last modified before it can be deleted, 0 for none
+ * @return: The number of the packs deleted
+ * @note: A pack whose objects are all kept is always deleted. A pack holding 
+ *        any other object is deleted only once it expires, so the objects
+ *        packed recently outlive a concurrent gc like the loose ones.
+ */
+extern size_t pack_remove_redundant(const struct object_id * keep_pack, const struct object_id * kept, 
+    size_t kept_count, time_t expire);
+
+#endif // GITLET_OBJECT_PACK_H
@@ -0,0 +1,52 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_REACHABLE_H
+#define GITLET_OBJECT_REACHABLE_H
+
+/**
+ * @brief: This header provide the reachability walk of the object graph,
+ *         from the commits, trees and tags to every object they refer to.
+ * @note: The walk goes one level of the graph at a time, the objects of a
+ *        level are parsed on the worker threads and the new objects found 
+ *        by them are merged into the set of the seen objects afterwards.
+ */
+#include <stddef.h>
+
+#include <object/object.h>
+
+/**
+ * @brief: Find all the objects reachable from the roots
+ * @param roots: The ids of the objects the walk starts from
+ * @param root_count: The number of the roots
+ * @param threads: The number of the threads parsing the objects, 0 for all the processors
+ * @param count: The pointer to store the number of the reachable objects
+ * @return: The reachable ids sorted by id, including the roots, allocated with malloc
+ * @note: A submodule commit in a tree is not followed, and a missing or
+ *        broken object on the way will panic.
+ */
+extern struct object_id * reachable_list(const struct object_id * roots, size_t root_count, 
+    unsigned int threads, size_t * count);
+
+#endif // GITLET_OBJECT_REACHABLE_H
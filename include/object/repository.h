@@ -26,6 +26,17 @@
 #define GITLET_OBJECT_REPOSITORY_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include <object/oid.h>
+
+/**
+ * @brief: The callback for every ref of the repository
+ * @param name: The name of the ref, like refs/heads/master or HEAD
+ * @param oid: The object id the ref points to
+ * @param data: The user data
+ */
+typedef void (*repository_ref_callback)(const char * name, const struct object_id * oid, void * data);
 
 struct repository{
     const char * working_tree_path;
@@ -47,4 +58,54 @@ extern void repository_object_init(struct repository * this, const char * path,
  */
 extern void repository_create(const char * path);
 
+/**
+ * @brief: Get the value of the key from the config file of the gitlet repository
+ *         in the current working directory, the file is parsed once per process.
+ * @param section: The section of the key
+ * @param key: The key, compared case insensitively like git
+ * @return: The value of the key, NULL if the key is not set
+ */
+extern const char * repository_config_get(const char * section, const char * key);
+
+/**
+ * @brief: Get the size value of the key from the config file, the value can 
+ *         carry a k, m or g suffix like the git config.
+ * @param section: The section of the key
+ * @param key: The key
+ * @param default_value: The value returned when the key is not set
+ * @return: The size value of the key
+ */
+extern uint64_t repository_config_get_size(const char * section, const char * key, uint64_t default_value);
+
+/**
+ * @brief: Get the boolean value of the key from the config file, the value 
+ *         is one of true, yes, on, 1 or false, no, off, 0 like the git config.
+ * @param section: The section of the key
+ * @param key: The key
+ * @param default_value: The value returned when the key is not set
+ * @return: The boolean value of the key
+ */
+extern bool repository_config_get_bool(const char * section, const char * key, bool default_value);
+
+/**
+ * @brief: Call the callback for every ref of the gitlet repository in the 
+ *         current working directory, the loose refs under refs, the refs in 
+ *         packed-refs with their peeled ids, and a detached HEAD.
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ * @note: A symbolic ref is not reported on its own, the ref it points to is.
+ *        A ref in both places is reported for each of them.
+ */
+extern void repository_for_each_ref(repository_ref_callback callback, void * data);
+
+/**
+ * @brief: Resolve HEAD of the gitlet repository in the current working directory,
+ *         the branch it points to is looked up in the loose refs, then in packed-refs.
+ * @param ref: The buffer to store the ref HEAD points to like refs/heads/master, 
+ *             the length of the buffer is PATH_MAX, empty when HEAD is detached
+ * @param oid: The object id to store the commit HEAD points to
+ * @return: true if HEAD points to a commit, false for a branch without commits yet
+ */
+extern bool repository_resolve_head(char * ref, struct object_id * oid);
+
 #endif // GITLET_OBJECT_REPOSITORY_H
\ No newline at end of file
@@ -0,0 +1,161 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_UNTRACKED_H
+#define GITLET_OBJECT_UNTRACKED_H
+
+/**
+ * @brief: This header provide the scan of the working tree for the untracked
+ *         files, with the untracked cache kept in the index. The cache holds
+ *         a node for every directory read, with the mtime and the inode of 
+ *         the directory when it was read, the id of its .gitletignore, and 
+ *         the untracked paths found in it. A directory whose stat data and 
+ *         ignore file are unchanged is not read again, so the scan only costs
+ *         one lstat per directory plus the reads of the changed directories.
+ * @note: Adding or removing an entry of the index invalidates the nodes along
+ *        its path, since the untracked paths depend on the tracked ones. A 
+ *        directory modified at or after the index was written is read again,
+ *        like a racily clean entry.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <object/oid.h>
+
+struct index;
+
+/**
+ * @brief: The directory of the working tree in the untracked cache
+ * @param name: The name of the directory, "" for the top
+ * @param mtime_sec, mtime_nsec: The mtime of the directory when it was read
+ * @param ino: The inode of the directory, truncated to 32 bits
+ * @param ignore_oid: The blob id of the .gitletignore of the directory, all zero without one
+ * @param valid: Whether the untracked paths are still the ones of the directory
+ * @param check_only: Whether the directory has no tracked files and is only
+ *                    read to tell whether it holds any untracked file
+ * @param has_file: For check_only, whether an untracked file is under the directory
+ * @param untracked: The names of the untracked files of the directory, and of
+ *                   the untracked directories with a trailing '/', unless check_only
+ * @param untracked_count: The number of the untracked names
+ * @param children: The sub-directories read, sorted by the names
+ * @param child_count: The number of the sub-directories
+ */
+struct untracked_node{
+    char * name;
+    uint32_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t ino;
+    struct object_id ignore_oid;
+    bool valid;
+    bool check_only;
+    bool has_file;
+    char ** untracked;
+    size_t untracked_count;
+    struct untracked_node ** children;
+    size_t child_count;
+};
+
+/**
+ * @brief: The untracked cache of the index
+ * @param all: Whether the nodes list every untracked file, otherwise an 
+ *             untracked directory is listed instead of its files
+ * @param exclude_oid: The blob id of .gitlet/info/exclude, all zero without the file
+ * @param root: The node of the top of the working tree
+ */
+struct untracked_cache{
+    bool all;
+    struct object_id exclude_oid;
+    struct untracked_node * root;
+};
+
+/**
+ * @brief: The untracked paths found by the scan
+ * @param paths: The paths relative to the working tree, sorted
+ * @param count: The number of the paths
+ * @param capacity: The capacity of the paths
+ */
+struct untracked_list{
+    char ** paths;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: Check whether the untracked cache is enabled by core.untrackedCache, true by default
+ */
+extern bool untracked_cache_enabled(void);
+
+/**
+ * @brief: Parse the untracked cache from the data of the index extension
+ * @param data: The data of the extension
+ * @param size: The size of the data
+ * @return: The cache allocated on the heap, NULL if the data is broken
+ */
+extern struct untracked_cache * untracked_cache_parse(const unsigned char * data, size_t size);
+
+/**
+ * @brief: Serialize the untracked cache for the index extension
+ * @param cache: The cache
+ * @param size: The pointer to store the size of the data
+ * @return: The data allocated on the heap
+ */
+extern unsigned char * untracked_cache_serialize(const struct untracked_cache * cache, size_t * size);
+
+/**
+ * @brief: Invalidate the nodes of the directories holding the path, after 
+ *         the path is added to or removed from the index
+ * @param cache: The cache, NULL is ignored
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ */
+extern void untracked_cache_invalidate(struct untracked_cache * cache, const char * path, size_t length);
+
+/**
+ * @brief: Free the untracked cache
+ * @param cache: The cache, NULL is ignored
+ */
+extern void untracked_cache_free(struct untracked_cache * cache);
+
+/**
+ * @brief: Find the untracked paths of the working tree in the current 
+ *         working directory, the ignored ones are skipped.
+ * @param index: The index, whose untracked cache is used and updated when it
+ *               is enabled, the index is then marked as changed
+ * @param all: Whether to list every untracked file, otherwise a directory 
+ *             without tracked files is listed as "dir/" if it holds any
+ * @param threads: The number of the worker threads
+ * @param list: The list to store the untracked paths
+ * @note: The directories are read one level at a time on the workers, like
+ *        worktree_scan, and a valid node saves the read of its directory.
+ */
+extern void untracked_scan(struct index * index, bool all, unsigned int threads, struct untracked_list * list);
+
+/**
+ * @brief: Release the untracked paths
+ * @param list: The list
+ */
+extern void untracked_list_release(struct untracked_list * list);
+
+#endif // GITLET_OBJECT_UNTRACKED_H
@@ -0,0 +1,121 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_OBJECT_WORKTREE_H
+#define GITLET_OBJECT_WORKTREE_H
+
+/**
+ * @brief: This header provide the walk of the working tree, the directory 
+ *         of the repository and the .git directory next to it are skipped.
+ * @note: The walk goes one level of the directories at a time, the directories
+ *        of a level are read on the worker threads, one directory per item, 
+ *        and the sub-directories found by them make the next level.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief: The callback for every file and directory of the working tree
+ * @param path: The path relative to the working tree, separated by '/'
+ * @param length: The length of the path
+ * @param is_directory: Whether the path is a directory, a symbolic link is never one
+ * @param data: The user data
+ * @return: For a directory, whether to walk into it, ignored for a file
+ */
+typedef bool (*worktree_walk_callback)(const char * path, size_t length, bool is_directory, void * data);
+
+/**
+ * @brief: The callback of the parallel scan, called on the worker threads
+ * @param path: The path relative to the working tree, separated by '/'
+ * @param length: The length of the path
+ * @param is_directory: Whether the path is a directory, a symbolic link is never one
+ * @param worker: The index of the worker calling it
+ * @param data: The user data
+ * @return: For a directory, whether to scan it, ignored for a file
+ */
+typedef bool (*worktree_scan_callback)(const char * path, size_t length, bool is_directory, 
+    unsigned int worker, void * data);
+
+/**
+ * @brief: The callback for every entry of the directory read by worktree_read_directory
+ * @param name: The name of the entry
+ * @param length: The length of the name
+ * @param is_directory: Whether the entry is a directory, a symbolic link is never one
+ * @param data: The user data
+ */
+typedef void (*worktree_read_callback)(const char * name, size_t length, bool is_directory, void * data);
+
+/**
+ * @brief: Walk the directory of the working tree in the current working 
+ *         directory on the calling thread, the directory itself is not reported.
+ * @param directory: The path of the directory relative to the working tree, "" for the top
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ * @note: The entries are reported in no particular order.
+ */
+extern void worktree_walk(const char * directory, worktree_walk_callback callback, void * data);
+
+/**
+ * @brief: Scan the directory of the working tree like worktree_walk, with the
+ *         directories read and reported on the worker threads.
+ * @param directory: The path of the directory relative to the working tree, "" for the top
+ * @param threads: The number of the worker threads
+ * @param callback: The callback function, called by the workers at the same time
+ * @param data: The user data passed to the callback
+ * @note: The entries are reported in no particular order, the callback keeps
+ *        its results per worker and sorts them for a deterministic output.
+ */
+extern void worktree_scan(const char * directory, unsigned int threads, worktree_scan_callback callback, void * data);
+
+/**
+ * @brief: Read the entries of one directory of the working tree, without 
+ *         walking into the sub-directories
+ * @param directory: The path of the directory relative to the working tree, "" for the top
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ * @note: The entries are reported in no particular order, and a directory
+ *        which cannot be read has no entries.
+ */
+extern void worktree_read_directory(const char * directory, worktree_read_callback callback, void * data);
+
+/**
+ * @brief: Normalize the pathspec to the path relative to the working tree, 
+ *         without "./", repeated or trailing slashes, "" for the whole tree
+ * @param buffer: The buffer to store the path, the length of the buffer is PATH_MAX
+ * @param pathspec: The pathspec from the command line, relative to the working tree
+ * @note: A pathspec outside the working tree is a fatal error.
+ */
+extern void worktree_normalize_pathspec(char * buffer, const char * pathspec);
+
+/**
+ * @brief: Check whether the path is the normalized pathspec itself, or is 
+ *         under it when the pathspec is a directory
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ * @param pathspec: The pathspec from worktree_normalize_pathspec
+ * @param pathspec_length: The length of the pathspec
+ */
+extern bool worktree_path_matches(const char * path, size_t length, const char * pathspec, size_t pathspec_length);
+
+#endif // GITLET_OBJECT_WORKTREE_H
@@ -0,0 +1,109 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GITLET_UTIL_PARALLEL_H
+#define GITLET_UTIL_PARALLEL_H
+
+/**
+ * @brief: This header provide the worker pool helpers built on pthreads.
+ *         The ordered pipeline keeps many items in flight on the workers,
+ *         while the results are handed back in the order of the input.
+ *         The parallel loop spreads a fixed range of indexes over the workers.
+ */
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief: Process the item on a worker thread
+ * @param item: The item pushed into the pipeline
+ * @param worker: The index of the worker thread, from 0 to workers - 1
+ * @param data: The user data of the pipeline
+ */
+typedef void (*parallel_process_function)(void * item, unsigned int worker, void * data);
+
+/**
+ * @brief: Consume the processed item on the thread which pushes the items
+ * @param item: The processed item, in the order the items are pushed
+ * @param data: The user data of the pipeline
+ */
+typedef void (*parallel_output_function)(void * item, void * data);
+
+/**
+ * @brief: Run one index of the parallel loop on a worker thread
+ * @param index: The index, from 0 to count - 1
+ * @param worker: The index of the worker thread, from 0 to workers - 1
+ * @param data: The user data of the loop
+ */
+typedef void (*parallel_for_function)(size_t index, unsigned int worker, void * data);
+
+/**
+ * @brief: The ordered pipeline, the layout is private to the parallel module
+ */
+struct parallel_pipeline;
+
+/**
+ * @brief: Get the number of the online processors
+ * @return: The number of the online processors, at least 1
+ */
+extern unsigned int parallel_cpu_count(void);
+
+/**
+ * @brief: Create the ordered pipeline and start the worker threads
+ * @param workers: The number of the worker threads, at least 1
+ * @param capacity: The most items in flight, the push blocks when it is reached
+ * @param process: The function to process the item on the workers
+ * @param output: The function to consume the item in the input order
+ * @param data: The user data passed to both functions
+ * @return: The pipeline
+ */
+extern struct parallel_pipeline * parallel_pipeline_create(unsigned int workers, size_t capacity,
+    parallel_process_function process, parallel_output_function output, void * data);
+
+/**
+ * @brief: Push the item into the pipeline, the items already processed at
+ *         the head of the pipeline are output before it returns.
+ * @param pipeline: The pipeline
+ * @param item: The item to be processed
+ */
+extern void parallel_pipeline_push(struct parallel_pipeline * pipeline, void * item);
+
+/**
+ * @brief: Wait for all the items, output the rest of them, then stop the 
+ *         workers and release the pipeline.
+ * @param pipeline: The pipeline
+ */
+extern void parallel_pipeline_finish(struct parallel_pipeline * pipeline);
+
+/**
+ * @brief: Run the function for every index from 0 to count - 1 on the worker 
+ *         threads, the indexes are claimed one by one so the uneven work is
+ *         balanced, and it returns once all of them are done.
+ * @param workers: The number of the worker threads, the calling thread is one of them
+ * @param count: The number of the indexes
+ * @param function: The function to run for every index
+ * @param data: The user data passed to the function
+ */
+extern void parallel_for(unsigned int workers, size_t count, parallel_for_function function, void * data);
+
+#endif // GITLET_UTIL_PARALLEL_H
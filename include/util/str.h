@@ -78,6 +78,23 @@ extern void str_hash_sha1(char * restrict buffer, const char * str);
  */
 extern void str_hash_sha1_n(char * restrict buffer, const char * str, size_t len);
 
+/**
+ * @brief: Encode the binary data as a lower case hex string
+ * @param buffer: The buffer to store the hex string, at least 2 * len + 1 bytes
+ * @param data: The binary data to be encoded
+ * @param len: The length of the binary data
+ */
+extern void str_hex_encode(char * restrict buffer, const unsigned char * data, size_t len);
+
+/**
+ * @brief: Decode the hex string into the binary data
+ * @param buffer: The buffer to store the binary data, at least len bytes
+ * @param hex: The hex string, at least 2 * len characters
+ * @param len: The length of the binary data
+ * @return: true if the hex string is valid, false otherwise
+ */
+extern bool str_hex_decode(unsigned char * restrict buffer, const char * hex, size_t len);
+
 /**
  * @brief: Decompress the content using zlib
  * @param src_buffer: The source buffer
@@ -101,4 +118,16 @@ extern unsigned long str_decompress(const char * src_buffer, size_t src_size,
 extern unsigned long str_compress(const char * src_buffer, size_t src_size, 
     char * dest_buffer, size_t dest_size);
 
+/**
+ * @brief: Compress the content using zlib at the compression level
+ * @param src_buffer: The source buffer
+ * @param src_size: The size of the source buffer
+ * @param dest_buffer: The destination buffer
+ * @param dest_size: The size of the destination buffer
+ * @param level: The zlib compression level, from 0 (stored) to 9, -1 for the default
+ * @return: The size of the compressed content
+ */
+extern unsigned long str_compress_level(const char * src_buffer, size_t src_size, 
+    char * dest_buffer, size_t dest_size, int level);
+
 #endif // GITLET_UTIL_STR_H
\ No newline at end of file
@@ -22,8 +22,388 @@
  * SOFTWARE.
  */
 
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <argparse.h>
+
 #include <command/add.h>
+#include <object/fsmonitor.h>
+#include <object/ignore.h>
+#include <object/index.h>
+#include <object/object.h>
+#include <object/repository.h>
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <util/str.h>
+#include <global/config.h>
+
+/**
+ * @brief: The file to be added to the index
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ * @param status: The lstat result of the file
+ * @param oid: The id of the blob of the content
+ * @param hash: Whether the content has to be hashed, the stat data cannot tell it is unchanged
+ */
+struct add_item{
+    char * path;
+    size_t length;
+    struct stat status;
+    struct object_id oid;
+    bool hash;
+};
+
+/**
+ * @brief: The growable list of the files to be added
+ * @param items: The items
+ * @param count: The number of the items
+ * @param capacity: The capacity of the list
+ */
+struct add_list{
+    struct add_item * items;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: Append the path to the list
+ * @param list: The list
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ */
+static void add_list_append(struct add_list * list, const char * path, size_t length){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->items = (struct add_item *)realloc(list->items, list->capacity * sizeof(struct add_item));
+        if (list->items == NULL){
+            gitlet_panic("Failed to allocate memory for the paths");
+        }
+    }
+    struct add_item * item = &list->items[list->count++];
+    memset(item, 0, sizeof(struct add_item));
+    item->path = strndup(path, length);
+    if (item->path == NULL){
+        gitlet_panic("Failed to allocate memory for the paths");
+    }
+    item->length = length;
+}
+
+/**
+ * @brief: The state of the walk collecting the files under a pathspec
+ * @param list: The files collected
+ * @param index: The index
+ * @param ignore: The ignore rules, NULL to add the ignored files too
+ */
+struct add_walk_state{
+    struct add_list * list;
+    const struct index * index;
+    struct ignore * ignore;
+};
 
+/**
+ * @brief: Check whether the index has the path, or any entry under it
+ */
+static bool add_has_tracked(const struct index * index, const char * path, size_t length){
+    bool found = false;
+    size_t position = index_position(index, path, length, &found);
+    for (; !found && position < index->count; position++){
+        const struct index_entry * entry = index->entries[position];
+        if (entry->path_length < length || memcmp(entry->path, path, length) != 0){
+            break;
+        }
+        if (worktree_path_matches(entry->path, entry->path_length, path, length)){
+            return true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief: Collect the files found by the walk of the working tree, the 
+ *         ignored ones are skipped unless they are tracked already
+ */
+static bool add_collect_file(const char * path, size_t length, bool is_directory, void * data){
+    struct add_walk_state * state = (struct add_walk_state *)data;
+    bool ignored = state->ignore != NULL && ignore_is_excluded(state->ignore, path, length, is_directory, NULL, NULL);
+    if (is_directory){
+        return !ignored || add_has_tracked(state->index, path, length);
+    }
+    if (!ignored || add_has_tracked(state->index, path, length)){
+        add_list_append(state->list, path, length);
+    }
+    return true;
+}
+
+/**
+ * @brief: Compare two paths in the order of the index
+ */
+static int add_compare_path(const char * left, size_t left_length, const char * right, size_t right_length){
+    int result = memcmp(left, right, left_length < right_length ? left_length : right_length);
+    if (result != 0){
+        return result;
+    }
+    return left_length < right_length ? -1 : (left_length > right_length ? 1 : 0);
+}
+
+/**
+ * @brief: Compare the items by the paths in the order of the index
+ */
+static int add_item_compare(const void * left, const void * right){
+    const struct add_item * left_item = (const struct add_item *)left;
+    const struct add_item * right_item = (const struct add_item *)right;
+    return add_compare_path(left_item->path, left_item->length, right_item->path, right_item->length);
+}
+
+/**
+ * @brief: Check whether the path is inside the directory of the repository
+ */
+static bool add_is_repository_path(const char * path){
+    return str_equals(path, ".gitlet") || str_start_with(path, ".gitlet/") 
+        || str_equals(path, ".git") || str_start_with(path, ".git/");
+}
+
+/**
+ * @brief: Mark the entries under the pathspec whose files are not in the 
+ *         sorted list of the files found on the disk as removed
+ * @param index: The index
+ * @param path: The normalized pathspec
+ * @param list: The sorted files found under the pathspec
+ * @param verbose: Whether to print the removed paths
+ * @return: The number of the entries under the pathspec
+ */
+static size_t add_mark_removed(struct index * index, const char * path, const struct add_list * list, bool verbose){
+    size_t path_length = strlen(path);
+    bool found = false;
+    size_t position = index_position(index, path, path_length, &found);
+    size_t matched = 0;
+    size_t file = 0;
+    for (; position < index->count; position++){
+        struct index_entry * entry = index->entries[position];
+        if (!worktree_path_matches(entry->path, entry->path_length, path, path_length)){
+            if (entry->path_length >= path_length && memcmp(entry->path, path, path_length) == 0){
+                // a sibling like "a.txt" sorts between "a" and "a/", keep looking
+                continue;
+            }
+            break;
+        }
+        matched++;
+
+        while (file < list->count && add_compare_path(list->items[file].path, list->items[file].length,
+            entry->path, entry->path_length) < 0){
+            file++;
+        }
+        bool on_disk = file < list->count && add_compare_path(list->items[file].path, 
+            list->items[file].length, entry->path, entry->path_length) == 0;
+        if (!on_disk && !entry->removed){
+            entry->removed = true;
+            if (verbose){
+                printf("remove '%s'\n", entry->path);
+            }
+        }
+    }
+    return matched;
+}
+
+/**
+ * @brief: The state of the hashing shared by the worker threads
+ * @param list: The files to be added
+ * @param writers: The object writers of the workers
+ */
+struct add_hash_state{
+    struct add_list * list;
+    struct object_writer * writers;
+};
+
+/**
+ * @brief: Hash the file on the worker thread with the writer of the worker
+ */
+static void add_hash_item(size_t index, unsigned int worker, void * data){
+    struct add_hash_state * state = (struct add_hash_state *)data;
+    struct add_item * item = &state->list->items[index];
+    if (item->hash){
+        index_hash_path(&state->writers[worker], &item->oid, item->path, &item->status);
+    }
+}
+
+// gitlet add [-n] [-v] [-f] [--] <pathspec>...
 void command_add(int argc, char *argv[]) {
-    
-}
\ No newline at end of file
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet add [-n] [-v] [-f] [--] <pathspec>...";
+    description._description = "Add file contents to the index";
+    description._epilog = NULL;
+
+    bool dry_run_flag = false;
+    bool verbose_flag = false;
+    bool force_flag = false;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('n', "dry-run", "dry run", &dry_run_flag, NULL, 0),
+        OPTION_BOOLEAN('v', "verbose", "be verbose", &verbose_flag, NULL, 0),
+        OPTION_BOOLEAN('f', "force", "allow adding otherwise ignored files", &force_flag, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    // the options come before the pathspecs, or before "--"
+    int option_count = 0;
+    while (option_count < argc && str_start_with(argv[option_count], "-") && !str_equals(argv[option_count], "--")){
+        option_count++;
+    }
+    if (option_count != 0){
+        argparse_parse(&argparse, option_count, argv);
+    }
+    int pathspec_start = option_count < argc && str_equals(argv[option_count], "--") ? option_count + 1 : option_count;
+    if (pathspec_start == argc){
+        fprintf(stderr, "Nothing specified, nothing added.\n");
+        return;
+    }
+    verbose_flag = verbose_flag || dry_run_flag;
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    struct index index;
+    index_read(&index);
+    bool monitored = fsmonitor_refresh_index(&index);
+    struct ignore ignore;
+    ignore_init(&ignore);
+
+    /**
+     * The files under all the pathspecs are collected and sorted first, so 
+     * the changed ones are hashed together and merged into the index at once.
+     * A tracked file missing from the disk under a pathspec is removed. An 
+     * ignored pathspec without tracked files is refused unless forced.
+     */
+    struct add_list list;
+    memset(&list, 0, sizeof(struct add_list));
+    struct add_walk_state walk_state = {&list, &index, force_flag ? NULL : &ignore};
+    size_t ignored_count = 0;
+    char path[PATH_MAX];
+    for (int i = pathspec_start; i < argc; i++){
+        worktree_normalize_pathspec(path, argv[i]);
+        size_t first = list.count;
+        struct stat status;
+        bool on_disk = !add_is_repository_path(path) && lstat(path[0] == '\0' ? "." : path, &status) == 0;
+        size_t path_length = strlen(path);
+        if (on_disk && !force_flag && path_length != 0 && !add_has_tracked(&index, path, path_length)
+            && ignore_is_excluded(&ignore, path, path_length, S_ISDIR(status.st_mode), NULL, NULL)){
+            if (ignored_count++ == 0){
+                fprintf(stderr, "The following paths are ignored by one of your %s files:\n", IGNORE_FILE_NAME);
+            }
+            fprintf(stderr, "%s\n", argv[i]);
+            continue;
+        }
+        if (on_disk && S_ISDIR(status.st_mode)){
+            worktree_walk(path, add_collect_file, &walk_state);
+        }else if (on_disk && index_mode_from_stat(&status) != 0){
+            add_list_append(&list, path, strlen(path));
+        }
+
+        struct add_list found = {list.items + first, list.count - first, 0};
+        qsort(found.items, found.count, sizeof(struct add_item), add_item_compare);
+        size_t tracked = add_mark_removed(&index, path, &found, verbose_flag);
+        if (!on_disk && tracked == 0){
+            gitlet_panic("pathspec '%s' did not match any files", argv[i]);
+        }
+    }
+    qsort(list.items, list.count, sizeof(struct add_item), add_item_compare);
+
+    // the file whose stat data matches a clean entry is not read again, nor
+    // stat again when the fsmonitor saw no change of it
+    size_t unique = 0;
+    for (size_t i = 0; i < list.count; i++){
+        struct add_item * item = &list.items[i];
+        if (unique != 0 && add_item_compare(&list.items[unique - 1], item) == 0){
+            free(item->path);
+            continue;
+        }
+        list.items[unique++] = *item;
+        item = &list.items[unique - 1];
+        struct index_entry * entry = index_find(&index, item->path);
+        if (monitored && entry != NULL && !entry->removed && entry->fsmonitor_valid){
+            item->hash = false;
+            continue;
+        }
+        if (lstat(item->path, &item->status) != 0){
+            gitlet_panic("unable to stat '%s': %s", item->path, strerror(errno));
+        }
+        item->hash = entry == NULL || !index_entry_stat_matches(entry, &item->status) 
+            || index_entry_is_racy(&index, entry);
+    }
+    list.count = unique;
+
+    unsigned int threads = parallel_cpu_count();
+    struct object_writer * writers = (struct object_writer *)malloc(threads * sizeof(struct object_writer));
+    if (writers == NULL){
+        gitlet_panic("Failed to allocate memory for object writers");
+    }
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_init(&writers[i], !dry_run_flag);
+    }
+    struct add_hash_state state = {&list, writers};
+    parallel_for(threads, list.count, add_hash_item, &state);
+    // the objects are published before the index refers to them
+    object_writer_flush(writers, threads);
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_release(&writers[i]);
+    }
+    free(writers);
+
+    struct index_entry ** entries = (struct index_entry **)malloc((list.count + 1) * sizeof(struct index_entry *));
+    if (entries == NULL){
+        gitlet_panic("Failed to allocate memory for the index entries");
+    }
+    size_t entry_count = 0;
+    for (size_t i = 0; i < list.count; i++){
+        struct add_item * item = &list.items[i];
+        if (item->hash){
+            struct index_entry * entry = index_find(&index, item->path);
+            bool updated = entry == NULL || entry->removed || !oid_equals(&entry->oid, &item->oid) 
+                || entry->mode != index_mode_from_stat(&item->status);
+            if (updated && verbose_flag){
+                printf("add '%s'\n", item->path);
+            }
+            entries[entry_count++] = index_entry_create(item->path, item->length, &item->oid, &item->status);
+        }
+        free(item->path);
+    }
+    free(list.items);
+
+    if (!dry_run_flag){
+        index_remove_marked(&index);
+        index_add_entries(&index, entries, entry_count);
+        if (index.changed){
+            index_write(&index);
+        }
+    }else{
+        for (size_t i = 0; i < entry_count; i++){
+            free(entries[i]);
+        }
+    }
+    free(entries);
+    ignore_release(&ignore);
+    index_release(&index);
+    if (ignored_count != 0){
+        fprintf(stderr, "hint: Use -f if you really want to add them.\n");
+        exit(EXIT_FAILURE);
+    }
+}
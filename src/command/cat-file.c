@@ -38,6 +38,114 @@
 #include <util/error.h>
 #include <util/str.h>
 #include <util/files.h>
+#include <global/config.h>
+
+// size of the chunk when streaming the object content to stdout
+#define CAT_FILE_CHUNK_SIZE     (64 * 1024)
+// size of the stdout buffer in the batch mode
+#define CAT_FILE_BATCH_BUFFER_SIZE  (256 * 1024)
+
+/**
+ * @brief: Stream the object content to stdout chunk by chunk
+ * @param stream: The opened object stream
+ */
+static void cat_file_stream_content(struct object_stream * stream){
+    char chunk_buffer[CAT_FILE_CHUNK_SIZE];
+    size_t read_size = 0;
+    while ((read_size = object_stream_read(stream, chunk_buffer, CAT_FILE_CHUNK_SIZE)) > 0){
+        if (fwrite(chunk_buffer, 1, read_size, stdout) != read_size){
+            object_stream_close(stream);
+            gitlet_panic("Failed to write the object content");
+        }
+    }
+}
+
+/**
+ * @brief: The options of the batch mode
+ * @param show_content: Whether to print the content after the header of every object
+ * @param buffer_output: Whether to flush the output only at the end, instead of after every object
+ */
+struct cat_file_batch_options{
+    bool show_content;
+    bool buffer_output;
+};
+
+/**
+ * @brief: Flush the answer to the reader on the other end of a pipe, which
+ *         may wait for every answer, unless the output is buffered.
+ * @param options: The options of the batch mode
+ */
+static void cat_file_batch_flush(const struct cat_file_batch_options * options){
+    if (!options->buffer_output && fflush(stdout) != 0){
+        gitlet_panic("Failed to write the object content");
+    }
+}
+
+/**
+ * @brief: Print the header of the object, and its content in the --batch mode
+ * @param name: The name of the object as given
+ * @param oid: The id of the object
+ * @param options: The options of the batch mode
+ */
+static void cat_file_batch_object(const char * name, const struct object_id * oid, 
+    const struct cat_file_batch_options * options){
+    if (options->show_content){
+        struct object_stream stream;
+        object_stream_open(&stream, oid);
+        printf("%s %s %llu\n", name, object_type_name(stream.type), (unsigned long long)stream.file_size);
+        cat_file_stream_content(&stream);
+        object_stream_close(&stream);
+        putchar('\n');
+    }else{
+        struct object obj;
+        object_read_header(&obj, oid);
+        printf("%s %s %llu\n", name, object_type_name(obj.type), (unsigned long long)obj.file_size);
+    }
+    cat_file_batch_flush(options);
+}
+
+/**
+ * @brief: Print the objects named by the lines from stdin, one process
+ *         serves all the objects instead of one process per object.
+ * @param options: The options of the batch mode
+ */
+static void cat_file_batch(const struct cat_file_batch_options * options){
+    char * line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_length = 0;
+    while ((line_length = getline(&line, &line_capacity, stdin)) != -1){
+        if (line_length > 0 && line[line_length - 1] == '\n'){
+            line[--line_length] = '\0';
+        }
+
+        // the header names the object with the full id, even for an abbreviated input
+        struct object_id oid;
+        enum object_name_result result = object_resolve_name(&oid, line);
+        if (result == OBJECT_NAME_AMBIGUOUS){
+            printf("%s ambiguous\n", line);
+            cat_file_batch_flush(options);
+            continue;
+        }
+        if (result != OBJECT_NAME_FOUND || !object_exists(&oid)){
+            printf("%s missing\n", line);
+            cat_file_batch_flush(options);
+            continue;
+        }
+        char hex[OBJECT_ID_HEX_SIZE + 1];
+        cat_file_batch_object(oid_to_hex(hex, &oid), &oid, options);
+    }
+    free(line);
+}
+
+/**
+ * @brief: Print the object found by the enumeration of all the objects
+ * @param oid: The id of the object
+ * @param data: The options of the batch mode
+ */
+static void cat_file_batch_each(const struct object_id * oid, void * data){
+    char hex[OBJECT_ID_HEX_SIZE + 1];
+    cat_file_batch_object(oid_to_hex(hex, oid), oid, (const struct cat_file_batch_options *)data);
+}
 
 void command_cat_file(int argc, char *argv[]) {
     char current_dir[PATH_MAX];
@@ -49,7 +157,7 @@ void command_cat_file(int argc, char *argv[]) {
 
     struct argparse_description description;
     description._program_name =  NULL;
-    description._usage = "gitlet cat-file <type> <object>\n   or: gitlet cat-file (-e | -p) <object>\n   or: gitlet cat-file (-s | -p) <object>";
+    description._usage = "gitlet cat-file <type> <object>\n   or: gitlet cat-file (-e | -p) <object>\n   or: gitlet cat-file (-s | -p) <object>\n   or: gitlet cat-file (--batch | --batch-check) [--buffer] < <list-of-objects>\n   or: gitlet cat-file (--batch | --batch-check) --batch-all-objects [--buffer] [--unordered]";
     description._description = "Display the contents of an object";
     description._epilog = NULL;
 
@@ -57,6 +165,11 @@ void command_cat_file(int argc, char *argv[]) {
     bool p_flag = false;
     bool s_flag = false;
     bool e_flag = false;
+    bool batch_flag = false;
+    bool batch_check_flag = false;
+    bool buffer_flag = false;
+    bool batch_all_objects_flag = false;
+    bool unordered_flag = false;
 
     struct argparse_option options[] = {
         OPTION_GROUP("Options"),
@@ -65,6 +178,11 @@ void command_cat_file(int argc, char *argv[]) {
         OPTION_BOOLEAN('p', NULL, "pretty-print the contents of the object", &p_flag, NULL, 0),
         OPTION_BOOLEAN('s', NULL, "show object size", &s_flag, NULL, 0),
         OPTION_BOOLEAN('e', NULL, "check if <object> exists", &e_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "batch", "show the info and content of the objects from stdin", &batch_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "batch-check", "show the info of the objects from stdin", &batch_check_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "buffer", "buffer the output of the batch until the end of the input", &buffer_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "batch-all-objects", "show all the objects in the repository instead of the objects from stdin", &batch_all_objects_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "unordered", "show the objects of --batch-all-objects in the storage order instead of the id order", &unordered_flag, NULL, 0),
         OPTION_GROUP_END(),
         OPTION_END()
     };
@@ -74,16 +192,43 @@ void command_cat_file(int argc, char *argv[]) {
 
     if (argc == 0){
         argparse_parse(&argparse, 1, (char *[]){"-h"});
+    }else if (str_start_with(argv[argc - 1], "--batch") || str_equals(argv[argc - 1], "--buffer") 
+        || str_equals(argv[argc - 1], "--unordered")){
+        // the batch mode reads the objects from stdin instead of the arguments
+        argparse_parse(&argparse, argc, argv);
+
+        if (batch_flag && batch_check_flag){
+            gitlet_panic("options \'--batch\' and \'--batch-check\' cannot be used together");
+        }
+        if (!batch_flag && !batch_check_flag){
+            gitlet_panic("\'--buffer\', \'--batch-all-objects\' and \'--unordered\' require \'--batch\' or \'--batch-check\'");
+        }
+        if (unordered_flag && !batch_all_objects_flag){
+            gitlet_panic("\'--unordered\' requires \'--batch-all-objects\'");
+        }
+        if (t_flag || p_flag || s_flag || e_flag){
+            gitlet_panic("options \'-t\', \'-p\', \'-s\' and \'-e\' cannot be used in the batch mode");
+        }
+
+        struct repository repo;
+        repository_object_init(&repo, current_dir, true);
+        struct cat_file_batch_options batch_options = {batch_flag, buffer_flag};
+        setvbuf(stdout, NULL, _IOFBF, CAT_FILE_BATCH_BUFFER_SIZE);
+        if (batch_all_objects_flag){
+            object_for_each(cat_file_batch_each, &batch_options, !unordered_flag);
+        }else{
+            cat_file_batch(&batch_options);
+        }
+        if (fflush(stdout) != 0){
+            gitlet_panic("Failed to write the object content");
+        }
     }else{
         const char * sha1 = argv[argc - 1];
-        
-        if (!isxdigit(sha1[0]) || strlen(sha1) != 40){
-            // Make sure the last argument is not  help flag
-            if (strcmp(sha1, "-h") == 0 || strcmp(sha1, "--help") == 0){
-                argparse_parse(&argparse, 1, (char *[]){"-h"});
-            }else{
-                gitlet_panic("Not a valid object name: %s", sha1);
-            }
+        struct object_id oid;
+
+        // Make sure the last argument is not  help flag
+        if (strcmp(sha1, "-h") == 0 || strcmp(sha1, "--help") == 0){
+            argparse_parse(&argparse, 1, (char *[]){"-h"});
         }
         if (argc < 2){
             gitlet_panic("only two arguments allowed in <type> <object> mode, not 1");
@@ -107,48 +252,50 @@ void command_cat_file(int argc, char *argv[]) {
         struct repository repo;
         repository_object_init(&repo, current_dir, true);
 
-        if (e_flag){
-            strcat(current_dir, "/.gitlet/objects/");
-            strncpy(current_dir + strlen(current_dir), sha1, 2);
-            strcat(current_dir, "/");
-            strncpy(current_dir + strlen(current_dir), sha1 + 2, 38);
+        // the object can be named by its full id or a unique prefix of it
+        switch (object_resolve_name(&oid, sha1)){
+            case OBJECT_NAME_FOUND:
+                break;
+            case OBJECT_NAME_AMBIGUOUS:
+                gitlet_panic("short object ID %s is ambiguous", sha1);
+                break;
+            default:
+                gitlet_panic("Not a valid object name: %s", sha1);
+        }
 
-            if (exists(current_dir)){
+        if (e_flag){
+            if (object_exists(&oid)){
                 return;
             }else{
                 gitlet_panic("fatal: Not a valid object name %s", sha1);
             }
         }
 
-        // Read the object
+        /**
+         * Pretty print streams the object content to stdout chunk by chunk,
+         * so the object is never materialized in memory.
+         */
+        if (p_flag){
+            struct object_stream stream;
+            object_stream_open(&stream, &oid);
+            cat_file_stream_content(&stream);
+            object_stream_close(&stream);
+            return;
+        }
+
+        // Type and size only need the object header
         struct object obj;
-        object_read(&obj, sha1);
+        object_read_header(&obj, &oid);
 
         if (t_flag){
-            switch (obj.type){
-                case OBJECT_TYPE_BLOB:
-                    printf("blob\n");
-                    break;
-                case OBJECT_TYPE_TREE:
-                    printf("tree\n");
-                    break;
-                case OBJECT_TYPE_COMMIT:
-                    printf("commit\n");
-                    break;
-                case OBJECT_TYPE_TAG:
-                    printf("tag\n");
-                    break;
-                default:
-                    gitlet_panic("Unknown object type: %s", obj.type);
+            const char * type_name = object_type_name(obj.type);
+            if (type_name == NULL){
+                gitlet_panic("Unknown object type: %d", obj.type);
             }
-        }
-        else if (p_flag){
-            printf("%s", obj.content);
+            printf("%s\n", type_name);
         }
         else if (s_flag){
-            printf("%llu\n", obj.file_size);
+            printf("%llu\n", (unsigned long long)obj.file_size);
         }
-        
-        free(obj.content);
     }
 }
\ No newline at end of file
@@ -22,8 +22,107 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <argparse.h>
+
 #include <command/check-ignore.h>
+#include <object/ignore.h>
+#include <object/index.h>
+#include <object/repository.h>
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
 
+// gitlet check-ignore [-v] [-n] [--] <pathname>...
 void command_check_ignore(int argc, char *argv[]) {
-    
-}
\ No newline at end of file
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet check-ignore [-v] [-n] [--] <pathname>...";
+    description._description = "Debug the ignore rules of .gitletignore and .gitlet/info/exclude";
+    description._epilog = "The tracked paths are never ignored, so they are not shown.";
+
+    bool verbose_flag = false;
+    bool non_matching_flag = false;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('v', "verbose", "output the matching pattern of every path", &verbose_flag, NULL, 0),
+        OPTION_BOOLEAN('n', "non-matching", "show the paths not matching any pattern, with -v", &non_matching_flag, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    // the options come before the paths, or before "--"
+    int option_count = 0;
+    while (option_count < argc && str_start_with(argv[option_count], "-") && !str_equals(argv[option_count], "--")){
+        option_count++;
+    }
+    if (option_count != 0){
+        argparse_parse(&argparse, option_count, argv);
+    }
+    int path_start = option_count < argc && str_equals(argv[option_count], "--") ? option_count + 1 : option_count;
+    if (path_start >= argc){
+        gitlet_panic("no path specified");
+    }
+    if (non_matching_flag && !verbose_flag){
+        gitlet_panic("--non-matching is only valid with --verbose");
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    struct index index;
+    index_read(&index);
+    struct ignore ignore;
+    ignore_init(&ignore);
+
+    size_t ignored_count = 0;
+    for (int i = path_start; i < argc; i++){
+        char path[PATH_MAX];
+        worktree_normalize_pathspec(path, argv[i]);
+        size_t length = strlen(path);
+        struct stat status;
+        bool is_directory = str_end_with(argv[i], "/") || (lstat(path, &status) == 0 && S_ISDIR(status.st_mode));
+
+        // like git, a negative pattern only counts with -v, which shows what decided the path
+        const struct ignore_rules * rules = NULL;
+        const struct ignore_pattern * pattern = NULL;
+        if (length != 0 && index_find(&index, path) == NULL){
+            ignore_is_excluded(&ignore, path, length, is_directory, &rules, &pattern);
+        }
+        if (pattern != NULL && pattern->negative && !verbose_flag){
+            pattern = NULL;
+        }
+        if (pattern != NULL && verbose_flag){
+            printf("%s:%zu:%s\t%s\n", rules->source, pattern->line, pattern->text, argv[i]);
+        }else if (pattern != NULL){
+            printf("%s\n", argv[i]);
+        }else if (non_matching_flag){
+            printf("::\t%s\n", argv[i]);
+        }
+        ignored_count += pattern != NULL ? 1 : 0;
+    }
+
+    ignore_release(&ignore);
+    index_release(&index);
+    if (ignored_count == 0){
+        exit(EXIT_FAILURE);
+    }
+}
@@ -34,12 +34,16 @@
 #include <command/cat-file.h>
 #include <command/check-ignore.h>
 #include <command/checkout.h>
+#include <command/fsck.h>
+#include <command/fsmonitor.h>
+#include <command/gc.h>
 #include <command/hash-object.h>
 #include <command/help.h>
 #include <command/init.h>
 #include <command/log.h>
 #include <command/ls-files.h>
 #include <command/ls-tree.h>
+#include <command/pack-objects.h>
 #include <command/rev-parse.h>
 #include <command/rm.h>
 #include <command/show-ref.h>
@@ -62,12 +66,16 @@ static const struct command commands_list[] = {
     {"check-ignore",    command_check_ignore},
     {"checkout",        command_checkout},
     {"commit",          command_commit},
+    {"fsck",            command_fsck},
+    {"fsmonitor",       command_fsmonitor},
+    {"gc",              command_gc},
     {"hash-object",     command_hash_object},
     {"help",            command_help},
     {"init",            command_init},
     {"log",             command_log},
     {"ls-files",        command_ls_files},
     {"ls-tree",         command_ls_tree},
+    {"pack-objects",    command_pack_objects},
     {"rev-parse",       command_rev_parse},
     {"rm",              command_rm},
     {"show-ref",        command_show_ref},
@@ -0,0 +1,526 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <argparse.h>
+
+#include <command/fsck.h>
+#include <object/index.h>
+#include <object/object.h>
+#include <object/pack.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the longest problem reported for one object
+#define FSCK_MESSAGE_SIZE       256
+// the mode of the submodule entry in the tree
+#define FSCK_MODE_GITLINK       0160000
+
+/**
+ * @brief: The problem found in an object
+ * @param index: The index of the object in the sorted ids
+ * @param message: The line reported for the problem
+ */
+struct fsck_problem{
+    size_t index;
+    char message[FSCK_MESSAGE_SIZE];
+};
+
+/**
+ * @brief: The problems found by one worker thread
+ * @param problems: The problems
+ * @param count: The number of the problems
+ * @param capacity: The capacity of the problems
+ */
+struct fsck_problem_list{
+    struct fsck_problem * problems;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The state of the check shared by the worker threads
+ * @param ids: The sorted ids of all the objects
+ * @param count: The number of the objects
+ * @param capacity: The capacity of the ids
+ * @param lists: The problems found by every worker
+ * @param checked: The number of the objects checked so far
+ * @param show_progress: Whether the first worker prints the progress
+ * @param shown_percent: The percentage printed last time
+ */
+struct fsck_state{
+    struct object_id * ids;
+    size_t count;
+    size_t capacity;
+    struct fsck_problem_list * lists;
+    atomic_size_t checked;
+    bool show_progress;
+    int shown_percent;
+};
+
+/**
+ * @brief: Record the problem of the object
+ * @param list: The problems of the worker
+ * @param index: The index of the object
+ * @param format: The format of the message
+ */
+static void fsck_report(struct fsck_problem_list * list, size_t index, const char * format, ...){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->problems = (struct fsck_problem *)realloc(list->problems, list->capacity * sizeof(struct fsck_problem));
+        if (list->problems == NULL){
+            gitlet_panic("Failed to allocate memory for the problems");
+        }
+    }
+    struct fsck_problem * problem = &list->problems[list->count++];
+    problem->index = index;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(problem->message, FSCK_MESSAGE_SIZE, format, args);
+    va_end(args);
+}
+
+/**
+ * @brief: Check whether the object is in the repository
+ * @param state: The state of the check
+ * @param oid: The id of the object
+ * @return: true if the object is among the ids, false otherwise
+ */
+static bool fsck_has_object(const struct fsck_state * state, const struct object_id * oid){
+    size_t low = 0;
+    size_t high = state->count;
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+        int compare = oid_compare(&state->ids[middle], oid);
+        if (compare == 0){
+            return true;
+        }else if (compare < 0){
+            low = middle + 1;
+        }else{
+            high = middle;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief: Parse the hex id at the beginning of the line, and check that the object exists
+ * @param state: The state of the check
+ * @param list: The problems of the worker
+ * @param index: The index of the object holding the line
+ * @param hex: The hex id in the line
+ * @param end: The end of the content
+ * @return: true if the line holds a valid hex id followed by a newline, false otherwise
+ */
+static bool fsck_check_link(const struct fsck_state * state, struct fsck_problem_list * list, size_t index,
+    const char * hex, const char * end){
+    char hex_buffer[OBJECT_ID_HEX_SIZE + 1];
+    struct object_id oid;
+    if (end - hex < OBJECT_ID_HEX_SIZE + 1 || hex[OBJECT_ID_HEX_SIZE] != '\n'){
+        return false;
+    }
+    memcpy(hex_buffer, hex, OBJECT_ID_HEX_SIZE);
+    hex_buffer[OBJECT_ID_HEX_SIZE] = '\0';
+    if (!oid_from_hex(&oid, hex_buffer)){
+        return false;
+    }
+    if (!fsck_has_object(state, &oid)){
+        char self_hex[OBJECT_ID_HEX_SIZE + 1];
+        fsck_report(list, index, "broken link from %s to %s", oid_to_hex(self_hex, &state->ids[index]), hex_buffer);
+    }
+    return true;
+}
+
+/**
+ * @brief: Get the next line of the content
+ * @param line: The beginning of the line
+ * @param end: The end of the content
+ * @return: The beginning of the next line, NULL if the line does not end with a newline
+ */
+static const char * fsck_next_line(const char * line, const char * end){
+    const char * newline = memchr(line, '\n', (size_t)(end - line));
+    return newline == NULL ? NULL : newline + 1;
+}
+
+/**
+ * @brief: Check the header of the commit, the tree, the parents, the author and the committer
+ * @return: The problem of the commit, NULL if it is well formed
+ */
+static const char * fsck_check_commit(const struct fsck_state * state, struct fsck_problem_list * list, size_t index,
+    const char * content, size_t size){
+    const char * end = content + size;
+    const char * line = content;
+    if (size < 5 || memcmp(line, "tree ", 5) != 0 || !fsck_check_link(state, list, index, line + 5, end)){
+        return "invalid tree line";
+    }
+    line += 5 + OBJECT_ID_HEX_SIZE + 1;
+    while (end - line > 7 && memcmp(line, "parent ", 7) == 0){
+        if (!fsck_check_link(state, list, index, line + 7, end)){
+            return "invalid parent line";
+        }
+        line += 7 + OBJECT_ID_HEX_SIZE + 1;
+    }
+    if (end - line < 7 || memcmp(line, "author ", 7) != 0 || (line = fsck_next_line(line, end)) == NULL){
+        return "invalid author line";
+    }
+    if (end - line < 10 || memcmp(line, "committer ", 10) != 0 || fsck_next_line(line, end) == NULL){
+        return "invalid committer line";
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Check the header of the tag, the tagged object, its type and the tag name
+ * @return: The problem of the tag, NULL if it is well formed
+ */
+static const char * fsck_check_tag(const struct fsck_state * state, struct fsck_problem_list * list, size_t index,
+    const char * content, size_t size){
+    const char * end = content + size;
+    const char * line = content;
+    if (size < 7 || memcmp(line, "object ", 7) != 0 || !fsck_check_link(state, list, index, line + 7, end)){
+        return "invalid object line";
+    }
+    line += 7 + OBJECT_ID_HEX_SIZE + 1;
+    const char * next = NULL;
+    if (end - line < 5 || memcmp(line, "type ", 5) != 0 || (next = fsck_next_line(line, end)) == NULL){
+        return "invalid type line";
+    }
+    bool known_type = false;
+    for (enum object_type type = OBJECT_TYPE_BLOB; type < OBJECT_TYPE_UNKNOWN; type++){
+        const char * name = object_type_name(type);
+        known_type = known_type || (strlen(name) == (size_t)(next - line - 6) && memcmp(name, line + 5, strlen(name)) == 0);
+    }
+    if (!known_type){
+        return "invalid type line";
+    }
+    line = next;
+    if (end - line < 5 || memcmp(line, "tag ", 4) != 0 || line[4] == '\n' || fsck_next_line(line, end) == NULL){
+        return "invalid tag line";
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Check the entries of the tree, the modes, the names and their order
+ * @return: The problem of the tree, NULL if it is well formed
+ */
+static const char * fsck_check_tree(const struct fsck_state * state, struct fsck_problem_list * list, size_t index,
+    const char * content, size_t size){
+    const char * end = content + size;
+    const char * current = content;
+    const char * last_name = NULL;
+    size_t last_length = 0;
+    bool last_is_tree = false;
+
+    while (current < end){
+        // every entry is "<mode> <name>\0" followed by the raw id
+        const char * space = memchr(current, ' ', (size_t)(end - current));
+        const char * name_end = space == NULL ? NULL : memchr(space, '\0', (size_t)(end - space));
+        if (name_end == NULL || (size_t)(end - name_end - 1) < OBJECT_ID_RAW_SIZE){
+            return "truncated entry";
+        }
+        if (space == current || *current == '0'){
+            return "bad file mode";
+        }
+        unsigned int mode = 0;
+        for (const char * digit = current; digit < space; digit++){
+            if (*digit < '0' || *digit > '7'){
+                return "bad file mode";
+            }
+            mode = mode * 8 + (unsigned int)(*digit - '0');
+        }
+        if (mode != 0100644 && mode != 0100755 && mode != 0100664 && mode != 0120000 
+            && mode != 040000 && mode != FSCK_MODE_GITLINK){
+            return "bad file mode";
+        }
+
+        const char * name = space + 1;
+        size_t name_length = (size_t)(name_end - name);
+        if (name_length == 0 || memchr(name, '/', name_length) != NULL 
+            || (name_length == 1 && name[0] == '.') || (name_length == 2 && memcmp(name, "..", 2) == 0)){
+            return "bad entry name";
+        }
+
+        /**
+         * The entries are sorted like git, as if the name of a tree ended 
+         * with a slash, and no two entries share a name.
+         */
+        bool is_tree = S_ISDIR(mode);
+        if (last_name != NULL){
+            size_t common = last_length < name_length ? last_length : name_length;
+            int compare = memcmp(last_name, name, common);
+            if (compare == 0 && last_length == name_length){
+                return "duplicate entries";
+            }
+            if (compare == 0){
+                unsigned char last_next = last_length > common ? (unsigned char)last_name[common] : (last_is_tree ? '/' : '\0');
+                unsigned char next = name_length > common ? (unsigned char)name[common] : (is_tree ? '/' : '\0');
+                compare = (int)last_next - (int)next;
+            }
+            if (compare > 0){
+                return "entries not sorted";
+            }
+        }
+        last_name = name;
+        last_length = name_length;
+        last_is_tree = is_tree;
+
+        struct object_id oid;
+        memcpy(oid.hash, name_end + 1, OBJECT_ID_RAW_SIZE);
+        if (mode != FSCK_MODE_GITLINK && !fsck_has_object(state, &oid)){
+            char self_hex[OBJECT_ID_HEX_SIZE + 1];
+            char hex[OBJECT_ID_HEX_SIZE + 1];
+            fsck_report(list, index, "broken link from %s to %s", oid_to_hex(self_hex, &state->ids[index]), 
+                oid_to_hex(hex, &oid));
+        }
+        current = name_end + 1 + OBJECT_ID_RAW_SIZE;
+    }
+    return NULL;
+}
+
+/**
+ * @brief: Print the progress of the check
+ * @param state: The state of the check
+ * @param checked: The number of the objects checked
+ * @param done: Whether the check is done
+ */
+static void fsck_show_progress(struct fsck_state * state, size_t checked, bool done){
+    int percent = state->count == 0 ? 100 : (int)(checked * 100 / state->count);
+    if (!done && percent == state->shown_percent){
+        return;
+    }
+    state->shown_percent = percent;
+    fprintf(stderr, "\rChecking objects: %3d%% (%zu/%zu)%s", percent, checked, state->count, done ? ", done.\n" : "");
+}
+
+/**
+ * @brief: Verify one object on the worker thread
+ * @param index: The index of the object in the sorted ids
+ * @param worker: The index of the worker thread
+ * @param data: The state of the check
+ */
+static void fsck_check_object(size_t index, unsigned int worker, void * data){
+    struct fsck_state * state = (struct fsck_state *)data;
+    struct fsck_problem_list * list = &state->lists[worker];
+    const struct object_id * oid = &state->ids[index];
+    char hex[OBJECT_ID_HEX_SIZE + 1];
+    oid_to_hex(hex, oid);
+
+    struct object obj;
+    switch (object_verify(&obj, oid)){
+        case OBJECT_VERIFY_MISSING:
+            fsck_report(list, index, "missing %s", hex);
+            break;
+        case OBJECT_VERIFY_CORRUPT:
+            fsck_report(list, index, "corrupt object %s", hex);
+            break;
+        case OBJECT_VERIFY_MISMATCH:
+            fsck_report(list, index, "hash mismatch %s", hex);
+            break;
+        default:{
+            const char * problem = NULL;
+            const char * content = (const char *)obj.content;
+            if (obj.type == OBJECT_TYPE_COMMIT){
+                problem = fsck_check_commit(state, list, index, content, (size_t)obj.file_size);
+            }else if (obj.type == OBJECT_TYPE_TAG){
+                problem = fsck_check_tag(state, list, index, content, (size_t)obj.file_size);
+            }else if (obj.type == OBJECT_TYPE_TREE){
+                problem = fsck_check_tree(state, list, index, content, (size_t)obj.file_size);
+            }
+            if (problem != NULL){
+                fsck_report(list, index, "error in %s %s: %s", object_type_name(obj.type), hex, problem);
+            }
+            object_release(&obj);
+            break;
+        }
+    }
+
+    size_t checked = atomic_fetch_add(&state->checked, 1) + 1;
+    if (state->show_progress && worker == 0){
+        fsck_show_progress(state, checked, false);
+    }
+}
+
+/**
+ * @brief: Report the broken pack
+ * @param path: The path of the pack
+ * @param data: The number of the problems
+ */
+static void fsck_report_pack(const char * path, void * data){
+    (*(size_t *)data)++;
+    fprintf(stdout, "broken pack %s\n", path);
+}
+
+static int fsck_problem_compare(const void * left, const void * right){
+    const struct fsck_problem * left_problem = (const struct fsck_problem *)left;
+    const struct fsck_problem * right_problem = (const struct fsck_problem *)right;
+    if (left_problem->index != right_problem->index){
+        return left_problem->index < right_problem->index ? -1 : 1;
+    }
+    // qsort is not stable, the problems of the same object are ordered by the message
+    return strcmp(left_problem->message, right_problem->message);
+}
+
+/**
+ * @brief: Append the id to the list of all the objects
+ * @param oid: The id of the object
+ * @param data: The state of the check
+ */
+static void fsck_collect_object(const struct object_id * oid, void * data){
+    struct fsck_state * state = (struct fsck_state *)data;
+    if (state->count == state->capacity){
+        state->capacity = state->capacity == 0 ? 64 : state->capacity * 2;
+        state->ids = (struct object_id *)realloc(state->ids, state->capacity * sizeof(struct object_id));
+        if (state->ids == NULL){
+            gitlet_panic("Failed to allocate memory for the object ids");
+        }
+    }
+    state->ids[state->count++] = *oid;
+}
+
+/**
+ * @brief: Check that the blob of every entry of the index is in the repository
+ * @param state: The state of the check, with all the ids collected
+ * @return: The number of the entries whose blob is missing
+ */
+static size_t fsck_check_index(const struct fsck_state * state){
+    struct index index;
+    index_read(&index);
+    size_t missing = 0;
+    for (size_t i = 0; i < index.count; i++){
+        const struct index_entry * entry = index.entries[i];
+        if (!fsck_has_object(state, &entry->oid)){
+            char hex[OBJECT_ID_HEX_SIZE + 1];
+            fprintf(stdout, "missing blob %s in index for %s\n", oid_to_hex(hex, &entry->oid), entry->path);
+            missing++;
+        }
+    }
+    index_release(&index);
+    return missing;
+}
+
+// gitlet fsck [--threads <n>] [--progress | --no-progress]
+void command_fsck(int argc, char *argv[]) {
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet fsck [--threads <n>] [--progress | --no-progress]";
+    description._description = "Verify the connectivity and validity of the objects in the database";
+    description._epilog = NULL;
+
+    int threads = 0;
+    bool progress_flag = false;
+    bool no_progress_flag = false;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_INT(0, "threads", "the number of the threads verifying the objects, 0 for all the processors", &threads, NULL, 0),
+        OPTION_BOOLEAN(0, "progress", "show the progress even if stderr is not a terminal", &progress_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "no-progress", "never show the progress", &no_progress_flag, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+    if (argc != 0){
+        argparse_parse(&argparse, argc, argv);
+    }
+    if (threads < 0){
+        gitlet_panic("The number of the threads must not be negative");
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    /**
+     * The packs are verified as a whole first and a broken one is dropped, 
+     * so the objects are never inflated out of it. Every object is then 
+     * inflated and hashed again on the workers, and the links of the trees,
+     * commits and tags are looked up in the sorted list of all the ids, 
+     * and so are the blobs of the index entries.
+     */
+    size_t problem_count = 0;
+    pack_verify(fsck_report_pack, &problem_count);
+
+    struct fsck_state state;
+    memset(&state, 0, sizeof(struct fsck_state));
+    object_for_each(fsck_collect_object, &state, true);
+    atomic_init(&state.checked, 0);
+    state.show_progress = !no_progress_flag && (progress_flag || isatty(STDERR_FILENO));
+    state.shown_percent = -1;
+
+    unsigned int workers = threads == 0 ? parallel_cpu_count() : (unsigned int)threads;
+    state.lists = (struct fsck_problem_list *)calloc(workers, sizeof(struct fsck_problem_list));
+    if (state.lists == NULL){
+        gitlet_panic("Failed to allocate memory for the problems");
+    }
+    parallel_for(workers, state.count, fsck_check_object, &state);
+    if (state.show_progress){
+        fsck_show_progress(&state, state.count, true);
+    }
+
+    // the problems are reported in the order of the ids, whichever worker found them
+    struct fsck_problem_list all;
+    memset(&all, 0, sizeof(struct fsck_problem_list));
+    for (unsigned int i = 0; i < workers; i++){
+        for (size_t j = 0; j < state.lists[i].count; j++){
+            fsck_report(&all, state.lists[i].problems[j].index, "%s", state.lists[i].problems[j].message);
+        }
+        free(state.lists[i].problems);
+    }
+    qsort(all.problems, all.count, sizeof(struct fsck_problem), fsck_problem_compare);
+    for (size_t i = 0; i < all.count; i++){
+        fprintf(stdout, "%s\n", all.problems[i].message);
+    }
+    problem_count += all.count;
+
+    // the staged blobs are reachable from the index alone, like git
+    problem_count += fsck_check_index(&state);
+
+    free(all.problems);
+    free(state.lists);
+    free(state.ids);
+    fflush(stdout);
+    if (problem_count != 0){
+        exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,617 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include <argparse.h>
+
+#include <command/fsmonitor.h>
+#include <object/fsmonitor.h>
+#include <object/repository.h>
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the milliseconds to wait for the daemon started in the background to answer
+#define FSMONITOR_START_TIMEOUT_MS  10000
+// the milliseconds between the checks of the daemon being started
+#define FSMONITOR_START_POLL_MS     10
+
+#ifdef __linux__
+
+// the number of the changes kept for the queries, the older half is dropped beyond it
+#define FSMONITOR_MAX_EVENTS        (1 << 18)
+// the size of the buffer the inotify events are read into
+#define FSMONITOR_EVENT_BUFFER_SIZE (64 * 1024)
+// the longest request line of a client
+#define FSMONITOR_REQUEST_MAX       (FSMONITOR_TOKEN_MAX + 16)
+// the events of the watched directories, any change of an entry makes its path dirty
+#define FSMONITOR_WATCH_MASK        (IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE \
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+
+/**
+ * @brief: The path changed, in the order of the changes
+ * @param sequence: The sequence number of the change
+ * @param path: The path relative to the working tree
+ */
+struct fsmonitor_event{
+    uint64_t sequence;
+    char * path;
+};
+
+/**
+ * @brief: The state of the daemon
+ * @param inotify_fd: The inotify instance watching the directories
+ * @param listen_fd: The socket the clients connect to
+ * @param watches: The path of the directory of every watch descriptor, NULL when unused
+ * @param watch_capacity: The capacity of the watches
+ * @param instance: The identity of this run of the daemon, the prefix of its tokens
+ * @param sequence: The sequence number of the last change
+ * @param stale_before: The tokens before this sequence number miss some changes
+ * @param events: The changes kept for the queries
+ * @param event_count: The number of the changes
+ * @param event_capacity: The capacity of the changes
+ * @param running: Whether the daemon keeps serving
+ */
+struct fsmonitor_daemon{
+    int inotify_fd;
+    int listen_fd;
+    char ** watches;
+    size_t watch_capacity;
+    char instance[64];
+    uint64_t sequence;
+    uint64_t stale_before;
+    struct fsmonitor_event * events;
+    size_t event_count;
+    size_t event_capacity;
+    bool running;
+};
+
+/**
+ * @brief: The directory being watched with the walk of the working tree
+ * @param daemon: The daemon
+ * @param record: Whether every path found is a change, for a directory created after the start
+ */
+struct fsmonitor_watch_walk{
+    struct fsmonitor_daemon * daemon;
+    bool record;
+};
+
+// whether the socket of the daemon is to be removed at the exit
+static bool fsmonitor_socket_owned = false;
+
+/**
+ * @brief: Remove the socket at the exit of the daemon, also after a fatal error
+ */
+static void fsmonitor_remove_socket(void){
+    if (fsmonitor_socket_owned){
+        unlink(FSMONITOR_SOCKET_PATH);
+        fsmonitor_socket_owned = false;
+    }
+}
+
+/**
+ * @brief: Record the change of the path
+ * @param daemon: The daemon
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ * @note: Beyond FSMONITOR_MAX_EVENTS the older half of the changes is dropped,
+ *        and the tokens before the last dropped change become stale.
+ */
+static void fsmonitor_record(struct fsmonitor_daemon * daemon, const char * path, size_t length){
+    if (daemon->event_count == FSMONITOR_MAX_EVENTS){
+        size_t dropped = FSMONITOR_MAX_EVENTS / 2;
+        for (size_t i = 0; i < dropped; i++){
+            free(daemon->events[i].path);
+        }
+        daemon->stale_before = daemon->events[dropped - 1].sequence;
+        memmove(daemon->events, daemon->events + dropped, 
+            (daemon->event_count - dropped) * sizeof(struct fsmonitor_event));
+        daemon->event_count -= dropped;
+    }
+    if (daemon->event_count == daemon->event_capacity){
+        daemon->event_capacity = daemon->event_capacity == 0 ? 1024 : daemon->event_capacity * 2;
+        daemon->events = (struct fsmonitor_event *)realloc(daemon->events, 
+            daemon->event_capacity * sizeof(struct fsmonitor_event));
+        if (daemon->events == NULL){
+            gitlet_panic("Failed to allocate memory for the changes");
+        }
+    }
+    struct fsmonitor_event * event = &daemon->events[daemon->event_count++];
+    event->sequence = ++daemon->sequence;
+    event->path = strndup(path, length);
+    if (event->path == NULL){
+        gitlet_panic("Failed to allocate memory for the changes");
+    }
+}
+
+/**
+ * @brief: Watch the directory
+ * @param daemon: The daemon
+ * @param path: The path of the directory relative to the working tree, "" for the top
+ */
+static void fsmonitor_add_watch(struct fsmonitor_daemon * daemon, const char * path){
+    int wd = inotify_add_watch(daemon->inotify_fd, path[0] == '\0' ? "." : path, FSMONITOR_WATCH_MASK);
+    if (wd < 0 && errno == ENOSPC){
+        gitlet_panic("inotify watch limit reached, raise fs.inotify.max_user_watches");
+    }
+    if (wd < 0){
+        // the directory is gone already, its parent reports it
+        return;
+    }
+    if ((size_t)wd >= daemon->watch_capacity){
+        size_t capacity = daemon->watch_capacity == 0 ? 1024 : daemon->watch_capacity;
+        while (capacity <= (size_t)wd){
+            capacity *= 2;
+        }
+        daemon->watches = (char **)realloc(daemon->watches, capacity * sizeof(char *));
+        if (daemon->watches == NULL){
+            gitlet_panic("Failed to allocate memory for the watches");
+        }
+        memset(daemon->watches + daemon->watch_capacity, 0, (capacity - daemon->watch_capacity) * sizeof(char *));
+        daemon->watch_capacity = capacity;
+    }
+    free(daemon->watches[wd]);
+    if ((daemon->watches[wd] = strdup(path)) == NULL){
+        gitlet_panic("Failed to allocate memory for the watches");
+    }
+}
+
+/**
+ * @brief: Watch the directory found by the walk, and record the path if asked
+ */
+static bool fsmonitor_watch_entry(const char * path, size_t length, bool is_directory, void * data){
+    struct fsmonitor_watch_walk * walk = (struct fsmonitor_watch_walk *)data;
+    if (is_directory){
+        fsmonitor_add_watch(walk->daemon, path);
+    }
+    if (walk->record){
+        fsmonitor_record(walk->daemon, path, length);
+    }
+    return true;
+}
+
+/**
+ * @brief: Watch the directory and every directory under it
+ * @param daemon: The daemon
+ * @param path: The path of the directory relative to the working tree, "" for the top
+ * @param record: Whether every path under it is a change
+ * @note: The directory is watched before it is walked, so a file created in 
+ *        it meanwhile is either found by the walk or reported by the watch.
+ */
+static void fsmonitor_watch_tree(struct fsmonitor_daemon * daemon, const char * path, bool record){
+    fsmonitor_add_watch(daemon, path);
+    struct fsmonitor_watch_walk walk = {daemon, record};
+    worktree_walk(path, fsmonitor_watch_entry, &walk);
+}
+
+/**
+ * @brief: Stop watching the directory moved away and every directory under it,
+ *         its new place is watched again when it is moved into the working tree
+ * @param daemon: The daemon
+ * @param path: The old path of the directory
+ * @param length: The length of the path
+ */
+static void fsmonitor_unwatch_tree(struct fsmonitor_daemon * daemon, const char * path, size_t length){
+    for (size_t wd = 0; wd < daemon->watch_capacity; wd++){
+        const char * watch = daemon->watches[wd];
+        if (watch != NULL && worktree_path_matches(watch, strlen(watch), path, length)){
+            inotify_rm_watch(daemon->inotify_fd, (int)wd);
+            free(daemon->watches[wd]);
+            daemon->watches[wd] = NULL;
+        }
+    }
+}
+
+/**
+ * @brief: Handle the inotify event
+ * @param daemon: The daemon
+ * @param event: The event
+ */
+static void fsmonitor_handle_event(struct fsmonitor_daemon * daemon, const struct inotify_event * event){
+    if (event->mask & IN_Q_OVERFLOW){
+        // some changes are lost, so every token given out so far is stale
+        daemon->stale_before = ++daemon->sequence;
+        return;
+    }
+    if (event->wd < 0 || (size_t)event->wd >= daemon->watch_capacity || daemon->watches[event->wd] == NULL){
+        return;
+    }
+    const char * directory = daemon->watches[event->wd];
+    if (event->mask & IN_IGNORED){
+        free(daemon->watches[event->wd]);
+        daemon->watches[event->wd] = NULL;
+        return;
+    }
+    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)){
+        // the working tree itself is gone, anything else is reported by its parent
+        if (directory[0] == '\0'){
+            daemon->running = false;
+        }
+        return;
+    }
+    const char * name = event->len == 0 ? "" : event->name;
+    if (name[0] == '\0' || str_equals(name, ".gitlet") || str_equals(name, ".git")){
+        return;
+    }
+
+    char path[PATH_MAX];
+    size_t directory_length = strlen(directory);
+    size_t name_length = strlen(name);
+    size_t length = directory_length == 0 ? name_length : directory_length + 1 + name_length;
+    if (length + 1 > PATH_MAX){
+        return;
+    }
+    if (directory_length != 0){
+        memcpy(path, directory, directory_length);
+        path[directory_length] = '/';
+    }
+    memcpy(path + length - name_length, name, name_length + 1);
+
+    fsmonitor_record(daemon, path, length);
+    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))){
+        fsmonitor_watch_tree(daemon, path, true);
+    }else if ((event->mask & IN_ISDIR) && (event->mask & IN_MOVED_FROM)){
+        fsmonitor_unwatch_tree(daemon, path, length);
+    }
+}
+
+/**
+ * @brief: Handle all the inotify events queued so far
+ * @param daemon: The daemon
+ */
+static void fsmonitor_drain_events(struct fsmonitor_daemon * daemon){
+    static uint64_t buffer[FSMONITOR_EVENT_BUFFER_SIZE / sizeof(uint64_t)];
+    ssize_t read_size = 0;
+    while ((read_size = read(daemon->inotify_fd, buffer, sizeof(buffer))) > 0){
+        for (ssize_t offset = 0; offset < read_size; ){
+            const struct inotify_event * event = (const struct inotify_event *)((const char *)buffer + offset);
+            offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+            fsmonitor_handle_event(daemon, event);
+        }
+    }
+}
+
+/**
+ * @brief: Compare the paths for the sort
+ */
+static int fsmonitor_compare_path(const void * left, const void * right){
+    return strcmp(*(const char * const *)left, *(const char * const *)right);
+}
+
+/**
+ * @brief: Send the whole buffer to the client
+ * @return: true if everything is sent
+ */
+static bool fsmonitor_send(int fd, const char * data, size_t size){
+    while (size > 0){
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR){
+            continue;
+        }
+        if (sent <= 0){
+            return false;
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return true;
+}
+
+/**
+ * @brief: Reply to the query with the paths changed after the token
+ * @param daemon: The daemon
+ * @param client: The socket of the client
+ * @param token: The token of the client, empty for the first query
+ */
+static void fsmonitor_reply_query(struct fsmonitor_daemon * daemon, int client, const char * token){
+    char reply_header[FSMONITOR_TOKEN_MAX + 16];
+    size_t instance_length = strlen(daemon->instance);
+
+    // the token is "<instance>:<sequence>", the changes after the sequence are asked for
+    bool valid = strncmp(token, daemon->instance, instance_length) == 0 && token[instance_length] == ':';
+    char * end = NULL;
+    unsigned long long sequence = valid ? strtoull(token + instance_length + 1, &end, 10) : 0;
+    valid = valid && end != token + instance_length + 1 && *end == '\0' 
+        && sequence >= daemon->stale_before && sequence <= daemon->sequence;
+
+    int header_length = snprintf(reply_header, sizeof(reply_header), "%s:%llu\n%s\n", daemon->instance, 
+        (unsigned long long)daemon->sequence, valid ? FSMONITOR_REPLY_DIRTY : FSMONITOR_REPLY_FULL);
+    if (!fsmonitor_send(client, reply_header, (size_t)header_length) || !valid){
+        return;
+    }
+
+    // the changes are in the order of the sequence numbers, so the first one after the token is searched
+    size_t low = 0;
+    size_t high = daemon->event_count;
+    while (low < high){
+        size_t middle = low + (high - low) / 2;
+        if (daemon->events[middle].sequence <= sequence){
+            low = middle + 1;
+        }else{
+            high = middle;
+        }
+    }
+    size_t count = daemon->event_count - low;
+    const char ** paths = (const char **)malloc((count + 1) * sizeof(char *));
+    if (paths == NULL){
+        gitlet_panic("Failed to allocate memory for the reply");
+    }
+    for (size_t i = 0; i < count; i++){
+        paths[i] = daemon->events[low + i].path;
+    }
+    qsort(paths, count, sizeof(char *), fsmonitor_compare_path);
+    for (size_t i = 0; i < count; i++){
+        if (i > 0 && str_equals(paths[i - 1], paths[i])){
+            continue;
+        }
+        if (!fsmonitor_send(client, paths[i], strlen(paths[i]) + 1)){
+            break;
+        }
+    }
+    free(paths);
+}
+
+/**
+ * @brief: Serve the client connected to the socket
+ * @param daemon: The daemon
+ */
+static void fsmonitor_serve_client(struct fsmonitor_daemon * daemon){
+    int client = accept4(daemon->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (client < 0){
+        return;
+    }
+    struct timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request[FSMONITOR_REQUEST_MAX];
+    size_t length = 0;
+    ssize_t read_size = 0;
+    while (length < sizeof(request) - 1 && (read_size = read(client, request + length, sizeof(request) - 1 - length)) > 0){
+        length += (size_t)read_size;
+        if (memchr(request, '\n', length) != NULL){
+            break;
+        }
+    }
+    request[length] = '\0';
+    char * newline = strchr(request, '\n');
+    if (newline == NULL){
+        close(client);
+        return;
+    }
+    *newline = '\0';
+
+    // every change finished before the request is in the inotify queue by now
+    fsmonitor_drain_events(daemon);
+    if (str_equals(request, FSMONITOR_REQUEST_QUIT)){
+        daemon->running = false;
+        fsmonitor_remove_socket();
+        fsmonitor_send(client, "ok\n", 3);
+    }else if (str_start_with(request, FSMONITOR_REQUEST_QUERY " ")){
+        fsmonitor_reply_query(daemon, client, request + strlen(FSMONITOR_REQUEST_QUERY " "));
+    }
+    close(client);
+}
+
+/**
+ * @brief: Watch the working tree in the current working directory and serve
+ *         the clients until asked to quit, or until the working tree is gone
+ */
+static void fsmonitor_run(void){
+    signal(SIGPIPE, SIG_IGN);
+
+    struct fsmonitor_daemon daemon;
+    memset(&daemon, 0, sizeof(struct fsmonitor_daemon));
+    daemon.running = true;
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    snprintf(daemon.instance, sizeof(daemon.instance), "%ld.%lld.%ld", 
+        (long)getpid(), (long long)now.tv_sec, (long)now.tv_nsec);
+
+    daemon.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (daemon.inotify_fd < 0){
+        gitlet_panic("Failed to initialize inotify");
+    }
+    fsmonitor_watch_tree(&daemon, "", false);
+
+    // the socket is only bound once the whole tree is watched
+    daemon.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(struct sockaddr_un));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, FSMONITOR_SOCKET_PATH);
+    unlink(FSMONITOR_SOCKET_PATH);
+    if (daemon.listen_fd < 0 || bind(daemon.listen_fd, (struct sockaddr *)&address, sizeof(struct sockaddr_un)) != 0
+        || listen(daemon.listen_fd, 16) != 0){
+        gitlet_panic("Failed to listen on %s", FSMONITOR_SOCKET_PATH);
+    }
+    fsmonitor_socket_owned = true;
+    atexit(fsmonitor_remove_socket);
+
+    struct pollfd fds[2] = {{daemon.inotify_fd, POLLIN, 0}, {daemon.listen_fd, POLLIN, 0}};
+    while (daemon.running){
+        if (poll(fds, 2, -1) < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            gitlet_panic("Failed to wait for the changes");
+        }
+        if (fds[0].revents & POLLIN){
+            fsmonitor_drain_events(&daemon);
+        }
+        if (daemon.running && (fds[1].revents & POLLIN)){
+            fsmonitor_serve_client(&daemon);
+        }
+    }
+
+    fsmonitor_remove_socket();
+    close(daemon.listen_fd);
+    close(daemon.inotify_fd);
+    for (size_t i = 0; i < daemon.watch_capacity; i++){
+        free(daemon.watches[i]);
+    }
+    free(daemon.watches);
+    for (size_t i = 0; i < daemon.event_count; i++){
+        free(daemon.events[i].path);
+    }
+    free(daemon.events);
+}
+
+/**
+ * @brief: Start the daemon in the background, and wait until it answers
+ */
+static void fsmonitor_start(void){
+    struct fsmonitor_changes changes;
+    if (fsmonitor_query(NULL, &changes)){
+        fsmonitor_changes_release(&changes);
+        gitlet_panic("fsmonitor is already running");
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0){
+        gitlet_panic("Failed to start the fsmonitor");
+    }
+    if (pid == 0){
+        // the daemon leaves the session and the pipes of the caller
+        setsid();
+        int null_fd = open("/dev/null", O_RDWR);
+        int log_fd = open(FSMONITOR_LOG_PATH, O_WRONLY | O_CREAT | O_APPEND, 0666);
+        if (null_fd >= 0){
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(log_fd >= 0 ? log_fd : null_fd, STDERR_FILENO);
+        }
+        fsmonitor_run();
+        exit(EXIT_SUCCESS);
+    }
+
+    for (int waited = 0; waited < FSMONITOR_START_TIMEOUT_MS; waited += FSMONITOR_START_POLL_MS){
+        if (fsmonitor_query(NULL, &changes)){
+            fsmonitor_changes_release(&changes);
+            printf("fsmonitor started\n");
+            return;
+        }
+        if (waitpid(pid, NULL, WNOHANG) == pid){
+            break;
+        }
+        usleep(FSMONITOR_START_POLL_MS * 1000);
+    }
+    gitlet_panic("fsmonitor failed to start, see %s", FSMONITOR_LOG_PATH);
+}
+
+#endif
+
+// gitlet fsmonitor (start | run | stop | status)
+void command_fsmonitor(int argc, char *argv[]) {
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet fsmonitor (start | run | stop | status)";
+    description._description = "Watch the working tree so status only checks the changed paths";
+    description._epilog = "start runs the daemon in the background, run in the foreground.\n"
+        "The commands ask it for the changes when core.fsmonitor is true.";
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    if (argc != 1 || str_start_with(argv[0], "-")){
+        argparse_parse(&argparse, 1, (char *[]){"-h"});
+        return;
+    }
+    const char * action = argv[0];
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    if (str_equals(action, "stop")){
+        if (!fsmonitor_stop()){
+            gitlet_panic("fsmonitor is not running");
+        }
+        printf("fsmonitor stopped\n");
+        return;
+    }
+    if (str_equals(action, "status")){
+        struct fsmonitor_changes changes;
+        if (!fsmonitor_query(NULL, &changes)){
+            printf("fsmonitor is not running\n");
+            exit(EXIT_FAILURE);
+        }
+        fsmonitor_changes_release(&changes);
+        printf("fsmonitor is watching %s\n", current_dir);
+        return;
+    }
+#ifdef __linux__
+    if (str_equals(action, "start")){
+        fsmonitor_start();
+        return;
+    }
+    if (str_equals(action, "run")){
+        struct fsmonitor_changes changes;
+        if (fsmonitor_query(NULL, &changes)){
+            fsmonitor_changes_release(&changes);
+            gitlet_panic("fsmonitor is already running");
+        }
+        fsmonitor_run();
+        return;
+    }
+#else
+    if (str_equals(action, "start") || str_equals(action, "run")){
+        gitlet_panic("fsmonitor is only supported on linux");
+    }
+#endif
+    gitlet_panic("Unknown fsmonitor action: %s", action);
+}
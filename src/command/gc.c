@@ -0,0 +1,247 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <argparse.h>
+
+#include <command/gc.h>
+#include <object/index.h>
+#include <object/object.h>
+#include <object/pack.h>
+#include <object/reachable.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the grace period of the unreachable objects when gc.pruneExpire is not set, like git
+#define GC_DEFAULT_PRUNE_EXPIRE     "2.weeks.ago"
+
+/**
+ * @brief: The list of the ids of the refs and the index entries
+ * @param oid_list: The object ids
+ * @param count: The number of the object ids
+ * @param capacity: The capacity of the list
+ */
+struct gc_root_list{
+    struct object_id * oid_list;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: Append the id of the ref to the list
+ * @param name: The name of the ref, or the path of the index entry
+ * @param oid: The id the ref points to
+ * @param data: The list
+ */
+static void gc_root_list_append(const char * name, const struct object_id * oid, void * data){
+    (void)name;
+    struct gc_root_list * list = (struct gc_root_list *)data;
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->oid_list = (struct object_id *)realloc(list->oid_list, list->capacity * sizeof(struct object_id));
+        if (list->oid_list == NULL){
+            gitlet_panic("Failed to allocate memory for the ref list");
+        }
+    }
+    list->oid_list[list->count++] = *oid;
+}
+
+/**
+ * @brief: Append the blobs of the index entries to the list, so the staged
+ *         files survive the prune like the committed ones, the entries of
+ *         the shared index included
+ * @param list: The list
+ */
+static void gc_root_list_append_index(struct gc_root_list * list){
+    struct index index;
+    index_read(&index);
+    for (size_t i = 0; i < index.count; i++){
+        gc_root_list_append(index.entries[i]->path, &index.entries[i]->oid, list);
+    }
+    index_release(&index);
+}
+
+/**
+ * @brief: Parse the expiry date of the prune, in the forms accepted by git gc
+ *         for the relative dates: "now", "never" and "<n>.<unit>.ago".
+ * @param value: The date
+ * @param expire: The pointer to store the time, the objects modified before it are pruned
+ * @return: true if the date is valid, false otherwise
+ */
+static bool gc_parse_expire(const char * value, time_t * expire){
+    time_t now = time(NULL);
+    if (strcasecmp(value, "now") == 0 || strcasecmp(value, "all") == 0){
+        // everything modified up to this second is old enough
+        *expire = now + 1;
+        return true;
+    }
+    if (strcasecmp(value, "never") == 0){
+        *expire = 0;
+        return true;
+    }
+
+    static const struct {
+        const char * unit;
+        long seconds;
+    } units[] = {
+        {"second", 1}, {"minute", 60}, {"hour", 60 * 60}, {"day", 24 * 60 * 60},
+        {"week", 7 * 24 * 60 * 60}, {"month", 30 * 24 * 60 * 60}, {"year", 365 * 24 * 60 * 60},
+    };
+
+    // the separators are dots or spaces, and the unit can be plural
+    char * end = NULL;
+    long amount = strtol(value, &end, 10);
+    if (end == value || amount < 0 || (*end != '.' && *end != ' ')){
+        return false;
+    }
+    const char * unit = end + 1;
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++){
+        size_t unit_length = strlen(units[i].unit);
+        if (strncasecmp(unit, units[i].unit, unit_length) != 0){
+            continue;
+        }
+        const char * rest = unit + unit_length;
+        if (*rest == 's' || *rest == 'S'){
+            rest++;
+        }
+        if (*rest != '\0' && strcasecmp(rest, ".ago") != 0 && strcasecmp(rest, " ago") != 0){
+            return false;
+        }
+        *expire = now - (time_t)amount * units[i].seconds;
+        return true;
+    }
+    return false;
+}
+
+// gitlet gc [--prune=<date> | --no-prune] [--threads <n>] [-q]
+void command_gc(int argc, char *argv[]) {
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet gc [--prune=<date> | --no-prune] [--threads <n>] [-q]";
+    description._description = "Pack the reachable objects and prune the unreachable ones";
+    description._epilog = NULL;
+
+    bool quiet_flag = false;
+    int threads = 0;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('q', "quiet", "suppress the summary", &quiet_flag, NULL, 0),
+        OPTION_INT(0, "threads", "the number of the threads marking the reachable objects, 0 for all the processors", &threads, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    /**
+     * The date of --prune follows an equal sign, which the argument parser 
+     * does not split, so the prune options are peeled off by hand first.
+     */
+    const char * prune_expire = NULL;
+    bool no_prune = false;
+    int option_count = 0;
+    for (int i = 0; i < argc; i++){
+        if (str_start_with(argv[i], "--prune=")){
+            prune_expire = argv[i] + strlen("--prune=");
+            no_prune = false;
+        }else if (str_equals(argv[i], "--prune")){
+            prune_expire = NULL;
+            no_prune = false;
+        }else if (str_equals(argv[i], "--no-prune")){
+            no_prune = true;
+        }else{
+            argv[option_count++] = argv[i];
+        }
+    }
+    if (option_count != 0){
+        argparse_parse(&argparse, option_count, argv);
+    }
+    if (threads < 0){
+        gitlet_panic("The number of the threads must not be negative");
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    if (prune_expire == NULL){
+        prune_expire = repository_config_get("gc", "pruneExpire");
+    }
+    if (prune_expire == NULL){
+        prune_expire = GC_DEFAULT_PRUNE_EXPIRE;
+    }
+    time_t expire = 0;
+    if (!gc_parse_expire(prune_expire, &expire)){
+        gitlet_panic("Invalid prune expiry date: %s", prune_expire);
+    }
+    if (no_prune){
+        expire = 0;
+    }
+
+    // mark everything reachable from the refs and the index
+    struct gc_root_list roots;
+    memset(&roots, 0, sizeof(struct gc_root_list));
+    repository_for_each_ref(gc_root_list_append, &roots);
+    gc_root_list_append_index(&roots);
+    size_t reachable_count = 0;
+    struct object_id * reachable = reachable_list(roots.oid_list, roots.count, (unsigned int)threads, &reachable_count);
+    free(roots.oid_list);
+
+    /**
+     * The reachable objects go into one fresh pack before anything is deleted,
+     * then the packs and the loose objects it makes redundant are removed.
+     * The unreachable objects newer than the expiry stay, since a concurrent
+     * writer may be about to refer to them.
+     */
+    struct object_id pack_id;
+    bool packed = reachable_count != 0;
+    if (packed){
+        pack_write(&pack_id, reachable, reachable_count, PACK_DEFAULT_WINDOW, PACK_DEFAULT_DEPTH);
+    }
+    size_t removed_packs = pack_remove_redundant(packed ? &pack_id : NULL, reachable, reachable_count, expire);
+    size_t pruned_objects = object_prune_loose(reachable, reachable_count, expire);
+    free(reachable);
+
+    if (!quiet_flag){
+        fprintf(stdout, "Packed %zu objects, removed %zu packs and %zu loose objects\n", 
+            reachable_count, removed_packs, pruned_objects);
+    }
+}
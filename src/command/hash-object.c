@@ -33,8 +33,112 @@
 #include <util/files.h>
 #include <argparse.h>
 #include <object/object.h>
+#include <util/parallel.h>
+#include <global/config.h>
+
+// the most paths in flight per worker thread in the batch mode
+#define HASH_OBJECT_PATHS_PER_WORKER    64
+
+/**
+ * @brief: The path in flight in the batch mode
+ * @param path: The path of the file
+ * @param oid: The id of the object
+ */
+struct hash_object_item{
+    char * path;
+    struct object_id oid;
+};
+
+/**
+ * @brief: Hash the file on the worker thread with the writer of the worker
+ * @param item: The hash object item
+ * @param worker: The index of the worker
+ * @param data: The object writers of the workers
+ */
+static void hash_object_process(void * item, unsigned int worker, void * data){
+    struct hash_object_item * hash_item = (struct hash_object_item *)item;
+    struct object_writer * writers = (struct object_writer *)data;
+    object_writer_write(&writers[worker], &hash_item->oid, hash_item->path);
+}
+
+/**
+ * @brief: Print the id of the hashed file in the input order
+ * @param item: The hash object item
+ * @param data: The object writers of the workers
+ */
+static void hash_object_output(void * item, void * data){
+    struct hash_object_item * hash_item = (struct hash_object_item *)item;
+    char sha1_buffer[OBJECT_ID_HEX_SIZE + 1];
+    fputs(oid_to_hex(sha1_buffer, &hash_item->oid), stdout);
+    fputc('\n', stdout);
+    free(hash_item->path);
+    free(hash_item);
+}
+
+/**
+ * @brief: Hash the files of the paths from stdin, and print the ids in the input order
+ * @param write_to_repo: Whether to write the objects to the gitlet repository
+ * @param delimiter: The delimiter of the paths
+ * @param threads: The number of the worker threads
+ */
+static void hash_object_stdin_paths(bool write_to_repo, int delimiter, unsigned int threads){
+    /**
+     * Every worker owns a writer, so the hashing state, the deflate stream 
+     * and the buffers are set up once per worker for the whole batch. The
+     * reading of the paths, the hashing and compressing on the workers,
+     * and the printing of the ids all overlap.
+     */
+    struct object_writer * writers = (struct object_writer *)malloc(threads * sizeof(struct object_writer));
+    if (writers == NULL){
+        gitlet_panic("Failed to allocate memory for object writers");
+    }
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_init(&writers[i], write_to_repo);
+    }
+
+    struct parallel_pipeline * pipeline = NULL;
+    if (threads > 1){
+        pipeline = parallel_pipeline_create(threads, (size_t)threads * HASH_OBJECT_PATHS_PER_WORKER,
+            hash_object_process, hash_object_output, writers);
+    }
+
+    char * path = NULL;
+    size_t path_capacity = 0;
+    ssize_t path_length = 0;
+    while ((path_length = getdelim(&path, &path_capacity, delimiter, stdin)) != -1){
+        if (path_length > 0 && path[path_length - 1] == delimiter){
+            path[--path_length] = '\0';
+        }
+        if (path_length == 0){
+            continue;
+        }
+
+        struct hash_object_item * item = (struct hash_object_item *)malloc(sizeof(struct hash_object_item));
+        if (item == NULL || (item->path = strdup(path)) == NULL){
+            gitlet_panic("Failed to allocate memory for the path");
+        }
+        if (pipeline != NULL){
+            parallel_pipeline_push(pipeline, item);
+        }else{
+            hash_object_process(item, 0, writers);
+            hash_object_output(item, writers);
+        }
+    }
+    free(path);
+
+    if (pipeline != NULL){
+        parallel_pipeline_finish(pipeline);
+    }
+    // one barrier publishes the objects held back by all the writers
+    object_writer_flush(writers, threads);
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_release(&writers[i]);
+    }
+    free(writers);
+}
 
 // gitlet hash-object [-w] [file]
+// gitlet hash-object [-w] --stdin-paths [-z] [--threads <n>] < path-list
 void command_hash_object(int argc, char *argv[]) {
     char current_dir[PATH_MAX];
     memset(current_dir, 0, PATH_MAX);
@@ -45,15 +149,21 @@ void command_hash_object(int argc, char *argv[]) {
 
     struct argparse_description description;
     description._program_name =  NULL;
-    description._usage = "gitlet hash-object [file]";
+    description._usage = "gitlet hash-object [-w] [file]\n   or: gitlet hash-object [-w] --stdin-paths [-z] [--threads <n>] < <list-of-paths>";
     description._description = "Hash an object";
 
     bool w_flag = false;
+    bool stdin_paths_flag = false;
+    bool z_flag = false;
+    int threads = 0;
 
     struct argparse_option options[] = {
         OPTION_GROUP("Options"),
         OPTION_HELP(),
         OPTION_BOOLEAN('w', NULL, "write the object into the object database", &w_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "stdin-paths", "read the file paths from stdin, one per line", &stdin_paths_flag, NULL, 0),
+        OPTION_BOOLEAN('z', NULL, "the paths from stdin are separated by NUL instead of newline", &z_flag, NULL, 0),
+        OPTION_INT(0, "threads", "the number of the threads hashing the paths from stdin, 0 for all the processors", &threads, NULL, 0),
         OPTION_GROUP_END(),
         OPTION_END()
     };
@@ -65,7 +175,11 @@ void command_hash_object(int argc, char *argv[]) {
         const char * last_arg = argv[argc - 1];
         const char * file_path = NULL;
         
-        if (str_start_with(last_arg, "-") || str_equals(last_arg, "--")){
+        // the value of the threads option is not a file either
+        bool last_is_option = str_start_with(last_arg, "-") || str_equals(last_arg, "--") ||
+            (argc > 1 && str_equals(argv[argc - 2], "--threads"));
+
+        if (last_is_option){
             argparse_parse(&argparse, argc, argv);
         }else{
             // by default, the last argument is the file to be hashed
@@ -78,8 +192,26 @@ void command_hash_object(int argc, char *argv[]) {
 
         }
 
-        char sha1_buffer[41] = {0};
-        object_write(sha1_buffer, file_path, w_flag);
-        fprintf(stdout, "%s\n", sha1_buffer);
+        struct object_id oid;
+        char sha1_buffer[OBJECT_ID_HEX_SIZE + 1];
+
+        if (stdin_paths_flag){
+            if (file_path != NULL){
+                gitlet_panic("Can't specify files with --stdin-paths");
+            }
+
+            if (threads < 0){
+                gitlet_panic("The number of the threads must not be negative");
+            }
+            hash_object_stdin_paths(w_flag, z_flag ? '\0' : '\n', 
+                threads == 0 ? parallel_cpu_count() : (unsigned int)threads);
+            return;
+        }
+        if (file_path == NULL){
+            gitlet_panic("No file specified");
+        }
+
+        object_write(&oid, file_path, w_flag);
+        fprintf(stdout, "%s\n", oid_to_hex(sha1_buffer, &oid));
     }
 }
\ No newline at end of file
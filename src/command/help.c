@@ -64,6 +64,12 @@ static inline void print_help_information(){
     PRINT_COMMAND_HELP("log", "Show commit logs");
     PRINT_COMMAND_HELP("status", "Show the working tree status");
     PRINT_GROUP_END();
+
+    PRINT_GROUP_BEGIN("Maintain the repository");
+    PRINT_COMMAND_HELP("fsck", "Verify the connectivity and validity of the objects");
+    PRINT_COMMAND_HELP("fsmonitor", "Watch the working tree so status only checks the changed paths");
+    PRINT_COMMAND_HELP("gc", "Pack the reachable objects and prune the unreachable ones");
+    PRINT_GROUP_END();
 }
 void command_help(int argc, char *argv[]){
     (void)argc;
@@ -22,8 +22,103 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <argparse.h>
+
 #include <command/ls-files.h>
+#include <object/index.h>
+#include <object/repository.h>
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
 
+// gitlet ls-files [-c] [-s] [-z] [--] [<pathspec>...]
 void command_ls_files(int argc, char *argv[]) {
-    
-}
\ No newline at end of file
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet ls-files [-c] [-s] [-z] [--] [<pathspec>...]";
+    description._description = "Show information about the files in the index";
+    description._epilog = NULL;
+
+    bool cached_flag = false;
+    bool stage_flag = false;
+    bool z_flag = false;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('c', "cached", "show cached files in the output (default)", &cached_flag, NULL, 0),
+        OPTION_BOOLEAN('s', "stage", "show staged contents' mode, object name and stage number", &stage_flag, NULL, 0),
+        OPTION_BOOLEAN('z', NULL, "separate paths with NUL instead of newline", &z_flag, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    // the options come before the pathspecs, or before "--"
+    int option_count = 0;
+    while (option_count < argc && str_start_with(argv[option_count], "-") && !str_equals(argv[option_count], "--")){
+        option_count++;
+    }
+    if (option_count != 0){
+        argparse_parse(&argparse, option_count, argv);
+    }
+    int pathspec_start = option_count < argc && str_equals(argv[option_count], "--") ? option_count + 1 : option_count;
+    int pathspec_count = argc - pathspec_start;
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    char ** pathspecs = (char **)malloc((size_t)(pathspec_count + 1) * sizeof(char *));
+    if (pathspecs == NULL){
+        gitlet_panic("Failed to allocate memory for the pathspecs");
+    }
+    for (int i = 0; i < pathspec_count; i++){
+        char path[PATH_MAX];
+        worktree_normalize_pathspec(path, argv[pathspec_start + i]);
+        if ((pathspecs[i] = strdup(path)) == NULL){
+            gitlet_panic("Failed to allocate memory for the pathspecs");
+        }
+    }
+
+    struct index index;
+    index_read(&index);
+
+    int terminator = z_flag ? '\0' : '\n';
+    for (size_t i = 0; i < index.count; i++){
+        const struct index_entry * entry = index.entries[i];
+        bool matched = pathspec_count == 0;
+        for (int j = 0; j < pathspec_count && !matched; j++){
+            matched = worktree_path_matches(entry->path, entry->path_length, pathspecs[j], strlen(pathspecs[j]));
+        }
+        if (!matched){
+            continue;
+        }
+        if (stage_flag){
+            char hex[OBJECT_ID_HEX_SIZE + 1];
+            printf("%06o %s 0\t", entry->mode, oid_to_hex(hex, &entry->oid));
+        }
+        fputs(entry->path, stdout);
+        fputc(terminator, stdout);
+    }
+
+    for (int i = 0; i < pathspec_count; i++){
+        free(pathspecs[i]);
+    }
+    free(pathspecs);
+    index_release(&index);
+}
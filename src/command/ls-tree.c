@@ -22,8 +22,175 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <argparse.h>
+
 #include <command/ls-tree.h>
+#include <object/object.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the mode of the submodule entry in the tree
+#define LS_TREE_MODE_GITLINK    0160000
+
+/**
+ * @brief: The options of the ls-tree command
+ * @param recursive: Whether to recurse into the sub-trees
+ * @param only_trees: Whether to show only the tree entries
+ * @param show_trees: Whether to show the tree entries when recursing
+ * @param name_only: Whether to show only the paths
+ */
+struct ls_tree_options{
+    bool recursive;
+    bool only_trees;
+    bool show_trees;
+    bool name_only;
+};
+
+/**
+ * @brief: Print the entries of the tree object
+ * @param oid: The id of the tree object
+ * @param path: The path of the tree, the entry names are appended to it
+ * @param path_length: The length of the path
+ * @param options: The options of the ls-tree command
+ */
+static void ls_tree_print(const struct object_id * oid, char * path, size_t path_length, 
+    const struct ls_tree_options * options){
+    struct object obj;
+    object_read(&obj, oid);
+    if (obj.type != OBJECT_TYPE_TREE){
+        gitlet_panic("not a tree object");
+    }
+
+    // every entry is "<mode> <name>\0" followed by the raw id
+    const unsigned char * current = obj.content;
+    const unsigned char * end = obj.content + obj.file_size;
+    while (current < end){
+        const unsigned char * space = memchr(current, ' ', (size_t)(end - current));
+        const unsigned char * name_end = space == NULL ? NULL : memchr(space, '\0', (size_t)(end - space));
+        if (name_end == NULL || (size_t)(end - name_end - 1) < OBJECT_ID_RAW_SIZE){
+            gitlet_panic("Invalid tree object");
+        }
+        unsigned int mode = (unsigned int)strtoul((const char *)current, NULL, 8);
+        const char * name = (const char *)space + 1;
+        size_t name_length = (size_t)(name_end - space - 1);
+        struct object_id entry_oid;
+        memcpy(entry_oid.hash, name_end + 1, OBJECT_ID_RAW_SIZE);
+        current = name_end + 1 + OBJECT_ID_RAW_SIZE;
+
+        if (path_length + name_length + 2 > PATH_MAX){
+            gitlet_panic("Path too long in the tree: %s", path);
+        }
+        memcpy(path + path_length, name, name_length);
+        path[path_length + name_length] = '\0';
+
+        bool is_tree = S_ISDIR(mode);
+        const char * type = is_tree ? "tree" : (mode == LS_TREE_MODE_GITLINK ? "commit" : "blob");
+        bool show = is_tree ? (!options->recursive || options->show_trees || options->only_trees) 
+            : !options->only_trees;
+        if (show && options->name_only){
+            printf("%s\n", path);
+        }else if (show){
+            char hex[OBJECT_ID_HEX_SIZE + 1];
+            printf("%06o %s %s\t%s\n", mode, type, oid_to_hex(hex, &entry_oid), path);
+        }
 
+        if (is_tree && options->recursive){
+            path[path_length + name_length] = '/';
+            ls_tree_print(&entry_oid, path, path_length + name_length + 1, options);
+        }
+    }
+    object_release(&obj);
+}
+
+/**
+ * @usage: gitlet ls-tree [-r] [-d] [-t] [--name-only] <tree-ish>
+ */
 void command_ls_tree(int argc, char *argv[]) {
-    
-}
\ No newline at end of file
+    char current_dir[PATH_MAX];
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name = NULL;
+    description._usage = "gitlet ls-tree [-r] [-d] [-t] [--name-only] <tree-ish>";
+    description._description = "List the contents of a tree object";
+    description._epilog = NULL;
+
+    struct ls_tree_options ls_options = {false, false, false, false};
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('r', NULL, "recurse into sub-trees", &ls_options.recursive, NULL, 0),
+        OPTION_BOOLEAN('d', NULL, "only show trees", &ls_options.only_trees, NULL, 0),
+        OPTION_BOOLEAN('t', NULL, "show trees when recursing", &ls_options.show_trees, NULL, 0),
+        OPTION_BOOLEAN(0, "name-only", "list only filenames", &ls_options.name_only, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    if (argc == 0){
+        argparse_parse(&argparse, 1, (char *[]){"-h"});
+        return;
+    }
+
+    // the last argument is the tree-ish
+    const char * name = argv[argc - 1];
+    if (str_start_with(name, "-")){
+        argparse_parse(&argparse, argc, argv);
+        gitlet_panic("No tree-ish specified");
+    }
+    if (argc > 1){
+        argparse_parse(&argparse, argc - 1, argv);
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    struct object_id oid;
+    switch (object_resolve_name(&oid, name)){
+        case OBJECT_NAME_FOUND:
+            break;
+        case OBJECT_NAME_AMBIGUOUS:
+            gitlet_panic("short object ID %s is ambiguous", name);
+            break;
+        default:
+            gitlet_panic("Not a valid object name %s", name);
+    }
+    if (!object_exists(&oid)){
+        gitlet_panic("Not a valid object name %s", name);
+    }
+
+    // a commit is listed by its tree, the first line of the commit
+    struct object obj;
+    object_read_header(&obj, &oid);
+    if (obj.type == OBJECT_TYPE_COMMIT){
+        object_read(&obj, &oid);
+        if (obj.file_size < 5 + OBJECT_ID_HEX_SIZE || memcmp(obj.content, "tree ", 5) != 0){
+            gitlet_panic("Invalid commit object: %s", name);
+        }
+        char tree_hex[OBJECT_ID_HEX_SIZE + 1];
+        memcpy(tree_hex, obj.content + 5, OBJECT_ID_HEX_SIZE);
+        tree_hex[OBJECT_ID_HEX_SIZE] = '\0';
+        object_release(&obj);
+        if (!oid_from_hex(&oid, tree_hex)){
+            gitlet_panic("Invalid commit object: %s", name);
+        }
+    }else if (obj.type != OBJECT_TYPE_TREE){
+        gitlet_panic("not a tree object");
+    }
+
+    char path[PATH_MAX];
+    path[0] = '\0';
+    ls_tree_print(&oid, path, 0, &ls_options);
+}
@@ -0,0 +1,145 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ctype.h>
+
+#include <argparse.h>
+
+#include <command/pack-objects.h>
+#include <object/object.h>
+#include <object/pack.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+/**
+ * @brief: The list of the object ids to be packed
+ * @param oid_list: The object ids
+ * @param count: The number of the object ids
+ * @param capacity: The capacity of the list
+ */
+struct pack_objects_list{
+    struct object_id * oid_list;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: Append the object id to the list
+ * @param oid: The id of the object
+ * @param data: The list
+ */
+static void pack_objects_list_append(const struct object_id * oid, void * data){
+    struct pack_objects_list * list = (struct pack_objects_list *)data;
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->oid_list = (struct object_id *)realloc(list->oid_list, list->capacity * sizeof(struct object_id));
+        if (list->oid_list == NULL){
+            gitlet_panic("Failed to allocate memory for the object list");
+        }
+    }
+    list->oid_list[list->count++] = *oid;
+}
+
+// gitlet pack-objects [--all] [--window <n>] [--depth <n>] < object-list
+void command_pack_objects(int argc, char *argv[]) {
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet pack-objects [--all] [--window <n>] [--depth <n>] < object-list";
+    description._description = "Create a packed archive of objects";
+    description._epilog = NULL;
+
+    bool all_flag = false;
+    int window = PACK_DEFAULT_WINDOW;
+    int depth = PACK_DEFAULT_DEPTH;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN(0, "all", "pack all the loose objects instead of reading the object ids from stdin", &all_flag, NULL, 0),
+        OPTION_INT(0, "window", "the number of the objects searched for a delta base, 0 to disable deltas", &window, NULL, 0),
+        OPTION_INT(0, "depth", "the longest delta chain in the pack", &depth, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+    if (argc != 0){
+        argparse_parse(&argparse, argc, argv);
+    }
+
+    if (window < 0 || depth < 0){
+        gitlet_panic("The window and depth must not be negative");
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    struct pack_objects_list list;
+    memset(&list, 0, sizeof(struct pack_objects_list));
+
+    if (all_flag){
+        object_for_each_loose(pack_objects_list_append, &list);
+    }else{
+        // read one object id per line from stdin
+        char line_buffer[128];
+        while (fgets(line_buffer, sizeof(line_buffer), stdin) != NULL){
+            size_t length = strlen(line_buffer);
+            while (length > 0 && isspace((unsigned char)line_buffer[length - 1])){
+                line_buffer[--length] = '\0';
+            }
+            if (length == 0){
+                continue;
+            }
+            struct object_id oid;
+            if (!oid_from_hex(&oid, line_buffer)){
+                gitlet_panic("Not a valid object name: %s", line_buffer);
+            }
+            if (!object_exists(&oid)){
+                gitlet_panic("Object not found: %s", line_buffer);
+            }
+            pack_objects_list_append(&oid, &list);
+        }
+    }
+
+    struct object_id pack_id;
+    char pack_sha1[OBJECT_ID_HEX_SIZE + 1];
+    pack_write(&pack_id, list.oid_list, list.count, (unsigned int)window, (unsigned int)depth);
+    fprintf(stdout, "%s\n", oid_to_hex(pack_sha1, &pack_id));
+
+    free(list.oid_list);
+}
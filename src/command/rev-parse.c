@@ -22,8 +22,105 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <argparse.h>
+
 #include <command/rev-parse.h>
+#include <object/object.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the length of the abbreviated id of --short without a length, like git
+#define REV_PARSE_DEFAULT_ABBREV    7
 
+/**
+ * @usage: gitlet rev-parse [--short[=<length>]] <object>...
+ */
 void command_rev_parse(int argc, char *argv[]) {
-    
+    char current_dir[PATH_MAX];
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name = NULL;
+    description._usage = "gitlet rev-parse [--short[=<length>]] <object>...";
+    description._description = "Print the full or the shortest unique object ids of the objects";
+    description._epilog = NULL;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    /**
+     * The options and the object names can be mixed, and --short takes its
+     * length after an equal sign, so the arguments are peeled by hand. Like
+     * git, --short applies to the names after it and verifies a single one.
+     */
+    size_t abbrev = 0;
+    size_t abbrevs[argc > 0 ? argc : 1];
+    int name_count = 0;
+    int short_count = 0;
+    for (int i = 0; i < argc; i++){
+        if (str_equals(argv[i], "-h") || str_equals(argv[i], "--help")){
+            argparse_parse(&argparse, 1, (char *[]){"-h"});
+        }else if (str_equals(argv[i], "--short")){
+            abbrev = REV_PARSE_DEFAULT_ABBREV;
+        }else if (str_start_with(argv[i], "--short=")){
+            char * end = NULL;
+            long length = strtol(argv[i] + strlen("--short="), &end, 10);
+            if (*end != '\0' || end == argv[i] + strlen("--short=")){
+                gitlet_panic("Invalid length of --short: %s", argv[i]);
+            }
+            abbrev = length < OBJECT_ID_MIN_ABBREV ? OBJECT_ID_MIN_ABBREV 
+                : length > OBJECT_ID_HEX_SIZE ? OBJECT_ID_HEX_SIZE : (size_t)length;
+        }else if (str_start_with(argv[i], "-")){
+            gitlet_panic("unknown option %s", argv[i]);
+        }else{
+            short_count += abbrev != 0;
+            abbrevs[name_count] = abbrev;
+            argv[name_count++] = argv[i];
+        }
+    }
+    if (short_count > 1){
+        gitlet_panic("Needed a single revision");
+    }
+    if (name_count == 0){
+        return;
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    for (int i = 0; i < name_count; i++){
+        struct object_id oid;
+        switch (object_resolve_name(&oid, argv[i])){
+            case OBJECT_NAME_FOUND:
+                break;
+            case OBJECT_NAME_AMBIGUOUS:
+                gitlet_panic("short object ID %s is ambiguous", argv[i]);
+                break;
+            default:
+                gitlet_panic("ambiguous argument \'%s\': unknown revision or path not in the working tree.", argv[i]);
+        }
+
+        char hex[OBJECT_ID_HEX_SIZE + 1];
+        if (abbrevs[i] != 0){
+            object_abbreviate(hex, &oid, abbrevs[i]);
+        }else{
+            oid_to_hex(hex, &oid);
+        }
+        printf("%s\n", hex);
+    }
 }
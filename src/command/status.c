@@ -22,8 +22,606 @@
  * SOFTWARE.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <argparse.h>
+
 #include <command/status.h>
+#include <object/fsmonitor.h>
+#include <object/index.h>
+#include <object/object.h>
+#include <object/repository.h>
+#include <object/untracked.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the length of the abbreviated id of the detached HEAD, like git
+#define STATUS_ABBREV_LENGTH        7
+// the number of the chunks of the index entries for every worker
+#define STATUS_CHUNKS_PER_WORKER    8
+// the smallest number of the index entries in a chunk
+#define STATUS_MIN_CHUNK_SIZE       64
+
+/**
+ * @brief: Which untracked files are shown, from -u or --untracked-files
+ * @param STATUS_UNTRACKED_NO: Show no untracked files
+ * @param STATUS_UNTRACKED_NORMAL: Show the untracked files and directories, a 
+ *                                 directory without tracked files is shown alone
+ * @param STATUS_UNTRACKED_ALL: Show every untracked file
+ */
+enum status_untracked_mode{
+    STATUS_UNTRACKED_NO,
+    STATUS_UNTRACKED_NORMAL,
+    STATUS_UNTRACKED_ALL,
+};
+
+/**
+ * @brief: The file of the tree of HEAD
+ * @param path: The path relative to the working tree
+ * @param length: The length of the path
+ * @param mode: The mode of the tree entry
+ * @param oid: The id of the blob
+ */
+struct status_head_entry{
+    char * path;
+    size_t length;
+    uint32_t mode;
+    struct object_id oid;
+};
+
+/**
+ * @brief: The files of the tree of HEAD in the order of the index
+ * @param entries: The entries
+ * @param count: The number of the entries
+ * @param capacity: The capacity of the entries
+ */
+struct status_head_list{
+    struct status_head_entry * entries;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The changed path, in the two columns of the short format
+ * @param path: The path relative to the working tree, a directory ends with '/'
+ * @param staged: The change between HEAD and the index, ' ' for none
+ * @param unstaged: The change between the index and the working tree, ' ' for none
+ */
+struct status_change{
+    char * path;
+    char staged;
+    char unstaged;
+};
+
+/**
+ * @brief: The growable list of the changes
+ * @param changes: The changes
+ * @param count: The number of the changes
+ * @param capacity: The capacity of the list
+ */
+struct status_list{
+    struct status_change * changes;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: Append the change to the list
+ * @param list: The list
+ * @param path: The path
+ * @param length: The length of the path
+ * @param staged: The change between HEAD and the index
+ * @param unstaged: The change between the index and the working tree
+ */
+static void status_list_append(struct status_list * list, const char * path, size_t length, char staged, char unstaged){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->changes = (struct status_change *)realloc(list->changes, list->capacity * sizeof(struct status_change));
+        if (list->changes == NULL){
+            gitlet_panic("Failed to allocate memory for the changes");
+        }
+    }
+    struct status_change * change = &list->changes[list->count++];
+    change->path = strndup(path, length);
+    if (change->path == NULL){
+        gitlet_panic("Failed to allocate memory for the changes");
+    }
+    change->staged = staged;
+    change->unstaged = unstaged;
+}
 
+/**
+ * @brief: Release the changes of the list
+ */
+static void status_list_release(struct status_list * list){
+    for (size_t i = 0; i < list->count; i++){
+        free(list->changes[i].path);
+    }
+    free(list->changes);
+}
+
+/**
+ * @brief: Compare the changes by the paths
+ */
+static int status_change_compare(const void * left, const void * right){
+    return strcmp(((const struct status_change *)left)->path, ((const struct status_change *)right)->path);
+}
+
+/**
+ * @brief: Flatten the tree into the list of the files, the entries of a tree
+ *         are sorted as if the sub-trees end with '/', so walking them in 
+ *         order gives the files in the order of the index.
+ * @param list: The list to append the files to
+ * @param oid: The id of the tree
+ * @param path: The path of the tree, the entry names are appended to it
+ * @param path_length: The length of the path
+ */
+static void status_read_tree(struct status_head_list * list, const struct object_id * oid, char * path, size_t path_length){
+    struct object obj;
+    object_read(&obj, oid);
+    if (obj.type != OBJECT_TYPE_TREE){
+        gitlet_panic("not a tree object");
+    }
+
+    // every entry is "<mode> <name>\0" followed by the raw id
+    const unsigned char * current = obj.content;
+    const unsigned char * end = obj.content + obj.file_size;
+    while (current < end){
+        const unsigned char * space = memchr(current, ' ', (size_t)(end - current));
+        const unsigned char * name_end = space == NULL ? NULL : memchr(space, '\0', (size_t)(end - space));
+        if (name_end == NULL || (size_t)(end - name_end - 1) < OBJECT_ID_RAW_SIZE){
+            gitlet_panic("Invalid tree object");
+        }
+        uint32_t mode = (uint32_t)strtoul((const char *)current, NULL, 8);
+        size_t name_length = (size_t)(name_end - space - 1);
+        struct object_id entry_oid;
+        memcpy(entry_oid.hash, name_end + 1, OBJECT_ID_RAW_SIZE);
+        current = name_end + 1 + OBJECT_ID_RAW_SIZE;
+
+        if (path_length + name_length + 2 > PATH_MAX){
+            gitlet_panic("Path too long in the tree: %s", path);
+        }
+        memcpy(path + path_length, space + 1, name_length);
+        path[path_length + name_length] = '\0';
+
+        if (S_ISDIR(mode)){
+            path[path_length + name_length] = '/';
+            status_read_tree(list, &entry_oid, path, path_length + name_length + 1);
+            continue;
+        }
+        if (list->count == list->capacity){
+            list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+            list->entries = (struct status_head_entry *)realloc(list->entries, 
+                list->capacity * sizeof(struct status_head_entry));
+            if (list->entries == NULL){
+                gitlet_panic("Failed to allocate memory for the tree entries");
+            }
+        }
+        struct status_head_entry * entry = &list->entries[list->count++];
+        entry->length = path_length + name_length;
+        entry->path = strndup(path, entry->length);
+        if (entry->path == NULL){
+            gitlet_panic("Failed to allocate memory for the tree entries");
+        }
+        entry->mode = mode;
+        entry->oid = entry_oid;
+    }
+    object_release(&obj);
+}
+
+/**
+ * @brief: Read the files of the tree of the commit
+ * @param list: The list to store the files
+ * @param commit: The id of the commit
+ */
+static void status_read_commit(struct status_head_list * list, const struct object_id * commit){
+    struct object obj;
+    object_read(&obj, commit);
+    if (obj.type != OBJECT_TYPE_COMMIT || obj.file_size < 5 + OBJECT_ID_HEX_SIZE 
+        || memcmp(obj.content, "tree ", 5) != 0){
+        gitlet_panic("Invalid commit object");
+    }
+    char tree_hex[OBJECT_ID_HEX_SIZE + 1];
+    memcpy(tree_hex, obj.content + 5, OBJECT_ID_HEX_SIZE);
+    tree_hex[OBJECT_ID_HEX_SIZE] = '\0';
+    object_release(&obj);
+
+    struct object_id tree;
+    if (!oid_from_hex(&tree, tree_hex)){
+        gitlet_panic("Invalid commit object");
+    }
+    char path[PATH_MAX];
+    path[0] = '\0';
+    status_read_tree(list, &tree, path, 0);
+}
+
+/**
+ * @brief: Get the change between the entry of HEAD and the entry of the index
+ * @return: ' ' when they are the same, 'T' when the type changed, 'M' otherwise
+ */
+static char status_compare_entry(uint32_t head_mode, const struct object_id * head_oid, const struct index_entry * entry){
+    if (head_mode == entry->mode && oid_equals(head_oid, &entry->oid)){
+        return ' ';
+    }
+    return (head_mode & S_IFMT) == (entry->mode & S_IFMT) ? 'M' : 'T';
+}
+
+/**
+ * @brief: Get the change between the entry of the index and the working tree
+ * @param index: The index
+ * @param entry: The entry, which gets the new stat data when it is found clean by hashing
+ * @param writer: The object writer to hash the content
+ * @param refreshed: The flag to set when the entry is refreshed
+ * @return: ' ' when the file is clean, 'D', 'T' or 'M' otherwise
+ */
+static char status_check_worktree(const struct index * index, struct index_entry * entry, 
+    struct object_writer * writer, bool * refreshed){
+    struct stat status;
+    if (lstat(entry->path, &status) != 0 || index_mode_from_stat(&status) == 0){
+        return 'D';
+    }
+    if ((entry->mode == INDEX_MODE_SYMLINK) != S_ISLNK(status.st_mode)){
+        return 'T';
+    }
+    switch (index_entry_check(index, entry, &status, writer)){
+        case INDEX_ENTRY_MODIFIED:
+            return 'M';
+        case INDEX_ENTRY_REFRESHED:
+            *refreshed = true;
+            return ' ';
+        default:
+            return ' ';
+    }
+}
+
+/**
+ * @brief: Get the length of the directory part of the path, without the last '/'
+ */
+static size_t status_directory_length(const char * path, size_t length){
+    while (length > 0 && path[length - 1] != '/'){
+        length--;
+    }
+    return length == 0 ? 0 : length - 1;
+}
+
+/**
+ * @brief: The state of the check of the entries shared by the worker threads
+ * @param index: The index
+ * @param chunks: The first position of every chunk of the entries, and the count at the end
+ * @param unstaged: The change between the index and the working tree of every entry
+ * @param updated: Whether every worker updated any entry
+ * @param writers: The object writers of the workers
+ * @param monitored: Whether the fsmonitor flags of the entries are up to date
+ */
+struct status_check_state{
+    const struct index * index;
+    const size_t * chunks;
+    char * unstaged;
+    bool * updated;
+    struct object_writer * writers;
+    bool monitored;
+};
+
+/**
+ * @brief: Check the entries of the chunk against the working tree on the worker thread
+ */
+static void status_check_chunk(size_t chunk, unsigned int worker, void * data){
+    struct status_check_state * state = (struct status_check_state *)data;
+    for (size_t i = state->chunks[chunk]; i < state->chunks[chunk + 1]; i++){
+        struct index_entry * entry = state->index->entries[i];
+        if (state->monitored && entry->fsmonitor_valid){
+            // the fsmonitor saw no change of the path since it was found clean
+            state->unstaged[i] = ' ';
+            continue;
+        }
+        state->unstaged[i] = status_check_worktree(state->index, entry, 
+            &state->writers[worker], &state->updated[worker]);
+        if (state->monitored && state->unstaged[i] == ' '){
+            entry->fsmonitor_valid = true;
+            state->updated[worker] = true;
+        }
+    }
+}
+
+/**
+ * @brief: Check every entry of the index against the working tree on the workers
+ * @param index: The index, marked as changed when any entry is refreshed
+ * @param threads: The number of the worker threads
+ * @param monitored: Whether the fsmonitor flags of the entries are up to date
+ * @return: The change between the index and the working tree of every entry
+ * @note: The entries are split into chunks at the boundaries of the directories,
+ *        so the files of a directory are checked by one worker one after another.
+ */
+static char * status_check_entries(struct index * index, unsigned int threads, bool monitored){
+    char * unstaged = (char *)malloc(index->count + 1);
+    size_t * chunks = (size_t *)malloc((index->count + 1) * sizeof(size_t));
+    bool * updated = (bool *)calloc(threads, sizeof(bool));
+    struct object_writer * writers = (struct object_writer *)malloc(threads * sizeof(struct object_writer));
+    if (unstaged == NULL || chunks == NULL || updated == NULL || writers == NULL){
+        gitlet_panic("Failed to allocate memory for the check of the working tree");
+    }
+
+    // a few chunks per worker keep the workers busy when the directories are uneven
+    size_t chunk_size = index->count / ((size_t)threads * STATUS_CHUNKS_PER_WORKER);
+    chunk_size = chunk_size < STATUS_MIN_CHUNK_SIZE ? STATUS_MIN_CHUNK_SIZE : chunk_size;
+    size_t chunk_count = 0;
+    for (size_t i = 0; i < index->count; i++){
+        if (chunk_count != 0 && i - chunks[chunk_count - 1] < chunk_size){
+            continue;
+        }
+        const struct index_entry * entry = index->entries[i];
+        const struct index_entry * previous = i == 0 ? NULL : index->entries[i - 1];
+        size_t directory_length = status_directory_length(entry->path, entry->path_length);
+        if (previous == NULL || directory_length != status_directory_length(previous->path, previous->path_length)
+            || memcmp(entry->path, previous->path, directory_length) != 0){
+            chunks[chunk_count++] = i;
+        }
+    }
+    chunks[chunk_count] = index->count;
+
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_init(&writers[i], false);
+    }
+    struct status_check_state state = {index, chunks, unstaged, updated, writers, monitored};
+    parallel_for(threads, chunk_count, status_check_chunk, &state);
+    for (unsigned int i = 0; i < threads; i++){
+        object_writer_release(&writers[i]);
+        index->changed = index->changed || updated[i];
+    }
+
+    free(writers);
+    free(updated);
+    free(chunks);
+    return unstaged;
+}
+
+/**
+ * @brief: Find the untracked paths of the working tree, skipping the ignored ones
+ * @param index: The index, whose untracked cache saves the reads of the unchanged directories
+ * @param mode: Which untracked files are shown
+ * @param threads: The number of the worker threads
+ * @param untracked: The list to store the untracked paths, sorted
+ */
+static void status_scan_untracked(struct index * index, enum status_untracked_mode mode, 
+    unsigned int threads, struct status_list * untracked){
+    struct untracked_list list;
+    memset(&list, 0, sizeof(struct untracked_list));
+    untracked_scan(index, mode == STATUS_UNTRACKED_ALL, threads, &list);
+    for (size_t i = 0; i < list.count; i++){
+        status_list_append(untracked, list.paths[i], strlen(list.paths[i]), '?', '?');
+    }
+    untracked_list_release(&list);
+}
+
+/**
+ * @brief: Print the changes in the long format
+ * @param list: The changes of the tracked files
+ * @param column: 0 for the changes between HEAD and the index, 1 for the 
+ *                changes between the index and the working tree
+ * @return: The number of the changes printed
+ */
+static size_t status_print_long_section(const struct status_list * list, int column){
+    size_t printed = 0;
+    for (size_t i = 0; i < list->count; i++){
+        const struct status_change * change = &list->changes[i];
+        char code = column == 0 ? change->staged : change->unstaged;
+        const char * label = NULL;
+        switch (code){
+            case 'A': label = "new file:"; break;
+            case 'M': label = "modified:"; break;
+            case 'D': label = "deleted:"; break;
+            case 'T': label = "typechange:"; break;
+            default: continue;
+        }
+        if (printed == 0 && column == 0){
+            printf("Changes to be committed:\n");
+            printf("  (use \"gitlet rm --cached <file>...\" to unstage)\n");
+        }else if (printed == 0){
+            printf("Changes not staged for commit:\n");
+            printf("  (use \"gitlet add <file>...\" to update what will be committed)\n");
+        }
+        printf("\t%-12s%s\n", label, change->path);
+        printed++;
+    }
+    if (printed != 0){
+        printf("\n");
+    }
+    return printed;
+}
+
+/**
+ * @brief: Parse the mode of the untracked files
+ * @param value: The value of -u or --untracked-files
+ * @return: The mode
+ */
+static enum status_untracked_mode status_parse_untracked_mode(const char * value){
+    if (str_equals(value, "no")){
+        return STATUS_UNTRACKED_NO;
+    }
+    if (str_equals(value, "normal")){
+        return STATUS_UNTRACKED_NORMAL;
+    }
+    if (str_equals(value, "all")){
+        return STATUS_UNTRACKED_ALL;
+    }
+    gitlet_panic("Invalid untracked files mode '%s'", value);
+    return STATUS_UNTRACKED_NORMAL;
+}
+
+// gitlet status [-s] [--porcelain] [-u<mode> | --untracked-files=<mode>] [--threads <n>]
 void command_status(int argc, char *argv[]) {
-    
-}
\ No newline at end of file
+    char current_dir[PATH_MAX];
+    memset(current_dir, 0, PATH_MAX);
+
+    if (getcwd(current_dir, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+
+    struct argparse_description description;
+    description._program_name =  NULL;
+    description._usage = "gitlet status [-s] [--porcelain] [-u<mode> | --untracked-files=<mode>] [--threads <n>]";
+    description._description = "Show the working tree status";
+    description._epilog = NULL;
+
+    bool short_flag = false;
+    bool porcelain_flag = false;
+    int threads = 0;
+
+    struct argparse_option options[] = {
+        OPTION_GROUP("Options"),
+        OPTION_HELP(),
+        OPTION_BOOLEAN('s', "short", "show status concisely", &short_flag, NULL, 0),
+        OPTION_BOOLEAN(0, "porcelain", "machine-readable output", &porcelain_flag, NULL, 0),
+        OPTION_INT(0, "threads", "the number of the threads scanning the working tree, 0 for all the processors", &threads, NULL, 0),
+        OPTION_GROUP_END(),
+        OPTION_END()
+    };
+
+    struct argparse argparse;
+    argparse_init(&argparse, options, &description);
+
+    /**
+     * The mode of the untracked files sticks to -u or follows an equal sign, 
+     * which the argument parser does not split, so they are peeled off by hand.
+     */
+    enum status_untracked_mode untracked_mode = STATUS_UNTRACKED_NORMAL;
+    int option_count = 0;
+    for (int i = 0; i < argc; i++){
+        if (str_equals(argv[i], "-u") || str_equals(argv[i], "--untracked-files")){
+            untracked_mode = STATUS_UNTRACKED_ALL;
+        }else if (str_start_with(argv[i], "-u")){
+            untracked_mode = status_parse_untracked_mode(argv[i] + strlen("-u"));
+        }else if (str_start_with(argv[i], "--untracked-files=")){
+            untracked_mode = status_parse_untracked_mode(argv[i] + strlen("--untracked-files="));
+        }else if (str_equals(argv[i], "--porcelain=v1")){
+            porcelain_flag = true;
+        }else{
+            argv[option_count++] = argv[i];
+        }
+    }
+    if (option_count != 0){
+        argparse_parse(&argparse, option_count, argv);
+    }
+    if (threads < 0){
+        gitlet_panic("The number of the threads must not be negative");
+    }
+
+    struct repository repo;
+    repository_object_init(&repo, current_dir, true);
+
+    char head_ref[PATH_MAX];
+    struct object_id head_oid;
+    bool has_head = repository_resolve_head(head_ref, &head_oid);
+    struct status_head_list head;
+    memset(&head, 0, sizeof(struct status_head_list));
+    if (has_head){
+        status_read_commit(&head, &head_oid);
+    }
+
+    struct index index;
+    index_read(&index);
+    unsigned int workers = threads == 0 ? parallel_cpu_count() : (unsigned int)threads;
+
+    /**
+     * The files of HEAD and the entries of the index are in the same order, 
+     * so the staged changes come from one merge of the two. The unstaged 
+     * changes take one lstat per entry on the workers, and the content is 
+     * only hashed when the stat data cached in the entry cannot tell. With
+     * the fsmonitor, the entries it saw no change of skip the lstat too.
+     */
+    bool monitored = fsmonitor_refresh_index(&index);
+    char * unstaged_changes = status_check_entries(&index, workers, monitored);
+    struct status_list tracked;
+    memset(&tracked, 0, sizeof(struct status_list));
+    size_t head_position = 0;
+    for (size_t i = 0; i < index.count; i++){
+        struct index_entry * entry = index.entries[i];
+        char staged = 'A';
+        while (head_position < head.count){
+            const struct status_head_entry * head_entry = &head.entries[head_position];
+            int result = strcmp(head_entry->path, entry->path);
+            if (result > 0){
+                break;
+            }
+            head_position++;
+            if (result == 0){
+                staged = status_compare_entry(head_entry->mode, &head_entry->oid, entry);
+                break;
+            }
+            status_list_append(&tracked, head_entry->path, head_entry->length, 'D', ' ');
+        }
+        char unstaged = unstaged_changes[i];
+        if (staged != ' ' || unstaged != ' '){
+            status_list_append(&tracked, entry->path, entry->path_length, staged, unstaged);
+        }
+    }
+    for (; head_position < head.count; head_position++){
+        status_list_append(&tracked, head.entries[head_position].path, head.entries[head_position].length, 'D', ' ');
+    }
+    free(unstaged_changes);
+
+    struct status_list untracked;
+    memset(&untracked, 0, sizeof(struct status_list));
+    if (untracked_mode != STATUS_UNTRACKED_NO){
+        status_scan_untracked(&index, untracked_mode, workers, &untracked);
+    }
+
+    if (short_flag || porcelain_flag){
+        for (size_t i = 0; i < tracked.count; i++){
+            printf("%c%c %s\n", tracked.changes[i].staged, tracked.changes[i].unstaged, tracked.changes[i].path);
+        }
+        for (size_t i = 0; i < untracked.count; i++){
+            printf("?? %s\n", untracked.changes[i].path);
+        }
+    }else{
+        if (str_start_with(head_ref, "refs/heads/")){
+            printf("On branch %s\n", head_ref + strlen("refs/heads/"));
+        }else{
+            char hex[OBJECT_ID_HEX_SIZE + 1];
+            object_abbreviate(hex, &head_oid, STATUS_ABBREV_LENGTH);
+            printf("HEAD detached at %s\n", hex);
+        }
+        if (!has_head){
+            printf("\nNo commits yet\n");
+        }
+        printf("\n");
+        size_t staged_count = status_print_long_section(&tracked, 0);
+        size_t unstaged_count = status_print_long_section(&tracked, 1);
+        if (untracked.count != 0){
+            printf("Untracked files:\n");
+            printf("  (use \"gitlet add <file>...\" to include in what will be committed)\n");
+            for (size_t i = 0; i < untracked.count; i++){
+                printf("\t%s\n", untracked.changes[i].path);
+            }
+            printf("\n");
+        }
+        if (staged_count == 0 && unstaged_count != 0){
+            printf("no changes added to commit (use \"gitlet add\" and/or \"gitlet commit -a\")\n");
+        }else if (staged_count == 0 && untracked.count != 0){
+            printf("nothing added to commit but untracked files present (use \"gitlet add\" to track)\n");
+        }else if (staged_count == 0 && !has_head){
+            printf("nothing to commit (create/copy files and use \"gitlet add\" to track)\n");
+        }else if (staged_count == 0){
+            printf("nothing to commit, working tree clean\n");
+        }
+    }
+
+    // the stat data refreshed by hashing saves the hashing next time
+    if (index.changed){
+        index_try_write(&index);
+    }
+
+    status_list_release(&tracked);
+    status_list_release(&untracked);
+    for (size_t i = 0; i < head.count; i++){
+        free(head.entries[i].path);
+    }
+    free(head.entries);
+    index_release(&index);
+}
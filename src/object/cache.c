@@ -0,0 +1,310 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include <object/cache.h>
+#include <object/repository.h>
+#include <util/error.h>
+
+// the number of the buckets of the hash table at the beginning
+#define OBJECT_CACHE_INITIAL_BUCKETS    256
+// set this environment variable to print the counters of the cache at exit
+#define OBJECT_CACHE_STATS_ENV          "GITLET_OBJECT_CACHE_STATS"
+
+/**
+ * @brief: The reference counted content of the object
+ * @param refcount: The number of the references
+ * @param data: The content of the object
+ */
+struct object_content{
+    atomic_size_t refcount;
+    _Alignas(max_align_t) unsigned char data[];
+};
+
+/**
+ * @brief: The object in the cache
+ * @param oid: The id of the object
+ * @param obj: The object, the cache holds one reference of the content
+ * @param hash_next: The next entry in the same bucket
+ * @param lru_prev: The more recently used entry
+ * @param lru_next: The less recently used entry
+ */
+struct object_cache_entry{
+    struct object_id oid;
+    struct object obj;
+    struct object_cache_entry * hash_next;
+    struct object_cache_entry * lru_prev;
+    struct object_cache_entry * lru_next;
+};
+
+/**
+ * @brief: The object cache
+ * @param buckets: The buckets of the hash table
+ * @param bucket_count: The number of the buckets, always a power of two
+ * @param lru_head: The most recently used entry
+ * @param lru_tail: The least recently used entry
+ * @param stats: The counters of the cache
+ * @param initialized: Whether the budget is set
+ */
+struct object_cache{
+    struct object_cache_entry ** buckets;
+    size_t bucket_count;
+    struct object_cache_entry * lru_head;
+    struct object_cache_entry * lru_tail;
+    struct object_cache_stats stats;
+    bool initialized;
+};
+
+static struct object_cache _cache;
+// the readers on the worker threads share the cache
+static pthread_mutex_t _cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline struct object_content * _object_content_header(unsigned char * content){
+    return (struct object_content *)(content - offsetof(struct object_content, data));
+}
+
+unsigned char * object_content_alloc(uint64_t size){
+    if (size >= SIZE_MAX - sizeof(struct object_content)){
+        gitlet_panic("Object too large: %llu bytes", (unsigned long long)size);
+    }
+    struct object_content * _content = (struct object_content *)malloc(sizeof(struct object_content) + (size_t)size + 1);
+    if (_content == NULL){
+        gitlet_panic("Failed to allocate memory for object content");
+    }
+    atomic_init(&_content->refcount, 1);
+    return _content->data;
+}
+
+void object_content_retain(unsigned char * content){
+    atomic_fetch_add_explicit(&_object_content_header(content)->refcount, 1, memory_order_relaxed);
+}
+
+void object_content_release(unsigned char * content){
+    if (content == NULL){
+        return;
+    }
+    struct object_content * _content = _object_content_header(content);
+    if (atomic_fetch_sub_explicit(&_content->refcount, 1, memory_order_acq_rel) == 1){
+        free(_content);
+    }
+}
+
+/**
+ * @brief: Print the counters of the cache to stderr
+ */
+static void _object_cache_print_stats(void){
+    fprintf(stderr, "object cache: %llu hits, %llu misses, %llu evictions, %zu entries, %llu/%llu bytes\n",
+        (unsigned long long)_cache.stats.hits, (unsigned long long)_cache.stats.misses,
+        (unsigned long long)_cache.stats.evictions, _cache.stats.entries,
+        (unsigned long long)_cache.stats.bytes, (unsigned long long)_cache.stats.budget);
+}
+
+/**
+ * @brief: Read the budget from the config on the first use of the cache
+ */
+static void _object_cache_init(void){
+    if (_cache.initialized){
+        return;
+    }
+    _cache.initialized = true;
+    _cache.stats.budget = repository_config_get_size("core", "objectCacheSize", OBJECT_CACHE_DEFAULT_BUDGET);
+    if (getenv(OBJECT_CACHE_STATS_ENV) != NULL){
+        atexit(_object_cache_print_stats);
+    }
+}
+
+static inline size_t _object_cache_bucket(const struct object_id * oid){
+    return oid_hash(oid) & (_cache.bucket_count - 1);
+}
+
+/**
+ * @brief: Unlink the entry from the LRU list
+ */
+static void _object_cache_lru_unlink(struct object_cache_entry * entry){
+    if (entry->lru_prev != NULL){
+        entry->lru_prev->lru_next = entry->lru_next;
+    }else{
+        _cache.lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != NULL){
+        entry->lru_next->lru_prev = entry->lru_prev;
+    }else{
+        _cache.lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+/**
+ * @brief: Link the entry as the most recently used one
+ */
+static void _object_cache_lru_push(struct object_cache_entry * entry){
+    entry->lru_prev = NULL;
+    entry->lru_next = _cache.lru_head;
+    if (_cache.lru_head != NULL){
+        _cache.lru_head->lru_prev = entry;
+    }else{
+        _cache.lru_tail = entry;
+    }
+    _cache.lru_head = entry;
+}
+
+/**
+ * @brief: Remove the entry from the cache and drop the reference of the cache
+ */
+static void _object_cache_remove(struct object_cache_entry * entry){
+    struct object_cache_entry ** _link = &_cache.buckets[_object_cache_bucket(&entry->oid)];
+    while (*_link != entry){
+        _link = &(*_link)->hash_next;
+    }
+    *_link = entry->hash_next;
+    _object_cache_lru_unlink(entry);
+
+    _cache.stats.entries--;
+    _cache.stats.bytes -= entry->obj.file_size;
+    object_content_release(entry->obj.content);
+    free(entry);
+}
+
+/**
+ * @brief: Evict the least recently used objects until the cache fits the budget
+ */
+static void _object_cache_shrink(void){
+    while (_cache.lru_tail != NULL && _cache.stats.bytes > _cache.stats.budget){
+        _object_cache_remove(_cache.lru_tail);
+        _cache.stats.evictions++;
+    }
+}
+
+/**
+ * @brief: Double the buckets of the hash table
+ */
+static void _object_cache_grow(void){
+    size_t _old_count = _cache.bucket_count;
+    struct object_cache_entry ** _old_buckets = _cache.buckets;
+
+    _cache.bucket_count = _old_count == 0 ? OBJECT_CACHE_INITIAL_BUCKETS : _old_count * 2;
+    _cache.buckets = (struct object_cache_entry **)calloc(_cache.bucket_count, sizeof(struct object_cache_entry *));
+    if (_cache.buckets == NULL){
+        gitlet_panic("Failed to allocate memory for object cache");
+    }
+    for (size_t i = 0; i < _old_count; i++){
+        struct object_cache_entry * _entry = _old_buckets[i];
+        while (_entry != NULL){
+            struct object_cache_entry * _next = _entry->hash_next;
+            size_t _bucket = _object_cache_bucket(&_entry->oid);
+            _entry->hash_next = _cache.buckets[_bucket];
+            _cache.buckets[_bucket] = _entry;
+            _entry = _next;
+        }
+    }
+    free(_old_buckets);
+}
+
+void object_cache_set_budget(uint64_t budget){
+    pthread_mutex_lock(&_cache_lock);
+    _object_cache_init();
+    _cache.stats.budget = budget;
+    _object_cache_shrink();
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+void object_cache_get_stats(struct object_cache_stats * stats){
+    pthread_mutex_lock(&_cache_lock);
+    _object_cache_init();
+    *stats = _cache.stats;
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+bool object_cache_get(struct object * obj, const struct object_id * oid){
+    pthread_mutex_lock(&_cache_lock);
+    _object_cache_init();
+    if (_cache.bucket_count != 0){
+        for (struct object_cache_entry * _entry = _cache.buckets[_object_cache_bucket(oid)]; 
+            _entry != NULL; _entry = _entry->hash_next){
+            if (oid_equals(&_entry->oid, oid)){
+                _object_cache_lru_unlink(_entry);
+                _object_cache_lru_push(_entry);
+                object_content_retain(_entry->obj.content);
+                *obj = _entry->obj;
+                _cache.stats.hits++;
+                pthread_mutex_unlock(&_cache_lock);
+                return true;
+            }
+        }
+    }
+    _cache.stats.misses++;
+    pthread_mutex_unlock(&_cache_lock);
+    return false;
+}
+
+void object_cache_put(const struct object_id * oid, const struct object * obj){
+    pthread_mutex_lock(&_cache_lock);
+    _object_cache_init();
+    if (_cache.stats.budget == 0 || obj->file_size > _cache.stats.budget){
+        pthread_mutex_unlock(&_cache_lock);
+        return;
+    }
+    if (_cache.stats.entries >= _cache.bucket_count){
+        _object_cache_grow();
+    }
+
+    size_t _bucket = _object_cache_bucket(oid);
+    for (struct object_cache_entry * _entry = _cache.buckets[_bucket]; _entry != NULL; _entry = _entry->hash_next){
+        if (oid_equals(&_entry->oid, oid)){
+            pthread_mutex_unlock(&_cache_lock);
+            return;
+        }
+    }
+
+    struct object_cache_entry * _entry = (struct object_cache_entry *)calloc(1, sizeof(struct object_cache_entry));
+    if (_entry == NULL){
+        gitlet_panic("Failed to allocate memory for object cache");
+    }
+    _entry->oid = *oid;
+    _entry->obj = *obj;
+    object_content_retain(_entry->obj.content);
+    _entry->hash_next = _cache.buckets[_bucket];
+    _cache.buckets[_bucket] = _entry;
+    _object_cache_lru_push(_entry);
+
+    _cache.stats.entries++;
+    _cache.stats.bytes += obj->file_size;
+    _object_cache_shrink();
+    pthread_mutex_unlock(&_cache_lock);
+}
+
+void object_cache_clear(void){
+    pthread_mutex_lock(&_cache_lock);
+    while (_cache.lru_head != NULL){
+        _object_cache_remove(_cache.lru_head);
+    }
+    pthread_mutex_unlock(&_cache_lock);
+}
@@ -0,0 +1,102 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+#include <object/compress.h>
+#include <object/repository.h>
+#include <util/str.h>
+#include <util/error.h>
+
+static struct compress_policy _policy;
+static bool _policy_loaded = false;
+
+/**
+ * @brief: Get the zlib level from the config
+ * @param section: The section of the key
+ * @param key: The key
+ * @param default_value: The level returned when the key is not set
+ * @return: The zlib level, -1 is the default level of zlib
+ */
+static int _compress_config_get_level(const char * section, const char * key, int default_value){
+    const char * _value = repository_config_get(section, key);
+    if (_value == NULL){
+        return default_value;
+    }
+    char * _end = NULL;
+    long _level = strtol(_value, &_end, 10);
+    if (_end == _value || *_end != '\0' || _level < Z_DEFAULT_COMPRESSION || _level > Z_BEST_COMPRESSION){
+        gitlet_panic("Invalid compression level for %s.%s: %s", section, key, _value);
+    }
+    return (int)_level;
+}
+
+const struct compress_policy * compress_policy_get(void){
+    if (_policy_loaded){
+        return &_policy;
+    }
+    int _level = _compress_config_get_level("core", "compression", Z_DEFAULT_COMPRESSION);
+    _policy.loose_level = _compress_config_get_level("core", "looseCompression", _level);
+    _policy.pack_level = _compress_config_get_level("pack", "compression", _level);
+    _policy.store_threshold = repository_config_get_size("core", "storeThreshold", 0);
+    _policy.probe = repository_config_get_bool("core", "compressionProbe", true);
+    _policy_loaded = true;
+    return &_policy;
+}
+
+/**
+ * @brief: Compress the block at the fastest level to see whether it shrinks
+ * @param block: The block
+ * @param block_size: The size of the block
+ * @return: true if the block is incompressible, false otherwise
+ */
+static bool _compress_probe_incompressible(const unsigned char * block, size_t block_size){
+    unsigned long _bound = compressBound((uLong)block_size);
+    char * _buffer = (char *)malloc(_bound);
+    if (_buffer == NULL){
+        gitlet_panic("Failed to allocate memory for the compression probe");
+    }
+    unsigned long _compressed_size = str_compress_level((const char *)block, block_size, _buffer, _bound, Z_BEST_SPEED);
+    free(_buffer);
+    return (uint64_t)_compressed_size * 100 >= (uint64_t)block_size * COMPRESS_PROBE_RATIO;
+}
+
+int compress_choose_level(int level, uint64_t size, const unsigned char * block, size_t block_size){
+    const struct compress_policy * _policy = compress_policy_get();
+    if (level == Z_NO_COMPRESSION){
+        return level;
+    }
+    if (_policy->store_threshold != 0 && size > _policy->store_threshold){
+        return Z_NO_COMPRESSION;
+    }
+    if (_policy->probe && size > COMPRESS_PROBE_SIZE && block != NULL && block_size != 0){
+        size_t _probe_size = block_size < COMPRESS_PROBE_SIZE ? block_size : COMPRESS_PROBE_SIZE;
+        if (_compress_probe_incompressible(block, _probe_size)){
+            return Z_NO_COMPRESSION;
+        }
+    }
+    return level;
+}
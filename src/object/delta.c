@@ -0,0 +1,417 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <object/delta.h>
+#include <util/error.h>
+
+// size of the block hashed in the base and matched in the target
+#define DELTA_BLOCK_SIZE            16
+// the bucket of the index keeps at most this number of the blocks
+#define DELTA_BUCKET_LIMIT          64
+// multiplier of the rolling hash over the block
+#define DELTA_HASH_MULTIPLIER       0x01000193U
+// the longest literal run of one insert instruction
+#define DELTA_MAX_INSERT            127
+// the longest range of one copy instruction
+#define DELTA_MAX_COPY              0xffffffU
+// the copy instruction without the size bytes copies this many bytes
+#define DELTA_DEFAULT_COPY          0x10000U
+
+/**
+ * @brief: The block of the base object in the index
+ * @param offset: The offset of the block in the base object
+ * @param hash: The hash of the block
+ * @param next: The next block in the same bucket plus one, 0 for the end of the bucket
+ */
+struct delta_block{
+    uint32_t offset;
+    uint32_t hash;
+    uint32_t next;
+};
+
+struct delta_index{
+    const unsigned char * base;
+    size_t base_size;
+    uint32_t bucket_mask;
+    uint32_t * buckets;
+    unsigned char * bucket_sizes;
+    struct delta_block * blocks;
+};
+
+/**
+ * @brief: The delta being written
+ * @param buffer: The output buffer
+ * @param size: The size of the output
+ * @param capacity: The capacity of the buffer
+ * @param limit: The delta is dropped once it grows past this size
+ */
+struct delta_output{
+    unsigned char * buffer;
+    size_t size;
+    size_t capacity;
+    size_t limit;
+};
+
+/**
+ * @brief: Hash the whole block
+ */
+static inline uint32_t _delta_hash_block(const unsigned char * block){
+    uint32_t _hash = 0;
+    for (size_t i = 0; i < DELTA_BLOCK_SIZE; i++){
+        _hash = _hash * DELTA_HASH_MULTIPLIER + block[i];
+    }
+    return _hash;
+}
+
+/**
+ * @brief: Get the power of the multiplier used to drop the leaving byte of the rolling hash
+ */
+static inline uint32_t _delta_hash_drop_factor(void){
+    uint32_t _factor = 1;
+    for (size_t i = 1; i < DELTA_BLOCK_SIZE; i++){
+        _factor *= DELTA_HASH_MULTIPLIER;
+    }
+    return _factor;
+}
+
+struct delta_index * delta_index_create(const unsigned char * base, size_t base_size){
+    struct delta_index * _index = (struct delta_index *)calloc(1, sizeof(struct delta_index));
+    if (_index == NULL){
+        gitlet_panic("Failed to allocate memory for delta index");
+    }
+    _index->base = base;
+    _index->base_size = base_size;
+
+    size_t _block_count = base_size / DELTA_BLOCK_SIZE;
+    uint32_t _bucket_count = 16;
+    while (_bucket_count < _block_count && _bucket_count < (1U << 30)){
+        _bucket_count <<= 1;
+    }
+    _index->bucket_mask = _bucket_count - 1;
+    _index->buckets = (uint32_t *)calloc(_bucket_count, sizeof(uint32_t));
+    _index->bucket_sizes = (unsigned char *)calloc(_bucket_count, sizeof(unsigned char));
+    _index->blocks = (struct delta_block *)malloc((_block_count == 0 ? 1 : _block_count) * sizeof(struct delta_block));
+    if (_index->buckets == NULL || _index->bucket_sizes == NULL || _index->blocks == NULL){
+        gitlet_panic("Failed to allocate memory for delta index");
+    }
+
+    /**
+     * The blocks are indexed from the end of the base, so the earlier blocks
+     * end up at the head of the bucket and the long buckets keep the earliest blocks.
+     */
+    uint32_t _used = 0;
+    for (size_t i = _block_count; i > 0; i--){
+        uint32_t _offset = (uint32_t)((i - 1) * DELTA_BLOCK_SIZE);
+        uint32_t _hash = _delta_hash_block(base + _offset);
+        uint32_t _bucket = _hash & _index->bucket_mask;
+        if (_index->bucket_sizes[_bucket] == DELTA_BUCKET_LIMIT){
+            continue;
+        }
+        _index->bucket_sizes[_bucket]++;
+        _index->blocks[_used].offset = _offset;
+        _index->blocks[_used].hash = _hash;
+        _index->blocks[_used].next = _index->buckets[_bucket];
+        _index->buckets[_bucket] = ++_used;
+    }
+    return _index;
+}
+
+void delta_index_free(struct delta_index * index){
+    if (index == NULL){
+        return;
+    }
+    free(index->buckets);
+    free(index->bucket_sizes);
+    free(index->blocks);
+    free(index);
+}
+
+/**
+ * @brief: Append the bytes to the delta output
+ * @return: false if the delta grows past the limit
+ */
+static bool _delta_output_append(struct delta_output * output, const unsigned char * data, size_t size){
+    if (output->size + size >= output->limit){
+        return false;
+    }
+    if (output->size + size > output->capacity){
+        size_t _capacity = output->capacity * 2;
+        while (_capacity < output->size + size){
+            _capacity *= 2;
+        }
+        output->buffer = (unsigned char *)realloc(output->buffer, _capacity);
+        if (output->buffer == NULL){
+            gitlet_panic("Failed to allocate memory for delta");
+        }
+        output->capacity = _capacity;
+    }
+    memcpy(output->buffer + output->size, data, size);
+    output->size += size;
+    return true;
+}
+
+/**
+ * @brief: Append the size encoded as the little endian base-128 varint
+ */
+static bool _delta_output_size(struct delta_output * output, uint64_t size){
+    unsigned char _buffer[10];
+    size_t _length = 0;
+    do {
+        _buffer[_length] = size & 0x7f;
+        size >>= 7;
+        if (size != 0){
+            _buffer[_length] |= 0x80;
+        }
+        _length++;
+    } while (size != 0);
+    return _delta_output_append(output, _buffer, _length);
+}
+
+/**
+ * @brief: Append the insert instructions for the literal bytes
+ */
+static bool _delta_output_insert(struct delta_output * output, const unsigned char * data, size_t size){
+    while (size != 0){
+        unsigned char _length = (unsigned char)(size < DELTA_MAX_INSERT ? size : DELTA_MAX_INSERT);
+        if (!_delta_output_append(output, &_length, 1) || !_delta_output_append(output, data, _length)){
+            return false;
+        }
+        data += _length;
+        size -= _length;
+    }
+    return true;
+}
+
+/**
+ * @brief: Append the copy instructions for the range of the base
+ */
+static bool _delta_output_copy(struct delta_output * output, size_t offset, size_t size){
+    while (size != 0){
+        uint32_t _length = (uint32_t)(size < DELTA_MAX_COPY ? size : DELTA_MAX_COPY);
+        unsigned char _buffer[8];
+        size_t _position = 1;
+        _buffer[0] = 0x80;
+        for (unsigned int i = 0; i < 4; i++){
+            unsigned char _byte = (unsigned char)(offset >> (i * 8));
+            if (_byte != 0){
+                _buffer[0] |= (unsigned char)(1U << i);
+                _buffer[_position++] = _byte;
+            }
+        }
+        for (unsigned int i = 0; i < 3; i++){
+            unsigned char _byte = (unsigned char)(_length >> (i * 8));
+            if (_byte != 0){
+                _buffer[0] |= (unsigned char)(0x10U << i);
+                _buffer[_position++] = _byte;
+            }
+        }
+        if (!_delta_output_append(output, _buffer, _position)){
+            return false;
+        }
+        offset += _length;
+        size -= _length;
+    }
+    return true;
+}
+
+unsigned char * delta_create(const struct delta_index * index, const unsigned char * target, 
+    size_t target_size, size_t max_delta_size, size_t * delta_size){
+    // the offsets of the copy instruction only have 32 bits
+    if (index->base_size > UINT32_MAX){
+        return NULL;
+    }
+
+    struct delta_output _output;
+    _output.capacity = 64;
+    _output.size = 0;
+    _output.limit = max_delta_size;
+    _output.buffer = (unsigned char *)malloc(_output.capacity);
+    if (_output.buffer == NULL){
+        gitlet_panic("Failed to allocate memory for delta");
+    }
+
+    bool _success = _delta_output_size(&_output, index->base_size) 
+        && _delta_output_size(&_output, target_size);
+
+    const unsigned char * _base = index->base;
+    const uint32_t _drop_factor = _delta_hash_drop_factor();
+    size_t _insert_start = 0;
+    size_t _position = 0;
+    uint32_t _hash = target_size >= DELTA_BLOCK_SIZE ? _delta_hash_block(target) : 0;
+
+    while (_success && _position + DELTA_BLOCK_SIZE <= target_size){
+        // find the longest match among the base blocks with the same hash
+        size_t _best_offset = 0;
+        size_t _best_length = 0;
+        for (uint32_t _next = index->buckets[_hash & index->bucket_mask]; _next != 0; ){
+            const struct delta_block * _block = &index->blocks[_next - 1];
+            _next = _block->next;
+            if (_block->hash != _hash || memcmp(_base + _block->offset, target + _position, DELTA_BLOCK_SIZE) != 0){
+                continue;
+            }
+            size_t _length = DELTA_BLOCK_SIZE;
+            while (_block->offset + _length < index->base_size && _position + _length < target_size
+                && _base[_block->offset + _length] == target[_position + _length]){
+                _length++;
+            }
+            if (_length > _best_length){
+                _best_offset = _block->offset;
+                _best_length = _length;
+            }
+        }
+
+        if (_best_length == 0){
+            if (_position + DELTA_BLOCK_SIZE < target_size){
+                _hash = (_hash - target[_position] * _drop_factor) * DELTA_HASH_MULTIPLIER 
+                    + target[_position + DELTA_BLOCK_SIZE];
+            }
+            _position++;
+            continue;
+        }
+
+        // grow the match backward over the pending literal bytes
+        while (_best_offset > 0 && _position > _insert_start 
+            && _base[_best_offset - 1] == target[_position - 1]){
+            _best_offset--;
+            _position--;
+            _best_length++;
+        }
+
+        _success = _delta_output_insert(&_output, target + _insert_start, _position - _insert_start)
+            && _delta_output_copy(&_output, _best_offset, _best_length);
+        _position += _best_length;
+        _insert_start = _position;
+        if (_position + DELTA_BLOCK_SIZE <= target_size){
+            _hash = _delta_hash_block(target + _position);
+        }
+    }
+    _success = _success && _delta_output_insert(&_output, target + _insert_start, target_size - _insert_start);
+
+    if (!_success){
+        free(_output.buffer);
+        return NULL;
+    }
+    *delta_size = _output.size;
+    return _output.buffer;
+}
+
+/**
+ * @brief: Parse the little endian base-128 varint of the delta header
+ * @return: false if the delta ends in the middle of the varint
+ */
+static bool _delta_parse_size(const unsigned char ** current, const unsigned char * end, uint64_t * size){
+    uint64_t _size = 0;
+    unsigned int _shift = 0;
+    unsigned char _byte = 0;
+    do {
+        if (*current >= end || _shift > 63){
+            return false;
+        }
+        _byte = *(*current)++;
+        _size |= (uint64_t)(_byte & 0x7f) << _shift;
+        _shift += 7;
+    } while (_byte & 0x80);
+    *size = _size;
+    return true;
+}
+
+bool delta_header(const unsigned char * delta, size_t delta_size, 
+    uint64_t * base_size, uint64_t * result_size){
+    const unsigned char * _current = delta;
+    const unsigned char * _end = delta + delta_size;
+    return _delta_parse_size(&_current, _end, base_size) && _delta_parse_size(&_current, _end, result_size);
+}
+
+unsigned char * delta_apply(const unsigned char * base, size_t base_size, 
+    const unsigned char * delta, size_t delta_size, size_t * result_size){
+    const unsigned char * _current = delta;
+    const unsigned char * _end = delta + delta_size;
+
+    uint64_t _base_size = 0;
+    uint64_t _result_size = 0;
+    if (!_delta_parse_size(&_current, _end, &_base_size) || !_delta_parse_size(&_current, _end, &_result_size)){
+        gitlet_panic("Invalid delta header");
+    }
+    if (_base_size != base_size){
+        gitlet_panic("Delta base size mismatch");
+    }
+
+    unsigned char * _result = (unsigned char *)malloc(_result_size + 1);
+    if (_result == NULL){
+        gitlet_panic("Failed to allocate memory for delta result");
+    }
+    unsigned char * _output = _result;
+    unsigned char * _output_end = _result + _result_size;
+
+    while (_current < _end){
+        unsigned char _command = *_current++;
+        if (_command & 0x80){
+            size_t _offset = 0;
+            size_t _size = 0;
+            for (unsigned int i = 0; i < 4; i++){
+                if (_command & (1U << i)){
+                    if (_current >= _end){
+                        gitlet_panic("Truncated delta copy instruction");
+                    }
+                    _offset |= (size_t)*_current++ << (i * 8);
+                }
+            }
+            for (unsigned int i = 0; i < 3; i++){
+                if (_command & (0x10U << i)){
+                    if (_current >= _end){
+                        gitlet_panic("Truncated delta copy instruction");
+                    }
+                    _size |= (size_t)*_current++ << (i * 8);
+                }
+            }
+            if (_size == 0){
+                _size = DELTA_DEFAULT_COPY;
+            }
+            if (_offset > base_size || _size > base_size - _offset || _size > (size_t)(_output_end - _output)){
+                gitlet_panic("Delta copy instruction out of range");
+            }
+            memcpy(_output, base + _offset, _size);
+            _output += _size;
+        }else if (_command != 0){
+            if (_command > (size_t)(_end - _current) || _command > (size_t)(_output_end - _output)){
+                gitlet_panic("Delta insert instruction out of range");
+            }
+            memcpy(_output, _current, _command);
+            _output += _command;
+            _current += _command;
+        }else{
+            gitlet_panic("Unexpected delta instruction");
+        }
+    }
+    if (_output != _output_end){
+        gitlet_panic("Delta result size mismatch");
+    }
+
+    _result[_result_size] = '\0';
+    *result_size = (size_t)_result_size;
+    return _result;
+}
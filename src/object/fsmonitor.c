@@ -0,0 +1,207 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <object/fsmonitor.h>
+#include <object/repository.h>
+#include <util/error.h>
+#include <util/str.h>
+
+// the seconds to wait for the reply of the daemon before falling back to the full scan
+#define FSMONITOR_TIMEOUT_SECONDS   10
+
+bool fsmonitor_enabled(void){
+    return repository_config_get_bool("core", "fsmonitor", false);
+}
+
+/**
+ * @brief: Connect to the socket of the daemon
+ * @return: The socket, -1 if the daemon is not running
+ */
+static int _fsmonitor_connect(void){
+    int _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (_fd < 0){
+        return -1;
+    }
+    struct sockaddr_un _address;
+    memset(&_address, 0, sizeof(struct sockaddr_un));
+    _address.sun_family = AF_UNIX;
+    strcpy(_address.sun_path, FSMONITOR_SOCKET_PATH);
+    struct timeval _timeout = {FSMONITOR_TIMEOUT_SECONDS, 0};
+    if (connect(_fd, (struct sockaddr *)&_address, sizeof(struct sockaddr_un)) != 0
+        || setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &_timeout, sizeof(_timeout)) != 0){
+        close(_fd);
+        return -1;
+    }
+    return _fd;
+}
+
+/**
+ * @brief: Send the request to the daemon and read the whole reply
+ * @param request: The request line without the newline
+ * @param size: The pointer to store the size of the reply
+ * @return: The reply ending with an extra NUL, NULL if the daemon is not running
+ */
+static char * _fsmonitor_request(const char * request, size_t * size){
+    int _fd = _fsmonitor_connect();
+    if (_fd < 0){
+        return NULL;
+    }
+    size_t _request_length = strlen(request);
+    // a daemon going away must not kill the client with SIGPIPE
+    bool _sent = send(_fd, request, _request_length, MSG_NOSIGNAL) == (ssize_t)_request_length 
+        && send(_fd, "\n", 1, MSG_NOSIGNAL) == 1 && shutdown(_fd, SHUT_WR) == 0;
+
+    size_t _capacity = 4096;
+    size_t _size = 0;
+    char * _reply = (char *)malloc(_capacity);
+    if (_reply == NULL){
+        gitlet_panic("Failed to allocate memory for the fsmonitor reply");
+    }
+    ssize_t _read_size = 0;
+    while (_sent && (_read_size = read(_fd, _reply + _size, _capacity - _size - 1)) > 0){
+        _size += (size_t)_read_size;
+        if (_capacity - _size - 1 == 0){
+            _capacity *= 2;
+            _reply = (char *)realloc(_reply, _capacity);
+            if (_reply == NULL){
+                gitlet_panic("Failed to allocate memory for the fsmonitor reply");
+            }
+        }
+    }
+    close(_fd);
+    // a timeout or a broken connection is the same as no daemon
+    if (!_sent || _read_size < 0){
+        free(_reply);
+        return NULL;
+    }
+    _reply[_size] = '\0';
+    *size = _size;
+    return _reply;
+}
+
+/**
+ * @brief: Compare the paths for the sort
+ */
+static int _fsmonitor_compare_path(const void * left, const void * right){
+    return strcmp(*(const char * const *)left, *(const char * const *)right);
+}
+
+bool fsmonitor_query(const char * token, struct fsmonitor_changes * changes){
+    memset(changes, 0, sizeof(struct fsmonitor_changes));
+    char _request[FSMONITOR_TOKEN_MAX + sizeof(FSMONITOR_REQUEST_QUERY) + 1];
+    snprintf(_request, sizeof(_request), "%s %s", FSMONITOR_REQUEST_QUERY, token == NULL ? "" : token);
+    size_t _size = 0;
+    char * _reply = _fsmonitor_request(_request, &_size);
+    if (_reply == NULL){
+        return false;
+    }
+
+    // the token line, then the kind of the reply
+    char * _token_end = memchr(_reply, '\n', _size);
+    char * _kind = _token_end == NULL ? NULL : _token_end + 1;
+    char * _kind_end = _kind == NULL ? NULL : memchr(_kind, '\n', _size - (size_t)(_kind - _reply));
+    if (_kind_end == NULL || (size_t)(_token_end - _reply) >= FSMONITOR_TOKEN_MAX){
+        free(_reply);
+        return false;
+    }
+    *_token_end = '\0';
+    *_kind_end = '\0';
+    strcpy(changes->token, _reply);
+    changes->_reply = _reply;
+    if (!str_equals(_kind, FSMONITOR_REPLY_DIRTY)){
+        changes->full = true;
+        return true;
+    }
+
+    char * _paths_end = _reply + _size;
+    size_t _capacity = 0;
+    for (char * _path = _kind_end + 1; _path < _paths_end; _path += strlen(_path) + 1){
+        if (changes->count == _capacity){
+            _capacity = _capacity == 0 ? 64 : _capacity * 2;
+            changes->paths = (char **)realloc(changes->paths, _capacity * sizeof(char *));
+            if (changes->paths == NULL){
+                gitlet_panic("Failed to allocate memory for the fsmonitor reply");
+            }
+        }
+        changes->paths[changes->count++] = _path;
+    }
+    qsort(changes->paths, changes->count, sizeof(char *), _fsmonitor_compare_path);
+    return true;
+}
+
+bool fsmonitor_stop(void){
+    size_t _size = 0;
+    char * _reply = _fsmonitor_request(FSMONITOR_REQUEST_QUIT, &_size);
+    free(_reply);
+    return _reply != NULL;
+}
+
+void fsmonitor_changes_release(struct fsmonitor_changes * changes){
+    free(changes->paths);
+    free(changes->_reply);
+    memset(changes, 0, sizeof(struct fsmonitor_changes));
+}
+
+bool fsmonitor_refresh_index(struct index * index){
+    struct fsmonitor_changes _changes;
+    bool _replied = fsmonitor_enabled() && fsmonitor_query(index->fsmonitor_token, &_changes);
+    if (!_replied || _changes.full){
+        for (size_t i = 0; i < index->count; i++){
+            index->changed = index->changed || index->entries[i]->fsmonitor_valid;
+            index->entries[i]->fsmonitor_valid = false;
+        }
+    }else{
+        // the entries of a changed path, or under it when it is a directory
+        for (size_t i = 0; i < _changes.count; i++){
+            const char * _path = _changes.paths[i];
+            size_t _length = strlen(_path);
+            bool _found = false;
+            for (size_t j = index_position(index, _path, _length, &_found); j < index->count; j++){
+                struct index_entry * _entry = index->entries[j];
+                if (_entry->path_length < _length || memcmp(_entry->path, _path, _length) != 0){
+                    break;
+                }
+                if (_entry->path_length != _length && _entry->path[_length] != '/'){
+                    // a sibling like "a.txt" sorts between "a" and "a/", keep looking
+                    continue;
+                }
+                index->changed = index->changed || _entry->fsmonitor_valid;
+                _entry->fsmonitor_valid = false;
+            }
+        }
+    }
+    index_set_fsmonitor_token(index, _replied ? _changes.token : NULL);
+    if (_replied){
+        fsmonitor_changes_release(&_changes);
+    }
+    return _replied;
+}
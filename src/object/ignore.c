@@ -0,0 +1,452 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <openssl/evp.h>
+
+#include <object/ignore.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+/**
+ * @brief: The directory of the working tree with its rules read, in a tree
+ *         of the directories checked so far
+ * @param name: The name of the directory, "" for the top
+ * @param rules: The rules of the directory
+ * @param children: The sub-directories read, sorted by the names
+ * @param child_count: The number of the sub-directories
+ */
+struct _ignore_directory{
+    char * name;
+    struct ignore_rules * rules;
+    struct _ignore_directory ** children;
+    size_t child_count;
+};
+
+/**
+ * @brief: Match the text against the wildcard pattern, '*' and '?' do not
+ *         match '/' in the pathname mode, where "**" between the slashes 
+ *         matches any number of the directories.
+ * @param start: The start of the whole pattern, to tell where "**" stands
+ * @param pattern: The rest of the pattern
+ * @param text: The rest of the text
+ * @param pathname: Whether the text is a path instead of a name
+ * @return: true if the whole text matches
+ */
+static bool _ignore_wildmatch(const char * start, const char * pattern, const char * text, bool pathname){
+    for (; *pattern != '\0'; pattern++, text++){
+        switch (*pattern){
+            case '?':
+                if (*text == '\0' || (pathname && *text == '/')){
+                    return false;
+                }
+                break;
+            case '*': {
+                bool _at_boundary = pattern == start || pattern[-1] == '/';
+                bool _double = pattern[1] == '*';
+                while (*pattern == '*'){
+                    pattern++;
+                }
+                if (pathname && _double && _at_boundary && (*pattern == '\0' || *pattern == '/')){
+                    if (*pattern == '\0'){
+                        return true;
+                    }
+                    // "**/" matches nothing, or everything up to one of the following slashes
+                    for (const char * _text = text; ; _text++){
+                        if (_ignore_wildmatch(start, pattern + 1, _text, pathname)){
+                            return true;
+                        }
+                        if ((_text = strchr(_text, '/')) == NULL){
+                            return false;
+                        }
+                    }
+                }
+                for (;; text++){
+                    if (_ignore_wildmatch(start, pattern, text, pathname)){
+                        return true;
+                    }
+                    if (*text == '\0' || (pathname && *text == '/')){
+                        return false;
+                    }
+                }
+            }
+            case '[': {
+                if (*text == '\0' || (pathname && *text == '/')){
+                    return false;
+                }
+                pattern++;
+                bool _negate = *pattern == '!' || *pattern == '^';
+                pattern += _negate ? 1 : 0;
+                bool _matched = false;
+                const char * _first = pattern;
+                while (*pattern != '\0' && (*pattern != ']' || pattern == _first)){
+                    char _low = *pattern;
+                    if (_low == '\\' && pattern[1] != '\0'){
+                        _low = *++pattern;
+                    }
+                    if (pattern[1] == '-' && pattern[2] != ']' && pattern[2] != '\0'){
+                        pattern += 2;
+                        char _high = *pattern;
+                        if (_high == '\\' && pattern[1] != '\0'){
+                            _high = *++pattern;
+                        }
+                        _matched = _matched || (*text >= _low && *text <= _high);
+                    }else{
+                        _matched = _matched || *text == _low;
+                    }
+                    pattern++;
+                }
+                // a class without the closing bracket matches nothing
+                if (*pattern != ']' || _matched == _negate){
+                    return false;
+                }
+                break;
+            }
+            case '\\':
+                if (pattern[1] != '\0'){
+                    pattern++;
+                }
+                // fall through
+            default:
+                if (*text != *pattern){
+                    return false;
+                }
+                break;
+        }
+    }
+    return *text == '\0';
+}
+
+/**
+ * @brief: Parse the lines of the file into the patterns, the text is changed in place
+ * @param rules: The rules with the text read
+ * @param size: The size of the text
+ */
+static void _ignore_parse(struct ignore_rules * rules, size_t size){
+    size_t _capacity = 0;
+    size_t _line_number = 0;
+    char * _line = rules->_text;
+    char * _end = rules->_text + size;
+    while (_line < _end){
+        char * _newline = memchr(_line, '\n', (size_t)(_end - _line));
+        char * _line_end = _newline == NULL ? _end : _newline;
+        char * _next = _newline == NULL ? _end : _newline + 1;
+        *_line_end = '\0';
+        _line_number++;
+
+        // the line ending of windows and the trailing spaces not escaped are dropped
+        size_t _length = (size_t)(_line_end - _line);
+        if (_length > 0 && _line[_length - 1] == '\r'){
+            _line[--_length] = '\0';
+        }
+        while (_length > 0 && _line[_length - 1] == ' ' && (_length < 2 || _line[_length - 2] != '\\')){
+            _line[--_length] = '\0';
+        }
+        if (_length == 0 || _line[0] == '#'){
+            _line = _next;
+            continue;
+        }
+
+        struct ignore_pattern _pattern;
+        memset(&_pattern, 0, sizeof(struct ignore_pattern));
+        _pattern.line = _line_number;
+        // the line is kept for check-ignore -v, the pattern is a copy stripped of the markers
+        _pattern.text = _line;
+        char * _value = strdup(_line);
+        if (_value == NULL){
+            gitlet_panic("Failed to allocate memory for the ignore rules");
+        }
+        char * _pattern_start = _value;
+        if (*_pattern_start == '!'){
+            _pattern.negative = true;
+            _pattern_start++;
+        }else if (_pattern_start[0] == '\\' && (_pattern_start[1] == '!' || _pattern_start[1] == '#')){
+            _pattern_start++;
+        }
+        size_t _pattern_length = strlen(_pattern_start);
+        if (_pattern_length > 0 && _pattern_start[_pattern_length - 1] == '/'){
+            _pattern.directory_only = true;
+            _pattern_start[--_pattern_length] = '\0';
+        }
+        _pattern.anchored = strchr(_pattern_start, '/') != NULL;
+        if (*_pattern_start == '/'){
+            _pattern_start++;
+        }
+        if (*_pattern_start == '\0'){
+            free(_value);
+            _line = _next;
+            continue;
+        }
+        memmove(_value, _pattern_start, strlen(_pattern_start) + 1);
+        _pattern.pattern = _value;
+
+        if (rules->count == _capacity){
+            _capacity = _capacity == 0 ? 8 : _capacity * 2;
+            rules->patterns = (struct ignore_pattern *)realloc(rules->patterns, _capacity * sizeof(struct ignore_pattern));
+            if (rules->patterns == NULL){
+                gitlet_panic("Failed to allocate memory for the ignore rules");
+            }
+        }
+        rules->patterns[rules->count++] = _pattern;
+        _line = _next;
+    }
+}
+
+/**
+ * @brief: Read the rules of the file
+ * @param parent: The rules of the parent directory
+ * @param directory: The directory the patterns are relative to
+ * @param length: The length of the directory
+ * @param source: The path of the file
+ * @return: The rules allocated on the heap
+ */
+static struct ignore_rules * _ignore_rules_read(const struct ignore_rules * parent, 
+    const char * directory, size_t length, const char * source){
+    struct ignore_rules * _rules = (struct ignore_rules *)calloc(1, sizeof(struct ignore_rules));
+    if (_rules == NULL || (_rules->directory = strndup(directory, length)) == NULL 
+        || (_rules->source = strdup(source)) == NULL){
+        gitlet_panic("Failed to allocate memory for the ignore rules");
+    }
+    _rules->parent = parent;
+    _rules->directory_length = length;
+
+    int _fd = open(source, O_RDONLY | O_CLOEXEC);
+    if (_fd < 0){
+        return _rules;
+    }
+    struct stat _status;
+    if (fstat(_fd, &_status) != 0 || !S_ISREG(_status.st_mode)){
+        close(_fd);
+        return _rules;
+    }
+    size_t _size = (size_t)_status.st_size;
+    _rules->_text = (char *)malloc(_size + 1);
+    if (_rules->_text == NULL){
+        gitlet_panic("Failed to allocate memory for the ignore rules");
+    }
+    size_t _read = 0;
+    while (_read < _size){
+        ssize_t _result = read(_fd, _rules->_text + _read, _size - _read);
+        if (_result <= 0){
+            break;
+        }
+        _read += (size_t)_result;
+    }
+    close(_fd);
+    _rules->_text[_read] = '\0';
+
+    // the id of the blob tells a changed file without keeping its content
+    char _header[32];
+    int _header_length = snprintf(_header, sizeof(_header), "blob %zu", _read);
+    unsigned int _hash_size = 0;
+    EVP_MD_CTX * _context = EVP_MD_CTX_new();
+    if (_context == NULL || EVP_DigestInit_ex(_context, EVP_sha1(), NULL) != 1
+        || EVP_DigestUpdate(_context, _header, (size_t)_header_length + 1) != 1
+        || EVP_DigestUpdate(_context, _rules->_text, _read) != 1
+        || EVP_DigestFinal_ex(_context, _rules->oid.hash, &_hash_size) != 1){
+        gitlet_panic("Failed to hash the ignore file %s", source);
+    }
+    EVP_MD_CTX_free(_context);
+
+    _ignore_parse(_rules, _read);
+    return _rules;
+}
+
+struct ignore_rules * ignore_rules_load_exclude(void){
+    return _ignore_rules_read(NULL, "", 0, IGNORE_EXCLUDE_PATH);
+}
+
+struct ignore_rules * ignore_rules_load(const struct ignore_rules * parent, const char * directory, size_t length){
+    char _source[PATH_MAX];
+    if (length + strlen(IGNORE_FILE_NAME) + 2 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %.*s", (int)length, directory);
+    }
+    if (length == 0){
+        strcpy(_source, IGNORE_FILE_NAME);
+    }else{
+        memcpy(_source, directory, length);
+        _source[length] = '/';
+        strcpy(_source + length + 1, IGNORE_FILE_NAME);
+    }
+    return _ignore_rules_read(parent, directory, length, _source);
+}
+
+void ignore_rules_free(struct ignore_rules * rules){
+    if (rules == NULL){
+        return;
+    }
+    for (size_t i = 0; i < rules->count; i++){
+        free((char *)rules->patterns[i].pattern);
+    }
+    free(rules->patterns);
+    free(rules->directory);
+    free(rules->source);
+    free(rules->_text);
+    free(rules);
+}
+
+bool ignore_rules_match(const struct ignore_rules * rules, const char * path, size_t length, 
+    bool is_directory, const struct ignore_rules ** matched_rules, const struct ignore_pattern ** matched){
+    const char * _name = strrchr(path, '/');
+    _name = _name == NULL ? path : _name + 1;
+    for (const struct ignore_rules * _rules = rules; _rules != NULL; _rules = _rules->parent){
+        if (_rules->count == 0 || length <= _rules->directory_length){
+            continue;
+        }
+        const char * _relative = _rules->directory_length == 0 ? path : path + _rules->directory_length + 1;
+        for (size_t i = _rules->count; i > 0; i--){
+            const struct ignore_pattern * _pattern = &_rules->patterns[i - 1];
+            if (_pattern->directory_only && !is_directory){
+                continue;
+            }
+            bool _match = _pattern->anchored 
+                ? _ignore_wildmatch(_pattern->pattern, _pattern->pattern, _relative, true)
+                : _ignore_wildmatch(_pattern->pattern, _pattern->pattern, _name, false);
+            if (_match){
+                if (matched_rules != NULL){
+                    *matched_rules = _rules;
+                }
+                if (matched != NULL){
+                    *matched = _pattern;
+                }
+                return !_pattern->negative;
+            }
+        }
+    }
+    if (matched_rules != NULL){
+        *matched_rules = NULL;
+    }
+    if (matched != NULL){
+        *matched = NULL;
+    }
+    return false;
+}
+
+/**
+ * @brief: Create the directory of the tree with its rules read
+ */
+static struct _ignore_directory * _ignore_directory_create(const struct ignore_rules * parent, 
+    const char * path, size_t length, const char * name, size_t name_length){
+    struct _ignore_directory * _directory = (struct _ignore_directory *)calloc(1, sizeof(struct _ignore_directory));
+    if (_directory == NULL || (_directory->name = strndup(name, name_length)) == NULL){
+        gitlet_panic("Failed to allocate memory for the ignore rules");
+    }
+    _directory->rules = ignore_rules_load(parent, path, length);
+    return _directory;
+}
+
+/**
+ * @brief: Find the sub-directory of the tree, and read its rules the first time
+ * @param directory: The directory
+ * @param path: The path of the sub-directory
+ * @param length: The length of the path
+ * @param name: The name of the sub-directory, in the path
+ * @param name_length: The length of the name
+ * @return: The sub-directory
+ */
+static struct _ignore_directory * _ignore_directory_child(struct _ignore_directory * directory, 
+    const char * path, size_t length, const char * name, size_t name_length){
+    size_t _low = 0;
+    size_t _high = directory->child_count;
+    while (_low < _high){
+        size_t _middle = _low + (_high - _low) / 2;
+        const char * _name = directory->children[_middle]->name;
+        int _result = strncmp(_name, name, name_length);
+        _result = _result != 0 ? _result : (_name[name_length] == '\0' ? 0 : 1);
+        if (_result == 0){
+            return directory->children[_middle];
+        }
+        if (_result < 0){
+            _low = _middle + 1;
+        }else{
+            _high = _middle;
+        }
+    }
+    struct _ignore_directory ** _children = (struct _ignore_directory **)realloc(directory->children, 
+        (directory->child_count + 1) * sizeof(struct _ignore_directory *));
+    if (_children == NULL){
+        gitlet_panic("Failed to allocate memory for the ignore rules");
+    }
+    memmove(_children + _low + 1, _children + _low, (directory->child_count - _low) * sizeof(struct _ignore_directory *));
+    _children[_low] = _ignore_directory_create(directory->rules, path, length, name, name_length);
+    directory->children = _children;
+    directory->child_count++;
+    return _children[_low];
+}
+
+/**
+ * @brief: Free the directory of the tree and everything under it
+ */
+static void _ignore_directory_free(struct _ignore_directory * directory){
+    for (size_t i = 0; i < directory->child_count; i++){
+        _ignore_directory_free(directory->children[i]);
+    }
+    ignore_rules_free(directory->rules);
+    free(directory->children);
+    free(directory->name);
+    free(directory);
+}
+
+void ignore_init(struct ignore * ignore){
+    ignore->exclude = ignore_rules_load_exclude();
+    ignore->_root = _ignore_directory_create(ignore->exclude, "", 0, "", 0);
+}
+
+bool ignore_is_excluded(struct ignore * ignore, const char * path, size_t length, bool is_directory, 
+    const struct ignore_rules ** matched_rules, const struct ignore_pattern ** matched){
+    char _prefix[PATH_MAX];
+    if (length + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s", path);
+    }
+    memcpy(_prefix, path, length + 1);
+
+    // every parent directory is checked by the rules of its own parent first
+    struct _ignore_directory * _directory = ignore->_root;
+    size_t _start = 0;
+    for (const char * _slash = strchr(path, '/'); _slash != NULL; _slash = strchr(_slash + 1, '/')){
+        size_t _length = (size_t)(_slash - path);
+        _prefix[_length] = '\0';
+        if (ignore_rules_match(_directory->rules, _prefix, _length, true, matched_rules, matched)){
+            return true;
+        }
+        _directory = _ignore_directory_child(_directory, _prefix, _length, path + _start, _length - _start);
+        _prefix[_length] = '/';
+        _start = _length + 1;
+    }
+    return ignore_rules_match(_directory->rules, path, length, is_directory, matched_rules, matched);
+}
+
+void ignore_release(struct ignore * ignore){
+    _ignore_directory_free(ignore->_root);
+    ignore_rules_free(ignore->exclude);
+    ignore->_root = NULL;
+    ignore->exclude = NULL;
+}
@@ -0,0 +1,1378 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <openssl/evp.h>
+
+#include <object/index.h>
+#include <object/repository.h>
+#include <object/untracked.h>
+#include <util/error.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the size of the header, the signature, the version and the number of the entries
+#define INDEX_HEADER_SIZE           12
+// the size of the fixed part of the entry before the path
+#define INDEX_ENTRY_FIXED_SIZE      62
+// the size of the SHA1 checksum at the end of the file
+#define INDEX_CHECKSUM_SIZE         20
+// the flag of the entry with the extended flags, only valid since version 3
+#define INDEX_ENTRY_EXTENDED        0x4000
+// the version of the fsmonitor extension
+#define INDEX_FSMONITOR_VERSION     1
+// the size of the buffer the index file is written through
+#define INDEX_WRITE_BUFFER_SIZE     (64 * 1024)
+
+/**
+ * @brief: The index file being written, the bytes are hashed as they are flushed
+ * @param fd: The file descriptor of index.lock
+ * @param sha1_context: The SHA1 context of the checksum
+ * @param buffer: The write buffer
+ * @param size: The number of the bytes in the buffer
+ */
+struct _index_file{
+    int fd;
+    EVP_MD_CTX * sha1_context;
+    unsigned char * buffer;
+    size_t size;
+};
+
+static inline uint32_t _get_be32(const unsigned char * buffer){
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) 
+        | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+static inline uint16_t _get_be16(const unsigned char * buffer){
+    return (uint16_t)(((uint16_t)buffer[0] << 8) | (uint16_t)buffer[1]);
+}
+
+static inline void _put_be32(unsigned char * buffer, uint32_t value){
+    buffer[0] = (unsigned char)(value >> 24);
+    buffer[1] = (unsigned char)(value >> 16);
+    buffer[2] = (unsigned char)(value >> 8);
+    buffer[3] = (unsigned char)value;
+}
+
+static inline void _put_be16(unsigned char * buffer, uint16_t value){
+    buffer[0] = (unsigned char)(value >> 8);
+    buffer[1] = (unsigned char)value;
+}
+
+/**
+ * @brief: Get the path of the file in the gitlet repository
+ * @param buffer: The buffer to store the path, the length of the buffer is PATH_MAX
+ * @param name: The name of the file under .gitlet
+ */
+static void _index_get_path(char * buffer, const char * name){
+    if (getcwd(buffer, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+    if (strlen(buffer) + strlen("/.gitlet/") + strlen(name) + 1 > PATH_MAX){
+        gitlet_panic("Repository path too long: %s", buffer);
+    }
+    strcat(buffer, "/.gitlet/");
+    strcat(buffer, name);
+}
+
+/**
+ * @brief: Get the path of the shared index file
+ * @param buffer: The buffer to store the path, the length of the buffer is PATH_MAX
+ * @param oid: The checksum of the shared index
+ */
+static void _index_get_shared_path(char * buffer, const struct object_id * oid){
+    char _name[sizeof(INDEX_SHARED_PREFIX) + OBJECT_ID_HEX_SIZE];
+    memcpy(_name, INDEX_SHARED_PREFIX, strlen(INDEX_SHARED_PREFIX));
+    oid_to_hex(_name + strlen(INDEX_SHARED_PREFIX), oid);
+    _index_get_path(buffer, _name);
+}
+
+/**
+ * @brief: Compare two paths in the order of the index, the bytes of the 
+ *         paths and then their lengths
+ * @return: negative, zero or positive like memcmp
+ */
+static int _index_compare_path(const char * left, size_t left_length, const char * right, size_t right_length){
+    int _result = memcmp(left, right, left_length < right_length ? left_length : right_length);
+    if (_result != 0){
+        return _result;
+    }
+    return left_length < right_length ? -1 : (left_length > right_length ? 1 : 0);
+}
+
+/**
+ * @brief: Check whether the entry is in the block of memory
+ */
+static inline bool _index_in_block(const void * block, size_t size, const struct index_entry * entry){
+    const char * _block = (const char *)block;
+    return _block != NULL && (const char *)entry >= _block && (const char *)entry < _block + size;
+}
+
+/**
+ * @brief: Free the entry unless it lives in the block of the entries read 
+ *         from the index file or from the shared index file
+ */
+static void _index_free_entry(const struct index * index, struct index_entry * entry){
+    if (!_index_in_block(index->_arena, index->_arena_size, entry) 
+        && !_index_in_block(index->_shared_arena, index->_shared_arena_size, entry)){
+        free(entry);
+    }
+}
+
+/**
+ * @brief: Make room for at least the number of the entries
+ * @param index: The index
+ * @param capacity: The number of the entries
+ */
+static void _index_reserve(struct index * index, size_t capacity){
+    if (capacity <= index->capacity){
+        return;
+    }
+    size_t _capacity = index->capacity == 0 ? 16 : index->capacity;
+    while (_capacity < capacity){
+        _capacity *= 2;
+    }
+    index->entries = (struct index_entry **)realloc(index->entries, _capacity * sizeof(struct index_entry *));
+    if (index->entries == NULL){
+        gitlet_panic("Failed to allocate memory for the index entries");
+    }
+    index->capacity = _capacity;
+}
+
+/**
+ * @brief: Decode the variable length integer of the version 4 entry, every
+ *         byte holds 7 bits and the high bit tells another byte follows, one
+ *         is added before every shift so every value has one encoding, like git
+ * @param cursor: The pointer to the first byte, moved past the integer
+ * @param end: The end of the bytes
+ * @param value: The pointer to store the value
+ * @return: false if the integer is truncated or too large
+ */
+static bool _index_decode_varint(const unsigned char ** cursor, const unsigned char * end, size_t * value){
+    const unsigned char * _cursor = *cursor;
+    if (_cursor >= end){
+        return false;
+    }
+    unsigned char _byte = *_cursor++;
+    size_t _value = _byte & 127;
+    while (_byte & 128){
+        if (_cursor >= end || _value + 1 > (SIZE_MAX >> 7)){
+            return false;
+        }
+        _byte = *_cursor++;
+        _value = ((_value + 1) << 7) | (_byte & 127);
+    }
+    *cursor = _cursor;
+    *value = _value;
+    return true;
+}
+
+/**
+ * @brief: Encode the variable length integer of the version 4 entry
+ * @param buffer: The buffer to store the integer, at least 16 bytes
+ * @param value: The value
+ * @return: The number of the bytes of the integer
+ */
+static size_t _index_encode_varint(unsigned char * buffer, size_t value){
+    unsigned char _varint[16];
+    size_t _position = sizeof(_varint) - 1;
+    _varint[_position] = (unsigned char)(value & 127);
+    while (value >>= 7){
+        _varint[--_position] = (unsigned char)(128 | (--value & 127));
+    }
+    memcpy(buffer, _varint + _position, sizeof(_varint) - _position);
+    return sizeof(_varint) - _position;
+}
+
+/**
+ * @brief: Where the path of the entry is in the file
+ * @param kept: The number of the bytes kept from the start of the previous
+ *              path, 0 before the version 4
+ * @param suffix: The bytes appended to the ones kept, the whole path before the version 4
+ * @param suffix_length: The number of the bytes of the suffix
+ * @param entry_size: The size of the entry in the file
+ */
+struct _index_entry_path{
+    size_t kept;
+    const char * suffix;
+    size_t suffix_length;
+    size_t entry_size;
+};
+
+/**
+ * @brief: Find the path of the entry in the file
+ * @param data: The start of the entry in the file
+ * @param end: The end of the entries, which is before the checksum
+ * @param version: The version of the file
+ * @param previous_length: The length of the path of the previous entry, 0 for the first one
+ * @param path: The pointer to store where the path is
+ * @return: false if the entry is truncated or broken
+ */
+static bool _index_find_entry_path(const unsigned char * data, const unsigned char * end, uint32_t version, 
+    size_t previous_length, struct _index_entry_path * path){
+    if (end - data <= INDEX_ENTRY_FIXED_SIZE){
+        return false;
+    }
+    const unsigned char * _cursor = data + INDEX_ENTRY_FIXED_SIZE;
+    if (version == INDEX_VERSION_COMPRESSED){
+        size_t _strip = 0;
+        if (!_index_decode_varint(&_cursor, end, &_strip) || _strip > previous_length){
+            return false;
+        }
+        path->kept = previous_length - _strip;
+    }else{
+        path->kept = 0;
+    }
+    path->suffix = (const char *)_cursor;
+
+    uint16_t _flags = _get_be16(data + 60);
+    size_t _flags_length = _flags & INDEX_ENTRY_NAME_MASK;
+    if (version != INDEX_VERSION_COMPRESSED && _flags_length < INDEX_ENTRY_NAME_MASK){
+        path->suffix_length = _flags_length;
+    }else{
+        // the length of a long path does not fit in the flags, nor the one of a suffix
+        const unsigned char * _nul = memchr(_cursor, '\0', (size_t)(end - _cursor));
+        if (_nul == NULL){
+            return false;
+        }
+        path->suffix_length = (size_t)(_nul - _cursor);
+    }
+
+    if (version == INDEX_VERSION_COMPRESSED){
+        // the suffix ends with one NUL, and the entry is not padded
+        path->entry_size = (size_t)(_cursor - data) + path->suffix_length + 1;
+    }else{
+        // the entry is padded with 1 to 8 NULs to a multiple of 8 bytes
+        path->entry_size = (INDEX_ENTRY_FIXED_SIZE + path->suffix_length + 8) & ~(size_t)7;
+    }
+    return path->entry_size <= (size_t)(end - data) && path->suffix[path->suffix_length] == '\0'
+        && path->kept + path->suffix_length > 0;
+}
+
+/**
+ * @brief: Parse the entries of the mapped index file into one block of memory
+ * @param index: The index to store the entries
+ * @param map: The mapped index file
+ * @param size: The size of the file without the checksum
+ * @param count: The number of the entries from the header
+ * @param offsets: The array to store the offsets of the entries in the file, NULL if not needed
+ * @return: The offset of the first byte after the entries
+ * @note: The entries are decoded one at a time into the block, a prefix
+ *        compressed path is completed from the path of the entry before it.
+ */
+static size_t _index_parse_entries(struct index * index, const unsigned char * map, size_t size, 
+    uint32_t count, size_t * offsets){
+    uint32_t _version = _get_be32(map + 4);
+    const unsigned char * _end = map + size;
+    struct _index_entry_path _path;
+
+    /**
+     * Every path before the version 4 is shorter than its entry in the file,
+     * so the block holding the entries in memory never needs more than the 
+     * aligned fixed parts plus the size of the file. The prefix compressed
+     * paths can be much longer than the file, so their lengths are summed 
+     * by a first pass over the entries, which copies nothing.
+     */
+    size_t _entry_align = sizeof(size_t);
+    size_t _fixed_size = (sizeof(struct index_entry) + _entry_align) & ~(_entry_align - 1);
+    size_t _paths_size = size;
+    if (_version == INDEX_VERSION_COMPRESSED){
+        size_t _previous_length = 0;
+        size_t _offset = INDEX_HEADER_SIZE;
+        _paths_size = 0;
+        for (uint32_t i = 0; i < count; i++){
+            if (!_index_find_entry_path(map + _offset, _end, _version, _previous_length, &_path)){
+                gitlet_panic("index file corrupt: entry %u is truncated", i);
+            }
+            _previous_length = _path.kept + _path.suffix_length;
+            _paths_size += _previous_length + _entry_align;
+            _offset += _path.entry_size;
+        }
+    }
+    index->_arena_size = (size_t)count * _fixed_size + _paths_size;
+    index->_arena = malloc(index->_arena_size);
+    if (index->_arena == NULL){
+        gitlet_panic("Failed to allocate memory for the index entries");
+    }
+    _index_reserve(index, count);
+
+    char * _arena = (char *)index->_arena;
+    size_t _arena_used = 0;
+    size_t _offset = INDEX_HEADER_SIZE;
+    const struct index_entry * _previous = NULL;
+    for (uint32_t i = 0; i < count; i++){
+        const unsigned char * _data = map + _offset;
+        if (!_index_find_entry_path(_data, _end, _version, _previous == NULL ? 0 : _previous->path_length, &_path)){
+            gitlet_panic("index file corrupt: entry %u is truncated", i);
+        }
+        uint16_t _flags = _get_be16(_data + 60);
+        if (_flags & INDEX_ENTRY_EXTENDED){
+            gitlet_panic("index file corrupt: extended flags in version %u", _version);
+        }
+        size_t _path_length = _path.kept + _path.suffix_length;
+
+        struct index_entry * _entry = (struct index_entry *)(_arena + _arena_used);
+        _arena_used += (sizeof(struct index_entry) + _path_length + _entry_align) & ~(_entry_align - 1);
+        _entry->ctime_sec = _get_be32(_data);
+        _entry->ctime_nsec = _get_be32(_data + 4);
+        _entry->mtime_sec = _get_be32(_data + 8);
+        _entry->mtime_nsec = _get_be32(_data + 12);
+        _entry->dev = _get_be32(_data + 16);
+        _entry->ino = _get_be32(_data + 20);
+        _entry->mode = _get_be32(_data + 24);
+        _entry->uid = _get_be32(_data + 28);
+        _entry->gid = _get_be32(_data + 32);
+        _entry->size = _get_be32(_data + 36);
+        memcpy(_entry->oid.hash, _data + 40, OBJECT_ID_RAW_SIZE);
+        _entry->flags = _flags;
+        _entry->uptodate = false;
+        _entry->removed = false;
+        _entry->fsmonitor_valid = false;
+        _entry->shared_position = 0;
+        _entry->path_length = _path_length;
+        if (_path.kept > 0){
+            memcpy(_entry->path, _previous->path, _path.kept);
+        }
+        memcpy(_entry->path + _path.kept, _path.suffix, _path.suffix_length + 1);
+
+        // the binary search depends on the order, so it is checked once here
+        if (_previous != NULL && _index_compare_path(_previous->path, _previous->path_length, 
+            _entry->path, _path_length) >= 0){
+            gitlet_panic("index file corrupt: entries out of order at %s", _entry->path);
+        }
+        index->entries[i] = _entry;
+        if (offsets != NULL){
+            offsets[i] = _offset;
+        }
+        _offset += _path.entry_size;
+        _previous = _entry;
+    }
+    index->count = count;
+    return _offset;
+}
+
+/**
+ * @brief: Map the index file, and check its header and its checksum
+ * @param path: The path of the index file
+ * @param size: The pointer to store the size of the file
+ * @param status: The pointer to store the stat data of the file
+ * @return: The mapped file, NULL if the file does not exist
+ */
+static const unsigned char * _index_map(const char * path, size_t * size, struct stat * status){
+    int _fd = open(path, O_RDONLY);
+    if (_fd < 0){
+        if (errno == ENOENT){
+            return NULL;
+        }
+        gitlet_panic("Failed to open the index file: %s", path);
+    }
+    if (fstat(_fd, status) != 0){
+        close(_fd);
+        gitlet_panic("Failed to stat the index file: %s", path);
+    }
+    *size = (size_t)status->st_size;
+    if (*size < INDEX_HEADER_SIZE + INDEX_CHECKSUM_SIZE){
+        close(_fd);
+        gitlet_panic("index file smaller than expected");
+    }
+    const unsigned char * _map = (const unsigned char *)mmap(NULL, *size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    close(_fd);
+    if (_map == MAP_FAILED){
+        gitlet_panic("Failed to map the index file: %s", path);
+    }
+
+    if (memcmp(_map, INDEX_SIGNATURE, 4) != 0){
+        gitlet_panic("index file corrupt: bad signature");
+    }
+    if (_get_be32(_map + 4) != INDEX_VERSION && _get_be32(_map + 4) != INDEX_VERSION_COMPRESSED){
+        gitlet_panic("index file corrupt: unsupported version %u", _get_be32(_map + 4));
+    }
+
+    unsigned char _checksum[EVP_MAX_MD_SIZE];
+    if (EVP_Digest(_map, *size - INDEX_CHECKSUM_SIZE, _checksum, NULL, EVP_sha1(), NULL) != 1){
+        gitlet_panic("Failed to hash the index file");
+    }
+    if (memcmp(_checksum, _map + *size - INDEX_CHECKSUM_SIZE, INDEX_CHECKSUM_SIZE) != 0){
+        gitlet_panic("index file corrupt: bad checksum");
+    }
+    return _map;
+}
+
+/**
+ * @brief: Map the shared index file of the checksum
+ * @param index: The index to keep the mapped file
+ * @param oid: The checksum of the shared index
+ */
+static void _index_map_shared(struct index * index, const struct object_id * oid){
+    char _path[PATH_MAX];
+    _index_get_shared_path(_path, oid);
+    struct stat _status;
+    index->_shared_map = _index_map(_path, &index->_shared_map_size, &_status);
+    if (index->_shared_map == NULL){
+        gitlet_panic("index file corrupt: shared index %s is missing", _path);
+    }
+    if (memcmp(index->_shared_map + index->_shared_map_size - INDEX_CHECKSUM_SIZE, oid->hash, OBJECT_ID_RAW_SIZE) != 0){
+        gitlet_panic("index file corrupt: shared index %s is not the one linked", _path);
+    }
+    index->_shared_oid = *oid;
+}
+
+/**
+ * @brief: Unmap the shared index, the entries read from it stay
+ * @param index: The index
+ */
+static void _index_unmap_shared(struct index * index){
+    if (index->_shared_map != NULL){
+        munmap((void *)index->_shared_map, index->_shared_map_size);
+    }
+    free(index->_shared_offsets);
+    index->_shared_map = NULL;
+    index->_shared_map_size = 0;
+    index->_shared_offsets = NULL;
+    index->_shared_count = 0;
+    memset(&index->_shared_oid, 0, sizeof(struct object_id));
+}
+
+/**
+ * @brief: Read the split extension, the checksum of the shared index, the 
+ *         number of the removed entries and their positions in the shared 
+ *         index in ascending order. The entries of the shared index are 
+ *         merged with the ones read from the index file, which replace the 
+ *         ones of the same paths.
+ * @param index: The index with the entries read
+ * @param data: The data of the extension
+ * @param size: The size of the data
+ */
+static void _index_read_split(struct index * index, const unsigned char * data, size_t size){
+    if (size < OBJECT_ID_RAW_SIZE + 4 || index->_shared_map != NULL 
+        || (size - OBJECT_ID_RAW_SIZE - 4) / 4 != _get_be32(data + OBJECT_ID_RAW_SIZE)
+        || (size - OBJECT_ID_RAW_SIZE - 4) % 4 != 0){
+        gitlet_panic("index file corrupt: bad %s extension", INDEX_EXTENSION_SPLIT);
+    }
+    struct object_id _oid;
+    memcpy(_oid.hash, data, OBJECT_ID_RAW_SIZE);
+    size_t _removed_count = _get_be32(data + OBJECT_ID_RAW_SIZE);
+    const unsigned char * _removed = data + OBJECT_ID_RAW_SIZE + 4;
+
+    _index_map_shared(index, &_oid);
+    struct index _shared;
+    memset(&_shared, 0, sizeof(struct index));
+    uint32_t _shared_count = _get_be32(index->_shared_map + 8);
+    index->_shared_offsets = (size_t *)malloc(((size_t)_shared_count + 1) * sizeof(size_t));
+    if (index->_shared_offsets == NULL){
+        gitlet_panic("Failed to allocate memory for the shared index");
+    }
+    size_t _shared_end = _index_parse_entries(&_shared, index->_shared_map, 
+        index->_shared_map_size - INDEX_CHECKSUM_SIZE, _shared_count, index->_shared_offsets);
+    if (_shared_end != index->_shared_map_size - INDEX_CHECKSUM_SIZE){
+        gitlet_panic("index file corrupt: shared index has extensions");
+    }
+    index->_shared_count = _shared_count;
+    index->_shared_arena = _shared._arena;
+    index->_shared_arena_size = _shared._arena_size;
+
+    struct index_entry ** _entries = (struct index_entry **)malloc(
+        ((size_t)_shared_count + index->count + 1) * sizeof(struct index_entry *));
+    if (_entries == NULL){
+        gitlet_panic("Failed to allocate memory for the index entries");
+    }
+    size_t _merged = 0;
+    size_t _shared_index = 0;
+    size_t _delta_index = 0;
+    size_t _removed_index = 0;
+    while (_shared_index < _shared_count || _delta_index < index->count){
+        if (_shared_index < _shared_count && _removed_index < _removed_count 
+            && _get_be32(_removed + _removed_index * 4) == _shared_index){
+            _shared_index++;
+            _removed_index++;
+            continue;
+        }
+        struct index_entry * _shared_entry = _shared_index < _shared_count ? _shared.entries[_shared_index] : NULL;
+        struct index_entry * _delta_entry = _delta_index < index->count ? index->entries[_delta_index] : NULL;
+        int _result = _shared_entry == NULL ? 1 : (_delta_entry == NULL ? -1 : _index_compare_path(
+            _shared_entry->path, _shared_entry->path_length, _delta_entry->path, _delta_entry->path_length));
+        if (_result < 0){
+            _shared_entry->shared_position = (uint32_t)_shared_index + 1;
+            _entries[_merged++] = _shared_entry;
+            _shared_index++;
+            continue;
+        }
+        if (_result == 0){
+            _delta_entry->shared_position = (uint32_t)_shared_index + 1;
+            _shared_index++;
+        }
+        _entries[_merged++] = _delta_entry;
+        _delta_index++;
+    }
+    // the positions out of order or out of range are never reached
+    if (_removed_index != _removed_count){
+        gitlet_panic("index file corrupt: bad %s extension", INDEX_EXTENSION_SPLIT);
+    }
+    free(_shared.entries);
+    free(index->entries);
+    index->entries = _entries;
+    index->capacity = (size_t)_shared_count + index->count + 1;
+    index->count = _merged;
+}
+
+/**
+ * @brief: Read the fsmonitor extension, the version, the token ending with 
+ *         NUL and the bitmap of the valid entries in the order of the entries
+ * @param index: The index with the entries read
+ * @param data: The data of the extension
+ * @param size: The size of the data
+ * @note: An extension which does not fit the entries is dropped, every entry 
+ *        is then checked again, which is always safe.
+ */
+static void _index_read_fsmonitor(struct index * index, const unsigned char * data, size_t size){
+    if (size < 4 || _get_be32(data) != INDEX_FSMONITOR_VERSION){
+        return;
+    }
+    const unsigned char * _token_end = memchr(data + 4, '\0', size - 4);
+    if (_token_end == NULL || (size_t)(data + size - _token_end - 1) != (index->count + 7) / 8){
+        return;
+    }
+    index->fsmonitor_token = strdup((const char *)data + 4);
+    if (index->fsmonitor_token == NULL){
+        gitlet_panic("Failed to allocate memory for the fsmonitor token");
+    }
+    const unsigned char * _bitmap = _token_end + 1;
+    for (size_t i = 0; i < index->count; i++){
+        index->entries[i]->fsmonitor_valid = (_bitmap[i / 8] >> (i % 8)) & 1;
+    }
+}
+
+/**
+ * @brief: Read the extension of the index understood by gitlet
+ * @param index: The index with the entries read
+ * @param signature: The 4 bytes signature of the extension
+ * @param data: The data of the extension
+ * @param size: The size of the data
+ * @return: true if the extension is understood
+ */
+static bool _index_read_extension(struct index * index, const char * signature, const unsigned char * data, size_t size){
+    if (memcmp(signature, INDEX_EXTENSION_SPLIT, 4) == 0){
+        _index_read_split(index, data, size);
+        return true;
+    }
+    if (memcmp(signature, INDEX_EXTENSION_FSMONITOR, 4) == 0){
+        _index_read_fsmonitor(index, data, size);
+        return true;
+    }
+    if (memcmp(signature, INDEX_EXTENSION_UNTRACKED, 4) == 0){
+        // a broken cache is dropped, the next scan builds it again
+        untracked_cache_free(index->untracked);
+        index->untracked = untracked_cache_parse(data, size);
+        return true;
+    }
+    return false;
+}
+
+void index_read(struct index * index){
+    memset(index, 0, sizeof(struct index));
+
+    char _path[PATH_MAX];
+    _index_get_path(_path, "index");
+    size_t _size = 0;
+    struct stat _status;
+    const unsigned char * _map = _index_map(_path, &_size, &_status);
+    if (_map == NULL){
+        return;
+    }
+    index->timestamp_sec = (uint32_t)_status.st_mtim.tv_sec;
+    index->timestamp_nsec = (uint32_t)_status.st_mtim.tv_nsec;
+
+    size_t _data_size = _size - INDEX_CHECKSUM_SIZE;
+    size_t _offset = _index_parse_entries(index, _map, _data_size, _get_be32(_map + 8), NULL);
+
+    /**
+     * The extensions follow the entries, every one is a 4 bytes signature
+     * and a 4 bytes size. Like git, an extension with an upper case first
+     * letter is optional and skipped when it is not understood. The split
+     * extension is written first, the ones after it see the merged entries.
+     */
+    while (_offset < _data_size){
+        if (_offset + 8 > _data_size || _get_be32(_map + _offset + 4) > _data_size - _offset - 8){
+            gitlet_panic("index file corrupt: extension is truncated");
+        }
+        const char * _signature = (const char *)_map + _offset;
+        uint32_t _extension_size = _get_be32(_map + _offset + 4);
+        if (!_index_read_extension(index, _signature, _map + _offset + 8, _extension_size)
+            && (_signature[0] < 'A' || _signature[0] > 'Z')){
+            gitlet_panic("index uses %.4s extension, which we do not understand", _signature);
+        }
+        _offset += 8 + _extension_size;
+    }
+    munmap((void *)_map, _size);
+}
+
+/**
+ * @brief: Write the buffered bytes to the index file and hash them
+ * @param file: The index file
+ * @return: true if all the bytes are written
+ */
+static bool _index_file_flush(struct _index_file * file){
+    EVP_DigestUpdate(file->sha1_context, file->buffer, file->size);
+    size_t _written = 0;
+    while (_written < file->size){
+        ssize_t _result = write(file->fd, file->buffer + _written, file->size - _written);
+        if (_result < 0 && errno == EINTR){
+            continue;
+        }
+        if (_result <= 0){
+            return false;
+        }
+        _written += (size_t)_result;
+    }
+    file->size = 0;
+    return true;
+}
+
+/**
+ * @brief: Append the bytes to the index file
+ * @param file: The index file
+ * @param data: The bytes
+ * @param size: The number of the bytes, at most INDEX_WRITE_BUFFER_SIZE
+ * @return: true if no write failed
+ */
+static bool _index_file_write(struct _index_file * file, const void * data, size_t size){
+    if (file->size + size > INDEX_WRITE_BUFFER_SIZE && !_index_file_flush(file)){
+        return false;
+    }
+    memcpy(file->buffer + file->size, data, size);
+    file->size += size;
+    return true;
+}
+
+/**
+ * @brief: Start writing the index file
+ * @param file: The index file
+ * @param fd: The file descriptor of the file
+ */
+static void _index_file_init(struct _index_file * file, int fd){
+    file->fd = fd;
+    file->size = 0;
+    file->sha1_context = EVP_MD_CTX_new();
+    file->buffer = (unsigned char *)malloc(INDEX_WRITE_BUFFER_SIZE);
+    if (file->sha1_context == NULL || file->buffer == NULL 
+        || EVP_DigestInit_ex(file->sha1_context, EVP_sha1(), NULL) != 1){
+        gitlet_panic("Failed to allocate memory for the index file");
+    }
+}
+
+/**
+ * @brief: Flush the index file and append the checksum of its bytes
+ * @param file: The index file, which can no longer be written
+ * @param checksum: The pointer to store the checksum
+ * @return: true if no write failed
+ */
+static bool _index_file_finish(struct _index_file * file, struct object_id * checksum){
+    bool _written = _index_file_flush(file);
+    if (_written){
+        unsigned char _checksum[EVP_MAX_MD_SIZE];
+        EVP_DigestFinal_ex(file->sha1_context, _checksum, NULL);
+        memcpy(checksum->hash, _checksum, OBJECT_ID_RAW_SIZE);
+        _written = write(file->fd, _checksum, INDEX_CHECKSUM_SIZE) == INDEX_CHECKSUM_SIZE;
+    }
+    EVP_MD_CTX_free(file->sha1_context);
+    free(file->buffer);
+    return _written;
+}
+
+/**
+ * @brief: Encode the entry as it is in the file, before its path
+ * @param entry: The entry
+ * @param data: The buffer of INDEX_ENTRY_FIXED_SIZE bytes
+ */
+static void _index_entry_encode(const struct index_entry * entry, unsigned char * data){
+    _put_be32(data, entry->ctime_sec);
+    _put_be32(data + 4, entry->ctime_nsec);
+    _put_be32(data + 8, entry->mtime_sec);
+    _put_be32(data + 12, entry->mtime_nsec);
+    _put_be32(data + 16, entry->dev);
+    _put_be32(data + 20, entry->ino);
+    _put_be32(data + 24, entry->mode);
+    _put_be32(data + 28, entry->uid);
+    _put_be32(data + 32, entry->gid);
+    _put_be32(data + 36, entry->size);
+    memcpy(data + 40, entry->oid.hash, OBJECT_ID_RAW_SIZE);
+    size_t _name_length = entry->path_length < INDEX_ENTRY_NAME_MASK ? entry->path_length : INDEX_ENTRY_NAME_MASK;
+    _put_be16(data + 60, (uint16_t)((entry->flags & ~INDEX_ENTRY_NAME_MASK) | _name_length));
+}
+
+/**
+ * @brief: Write the header and the entries to the file
+ * @param entries: The entries sorted by the paths
+ * @param count: The number of the entries
+ * @param version: The version of the file
+ * @param file: The index file
+ * @param offsets: The array to store the offsets of the entries in the file, NULL if not needed
+ * @return: true if no write failed
+ */
+static bool _index_write_entries(struct index_entry * const * entries, size_t count, uint32_t version,
+    struct _index_file * file, size_t * offsets){
+    unsigned char _header[INDEX_HEADER_SIZE];
+    memcpy(_header, INDEX_SIGNATURE, 4);
+    _put_be32(_header + 4, version);
+    _put_be32(_header + 8, (uint32_t)count);
+    if (!_index_file_write(file, _header, INDEX_HEADER_SIZE)){
+        return false;
+    }
+
+    static const unsigned char _padding_bytes[8] = {0};
+    unsigned char _data[INDEX_ENTRY_FIXED_SIZE + 16];
+    size_t _offset = INDEX_HEADER_SIZE;
+    const struct index_entry * _previous = NULL;
+    for (size_t i = 0; i < count; i++){
+        const struct index_entry * _entry = entries[i];
+        _index_entry_encode(_entry, _data);
+        size_t _data_size = INDEX_ENTRY_FIXED_SIZE;
+        size_t _kept = 0;
+        size_t _padding = 0;
+        if (version == INDEX_VERSION_COMPRESSED){
+            // the path shares its prefix with the previous one, only the rest is written
+            size_t _previous_length = _previous == NULL ? 0 : _previous->path_length;
+            size_t _limit = _previous_length < _entry->path_length ? _previous_length : _entry->path_length;
+            while (_kept < _limit && _previous->path[_kept] == _entry->path[_kept]){
+                _kept++;
+            }
+            _data_size += _index_encode_varint(_data + INDEX_ENTRY_FIXED_SIZE, _previous_length - _kept);
+            _padding = 1;
+        }else{
+            _padding = ((INDEX_ENTRY_FIXED_SIZE + _entry->path_length + 8) & ~(size_t)7) 
+                - INDEX_ENTRY_FIXED_SIZE - _entry->path_length;
+        }
+        if (!_index_file_write(file, _data, _data_size)){
+            return false;
+        }
+        // the path is written in pieces since it can be longer than the buffer
+        for (size_t _written = _kept; _written < _entry->path_length; _written += INDEX_WRITE_BUFFER_SIZE){
+            size_t _piece = _entry->path_length - _written;
+            _piece = _piece < INDEX_WRITE_BUFFER_SIZE ? _piece : INDEX_WRITE_BUFFER_SIZE;
+            if (!_index_file_write(file, _entry->path + _written, _piece)){
+                return false;
+            }
+        }
+        if (!_index_file_write(file, _padding_bytes, _padding)){
+            return false;
+        }
+        if (offsets != NULL){
+            offsets[i] = _offset;
+        }
+        _offset += _data_size + _entry->path_length - _kept + _padding;
+        _previous = _entry;
+    }
+    return true;
+}
+
+/**
+ * @brief: The entries of the index written along with the shared index
+ * @param entries: The entries added or changed since the shared index
+ * @param count: The number of the changed entries
+ * @param removed: The positions of the entries of the shared index removed since
+ * @param removed_count: The number of the removed entries
+ */
+struct _index_split{
+    struct index_entry ** entries;
+    size_t count;
+    uint32_t * removed;
+    size_t removed_count;
+};
+
+/**
+ * @brief: Check whether the entry is the same as its entry in the shared index
+ * @param index: The index with the shared index mapped
+ * @param entry: The entry
+ */
+static bool _index_shared_entry_matches(const struct index * index, const struct index_entry * entry){
+    if (entry->shared_position == 0 || entry->shared_position > index->_shared_count){
+        return false;
+    }
+    // the path is the same, the entries are matched by the paths
+    unsigned char _data[INDEX_ENTRY_FIXED_SIZE];
+    _index_entry_encode(entry, _data);
+    return memcmp(_data, index->_shared_map + index->_shared_offsets[entry->shared_position - 1], 
+        INDEX_ENTRY_FIXED_SIZE) == 0;
+}
+
+/**
+ * @brief: Find the entries changed and removed since the shared index
+ * @param index: The index
+ * @param split: The split to store the result, released by _index_split_release
+ * @note: The entries are compared with the bytes of the shared index, so an
+ *        entry refreshed in place is found as well as a replaced one.
+ */
+static void _index_split_prepare(const struct index * index, struct _index_split * split){
+    split->entries = (struct index_entry **)malloc((index->count + 1) * sizeof(struct index_entry *));
+    split->removed = (uint32_t *)malloc((index->_shared_count + 1) * sizeof(uint32_t));
+    bool * _kept = (bool *)calloc(index->_shared_count + 1, sizeof(bool));
+    if (split->entries == NULL || split->removed == NULL || _kept == NULL){
+        gitlet_panic("Failed to allocate memory for the split index");
+    }
+    split->count = 0;
+    split->removed_count = 0;
+    for (size_t i = 0; i < index->count; i++){
+        struct index_entry * _entry = index->entries[i];
+        if (_entry->shared_position != 0 && _entry->shared_position <= index->_shared_count){
+            _kept[_entry->shared_position - 1] = true;
+        }
+        if (!_index_shared_entry_matches(index, _entry)){
+            split->entries[split->count++] = _entry;
+        }
+    }
+    for (size_t i = 0; i < index->_shared_count; i++){
+        if (!_kept[i]){
+            split->removed[split->removed_count++] = (uint32_t)i;
+        }
+    }
+    free(_kept);
+}
+
+/**
+ * @brief: Release the split
+ * @param split: The split
+ */
+static void _index_split_release(struct _index_split * split){
+    free(split->entries);
+    free(split->removed);
+}
+
+/**
+ * @brief: Write all the entries as the new shared index, and map it
+ * @param index: The index
+ * @param version: The version of the file
+ * @return: true if the shared index is written
+ * @note: The shared index is written through sharedindex.lock, which is only
+ *        written while index.lock is held.
+ */
+static bool _index_write_shared(struct index * index, uint32_t version){
+    char _lock_path[PATH_MAX];
+    _index_get_path(_lock_path, INDEX_SHARED_PREFIX "lock");
+    int _fd = open(_lock_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (_fd < 0){
+        return false;
+    }
+    size_t * _offsets = (size_t *)malloc((index->count + 1) * sizeof(size_t));
+    if (_offsets == NULL){
+        gitlet_panic("Failed to allocate memory for the shared index");
+    }
+
+    struct _index_file _file;
+    _index_file_init(&_file, _fd);
+    struct object_id _oid;
+    memset(&_oid, 0, sizeof(struct object_id));
+    bool _written = _index_write_entries(index->entries, index->count, version, &_file, _offsets);
+    _written = _index_file_finish(&_file, &_oid) && _written;
+    char _shared_path[PATH_MAX];
+    _index_get_shared_path(_shared_path, &_oid);
+    if (close(_fd) != 0 || !_written || rename(_lock_path, _shared_path) != 0){
+        unlink(_lock_path);
+        free(_offsets);
+        return false;
+    }
+
+    _index_unmap_shared(index);
+    _index_map_shared(index, &_oid);
+    index->_shared_offsets = _offsets;
+    index->_shared_count = index->count;
+    for (size_t i = 0; i < index->count; i++){
+        index->entries[i]->shared_position = (uint32_t)i + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief: Write the split extension
+ * @param index: The index with the shared index mapped
+ * @param split: The split
+ * @param file: The index file
+ * @return: true if no write failed
+ */
+static bool _index_write_split(const struct index * index, const struct _index_split * split, struct _index_file * file){
+    unsigned char _header[8 + OBJECT_ID_RAW_SIZE + 4];
+    memcpy(_header, INDEX_EXTENSION_SPLIT, 4);
+    _put_be32(_header + 4, (uint32_t)(OBJECT_ID_RAW_SIZE + 4 + split->removed_count * 4));
+    memcpy(_header + 8, index->_shared_oid.hash, OBJECT_ID_RAW_SIZE);
+    _put_be32(_header + 8 + OBJECT_ID_RAW_SIZE, (uint32_t)split->removed_count);
+    if (!_index_file_write(file, _header, sizeof(_header))){
+        return false;
+    }
+    for (size_t i = 0; i < split->removed_count; i++){
+        unsigned char _position[4];
+        _put_be32(_position, split->removed[i]);
+        if (!_index_file_write(file, _position, sizeof(_position))){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief: Write the fsmonitor extension, if the index has a token
+ * @param index: The index
+ * @param file: The index file
+ * @return: true if no write failed
+ */
+static bool _index_write_fsmonitor(const struct index * index, struct _index_file * file){
+    if (index->fsmonitor_token == NULL){
+        return true;
+    }
+    size_t _token_size = strlen(index->fsmonitor_token) + 1;
+    size_t _bitmap_size = (index->count + 7) / 8;
+    unsigned char _header[12];
+    memcpy(_header, INDEX_EXTENSION_FSMONITOR, 4);
+    _put_be32(_header + 4, (uint32_t)(4 + _token_size + _bitmap_size));
+    _put_be32(_header + 8, INDEX_FSMONITOR_VERSION);
+    if (!_index_file_write(file, _header, sizeof(_header)) 
+        || !_index_file_write(file, index->fsmonitor_token, _token_size)){
+        return false;
+    }
+    unsigned char _bits = 0;
+    for (size_t i = 0; i < index->count; i++){
+        _bits |= (unsigned char)(index->entries[i]->fsmonitor_valid ? 1 << (i % 8) : 0);
+        if (i % 8 == 7 || i + 1 == index->count){
+            if (!_index_file_write(file, &_bits, 1)){
+                return false;
+            }
+            _bits = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief: Write the untracked cache extension, if the index has the cache
+ * @param index: The index
+ * @param file: The index file
+ * @return: true if no write failed
+ */
+static bool _index_write_untracked(const struct index * index, struct _index_file * file){
+    if (index->untracked == NULL){
+        return true;
+    }
+    size_t _size = 0;
+    unsigned char * _data = untracked_cache_serialize(index->untracked, &_size);
+    unsigned char _header[8];
+    memcpy(_header, INDEX_EXTENSION_UNTRACKED, 4);
+    _put_be32(_header + 4, (uint32_t)_size);
+    bool _written = _index_file_write(file, _header, sizeof(_header));
+    // the cache is written in pieces since it can be larger than the buffer
+    for (size_t _offset = 0; _written && _offset < _size; _offset += INDEX_WRITE_BUFFER_SIZE){
+        size_t _piece = _size - _offset < INDEX_WRITE_BUFFER_SIZE ? _size - _offset : INDEX_WRITE_BUFFER_SIZE;
+        _written = _index_file_write(file, _data + _offset, _piece);
+    }
+    free(_data);
+    return _written;
+}
+
+/**
+ * @brief: Write the extensions of the index after the entries
+ * @param index: The index
+ * @param split: The split, NULL if the index is written as a whole
+ * @param file: The index file
+ * @return: true if no write failed
+ */
+static bool _index_write_extensions(const struct index * index, const struct _index_split * split, 
+    struct _index_file * file){
+    return (split == NULL || _index_write_split(index, split, file)) 
+        && _index_write_fsmonitor(index, file) && _index_write_untracked(index, file);
+}
+
+/**
+ * @brief: Smudge the racily clean entries before the index is written
+ * @param index: The index
+ * @note: An entry modified after the old index was written but within its
+ *        second would look clean against the newer index file. So the racy
+ *        entries are checked now, and a modified one gets the size of zero,
+ *        which no longer matches the file and forces the content check.
+ */
+static void _index_smudge_racy_entries(struct index * index){
+    struct object_writer _writer;
+    bool _writer_ready = false;
+    for (size_t i = 0; i < index->count; i++){
+        struct index_entry * _entry = index->entries[i];
+        if (_entry->uptodate || !index_entry_is_racy(index, _entry)){
+            continue;
+        }
+        struct stat _status;
+        if (lstat(_entry->path, &_status) != 0){
+            continue;
+        }
+        if (!_writer_ready){
+            object_writer_init(&_writer, false);
+            _writer_ready = true;
+        }
+        switch (index_entry_check(index, _entry, &_status, &_writer)){
+            case INDEX_ENTRY_MODIFIED:
+                _entry->size = 0;
+                break;
+            case INDEX_ENTRY_REFRESHED:
+                index->changed = true;
+                break;
+            default:
+                break;
+        }
+    }
+    if (_writer_ready){
+        object_writer_release(&_writer);
+    }
+}
+
+/**
+ * @brief: Get the version of the index file to write from index.version
+ * @return: INDEX_VERSION or INDEX_VERSION_COMPRESSED
+ */
+static uint32_t _index_get_version(void){
+    uint64_t _version = repository_config_get_size("index", "version", INDEX_VERSION);
+    if (_version != INDEX_VERSION && _version != INDEX_VERSION_COMPRESSED){
+        gitlet_panic("index.version set, but the value is invalid: %llu", (unsigned long long)_version);
+    }
+    return (uint32_t)_version;
+}
+
+/**
+ * @brief: Write the index through index.lock
+ * @param index: The index
+ * @param fatal: Whether the existing lock is a fatal error, otherwise give up
+ * @return: true if the index is written
+ */
+static bool _index_write(struct index * index, bool fatal){
+    char _lock_path[PATH_MAX];
+    char _index_path[PATH_MAX];
+    _index_get_path(_lock_path, "index.lock");
+    _index_get_path(_index_path, "index");
+
+    // the config is read before the lock, a bad value is fatal
+    uint32_t _version = _index_get_version();
+    bool _split_index = repository_config_get_bool("core", "splitIndex", false);
+    uint64_t _max_percent = repository_config_get_size("splitIndex", "maxPercentChange", INDEX_SPLIT_MAX_PERCENT);
+
+    int _fd = open(_lock_path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+    if (_fd < 0){
+        if (errno == EEXIST && !fatal){
+            return false;
+        }
+        if (errno == EEXIST){
+            gitlet_panic("Unable to create '%s': File exists.\n"
+                "Another gitlet process seems to be running in this repository", _lock_path);
+        }
+        gitlet_panic("Unable to create '%s'", _lock_path);
+    }
+
+    _index_smudge_racy_entries(index);
+
+    /**
+     * With the split index only the entries changed since the shared index 
+     * are written, until they are too many compared with all the entries,
+     * then all of them are written as the new shared index.
+     */
+    bool _had_shared = index->_shared_map != NULL;
+    struct object_id _old_shared = index->_shared_oid;
+    struct _index_split _split;
+    if (_split_index){
+        _index_split_prepare(index, &_split);
+        if (!_had_shared || (_split.count + _split.removed_count) * 100 > _max_percent * index->count){
+            if (!_index_write_shared(index, _version)){
+                close(_fd);
+                unlink(_lock_path);
+                gitlet_panic("Failed to write the shared index file");
+            }
+            _split.count = 0;
+            _split.removed_count = 0;
+        }
+    }
+
+    struct _index_file _file;
+    _index_file_init(&_file, _fd);
+    struct object_id _checksum;
+    bool _written = _split_index ? _index_write_entries(_split.entries, _split.count, _version, &_file, NULL) 
+        : _index_write_entries(index->entries, index->count, _version, &_file, NULL);
+    _written = _written && _index_write_extensions(index, _split_index ? &_split : NULL, &_file);
+    _written = _index_file_finish(&_file, &_checksum) && _written;
+    if (_split_index){
+        _index_split_release(&_split);
+    }
+
+    // the racy entries are judged against the mtime of the new file from now on
+    struct stat _status;
+    _written = _written && fstat(_fd, &_status) == 0;
+    if (close(_fd) != 0 || !_written || rename(_lock_path, _index_path) != 0){
+        unlink(_lock_path);
+        gitlet_panic("Failed to write the index file: %s", _index_path);
+    }
+    index->timestamp_sec = (uint32_t)_status.st_mtim.tv_sec;
+    index->timestamp_nsec = (uint32_t)_status.st_mtim.tv_nsec;
+    index->changed = false;
+
+    // the shared index no longer linked is removed once the new index is in place
+    if (_had_shared && (!_split_index || !oid_equals(&_old_shared, &index->_shared_oid))){
+        char _shared_path[PATH_MAX];
+        _index_get_shared_path(_shared_path, &_old_shared);
+        unlink(_shared_path);
+    }
+    if (!_split_index){
+        _index_unmap_shared(index);
+    }
+    return true;
+}
+
+void index_write(struct index * index){
+    _index_write(index, true);
+}
+
+bool index_try_write(struct index * index){
+    return _index_write(index, false);
+}
+
+void index_set_fsmonitor_token(struct index * index, const char * token){
+    if (token == NULL ? index->fsmonitor_token == NULL 
+        : (index->fsmonitor_token != NULL && str_equals(token, index->fsmonitor_token))){
+        return;
+    }
+    free(index->fsmonitor_token);
+    index->fsmonitor_token = token == NULL ? NULL : strdup(token);
+    if (token != NULL && index->fsmonitor_token == NULL){
+        gitlet_panic("Failed to allocate memory for the fsmonitor token");
+    }
+    index->changed = true;
+}
+
+void index_release(struct index * index){
+    free(index->fsmonitor_token);
+    untracked_cache_free(index->untracked);
+    for (size_t i = 0; i < index->count; i++){
+        _index_free_entry(index, index->entries[i]);
+    }
+    free(index->entries);
+    free(index->_arena);
+    _index_unmap_shared(index);
+    free(index->_shared_arena);
+    memset(index, 0, sizeof(struct index));
+}
+
+size_t index_position(const struct index * index, const char * path, size_t length, bool * found){
+    size_t _low = 0;
+    size_t _high = index->count;
+    while (_low < _high){
+        size_t _middle = _low + (_high - _low) / 2;
+        const struct index_entry * _entry = index->entries[_middle];
+        int _result = _index_compare_path(_entry->path, _entry->path_length, path, length);
+        if (_result == 0){
+            *found = true;
+            return _middle;
+        }
+        if (_result < 0){
+            _low = _middle + 1;
+        }else{
+            _high = _middle;
+        }
+    }
+    *found = false;
+    return _low;
+}
+
+struct index_entry * index_find(const struct index * index, const char * path){
+    bool _found = false;
+    size_t _position = index_position(index, path, strlen(path), &_found);
+    return _found ? index->entries[_position] : NULL;
+}
+
+struct index_entry * index_entry_create(const char * path, size_t length, 
+    const struct object_id * oid, const struct stat * status){
+    struct index_entry * _entry = (struct index_entry *)malloc(sizeof(struct index_entry) + length + 1);
+    if (_entry == NULL){
+        gitlet_panic("Failed to allocate memory for the index entry");
+    }
+    memset(_entry, 0, sizeof(struct index_entry));
+    index_entry_fill_stat(_entry, status);
+    _entry->mode = index_mode_from_stat(status);
+    _entry->oid = *oid;
+    _entry->uptodate = true;
+    _entry->path_length = length;
+    memcpy(_entry->path, path, length);
+    _entry->path[length] = '\0';
+    return _entry;
+}
+
+void index_add_entry(struct index * index, struct index_entry * entry){
+    bool _found = false;
+    size_t _position = index_position(index, entry->path, entry->path_length, &_found);
+    if (_found){
+        _index_free_entry(index, index->entries[_position]);
+        index->entries[_position] = entry;
+    }else{
+        untracked_cache_invalidate(index->untracked, entry->path, entry->path_length);
+        _index_reserve(index, index->count + 1);
+        memmove(index->entries + _position + 1, index->entries + _position, 
+            (index->count - _position) * sizeof(struct index_entry *));
+        index->entries[_position] = entry;
+        index->count++;
+    }
+    index->changed = true;
+}
+
+void index_add_entries(struct index * index, struct index_entry ** entries, size_t count){
+    if (count == 0){
+        return;
+    }
+    // merge from the back, so the merged entries never overwrite the unmerged ones
+    size_t _new_count = index->count;
+    for (size_t i = 0; i < count; i++){
+        bool _found = false;
+        index_position(index, entries[i]->path, entries[i]->path_length, &_found);
+        if (!_found){
+            untracked_cache_invalidate(index->untracked, entries[i]->path, entries[i]->path_length);
+            _new_count++;
+        }
+    }
+    _index_reserve(index, _new_count);
+
+    size_t _old = index->count;
+    size_t _new = count;
+    size_t _output = _new_count;
+    while (_new > 0){
+        struct index_entry * _entry = entries[_new - 1];
+        int _result = _old == 0 ? -1 : _index_compare_path(index->entries[_old - 1]->path, 
+            index->entries[_old - 1]->path_length, _entry->path, _entry->path_length);
+        if (_result > 0){
+            index->entries[--_output] = index->entries[--_old];
+            continue;
+        }
+        if (_result == 0){
+            _index_free_entry(index, index->entries[--_old]);
+        }
+        index->entries[--_output] = _entry;
+        _new--;
+    }
+    index->count = _new_count;
+    index->changed = true;
+}
+
+void index_remove_marked(struct index * index){
+    size_t _kept = 0;
+    for (size_t i = 0; i < index->count; i++){
+        struct index_entry * _entry = index->entries[i];
+        if (_entry->removed){
+            untracked_cache_invalidate(index->untracked, _entry->path, _entry->path_length);
+            _index_free_entry(index, _entry);
+            index->changed = true;
+        }else{
+            index->entries[_kept++] = _entry;
+        }
+    }
+    index->count = _kept;
+}
+
+uint32_t index_mode_from_stat(const struct stat * status){
+    if (S_ISLNK(status->st_mode)){
+        return INDEX_MODE_SYMLINK;
+    }
+    if (S_ISREG(status->st_mode)){
+        return (status->st_mode & S_IXUSR) ? INDEX_MODE_EXECUTABLE : INDEX_MODE_FILE;
+    }
+    return 0;
+}
+
+void index_entry_fill_stat(struct index_entry * entry, const struct stat * status){
+    entry->ctime_sec = (uint32_t)status->st_ctim.tv_sec;
+    entry->ctime_nsec = (uint32_t)status->st_ctim.tv_nsec;
+    entry->mtime_sec = (uint32_t)status->st_mtim.tv_sec;
+    entry->mtime_nsec = (uint32_t)status->st_mtim.tv_nsec;
+    entry->dev = (uint32_t)status->st_dev;
+    entry->ino = (uint32_t)status->st_ino;
+    entry->uid = (uint32_t)status->st_uid;
+    entry->gid = (uint32_t)status->st_gid;
+    entry->size = (uint32_t)status->st_size;
+}
+
+bool index_entry_stat_matches(const struct index_entry * entry, const struct stat * status){
+    return entry->mtime_sec == (uint32_t)status->st_mtim.tv_sec 
+        && entry->mtime_nsec == (uint32_t)status->st_mtim.tv_nsec
+        && entry->ctime_sec == (uint32_t)status->st_ctim.tv_sec 
+        && entry->ctime_nsec == (uint32_t)status->st_ctim.tv_nsec
+        && entry->ino == (uint32_t)status->st_ino 
+        && entry->dev == (uint32_t)status->st_dev
+        && entry->uid == (uint32_t)status->st_uid 
+        && entry->gid == (uint32_t)status->st_gid
+        && entry->size == (uint32_t)status->st_size
+        && entry->mode == index_mode_from_stat(status);
+}
+
+bool index_entry_is_racy(const struct index * index, const struct index_entry * entry){
+    // without an index file every entry is created and hashed by this process
+    if (index->timestamp_sec == 0){
+        return false;
+    }
+    return entry->mtime_sec > index->timestamp_sec 
+        || (entry->mtime_sec == index->timestamp_sec && entry->mtime_nsec >= index->timestamp_nsec);
+}
+
+void index_hash_path(struct object_writer * writer, struct object_id * oid, 
+    const char * path, const struct stat * status){
+    if (!S_ISLNK(status->st_mode)){
+        object_writer_write(writer, oid, path);
+        return;
+    }
+    // the blob of a symbolic link is the path it points to
+    char _target[PATH_MAX];
+    ssize_t _length = readlink(path, _target, PATH_MAX);
+    if (_length <= 0 || _length >= PATH_MAX){
+        gitlet_panic("Failed to read the symbolic link: %s", path);
+    }
+    FILE * _file = fmemopen(_target, (size_t)_length, "rb");
+    if (_file == NULL){
+        gitlet_panic("Failed to open the symbolic link: %s", path);
+    }
+    object_writer_write_file(writer, oid, _file, path);
+}
+
+enum index_entry_state index_entry_check(const struct index * index, struct index_entry * entry, 
+    const struct stat * status, struct object_writer * writer){
+    if (entry->mode != index_mode_from_stat(status)){
+        return INDEX_ENTRY_MODIFIED;
+    }
+    if (index_entry_stat_matches(entry, status) && (entry->uptodate || !index_entry_is_racy(index, entry))){
+        return INDEX_ENTRY_CLEAN;
+    }
+    // a smudged entry has the size of zero, and only its content can tell
+    if (entry->size != (uint32_t)status->st_size && entry->size != 0){
+        return INDEX_ENTRY_MODIFIED;
+    }
+
+    struct object_id _oid;
+    index_hash_path(writer, &_oid, entry->path, status);
+    if (!oid_equals(&_oid, &entry->oid)){
+        return INDEX_ENTRY_MODIFIED;
+    }
+    index_entry_fill_stat(entry, status);
+    entry->uptodate = true;
+    return INDEX_ENTRY_REFRESHED;
+}
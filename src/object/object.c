@@ -22,37 +22,110 @@
  * SOFTWARE.
  */
 
+#include <errno.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
 #include <zlib.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <openssl/sha.h>
+#include <openssl/evp.h>
 
 #include <object/object.h>
 #include <object/repository.h>
+#include <object/pack.h>
+#include <object/cache.h>
+#include <object/compress.h>
 #include <util/files.h>
 #include <util/str.h>
 #include <util/error.h>
+#include <util/parallel.h>
+#include <global/config.h>
 
 #define HEADER_TYPE_MAX_LENGTH      12
-#define HEADER_MAX_SIZE             128
+#define HEADER_MAX_SIZE             OBJECT_HEADER_MAX_SIZE
+
+// size of the chunk used when streaming the object content
+#define OBJECT_STREAM_CHUNK_SIZE    (64 * 1024)
+// size of the compressed prefix read when only the header is needed
+#define OBJECT_HEADER_READ_SIZE     256
+// size of the buffer on the stack for the object files read by object_read, larger files are mapped
+#define OBJECT_READ_BUFFER_SIZE     (16 * 1024)
+// size of the buffer of the directory entries when the fan-out directories are scanned
+#define OBJECT_SCAN_BUFFER_SIZE     (32 * 1024)
+// the most threads scanning the fan-out directories
+#define OBJECT_SCAN_MAX_THREADS     16
+// the mapped input of the inflate stream is fed in pieces no larger than this
+#define OBJECT_MAX_INPUT_PIECE      (1U << 30)
+// the most objects the batch mode holds back before the writer flushes itself
+#define OBJECT_WRITER_MAX_PENDING   4096
 
 /**
- * @brief: Get the object file path
- * @param buffer: The buffer to store the object file path
- * @param buffer_size: The size of the buffer
- * @param sha1: The SHA1 of the object
+ * @brief: Get the objects directory of the gitlet repository with the trailing
+ *         slash, the path is built once per process.
+ * @param length: The pointer to store the length of the path
+ * @return: The objects directory
  */
-static inline void _get_object_file_path(char * restrict buffer, size_t buffer_size, 
-    const char * restrict sha1){
-    if (getcwd(buffer, buffer_size) == NULL){
-        gitlet_panic("Failed to get the current working directory");
+static const char * _get_objects_directory(size_t * length){
+    static char _directory[PATH_MAX];
+    static size_t _length = 0;
+    if (_length == 0){
+        if (getcwd(_directory, PATH_MAX) == NULL){
+            gitlet_panic("Failed to get the current working directory");
+        }
+        if (strlen(_directory) + sizeof("/.gitlet/objects/") + OBJECT_ID_HEX_SIZE + 1 > PATH_MAX){
+            gitlet_panic("Repository path too long: %s", _directory);
+        }
+        strcat(_directory, "/.gitlet/objects/");
+        _length = strlen(_directory);
+    }
+    *length = _length;
+    return _directory;
+}
+
+/**
+ * @brief: Get the object file path, the hex of the id is written right 
+ *         after the objects directory with the slash after the fan-out byte.
+ * @param buffer: The buffer to store the object file path, at least PATH_MAX bytes
+ * @param oid: The id of the object
+ * @return: The length of the objects directory in the path
+ */
+static inline size_t _get_object_file_path(char * restrict buffer, const struct object_id * oid){
+    size_t _length = 0;
+    const char * _directory = _get_objects_directory(&_length);
+    memcpy(buffer, _directory, _length);
+
+    char _hex[OBJECT_ID_HEX_SIZE + 1];
+    oid_to_hex(_hex, oid);
+    buffer[_length] = _hex[0];
+    buffer[_length + 1] = _hex[1];
+    buffer[_length + 2] = '/';
+    memcpy(buffer + _length + 3, _hex + 2, OBJECT_ID_HEX_SIZE - 1);
+    return _length;
+}
+
+const char * object_type_name(enum object_type type){
+    switch (type){
+        case OBJECT_TYPE_BLOB:
+            return "blob";
+        case OBJECT_TYPE_TREE:
+            return "tree";
+        case OBJECT_TYPE_COMMIT:
+            return "commit";
+        case OBJECT_TYPE_TAG:
+            return "tag";
+        default:
+            return NULL;
     }
-    strcat(buffer, "/.gitlet/objects/");
-    strncpy(buffer + strlen(buffer), sha1, 2);
-    strcat(buffer, "/");
-    strncpy(buffer + strlen(buffer), sha1 + 2, 38);
 }
 
 /**
@@ -102,22 +175,8 @@ static void _read_object_header(char * buffer, struct object * obj){
  * @return: The pointer to the next position in the buffer
  */
 static char * _write_object_header(char * buffer, const struct object * obj){
-    const char * _type_buffer = NULL;
-    switch (obj->type)
-    {
-    case OBJECT_TYPE_BLOB:
-        _type_buffer = "blob";
-        break;
-    case OBJECT_TYPE_TREE:
-        _type_buffer = "tree";
-        break;
-    case OBJECT_TYPE_COMMIT:
-        _type_buffer = "commit";
-        break;
-    case OBJECT_TYPE_TAG:
-        _type_buffer = "tag";
-        break;
-    default:
+    const char * _type_buffer = object_type_name(obj->type);
+    if (_type_buffer == NULL){
         gitlet_panic("Invalid object type: %d", obj->type);
     }
 
@@ -130,209 +189,1485 @@ static char * _write_object_header(char * buffer, const struct object * obj){
     return buffer + written + 1;
 }
 
-void object_read(struct object * obj, const char * sha1){
-    char _file_buffer[PATH_MAX];
-    memset(_file_buffer, 0, PATH_MAX);
+/**
+ * @brief: Refill the input of the inflate stream when it is drained, from 
+ *         the object file with pread or from the mapped memory.
+ * @param stream: The object stream
+ */
+static void _object_stream_fill_input(struct object_stream * stream){
+    if (stream->_zstream.avail_in != 0){
+        return;
+    }
+    // a small loose object is read into the input buffer
+    if (stream->_fd >= 0){
+        ssize_t _read_size = pread(stream->_fd, stream->_input_buffer, stream->_input_size, 
+            (off_t)stream->_file_offset);
+        if (_read_size <= 0){
+            gitlet_panic("Unexpected end of the object file");
+        }
+        stream->_file_offset += (uint64_t)_read_size;
+        stream->_zstream.next_in = stream->_input_buffer;
+        stream->_zstream.avail_in = (uInt)_read_size;
+        return;
+    }
+    // a large loose object or an object inside a pack is inflated directly from the mapping
+    if (stream->_input_map_size == 0){
+        gitlet_panic("Unexpected end of the object");
+    }
+    size_t _piece_size = stream->_input_map_size < OBJECT_MAX_INPUT_PIECE 
+        ? stream->_input_map_size : OBJECT_MAX_INPUT_PIECE;
+    stream->_zstream.next_in = (Bytef *)stream->_input_map;
+    stream->_zstream.avail_in = (uInt)_piece_size;
+    stream->_input_map += _piece_size;
+    stream->_input_map_size -= _piece_size;
+}
+
+/**
+ * @brief: Run one inflate step of the object stream
+ * @param stream: The object stream
+ */
+static void _object_stream_inflate_step(struct object_stream * stream){
+    _object_stream_fill_input(stream);
+
+    int _result = inflate(&stream->_zstream, Z_NO_FLUSH);
+    if (_result == Z_STREAM_END){
+        stream->_finished = true;
+    }else if (_result != Z_OK){
+        gitlet_panic("Failed to decompress the object content: %d", _result);
+    }
+}
+
+/**
+ * @brief: Inflate the next piece of the object stream into the output buffer
+ * @param stream: The object stream
+ * @param buffer: The output buffer
+ * @param size: The size of the output buffer
+ * @return: The number of bytes inflated
+ */
+static size_t _object_stream_inflate(struct object_stream * stream, unsigned char * buffer, size_t size){
+    stream->_zstream.next_out = buffer;
+    stream->_zstream.avail_out = (uInt)size;
+
+    while (stream->_zstream.avail_out != 0 && !stream->_finished){
+        _object_stream_inflate_step(stream);
+    }
+    return size - stream->_zstream.avail_out;
+}
+
+/**
+ * @brief: Open the object from the packs or the loose object file and parse 
+ *         the object header, the inflate of a loose object stops as soon as 
+ *         the null terminator of the header shows up.
+ * @param stream: The object stream
+ * @param oid: The id of the object
+ * @param input_buffer: The buffer used to read the compressed content
+ * @param input_size: The size of the input buffer
+ * @param header_only: true if only the type and size are needed, a packed 
+ *                     delta is then left unresolved
+ */
+static void _object_stream_init(struct object_stream * stream, const struct object_id * oid,
+    unsigned char * input_buffer, size_t input_size, bool header_only){
+    memset(stream, 0, sizeof(struct object_stream));
+    stream->_fd = -1;
+
+    /**
+     * The packs are looked up first, a packed object has its type and size in 
+     * the pack entry, and the compressed content carries no header.
+     */
+    struct pack_object _pack_object;
+    if (pack_find_object(&_pack_object, oid)){
+        stream->type = _pack_object.type;
+        stream->file_size = _pack_object.file_size;
+        stream->_input_buffer = input_buffer;
+        stream->_input_size = input_size;
+        // a delta is resolved into memory up front, the stream then reads from the memory
+        if (_pack_object.is_delta){
+            if (!header_only){
+                stream->_content = pack_object_unpack(&_pack_object);
+            }
+            return;
+        }
+        stream->_input_map = _pack_object.data;
+        stream->_input_map_size = _pack_object.data_size;
+        if (inflateInit(&stream->_zstream) != Z_OK){
+            gitlet_panic("Failed to initialize the inflate stream");
+        }
+        return;
+    }
 
-    _get_object_file_path(_file_buffer, PATH_MAX, sha1);
+    char _file_buffer[PATH_MAX];
+    _get_object_file_path(_file_buffer, oid);
 
-    if (!exists(_file_buffer)){
+    int _fd = open(_file_buffer, O_RDONLY);
+    if (_fd < 0){
         gitlet_panic("Object file not found: %s", _file_buffer);
     }
+    struct stat _stat;
+    if (fstat(_fd, &_stat) != 0){
+        close(_fd);
+        gitlet_panic("Failed to stat object file: %s", _file_buffer);
+    }
 
-    // open the object file
-    FILE * _file = fopen(_file_buffer, "rb");
-    if (_file == NULL){
-        gitlet_panic("Failed to open object file: %s", _file_buffer);
+    /**
+     * The object file that fits in the input buffer, or whose header is all
+     * that is needed, is read with pread. A larger one is mapped and inflated
+     * in place, so its compressed content is never copied.
+     */
+    stream->_input_buffer = input_buffer;
+    stream->_input_size = input_size;
+    if (header_only || (uint64_t)_stat.st_size <= input_size){
+        stream->_fd = _fd;
+    }else{
+        void * _map = mmap(NULL, (size_t)_stat.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        close(_fd);
+        if (_map == MAP_FAILED){
+            gitlet_panic("Failed to map object file: %s", _file_buffer);
+        }
+        stream->_map = _map;
+        stream->_map_size = (size_t)_stat.st_size;
+        stream->_input_map = (const unsigned char *)_map;
+        stream->_input_map_size = stream->_map_size;
+    }
+
+    if (inflateInit(&stream->_zstream) != Z_OK){
+        gitlet_panic("Failed to initialize the inflate stream");
     }
 
-    // read the header first
-    size_t _compressed_header_size = file_size(_file) < HEADER_MAX_SIZE 
-        ? file_size(_file) : HEADER_MAX_SIZE;
+    /**
+     * Inflate step by step until the null terminator of the header shows up, 
+     * the bytes inflated after the header belong to the content and are kept as pending.
+     */
+    char _header_buffer[HEADER_MAX_SIZE];
+    char * _header_end = NULL;
+    stream->_zstream.next_out = (unsigned char *)_header_buffer;
+    stream->_zstream.avail_out = HEADER_MAX_SIZE;
+    while (_header_end == NULL){
+        if (stream->_zstream.avail_out == 0 || stream->_finished){
+            gitlet_panic("Invalid object header: %s", _file_buffer);
+        }
+        _object_stream_inflate_step(stream);
+        _header_end = memchr(_header_buffer, '\0', HEADER_MAX_SIZE - stream->_zstream.avail_out);
+    }
+    size_t _header_size = HEADER_MAX_SIZE - stream->_zstream.avail_out;
 
-    char _compressed_header_buffer[HEADER_MAX_SIZE];
-    memset(_compressed_header_buffer, 0, HEADER_MAX_SIZE);
+    struct object _obj;
+    _read_object_header(_header_buffer, &_obj);
+    stream->type = _obj.type;
+    stream->file_size = _obj.file_size;
 
-    if (fread(_compressed_header_buffer, 1, _compressed_header_size, _file) 
-        != _compressed_header_size){
-        fclose(_file);
-        gitlet_panic("Failed to read object header: %s", _file_buffer);
+    _header_end++;
+    stream->_pending_size = _header_size - (size_t)(_header_end - _header_buffer);
+    memcpy(stream->_pending, _header_end, stream->_pending_size);
+}
+
+/**
+ * @brief: Release the inflate stream and the object file of the stream
+ * @param stream: The object stream
+ */
+static void _object_stream_release(struct object_stream * stream){
+    inflateEnd(&stream->_zstream);
+    free(stream->_content);
+    stream->_content = NULL;
+    if (stream->_fd >= 0){
+        close(stream->_fd);
+        stream->_fd = -1;
+    }
+    if (stream->_map != NULL){
+        munmap(stream->_map, stream->_map_size);
+        stream->_map = NULL;
+    }
+}
+
+void object_stream_open(struct object_stream * stream, const struct object_id * oid){
+    unsigned char * _input_buffer = (unsigned char *)malloc(OBJECT_STREAM_CHUNK_SIZE);
+    if (_input_buffer == NULL){
+        gitlet_panic("Failed to allocate memory for object stream");
     }
+    _object_stream_init(stream, oid, _input_buffer, OBJECT_STREAM_CHUNK_SIZE, false);
+}
 
-    char _decompressed_header_buffer[HEADER_MAX_SIZE * 2];
-    memset(_decompressed_header_buffer, 0, HEADER_MAX_SIZE * 2);
+size_t object_stream_read(struct object_stream * stream, void * buffer, size_t size){
+    size_t _read_size = 0;
 
-    str_decompress(_compressed_header_buffer, _compressed_header_size, 
-        _decompressed_header_buffer, HEADER_MAX_SIZE * 2, true);
+    // the resolved delta is copied out of the memory
+    if (stream->_content != NULL){
+        uint64_t _remaining = stream->file_size - stream->_total_read;
+        _read_size = _remaining < size ? (size_t)_remaining : size;
+        memcpy(buffer, stream->_content + stream->_total_read, _read_size);
+        stream->_total_read += _read_size;
+        return _read_size;
+    }
 
-    _read_object_header(_decompressed_header_buffer, obj);
+    // drain the content inflated together with the header first
+    if (stream->_pending_offset < stream->_pending_size){
+        _read_size = stream->_pending_size - stream->_pending_offset;
+        if (_read_size > size){
+            _read_size = size;
+        }
+        memcpy(buffer, stream->_pending + stream->_pending_offset, _read_size);
+        stream->_pending_offset += _read_size;
+    }
+    if (_read_size < size){
+        _read_size += _object_stream_inflate(stream, (unsigned char *)buffer + _read_size, size - _read_size);
+    }
 
-    if (obj->file_size < HEADER_MAX_SIZE){
-        char * _content_ptr = (char *)obj->content;
-        obj->content = (unsigned char *)malloc(obj->file_size + 1);
-        if (obj->content == NULL){
-            fclose(_file);
-            gitlet_panic("Failed to allocate memory for object content");
+    stream->_total_read += _read_size;
+    if (stream->_total_read > stream->file_size 
+        || (_read_size == 0 && stream->_total_read != stream->file_size)){
+        gitlet_panic("Object size mismatch: expected %llu bytes", 
+            (unsigned long long)stream->file_size);
+    }
+    return _read_size;
+}
+
+void object_stream_close(struct object_stream * stream){
+    _object_stream_release(stream);
+    free(stream->_input_buffer);
+    stream->_input_buffer = NULL;
+}
+
+void object_read_header(struct object * obj, const struct object_id * oid){
+    /**
+     * The header is at the very beginning of the compressed stream, so only
+     * a small unbuffered read is needed, and the rest of the file is never touched.
+     */
+    unsigned char _input_buffer[OBJECT_HEADER_READ_SIZE];
+    struct object_stream _stream;
+    _object_stream_init(&_stream, oid, _input_buffer, OBJECT_HEADER_READ_SIZE, true);
+    _object_stream_release(&_stream);
+
+    obj->type = _stream.type;
+    obj->file_size = _stream.file_size;
+    obj->content = NULL;
+}
+
+bool object_exists(const struct object_id * oid){
+    if (pack_find_object(NULL, oid)){
+        return true;
+    }
+
+    char _file_buffer[PATH_MAX];
+    _get_object_file_path(_file_buffer, oid);
+    return exists(_file_buffer);
+}
+
+/**
+ * @brief: Append the id to the list of the ids
+ * @param ids: The pointer to the ids, grown with realloc
+ * @param count: The pointer to the number of the ids
+ * @param capacity: The pointer to the capacity of the ids
+ * @param oid: The id to be appended
+ */
+static void _object_id_list_append(struct object_id ** ids, size_t * count, size_t * capacity, 
+    const struct object_id * oid){
+    if (*count == *capacity){
+        size_t _capacity = *capacity == 0 ? 64 : *capacity * 2;
+        struct object_id * _ids = (struct object_id *)realloc(*ids, _capacity * sizeof(struct object_id));
+        if (_ids == NULL){
+            gitlet_panic("Failed to allocate memory for object ids");
+        }
+        *ids = _ids;
+        *capacity = _capacity;
+    }
+    (*ids)[(*count)++] = *oid;
+}
+
+/**
+ * @brief: Append the id named by the entry of the fan-out directory
+ * @param hex: The hex of the id, the first two characters are the fan-out directory
+ * @param name: The name of the entry
+ * @param ids: The pointer to the ids
+ * @param count: The pointer to the number of the ids
+ * @param capacity: The pointer to the capacity of the ids
+ */
+static void _object_scan_entry(char * hex, const char * name, struct object_id ** ids, size_t * count, 
+    size_t * capacity){
+    if (strlen(name) != OBJECT_ID_HEX_SIZE - 2){
+        return;
+    }
+    memcpy(hex + 2, name, OBJECT_ID_HEX_SIZE - 1);
+    struct object_id _oid;
+    if (oid_from_hex(&_oid, hex)){
+        _object_id_list_append(ids, count, capacity, &_oid);
+    }
+}
+
+#ifdef __linux__
+/**
+ * @brief: The directory entry returned by getdents64
+ */
+struct _linux_dirent64{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/**
+ * @brief: Append the ids of the loose objects under the fan-out directory
+ * @param fanout: The first byte of the ids
+ * @param ids: The pointer to the ids, grown with realloc
+ * @param count: The pointer to the number of the ids
+ * @param capacity: The pointer to the capacity of the ids
+ * @note: On linux the directory is read with getdents64 in large batches, and
+ *        the entries which are not regular files are skipped by d_type.
+ */
+static void _object_scan_fanout(unsigned char fanout, struct object_id ** ids, size_t * count, size_t * capacity){
+    char _path[PATH_MAX];
+    size_t _length = 0;
+    const char * _directory = _get_objects_directory(&_length);
+    memcpy(_path, _directory, _length);
+    char _hex[OBJECT_ID_HEX_SIZE + 1];
+    snprintf(_hex, sizeof(_hex), "%02x", fanout);
+    memcpy(_path + _length, _hex, 3);
+
+#ifdef __linux__
+    int _fd = open(_path, O_RDONLY | O_DIRECTORY);
+    if (_fd < 0){
+        return;
+    }
+    uint64_t _buffer[OBJECT_SCAN_BUFFER_SIZE / sizeof(uint64_t)];
+    long _read_size = 0;
+    while ((_read_size = syscall(SYS_getdents64, _fd, _buffer, sizeof(_buffer))) > 0){
+        for (long _offset = 0; _offset < _read_size; ){
+            struct _linux_dirent64 * _entry = (struct _linux_dirent64 *)((char *)_buffer + _offset);
+            _offset += _entry->d_reclen;
+            if (_entry->d_type == DT_REG || _entry->d_type == DT_UNKNOWN){
+                _object_scan_entry(_hex, _entry->d_name, ids, count, capacity);
+            }
+        }
+    }
+    close(_fd);
+#else
+    DIR * _fanout_directory = opendir(_path);
+    if (_fanout_directory == NULL){
+        return;
+    }
+    struct dirent * _entry = NULL;
+    while ((_entry = readdir(_fanout_directory)) != NULL){
+        _object_scan_entry(_hex, _entry->d_name, ids, count, capacity);
+    }
+    closedir(_fanout_directory);
+#endif
+}
+
+void object_for_each_loose(object_each_callback callback, void * data){
+    struct object_id * _ids = NULL;
+    size_t _capacity = 0;
+
+    // walk the 256 fan-out directories, every entry is the rest 38 hex of the sha1
+    for (unsigned int i = 0; i < 256; i++){
+        size_t _count = 0;
+        _object_scan_fanout((unsigned char)i, &_ids, &_count, &_capacity);
+        for (size_t j = 0; j < _count; j++){
+            callback(&_ids[j], data);
+        }
+    }
+    free(_ids);
+}
+
+/**
+ * @brief: The ids of the loose objects found under every fan-out directory
+ * @param ids: The ids under every fan-out directory
+ * @param counts: The number of the ids under every fan-out directory
+ * @param capacities: The capacity of the ids under every fan-out directory
+ * @param sorted: Whether to sort the ids under every fan-out directory
+ */
+struct _loose_scan{
+    struct object_id * ids[256];
+    size_t counts[256];
+    size_t capacities[256];
+    bool sorted;
+};
+
+static int _object_id_compare(const void * left, const void * right){
+    return oid_compare((const struct object_id *)left, (const struct object_id *)right);
+}
+
+/**
+ * @brief: Scan one fan-out directory on the worker thread
+ * @param index: The fan-out directory
+ * @param worker: The index of the worker thread
+ * @param data: The loose scan
+ */
+static void _loose_scan_fanout(size_t index, unsigned int worker, void * data){
+    (void)worker;
+    struct _loose_scan * _scan = (struct _loose_scan *)data;
+    _object_scan_fanout((unsigned char)index, &_scan->ids[index], &_scan->counts[index], &_scan->capacities[index]);
+    if (_scan->sorted){
+        qsort(_scan->ids[index], _scan->counts[index], sizeof(struct object_id), _object_id_compare);
+    }
+}
+
+struct object_id * object_list_loose(size_t * count, bool sorted){
+    /**
+     * Every fan-out directory is read and sorted on its own, the lists are
+     * joined in the order of the fan-out, so the whole list is sorted too.
+     */
+    struct _loose_scan * _scan = (struct _loose_scan *)calloc(1, sizeof(struct _loose_scan));
+    if (_scan == NULL){
+        gitlet_panic("Failed to allocate memory for object ids");
+    }
+    _scan->sorted = sorted;
+
+    size_t _length = 0;
+    _get_objects_directory(&_length);
+    unsigned int _workers = parallel_cpu_count();
+    parallel_for(_workers < OBJECT_SCAN_MAX_THREADS ? _workers : OBJECT_SCAN_MAX_THREADS, 256, 
+        _loose_scan_fanout, _scan);
+
+    size_t _total = 0;
+    for (unsigned int i = 0; i < 256; i++){
+        _total += _scan->counts[i];
+    }
+    struct object_id * _ids = (struct object_id *)malloc((_total == 0 ? 1 : _total) * sizeof(struct object_id));
+    if (_ids == NULL){
+        gitlet_panic("Failed to allocate memory for object ids");
+    }
+    size_t _offset = 0;
+    for (unsigned int i = 0; i < 256; i++){
+        if (_scan->counts[i] != 0){
+            memcpy(_ids + _offset, _scan->ids[i], _scan->counts[i] * sizeof(struct object_id));
+        }
+        _offset += _scan->counts[i];
+        free(_scan->ids[i]);
+    }
+    free(_scan);
+
+    *count = _total;
+    return _ids;
+}
+
+/**
+ * @brief: The list of the ids collected from the packs
+ */
+struct _object_id_list{
+    struct object_id * ids;
+    size_t count;
+    size_t capacity;
+};
+
+static void _object_id_list_collect(const struct object_id * oid, void * data){
+    struct _object_id_list * _list = (struct _object_id_list *)data;
+    _object_id_list_append(&_list->ids, &_list->count, &_list->capacity, oid);
+}
+
+void object_for_each(object_each_callback callback, void * data, bool sorted){
+    size_t _loose_count = 0;
+    struct object_id * _loose_ids = object_list_loose(&_loose_count, sorted);
+
+    if (!sorted){
+        // the packed objects go first, the loose objects also packed are skipped
+        pack_for_each_object(callback, data);
+        for (size_t i = 0; i < _loose_count; i++){
+            if (!pack_find_object(NULL, &_loose_ids[i])){
+                callback(&_loose_ids[i], data);
+            }
+        }
+        free(_loose_ids);
+        return;
+    }
+
+    struct _object_id_list _list = {_loose_ids, _loose_count, _loose_count};
+    pack_for_each_object(_object_id_list_collect, &_list);
+    if (_list.count != _loose_count){
+        qsort(_list.ids, _list.count, sizeof(struct object_id), _object_id_compare);
+    }
+    for (size_t i = 0; i < _list.count; i++){
+        if (i == 0 || !oid_equals(&_list.ids[i], &_list.ids[i - 1])){
+            callback(&_list.ids[i], data);
+        }
+    }
+    free(_list.ids);
+}
+
+void object_read(struct object * obj, const struct object_id * oid){
+    if (object_cache_get(obj, oid)){
+        return;
+    }
+
+    /**
+     * A small object file is read into the buffer on the stack, and a large
+     * one is mapped, so no input buffer is allocated for the read.
+     */
+    unsigned char _input_buffer[OBJECT_READ_BUFFER_SIZE];
+    struct object_stream _stream;
+    _object_stream_init(&_stream, oid, _input_buffer, OBJECT_READ_BUFFER_SIZE, false);
+
+    obj->type = _stream.type;
+    obj->file_size = _stream.file_size;
+
+    /**
+     * The buffer is sized from the parsed header, and the content is inflated 
+     * directly into it in a single pass, so the buffer is handed to the caller
+     * without any extra copy.
+     */
+    obj->content = object_content_alloc(obj->file_size);
+
+    size_t _read_size = 0;
+    for (uint64_t _offset = 0; _offset < obj->file_size; _offset += _read_size){
+        _read_size = object_stream_read(&_stream, obj->content + _offset, 
+            (size_t)(obj->file_size - _offset));
+    }
+    // make sure the stream ends exactly at the size from the header
+    unsigned char _trailing;
+    object_stream_read(&_stream, &_trailing, 1);
+    obj->content[obj->file_size] = '\0';
+
+    _object_stream_release(&_stream);
+    object_cache_put(oid, obj);
+}
+
+void object_release(struct object * obj){
+    object_content_release(obj->content);
+    obj->content = NULL;
+}
+
+/**
+ * @brief: Parse the object header without panicking on the broken one
+ * @param header: The header, "<type> <size>" with the null terminator
+ * @param obj: The object to store the type and the size
+ * @return: true if the header is valid, false otherwise
+ */
+static bool _object_verify_header(const char * header, struct object * obj){
+    const char * _space = strchr(header, ' ');
+    if (_space == NULL){
+        return false;
+    }
+    obj->type = OBJECT_TYPE_UNKNOWN;
+    for (enum object_type _type = OBJECT_TYPE_BLOB; _type < OBJECT_TYPE_UNKNOWN; _type++){
+        const char * _name = object_type_name(_type);
+        if (strlen(_name) == (size_t)(_space - header) && memcmp(_name, header, strlen(_name)) == 0){
+            obj->type = _type;
+        }
+    }
+    if (obj->type == OBJECT_TYPE_UNKNOWN || _space[1] < '0' || _space[1] > '9'){
+        return false;
+    }
+    char * _end = NULL;
+    obj->file_size = strtoull(_space + 1, &_end, 10);
+    return *_end == '\0';
+}
+
+/**
+ * @brief: Inflate the compressed data, hash it and keep the content of the
+ *         trees, commits and tags.
+ * @param obj: The object, with the type and size already set when the data has no header
+ * @param input: The compressed data
+ * @param input_size: The size of the compressed data
+ * @param has_header: true if the header is inside the data like a loose object
+ * @param sha1_context: The SHA1 context, which has already hashed the header when the data has none
+ * @param chunk: The buffer of OBJECT_STREAM_CHUNK_SIZE bytes for the inflated chunks
+ * @return: OBJECT_VERIFY_OK if the data is a valid object, OBJECT_VERIFY_CORRUPT otherwise
+ */
+static enum object_verify_result _object_verify_inflate(struct object * obj, const unsigned char * input, 
+    size_t input_size, bool has_header, EVP_MD_CTX * sha1_context, unsigned char * chunk){
+    z_stream _zstream;
+    memset(&_zstream, 0, sizeof(z_stream));
+    if (inflateInit(&_zstream) != Z_OK){
+        gitlet_panic("Failed to initialize the inflate stream");
+    }
+
+    char _header[HEADER_MAX_SIZE];
+    size_t _header_size = 0;
+    bool _header_done = !has_header;
+    uint64_t _content_size = 0;
+    if (_header_done && obj->type != OBJECT_TYPE_BLOB){
+        obj->content = object_content_alloc(obj->file_size);
+    }
+
+    int _status = Z_OK;
+    bool _valid = true;
+    while (_valid && _status != Z_STREAM_END){
+        if (_zstream.avail_in == 0){
+            if (input_size == 0){
+                _valid = false;
+                break;
+            }
+            size_t _piece_size = input_size < OBJECT_MAX_INPUT_PIECE ? input_size : OBJECT_MAX_INPUT_PIECE;
+            _zstream.next_in = (Bytef *)input;
+            _zstream.avail_in = (uInt)_piece_size;
+            input += _piece_size;
+            input_size -= _piece_size;
+        }
+        _zstream.next_out = chunk;
+        _zstream.avail_out = OBJECT_STREAM_CHUNK_SIZE;
+        _status = inflate(&_zstream, Z_NO_FLUSH);
+        if (_status != Z_OK && _status != Z_STREAM_END){
+            _valid = false;
+            break;
+        }
+        size_t _produced = OBJECT_STREAM_CHUNK_SIZE - _zstream.avail_out;
+        EVP_DigestUpdate(sha1_context, chunk, _produced);
+
+        // the header of a loose object ends at the first null byte
+        const unsigned char * _current = chunk;
+        while (!_header_done && _produced > 0){
+            _header[_header_size++] = (char)*_current;
+            _current++;
+            _produced--;
+            if (_header[_header_size - 1] == '\0'){
+                _header_done = true;
+                _valid = _object_verify_header(_header, obj);
+                if (_valid && obj->type != OBJECT_TYPE_BLOB){
+                    obj->content = object_content_alloc(obj->file_size);
+                }
+            }else if (_header_size == HEADER_MAX_SIZE){
+                _valid = false;
+                break;
+            }
         }
-        memcpy(obj->content, _content_ptr, obj->file_size);
+        if (!_valid || _produced == 0){
+            continue;
+        }
+        if (_produced > obj->file_size - _content_size){
+            _valid = false;
+            break;
+        }
+        if (obj->content != NULL){
+            memcpy(obj->content + _content_size, _current, _produced);
+        }
+        _content_size += _produced;
+    }
+    inflateEnd(&_zstream);
+
+    if (!_valid || !_header_done || _content_size != obj->file_size){
+        object_release(obj);
+        return OBJECT_VERIFY_CORRUPT;
+    }
+    if (obj->content != NULL){
         obj->content[obj->file_size] = '\0';
+    }
+    return OBJECT_VERIFY_OK;
+}
+
+/**
+ * @brief: Verify the loose object file
+ * @param obj: The object to store the result
+ * @param oid: The id of the object
+ * @param sha1_context: The initialized SHA1 context
+ * @param chunk: The buffer of OBJECT_STREAM_CHUNK_SIZE bytes for the inflated chunks
+ * @return: The result of the verification, the hash is left in the context
+ */
+static enum object_verify_result _object_verify_loose(struct object * obj, const struct object_id * oid,
+    EVP_MD_CTX * sha1_context, unsigned char * chunk){
+    char _file_buffer[PATH_MAX];
+    _get_object_file_path(_file_buffer, oid);
+    int _fd = open(_file_buffer, O_RDONLY);
+    if (_fd < 0){
+        return OBJECT_VERIFY_MISSING;
+    }
+    struct stat _stat;
+    if (fstat(_fd, &_stat) != 0 || _stat.st_size == 0){
+        close(_fd);
+        return OBJECT_VERIFY_CORRUPT;
+    }
+    void * _map = mmap(NULL, (size_t)_stat.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    close(_fd);
+    if (_map == MAP_FAILED){
+        return OBJECT_VERIFY_CORRUPT;
+    }
+    enum object_verify_result _result = _object_verify_inflate(obj, (const unsigned char *)_map, 
+        (size_t)_stat.st_size, true, sha1_context, chunk);
+    munmap(_map, (size_t)_stat.st_size);
+    return _result;
+}
+
+enum object_verify_result object_verify(struct object * obj, const struct object_id * oid){
+    obj->type = OBJECT_TYPE_UNKNOWN;
+    obj->file_size = 0;
+    obj->content = NULL;
+
+    EVP_MD_CTX * _sha1_context = EVP_MD_CTX_new();
+    unsigned char * _chunk = (unsigned char *)malloc(OBJECT_STREAM_CHUNK_SIZE);
+    if (_sha1_context == NULL || _chunk == NULL || EVP_DigestInit_ex(_sha1_context, EVP_sha1(), NULL) != 1){
+        gitlet_panic("Failed to initialize the object verification");
+    }
+
+    /**
+     * A packed entry carries its type and size outside the compressed data,
+     * so the header is hashed up front. A delta has to be resolved first,
+     * and the content it rebuilds is hashed in one go.
+     */
+    enum object_verify_result _result = OBJECT_VERIFY_OK;
+    struct pack_object _pack_object;
+    if (pack_find_object(&_pack_object, oid)){
+        obj->type = _pack_object.type;
+        obj->file_size = _pack_object.file_size;
+        char _header_buffer[HEADER_MAX_SIZE];
+        char * _header_end = _write_object_header(_header_buffer, obj);
+        EVP_DigestUpdate(_sha1_context, _header_buffer, (size_t)(_header_end - _header_buffer));
+        if (_pack_object.is_delta){
+            unsigned char * _content = pack_object_unpack(&_pack_object);
+            EVP_DigestUpdate(_sha1_context, _content, (size_t)obj->file_size);
+            if (obj->type != OBJECT_TYPE_BLOB){
+                obj->content = object_content_alloc(obj->file_size);
+                memcpy(obj->content, _content, (size_t)obj->file_size + 1);
+            }
+            free(_content);
+        }else{
+            _result = _object_verify_inflate(obj, _pack_object.data, _pack_object.data_size, false, 
+                _sha1_context, _chunk);
+        }
     }else{
-        size_t __compressed_buffer_size = file_size(_file);
-        char *__compressed_buffer = (char *)malloc(__compressed_buffer_size);
-
-        /**
-         * Make sure the decompressed buffer has enough space to store 
-         * the decompressed header and the file content
-         */
-        size_t __decompressed_buffer_size = HEADER_MAX_SIZE + obj->file_size + 1;
-        char * __decompressed_buffer = (char *)malloc(__decompressed_buffer_size);
-        if (__decompressed_buffer == NULL){
-            free(__compressed_buffer);
-            fclose(_file);
-            gitlet_panic("Failed to allocate memory for decompressed header buffer");
+        _result = _object_verify_loose(obj, oid, _sha1_context, _chunk);
+    }
+
+    if (_result == OBJECT_VERIFY_OK){
+        struct object_id _check_oid;
+        EVP_DigestFinal_ex(_sha1_context, _check_oid.hash, NULL);
+        if (!oid_equals(&_check_oid, oid)){
+            _result = OBJECT_VERIFY_MISMATCH;
         }
-        // read the raw compressed content include the header
-        if (fread(__compressed_buffer, 1, __compressed_buffer_size, _file) != __compressed_buffer_size){
-            free(__compressed_buffer);
-            free(__decompressed_buffer);
-            fclose(_file);
-            gitlet_panic("Failed to read object content: %s", _file_buffer);
+    }
+    EVP_MD_CTX_free(_sha1_context);
+    free(_chunk);
+    return _result;
+}
+
+/**
+ * @brief: Create a temporary object file in the object database
+ * @param buffer: The buffer to store the temporary file path
+ * @param buffer_size: The size of the buffer
+ * @return: The opened temporary file
+ * @note: The temporary file lives in the same directory tree as the final
+ *        object, so it can be published with a rename once the hash is known.
+ *        It already has the mode 0444 of the object, the open descriptor
+ *        can still write it.
+ */
+static FILE * _create_object_temp_file(char * restrict buffer, size_t buffer_size){
+    size_t _length = 0;
+    const char * _directory = _get_objects_directory(&_length);
+    if (snprintf(buffer, buffer_size, "%stmp_obj_XXXXXX", _directory) >= (int)buffer_size){
+        gitlet_panic("Object path too long: %s", _directory);
+    }
+
+    int _fd = mkstemp(buffer);
+    if (_fd < 0){
+        gitlet_panic("Failed to create temporary object file: %s", buffer);
+    }
+    // mkstemp creates the file 0600, an object is read only and readable by all like git
+    if (fchmod(_fd, 0444) != 0){
+        close(_fd);
+        remove_file(buffer);
+        gitlet_panic("Failed to set the mode of temporary object file: %s", buffer);
+    }
+    FILE * _temp_file = fdopen(_fd, "wb");
+    if (_temp_file == NULL){
+        close(_fd);
+        remove_file(buffer);
+        gitlet_panic("Failed to open temporary object file: %s", buffer);
+    }
+    return _temp_file;
+}
+
+/**
+ * @brief: Feed a chunk into the deflate stream and flush the output to the file
+ * @param writer: The object writer, its output buffer receives the compressed output
+ * @param chunk: The chunk to be compressed
+ * @param chunk_size: The size of the chunk
+ * @param flush: The zlib flush mode (Z_NO_FLUSH or Z_FINISH)
+ * @param file: The file to write the compressed output to
+ */
+static void _deflate_chunk(struct object_writer * writer, const unsigned char * chunk, size_t chunk_size, 
+    int flush, FILE * file){
+    z_stream * _stream = &writer->_zstream;
+    _stream->next_in = (Bytef *)chunk;
+    _stream->avail_in = (uInt)chunk_size;
+    do {
+        _stream->next_out = writer->_output_buffer;
+        _stream->avail_out = OBJECT_STREAM_CHUNK_SIZE;
+
+        int _result = deflate(_stream, flush);
+        if (_result == Z_STREAM_ERROR){
+            gitlet_panic("Failed to compress the object content");
         }
 
-        // decompress the all the content
-        str_decompress(__compressed_buffer, __compressed_buffer_size, 
-            __decompressed_buffer, __decompressed_buffer_size, false);
+        size_t _have = OBJECT_STREAM_CHUNK_SIZE - _stream->avail_out;
+        if (_have != 0 && fwrite(writer->_output_buffer, 1, _have, file) != _have){
+            gitlet_panic("Failed to write the compressed object content");
+        }
+    } while (_stream->avail_out == 0);
+}
 
-        // skip the header and the null terminator
-        char * _content_ptr = NULL;
-        _content_ptr = memchr(__decompressed_buffer, '\0', HEADER_MAX_SIZE);
-        if (_content_ptr == NULL){
-            free(__compressed_buffer);
-            free(__decompressed_buffer);
-            fclose(_file);
-            gitlet_panic("Failed to find the null terminator in the decompressed buffer");
-        }
-        _content_ptr++;
-
-        /**
-         * Copy the decompressed content from the buffer to the 
-         * object content pointer.
-         */
-        obj->content = (unsigned char *)malloc(obj->file_size + 1);
-        if (obj->content == NULL){
-            free(__compressed_buffer);
-            free(__decompressed_buffer);
-            fclose(_file);
-            gitlet_panic("Failed to allocate memory for object content");
+enum object_fsync_method object_get_fsync_method(void){
+    const char * _value = repository_config_get("core", "fsyncMethod");
+    if (_value == NULL || strcasecmp(_value, "none") == 0){
+        return OBJECT_FSYNC_NONE;
+    }
+    if (strcasecmp(_value, "fsync") == 0){
+        return OBJECT_FSYNC_FSYNC;
+    }
+    if (strcasecmp(_value, "batch") == 0){
+        return OBJECT_FSYNC_BATCH;
+    }
+    gitlet_panic("Invalid value for core.fsyncMethod: %s", _value);
+    return OBJECT_FSYNC_NONE;
+}
+
+/**
+ * @brief: Flush the temporary object file to the kernel, and sync it to the
+ *         disk or start its write back depending on the fsync method.
+ * @param writer: The object writer
+ * @param file: The temporary object file, still open
+ * @return: true on success, false otherwise
+ */
+static bool _object_writer_sync_file(struct object_writer * writer, FILE * file){
+    if (fflush(file) != 0){
+        return false;
+    }
+    switch (writer->fsync_method){
+        case OBJECT_FSYNC_FSYNC:
+            return fsync(fileno(file)) == 0;
+        case OBJECT_FSYNC_BATCH:
+#ifdef __linux__
+            // only start the write back, the barrier of the batch waits for it
+            sync_file_range(fileno(file), 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+            return true;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief: Hold the rename of the object back until the barrier of the batch
+ * @param writer: The object writer
+ * @param temp_path: The temporary object file path
+ * @param object_path: The final object file path
+ * @note: The pending paths are stored in pairs, the temporary path goes first.
+ */
+static void _object_writer_defer_rename(struct object_writer * writer, const char * temp_path, 
+    const char * object_path){
+    if (writer->_pending_count == writer->_pending_capacity){
+        size_t _capacity = writer->_pending_capacity == 0 ? 64 : writer->_pending_capacity * 2;
+        char ** _paths = (char **)realloc(writer->_pending_paths, _capacity * 2 * sizeof(char *));
+        if (_paths == NULL){
+            gitlet_panic("Failed to allocate memory for object writer");
         }
-        memcpy(obj->content, _content_ptr, obj->file_size);
-        obj->content[obj->file_size] = '\0';
+        writer->_pending_paths = _paths;
+        writer->_pending_capacity = _capacity;
+    }
 
-        // free the memory for buffer
-        free(__compressed_buffer);
-        free(__decompressed_buffer);
+    char ** _pair = writer->_pending_paths + writer->_pending_count * 2;
+    _pair[0] = strdup(temp_path);
+    _pair[1] = strdup(object_path);
+    if (_pair[0] == NULL || _pair[1] == NULL){
+        gitlet_panic("Failed to allocate memory for object writer");
+    }
+    writer->_pending_count++;
+
+    // bound the memory and the temporary files of a huge batch
+    if (writer->_pending_count >= OBJECT_WRITER_MAX_PENDING){
+        object_writer_flush(writer, 1);
     }
-    fclose(_file);
 }
 
-void object_write(char * buffer, const char * file, bool write_to_repo){
-    
+/**
+ * @brief: Sync the pending object files of the writers to the disk
+ * @param writers: The object writers
+ * @param count: The number of the writers
+ */
+static void _object_writer_barrier(struct object_writer * writers, size_t count){
+#ifdef __linux__
+    /**
+     * The objects directory and the temporary files are on the same file
+     * system, so one syncfs makes every pending object file durable.
+     */
+    size_t _length = 0;
+    int _directory_fd = open(_get_objects_directory(&_length), O_RDONLY | O_DIRECTORY);
+    if (_directory_fd >= 0){
+        int _result = syncfs(_directory_fd);
+        close(_directory_fd);
+        if (_result == 0){
+            return;
+        }
+    }
+#endif
+    // no syncfs, sync the pending files one by one instead
+    for (size_t i = 0; i < count; i++){
+        for (size_t j = 0; j < writers[i]._pending_count; j++){
+            const char * _temp_path = writers[i]._pending_paths[j * 2];
+            int _fd = open(_temp_path, O_RDONLY);
+            if (_fd < 0 || fsync(_fd) != 0){
+                gitlet_panic("Failed to sync object file: %s", _temp_path);
+            }
+            close(_fd);
+        }
+    }
+}
+
+void object_writer_flush(struct object_writer * writers, size_t count){
+    size_t _pending = 0;
+    for (size_t i = 0; i < count; i++){
+        _pending += writers[i]._pending_count;
+    }
+    if (_pending == 0){
+        return;
+    }
+
+    _object_writer_barrier(writers, count);
+    for (size_t i = 0; i < count; i++){
+        struct object_writer * _writer = &writers[i];
+        for (size_t j = 0; j < _writer->_pending_count; j++){
+            char * _temp_path = _writer->_pending_paths[j * 2];
+            char * _object_path = _writer->_pending_paths[j * 2 + 1];
+            if (rename(_temp_path, _object_path) != 0){
+                remove_file(_temp_path);
+                gitlet_panic("Failed to write object file: %s", _object_path);
+            }
+            free(_temp_path);
+            free(_object_path);
+        }
+        _writer->_pending_count = 0;
+    }
+}
+
+/**
+ * @brief: The ids of the loose objects under one fan-out directory, read
+ *         from the directory on the first lookup and kept sorted.
+ * @param loaded: Whether the directory has been read
+ * @param ids: The sorted object ids
+ * @param claimed: Whether the id at the same position was claimed by this
+ *                 process, rather than read from the directory
+ * @param count: The number of the ids
+ * @param capacity: The capacity of the ids
+ */
+struct _loose_object_set{
+    bool loaded;
+    struct object_id * ids;
+    bool * claimed;
+    size_t count;
+    size_t capacity;
+};
+
+static struct _loose_object_set _loose_sets[256];
+// the writers on the worker threads share the sets
+static pthread_mutex_t _loose_sets_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief: Search the id in the loose object set
+ * @param set: The loose object set
+ * @param oid: The id of the object
+ * @param position: The pointer to store the position to insert the id when missing
+ * @return: true if the id is in the set, false otherwise
+ */
+static bool _loose_object_set_search(const struct _loose_object_set * set, const struct object_id * oid, 
+    size_t * position){
+    size_t _low = 0;
+    size_t _high = set->count;
+    while (_low < _high){
+        size_t _middle = _low + (_high - _low) / 2;
+        int _compare = oid_compare(&set->ids[_middle], oid);
+        if (_compare == 0){
+            *position = _middle;
+            return true;
+        }else if (_compare < 0){
+            _low = _middle + 1;
+        }else{
+            _high = _middle;
+        }
+    }
+    *position = _low;
+    return false;
+}
+
+/**
+ * @brief: Insert the id claimed by this process into the loose object set at the position
+ * @param set: The loose object set
+ * @param oid: The id of the object
+ * @param position: The position from _loose_object_set_search
+ */
+static void _loose_object_set_insert(struct _loose_object_set * set, const struct object_id * oid, size_t position){
+    if (set->count == set->capacity){
+        size_t _capacity = set->capacity == 0 ? 64 : set->capacity * 2;
+        struct object_id * _ids = (struct object_id *)realloc(set->ids, _capacity * sizeof(struct object_id));
+        if (_ids == NULL){
+            gitlet_panic("Failed to allocate memory for loose object set");
+        }
+        set->ids = _ids;
+        bool * _claimed = (bool *)realloc(set->claimed, _capacity * sizeof(bool));
+        if (_claimed == NULL){
+            gitlet_panic("Failed to allocate memory for loose object set");
+        }
+        set->claimed = _claimed;
+        set->capacity = _capacity;
+    }
+    memmove(set->ids + position + 1, set->ids + position, (set->count - position) * sizeof(struct object_id));
+    memmove(set->claimed + position + 1, set->claimed + position, (set->count - position) * sizeof(bool));
+    set->ids[position] = *oid;
+    set->claimed[position] = true;
+    set->count++;
+}
+
+/**
+ * @brief: Read the ids of the loose objects under the fan-out directory into the set
+ * @param set: The loose object set
+ * @param fanout: The first byte of the ids
+ */
+static void _loose_object_set_load(struct _loose_object_set * set, unsigned char fanout){
+    set->loaded = true;
+    _object_scan_fanout(fanout, &set->ids, &set->count, &set->capacity);
+    qsort(set->ids, set->count, sizeof(struct object_id), _object_id_compare);
+    if (set->capacity != 0){
+        set->claimed = (bool *)calloc(set->capacity, sizeof(bool));
+        if (set->claimed == NULL){
+            gitlet_panic("Failed to allocate memory for loose object set");
+        }
+    }
+}
+
+/**
+ * @brief: Update the mtime of the loose object already stored
+ * @param oid: The id of the object
+ * @return: false if the object file cannot be touched, so it is written again
+ * @note: A missing file was pruned by a concurrent gc since the fan-out
+ *        directory was read, it is written again too.
+ */
+static bool _object_freshen_loose(const struct object_id * oid){
+    char _path[PATH_MAX];
+    _get_object_file_path(_path, oid);
+    return utimensat(AT_FDCWD, _path, NULL, 0) == 0;
+}
+
+/**
+ * @brief: Check whether the object is already in the object database, and
+ *         remember it as written when it is not.
+ * @param oid: The id of the object
+ * @return: true if the object is already stored, false if the caller must write it
+ * @note: The loose objects are looked up in memory, the fan-out directory is
+ *        only read on the first lookup under it. A claimed object that fails
+ *        to be written panics, so the set never outlives a missing object.
+ * @note: An object already stored gets the mtime of now, like git, so the
+ *        expiry of gc never prunes an object written again just before it.
+ *        One that cannot be touched is written again instead, and is then
+ *        claimed by this process. An object claimed by this process is not
+ *        touched, its rename may still be deferred.
+ */
+static bool _object_writer_claim(const struct object_id * oid){
+    if (pack_freshen_object(oid)){
+        return true;
+    }
+
+    pthread_mutex_lock(&_loose_sets_lock);
+    struct _loose_object_set * _set = &_loose_sets[oid->hash[0]];
+    if (!_set->loaded){
+        _loose_object_set_load(_set, oid->hash[0]);
+    }
+    size_t _position = 0;
+    bool _found = _loose_object_set_search(_set, oid, &_position);
+    if (!_found){
+        _loose_object_set_insert(_set, oid, _position);
+    }
+    bool _claimed = _found && _set->claimed[_position];
+    pthread_mutex_unlock(&_loose_sets_lock);
+    if (!_found || _claimed || _object_freshen_loose(oid)){
+        return _found;
+    }
+
+    // the id read from the directory becomes the one this process writes
+    pthread_mutex_lock(&_loose_sets_lock);
+    if (!_set->loaded){
+        _loose_object_set_load(_set, oid->hash[0]);
+    }
+    if (_loose_object_set_search(_set, oid, &_position)){
+        _set->claimed[_position] = true;
+    }else{
+        _loose_object_set_insert(_set, oid, _position);
+    }
+    pthread_mutex_unlock(&_loose_sets_lock);
+    return false;
+}
+
+enum object_name_result object_resolve_name(struct object_id * oid, const char * name){
+    size_t _length = strlen(name);
+    if (_length == OBJECT_ID_HEX_SIZE){
+        return oid_from_hex(oid, name) ? OBJECT_NAME_FOUND : OBJECT_NAME_NOT_FOUND;
+    }
+    struct object_id _prefix;
+    if (_length < OBJECT_ID_MIN_ABBREV || !oid_from_hex_prefix(&_prefix, name, _length)){
+        return OBJECT_NAME_NOT_FOUND;
+    }
+
+    // two different ids are enough to tell the prefix is ambiguous
+    struct object_id _matches[2];
+    size_t _count = 0;
+    pack_find_prefix(&_prefix, _length, _matches, &_count, 2);
+
+    /**
+     * The loose objects are searched in the sorted set of the fan-out directory,
+     * which is read once and kept for the rest of the process.
+     */
+    pthread_mutex_lock(&_loose_sets_lock);
+    struct _loose_object_set * _set = &_loose_sets[_prefix.hash[0]];
+    if (!_set->loaded){
+        _loose_object_set_load(_set, _prefix.hash[0]);
+    }
+    size_t _position = 0;
+    _loose_object_set_search(_set, &_prefix, &_position);
+    for ( ; _position < _set->count && _count < 2; _position++){
+        const struct object_id * _oid = &_set->ids[_position];
+        if (!oid_has_prefix(_oid, &_prefix, _length)){
+            break;
+        }
+        if (_count == 0 || !oid_equals(&_matches[0], _oid)){
+            _matches[_count++] = *_oid;
+        }
+    }
+    pthread_mutex_unlock(&_loose_sets_lock);
+
+    if (_count == 0){
+        return OBJECT_NAME_NOT_FOUND;
+    }
+    if (_count > 1){
+        return OBJECT_NAME_AMBIGUOUS;
+    }
+    *oid = _matches[0];
+    return OBJECT_NAME_FOUND;
+}
+
+size_t object_abbreviate(char * buffer, const struct object_id * oid, size_t min_length){
+    oid_to_hex(buffer, oid);
+    size_t _length = min_length < OBJECT_ID_MIN_ABBREV ? OBJECT_ID_MIN_ABBREV : min_length;
+    for ( ; _length < OBJECT_ID_HEX_SIZE; _length++){
+        char _saved = buffer[_length];
+        buffer[_length] = '\0';
+        struct object_id _found;
+        if (object_resolve_name(&_found, buffer) != OBJECT_NAME_AMBIGUOUS){
+            return _length;
+        }
+        buffer[_length] = _saved;
+    }
+    return OBJECT_ID_HEX_SIZE;
+}
+
+/**
+ * @brief: Make sure the fan-out directory of the object exists, the 
+ *         directories already checked by the writer are remembered.
+ * @param writer: The object writer
+ * @param path: The object file path, the fan-out directory ends at directory_length + 2
+ * @param directory_length: The length of the objects directory in the path
+ * @param oid: The id of the object
+ * @return: true if the directory exists, false otherwise
+ */
+static bool _object_writer_prepare_fanout(struct object_writer * writer, char * path, 
+    size_t directory_length, const struct object_id * oid){
+    unsigned char _fanout = oid->hash[0];
+    if (writer->_fanout_ready[_fanout / 8] & (1U << (_fanout % 8))){
+        return true;
+    }
+
+    // another writer may create the same directory at the same time
+    path[directory_length + 2] = '\0';
+    bool _ready = is_directory(path) || create_directory(path) || is_directory(path);
+    path[directory_length + 2] = '/';
+    if (_ready){
+        writer->_fanout_ready[_fanout / 8] |= (unsigned char)(1U << (_fanout % 8));
+    }
+    return _ready;
+}
+
+void object_writer_init(struct object_writer * writer, bool write_to_repo){
+    memset(writer, 0, sizeof(struct object_writer));
+    writer->write_to_repo = write_to_repo;
+    writer->fsync_method = write_to_repo ? object_get_fsync_method() : OBJECT_FSYNC_NONE;
+
+    // build the objects directory and map the packs now, so the writers on other threads only read them
+    size_t _length = 0;
+    _get_objects_directory(&_length);
+    if (write_to_repo){
+        pack_prepare();
+    }
+
+    writer->_sha1_context = EVP_MD_CTX_new();
+    if (writer->_sha1_context == NULL){
+        gitlet_panic("Failed to initialize the SHA1 context");
+    }
+    writer->_input_buffer = (unsigned char *)malloc(OBJECT_STREAM_CHUNK_SIZE);
+    if (writer->_input_buffer == NULL){
+        gitlet_panic("Failed to allocate memory for object writer");
+    }
+    if (write_to_repo){
+        writer->_output_buffer = (unsigned char *)malloc(OBJECT_STREAM_CHUNK_SIZE);
+        if (writer->_output_buffer == NULL){
+            gitlet_panic("Failed to allocate memory for object writer");
+        }
+        writer->_level = compress_policy_get()->loose_level;
+        if (deflateInit(&writer->_zstream, writer->_level) != Z_OK){
+            gitlet_panic("Failed to initialize the deflate stream");
+        }
+    }
+}
+
+void object_writer_release(struct object_writer * writer){
+    object_writer_flush(writer, 1);
+    free(writer->_pending_paths);
+    if (writer->write_to_repo){
+        deflateEnd(&writer->_zstream);
+    }
+    EVP_MD_CTX_free(writer->_sha1_context);
+    free(writer->_input_buffer);
+    free(writer->_output_buffer);
+    memset(writer, 0, sizeof(struct object_writer));
+}
+
+/**
+ * @brief: Hash the file content after the header into the SHA1 context
+ * @param writer: The object writer, the last chunk is left in its input buffer
+ * @param file: The file, read from its current position to the end
+ * @param deflate_file: The temporary object file to compress the content into, NULL to only hash
+ * @return: The number of bytes read from the file
+ */
+static uint64_t _object_writer_read_content(struct object_writer * writer, FILE * file, FILE * deflate_file){
+    unsigned char * _chunk_buffer = writer->_input_buffer;
+    uint64_t _total_read = 0;
+    size_t _read_size = 0;
+    while ((_read_size = fread(_chunk_buffer, 1, OBJECT_STREAM_CHUNK_SIZE, file)) > 0){
+        _total_read += _read_size;
+        EVP_DigestUpdate(writer->_sha1_context, _chunk_buffer, _read_size);
+        if (deflate_file != NULL){
+            _deflate_chunk(writer, _chunk_buffer, _read_size, Z_NO_FLUSH, deflate_file);
+        }
+    }
+    return _total_read;
+}
+
+void object_writer_write(struct object_writer * writer, struct object_id * oid, const char * file){
     FILE * _file = fopen(file, "rb");
     if (_file == NULL){
         gitlet_panic("Failed to open file: %s", file);
     }
+    // the chunk buffer already batches the reads, skip the stdio buffer
+    setvbuf(_file, NULL, _IONBF, 0);
+    object_writer_write_file(writer, oid, _file, file);
+}
+
+void object_writer_write_file(struct object_writer * writer, struct object_id * oid, FILE * input, const char * file){
+    bool write_to_repo = writer->write_to_repo;
+    FILE * _file = input;
 
     struct object _obj;
     _obj.type = OBJECT_TYPE_BLOB;
     _obj.file_size = file_size(_file);
     _obj.content = NULL;
 
-    /**
-     * allocate the memory for the raw buffer : the header + the file content
-     */
-    char * _raw_buffer = (char *)malloc(_obj.file_size + HEADER_MAX_SIZE);
-    if (_raw_buffer == NULL){
-        fclose(_file);
-        gitlet_panic("Failed to allocate memory for raw buffer");
-    }
     /**
      * Write the object header to the buffer, and
      * the return pointer from the function is always
      * non-NULL.
      */
-    char * _header_end = _write_object_header(_raw_buffer, &_obj);
+    char _header_buffer[HEADER_MAX_SIZE];
+    char * _header_end = _write_object_header(_header_buffer, &_obj);
+    size_t _header_size = (size_t)(_header_end - _header_buffer);
+
+    // the SHA1 context and the deflate stream are reset instead of recreated
+    if (EVP_DigestInit_ex(writer->_sha1_context, EVP_sha1(), NULL) != 1){
+        fclose(_file);
+        gitlet_panic("Failed to initialize the SHA1 context");
+    }
+    EVP_DigestUpdate(writer->_sha1_context, _header_buffer, _header_size);
 
     /**
-     * Read the rest content from the file, and write it to the buffer.
+     * Hash the content before compressing it, an object already in the
+     * object database costs only the hash and a lookup in memory.
      */
-    if (fread(_header_end, 1, _obj.file_size, _file) != _obj.file_size){
-        free(_raw_buffer);
+    uint64_t _total_read = _object_writer_read_content(writer, _file, NULL);
+    if (ferror(_file) || _total_read != _obj.file_size){
         fclose(_file);
         gitlet_panic("Failed to read file content: %s", file);
     }
-    // close the file
-    fclose(_file);
-    // update the header end pointer
-    _header_end += _obj.file_size;
+    EVP_DigestFinal_ex(writer->_sha1_context, oid->hash, NULL);
+
+    if (!write_to_repo || _object_writer_claim(oid)){
+        fclose(_file);
+        return;
+    }
 
     /**
-     * hash the file content after the header is added using SHA1
+     * The compressed object is streamed into a temporary file, and moved 
+     * to the object database once it is complete.
      */
-    str_hash_sha1_n(buffer, _raw_buffer, (size_t)(_header_end - _raw_buffer));
+    char _temp_file_path[PATH_MAX];
+    FILE * _temp_file = _create_object_temp_file(_temp_file_path, PATH_MAX);
+    if (deflateReset(&writer->_zstream) != Z_OK){
+        gitlet_panic("Failed to reset the deflate stream");
+    }
 
     /**
-     * If the write_to_repo flag is true, write the object to the gitlet object data base.
+     * A larger file is read again, and the content is hashed once more so 
+     * a file changed between the two reads is never stored under the old id.
+     * The whole content of a smaller file is still in the input buffer.
      */
-    if (write_to_repo){
-        char _object_file_path[PATH_MAX];
-        memset(_object_file_path, 0, PATH_MAX);
+    bool _resident = _obj.file_size <= OBJECT_STREAM_CHUNK_SIZE;
+    size_t _first_size = (size_t)_obj.file_size;
+    if (!_resident){
+        rewind(_file);
+        EVP_DigestInit_ex(writer->_sha1_context, EVP_sha1(), NULL);
+        EVP_DigestUpdate(writer->_sha1_context, _header_buffer, _header_size);
+        _first_size = fread(writer->_input_buffer, 1, OBJECT_STREAM_CHUNK_SIZE, _file);
+        EVP_DigestUpdate(writer->_sha1_context, writer->_input_buffer, _first_size);
+    }
 
-        if (getcwd(_object_file_path, PATH_MAX) == NULL){
-            gitlet_panic("Failed to get the current working directory");
+    // the level is picked from the size and the first block before any input
+    int _level = compress_choose_level(compress_policy_get()->loose_level, _obj.file_size, 
+        writer->_input_buffer, _first_size);
+    if (_level != writer->_level){
+        if (deflateParams(&writer->_zstream, _level, Z_DEFAULT_STRATEGY) != Z_OK){
+            gitlet_panic("Failed to set the compression level");
         }
+        writer->_level = _level;
+    }
+    _deflate_chunk(writer, (const unsigned char *)_header_buffer, _header_size, 
+        Z_NO_FLUSH, _temp_file);
+    _deflate_chunk(writer, writer->_input_buffer, _first_size, Z_NO_FLUSH, _temp_file);
 
-        strcat(_object_file_path, "/");
-        strcat(_object_file_path, ".gitlet/objects/");
-        strncpy(_object_file_path + strlen(_object_file_path), buffer, 2);
-
-        if (!(exists(_object_file_path) && is_directory(_object_file_path))){
-            if (!create_directory(_object_file_path)){
-                gitlet_panic("Failed to create directory: %s", _object_file_path);
-            }
+    if (!_resident){
+        struct object_id _check_oid;
+        _total_read = _first_size + _object_writer_read_content(writer, _file, _temp_file);
+        EVP_DigestFinal_ex(writer->_sha1_context, _check_oid.hash, NULL);
+        if (ferror(_file) || _total_read != _obj.file_size || !oid_equals(&_check_oid, oid)){
+            fclose(_file);
+            fclose(_temp_file);
+            remove_file(_temp_file_path);
+            gitlet_panic("File changed while being hashed: %s", file);
         }
+    }
+    // close the file
+    fclose(_file);
 
-        strcat(_object_file_path, "/");
-        strncpy(_object_file_path + strlen(_object_file_path), buffer + 2, 38);
+    _deflate_chunk(writer, NULL, 0, Z_FINISH, _temp_file);
 
-        FILE * _object_file = fopen(_object_file_path, "wb");
-        if (_object_file == NULL){
-            gitlet_panic("Failed to open object file: %s", _object_file_path);
-        }
+    bool _synced = _object_writer_sync_file(writer, _temp_file);
+    if (fclose(_temp_file) != 0 || !_synced){
+        remove_file(_temp_file_path);
+        gitlet_panic("Failed to write object file: %s", _temp_file_path);
+    }
 
-        /**
-         * Write the compressed content to the object file
-         */
-        char * _compressed_buffer = (char *)malloc(_obj.file_size + HEADER_MAX_SIZE);
-        if (_compressed_buffer == NULL){
-            fclose(_object_file);
-            gitlet_panic("Failed to allocate memory for compressed buffer");
-        }
+    char _object_file_path[PATH_MAX];
+    size_t _directory_length = _get_object_file_path(_object_file_path, oid);
+
+    // create the fan-out directory on the first object under it
+    if (!_object_writer_prepare_fanout(writer, _object_file_path, _directory_length, oid)){
+        remove_file(_temp_file_path);
+        _object_file_path[_directory_length + 2] = '\0';
+        gitlet_panic("Failed to create directory: %s", _object_file_path);
+    }
 
-        // compress the content
-        str_compress(_raw_buffer, (size_t)(_header_end - _raw_buffer), 
-            _compressed_buffer, _obj.file_size + HEADER_MAX_SIZE);
+    if (writer->fsync_method == OBJECT_FSYNC_BATCH){
+        _object_writer_defer_rename(writer, _temp_file_path, _object_file_path);
+    }else if (rename(_temp_file_path, _object_file_path) != 0){
+        remove_file(_temp_file_path);
+        gitlet_panic("Failed to write object file: %s", _object_file_path);
+    }
+}
+
+void object_write(struct object_id * oid, const char * file, bool write_to_repo){
+    struct object_writer _writer;
+    object_writer_init(&_writer, write_to_repo);
+    object_writer_write(&_writer, oid, file);
+    object_writer_release(&_writer);
+}
+
+/**
+ * @brief: The state of the loose prune shared by the worker threads
+ * @param kept: The sorted ids of the objects to keep when they are not packed
+ * @param kept_count: The number of the kept ids
+ * @param expire: The unkept loose objects last modified before it are deleted
+ * @param pruned: The number of the objects deleted under every fan-out directory
+ */
+struct _loose_prune{
+    const struct object_id * kept;
+    size_t kept_count;
+    time_t expire;
+    size_t pruned[256];
+};
+
+/**
+ * @brief: Prune one fan-out directory on the worker thread
+ * @param index: The fan-out directory
+ * @param worker: The index of the worker thread
+ * @param data: The loose prune
+ */
+static void _loose_prune_fanout(size_t index, unsigned int worker, void * data){
+    (void)worker;
+    struct _loose_prune * _prune = (struct _loose_prune *)data;
+    struct object_id * _ids = NULL;
+    size_t _count = 0;
+    size_t _capacity = 0;
+    _object_scan_fanout((unsigned char)index, &_ids, &_count, &_capacity);
 
-        if (fwrite(_compressed_buffer, 1, _obj.file_size + HEADER_MAX_SIZE, 
-        _object_file) != _obj.file_size + HEADER_MAX_SIZE){
-            fclose(_object_file);
-            free(_compressed_buffer);
-            gitlet_panic("Failed to write object file: %s", _object_file_path);
+    char _path[PATH_MAX];
+    size_t _directory_length = 0;
+    for (size_t i = 0; i < _count; i++){
+        _directory_length = _get_object_file_path(_path, &_ids[i]);
+        bool _remove = pack_find_object(NULL, &_ids[i]);
+        if (!_remove && bsearch(&_ids[i], _prune->kept, _prune->kept_count, sizeof(struct object_id), 
+            _object_id_compare) == NULL){
+            struct stat _status;
+            _remove = stat(_path, &_status) == 0 && _status.st_mtime < _prune->expire;
         }
+        if (_remove && remove_file(_path)){
+            _prune->pruned[index]++;
+        }
+    }
+    // the emptied fan-out directory goes too, it is created again by the next writer
+    if (_count != 0 && _prune->pruned[index] == _count){
+        _path[_directory_length + 2] = '\0';
+        rmdir(_path);
+    }
+    free(_ids);
 
-        fclose(_object_file);
-        free(_compressed_buffer);
+    // the next lookup reads the directory again
+    pthread_mutex_lock(&_loose_sets_lock);
+    struct _loose_object_set * _set = &_loose_sets[index];
+    free(_set->ids);
+    free(_set->claimed);
+    memset(_set, 0, sizeof(struct _loose_object_set));
+    pthread_mutex_unlock(&_loose_sets_lock);
+}
+
+size_t object_prune_loose(const struct object_id * kept, size_t kept_count, time_t expire){
+    struct _loose_prune * _prune = (struct _loose_prune *)calloc(1, sizeof(struct _loose_prune));
+    if (_prune == NULL){
+        gitlet_panic("Failed to allocate memory for the loose prune");
     }
+    _prune->kept = kept;
+    _prune->kept_count = kept_count;
+    _prune->expire = expire;
+
+    // the packs and the objects directory are set up before the workers share them
+    size_t _length = 0;
+    const char * _directory = _get_objects_directory(&_length);
+    pack_prepare();
+    unsigned int _workers = parallel_cpu_count();
+    parallel_for(_workers < OBJECT_SCAN_MAX_THREADS ? _workers : OBJECT_SCAN_MAX_THREADS, 256, 
+        _loose_prune_fanout, _prune);
 
-    // free the memory for raw buffer
-    free(_raw_buffer);
-}
\ No newline at end of file
+    size_t _pruned = 0;
+    for (unsigned int i = 0; i < 256; i++){
+        _pruned += _prune->pruned[i];
+    }
+    free(_prune);
+
+    // the temporary files of the writers which never finished
+    DIR * _objects_directory = opendir(_directory);
+    if (_objects_directory == NULL){
+        return _pruned;
+    }
+    struct dirent * _entry = NULL;
+    while ((_entry = readdir(_objects_directory)) != NULL){
+        if (!str_start_with(_entry->d_name, "tmp_obj_")){
+            continue;
+        }
+        char _temp_path[PATH_MAX];
+        struct stat _status;
+        if (snprintf(_temp_path, PATH_MAX, "%s%s", _directory, _entry->d_name) < PATH_MAX 
+            && stat(_temp_path, &_status) == 0 && _status.st_mtime < expire){
+            remove_file(_temp_path);
+        }
+    }
+    closedir(_objects_directory);
+    return _pruned;
+}
@@ -0,0 +1,46 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <object/oid.h>
+#include <util/str.h>
+
+char * oid_to_hex(char * buffer, const struct object_id * oid){
+    str_hex_encode(buffer, oid->hash, OBJECT_ID_RAW_SIZE);
+    return buffer;
+}
+
+bool oid_from_hex(struct object_id * oid, const char * hex){
+    return strnlen(hex, OBJECT_ID_HEX_SIZE + 1) == OBJECT_ID_HEX_SIZE 
+        && str_hex_decode(oid->hash, hex, OBJECT_ID_RAW_SIZE);
+}
+
+bool oid_from_hex_prefix(struct object_id * prefix, const char * hex, size_t hex_length){
+    if (hex_length > OBJECT_ID_HEX_SIZE){
+        return false;
+    }
+    char padded[OBJECT_ID_HEX_SIZE];
+    memcpy(padded, hex, hex_length);
+    memset(padded + hex_length, '0', OBJECT_ID_HEX_SIZE - hex_length);
+    return str_hex_decode(prefix->hash, padded, OBJECT_ID_RAW_SIZE);
+}
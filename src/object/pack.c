@@ -0,0 +1,1459 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <zlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+
+#include <object/pack.h>
+#include <object/object.h>
+#include <object/delta.h>
+#include <object/cache.h>
+#include <object/compress.h>
+#include <util/files.h>
+#include <util/str.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <global/config.h>
+
+#define PACK_SIGNATURE              0x5041434bU     // "PACK"
+#define PACK_VERSION                2
+#define PACK_HEADER_SIZE            12
+#define PACK_INDEX_SIGNATURE        0xff744f63U     // "\377tOc"
+#define PACK_INDEX_VERSION          2
+#define PACK_INDEX_HEADER_SIZE      8
+#define PACK_FANOUT_SIZE            256
+#define PACK_LARGE_OFFSET_FLAG      0x80000000U
+
+// size of the chunk used when streaming the object content into the pack
+#define PACK_CHUNK_SIZE             (64 * 1024)
+// the input of the inflate stream is fed in pieces no larger than this
+#define PACK_MAX_INPUT_PIECE        (1U << 30)
+// the objects larger than this are never compared for the deltas
+#define PACK_DELTA_MAX_SIZE         (32 * 1024 * 1024)
+// the two size varints at the beginning of the delta fit in this many bytes
+#define PACK_DELTA_HEADER_SIZE      20
+// the reader refuses the delta chains longer than this
+#define PACK_MAX_DELTA_CHAIN        4095
+
+// the type code of the pack entry
+#define PACK_TYPE_COMMIT            1
+#define PACK_TYPE_TREE              2
+#define PACK_TYPE_BLOB              3
+#define PACK_TYPE_TAG               4
+#define PACK_TYPE_OFS_DELTA         6
+#define PACK_TYPE_REF_DELTA         7
+
+/**
+ * @brief: The pack mapped into memory
+ * @param name: The path of the pack index
+ * @param index_map: The mapped pack index
+ * @param index_size: The size of the pack index
+ * @param pack_map: The mapped pack data
+ * @param pack_size: The size of the pack data
+ * @param object_count: The number of objects in the pack
+ * @param freshened: Whether the mtime of the pack data was updated by this process
+ * @param next: The next pack in the list
+ */
+struct pack{
+    char * name;
+    const unsigned char * index_map;
+    size_t index_size;
+    const unsigned char * pack_map;
+    size_t pack_size;
+    uint32_t object_count;
+    atomic_bool freshened;
+    struct pack * next;
+};
+
+/**
+ * @brief: The raw entry of the pack
+ * @param type: The type code of the entry
+ * @param size: The size of the inflated data, the size of the delta for the delta entry
+ * @param data: The compressed data of the entry inside the mapped pack
+ * @param data_size: The number of bytes available from data to the end of the pack
+ * @param base_pack: The pack of the delta base, NULL if the entry is not a delta
+ * @param base_offset: The offset of the delta base in its pack
+ */
+struct pack_entry{
+    unsigned int type;
+    uint64_t size;
+    const unsigned char * data;
+    size_t data_size;
+    const struct pack * base_pack;
+    uint64_t base_offset;
+};
+
+/**
+ * @brief: The entry of the pack index while writing the pack
+ * @param oid: The id of the object
+ * @param offset: The offset of the object in the pack
+ * @param crc32: The crc32 of the packed object
+ */
+struct pack_index_entry{
+    struct object_id oid;
+    uint64_t offset;
+    uint32_t crc32;
+};
+
+/**
+ * @brief: The object to be written in the delta order
+ * @param entry: The position of the object in the index entries
+ * @param type: The type of the object
+ * @param file_size: The size of the object content
+ */
+struct pack_delta_object{
+    size_t entry;
+    enum object_type type;
+    uint64_t file_size;
+};
+
+/**
+ * @brief: The slot of the sliding window of the delta base candidates
+ * @param entry: The position of the object in the index entries
+ * @param type: The type of the object
+ * @param content: The shared content of the object, NULL for the empty slot
+ * @param size: The size of the object content
+ * @param index: The delta index of the content, built on the first use as a base
+ * @param depth: The length of the delta chain of the object
+ */
+struct pack_delta_window{
+    size_t entry;
+    enum object_type type;
+    unsigned char * content;
+    size_t size;
+    struct delta_index * index;
+    unsigned int depth;
+};
+
+/**
+ * @brief: The pack data file being written
+ * @param file: The temporary pack file
+ * @param sha1_context: The SHA1 context over the whole pack
+ * @param offset: The current offset in the pack
+ * @param crc32: The crc32 of the current entry
+ */
+struct pack_file_writer{
+    FILE * file;
+    EVP_MD_CTX * sha1_context;
+    uint64_t offset;
+    uint32_t crc32;
+};
+
+static struct pack * _packs = NULL;
+static atomic_bool _packs_prepared = false;
+// the first lookup may come from any of the worker threads
+static pthread_mutex_t _packs_prepare_lock = PTHREAD_MUTEX_INITIALIZER;
+// the paths of the pack data whose pack or index is unusable, left out of the list
+static char ** _bad_packs = NULL;
+static size_t _bad_pack_count = 0;
+
+static inline uint32_t _get_be32(const unsigned char * buffer){
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) 
+        | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+static inline uint64_t _get_be64(const unsigned char * buffer){
+    return ((uint64_t)_get_be32(buffer) << 32) | (uint64_t)_get_be32(buffer + 4);
+}
+
+static inline void _put_be32(unsigned char * buffer, uint32_t value){
+    buffer[0] = (unsigned char)(value >> 24);
+    buffer[1] = (unsigned char)(value >> 16);
+    buffer[2] = (unsigned char)(value >> 8);
+    buffer[3] = (unsigned char)value;
+}
+
+/**
+ * @brief: Get the pack directory of the gitlet repository
+ * @param buffer: The buffer to store the path, the length of the buffer is PATH_MAX
+ */
+static void _get_pack_directory(char * buffer){
+    if (getcwd(buffer, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+    strcat(buffer, "/.gitlet/objects/pack");
+}
+
+/**
+ * @brief: Map the whole file into memory as read only
+ * @param path: The path of the file
+ * @param size: The pointer to store the size of the file
+ * @return: The mapped memory, NULL if the file cannot be mapped
+ */
+static const unsigned char * _map_file(const char * path, size_t * size){
+    int _fd = open(path, O_RDONLY);
+    if (_fd < 0){
+        return NULL;
+    }
+    struct stat _status;
+    if (fstat(_fd, &_status) != 0 || _status.st_size == 0){
+        close(_fd);
+        return NULL;
+    }
+    void * _map = mmap(NULL, (size_t)_status.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    close(_fd);
+    if (_map == MAP_FAILED){
+        return NULL;
+    }
+    *size = (size_t)_status.st_size;
+    return (const unsigned char *)_map;
+}
+
+/**
+ * @brief: Remember the pack left out of the list, so pack_verify reports it
+ * @param pack_path: The path of the pack data
+ */
+static void _pack_add_bad(const char * pack_path){
+    char ** _paths = (char **)realloc(_bad_packs, (_bad_pack_count + 1) * sizeof(char *));
+    if (_paths == NULL){
+        gitlet_panic("Failed to allocate memory for pack");
+    }
+    _bad_packs = _paths;
+    _bad_packs[_bad_pack_count] = strdup(pack_path);
+    if (_bad_packs[_bad_pack_count] == NULL){
+        gitlet_panic("Failed to allocate memory for pack");
+    }
+    _bad_pack_count++;
+}
+
+/**
+ * @brief: Map the pack index and the pack data, and add the pack to the list
+ * @param index_path: The path of the pack index
+ * @note: A pack whose index or data is empty or has a bad header is left out
+ *        of the list and remembered, its objects are not found but the other
+ *        packs and the loose objects can still be read and checked.
+ */
+static void _pack_add(const char * index_path){
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        if (str_equals(_pack->name, index_path)){
+            return;
+        }
+    }
+
+    char _pack_path[PATH_MAX];
+    memset(_pack_path, 0, PATH_MAX);
+    strncpy(_pack_path, index_path, strlen(index_path) - strlen(".idx"));
+    strcat(_pack_path, ".pack");
+
+    struct pack _pack;
+    memset(&_pack, 0, sizeof(struct pack));
+    // a missing pack is one being removed, an unreadable one is broken
+    _pack.index_map = _map_file(index_path, &_pack.index_size);
+    if (_pack.index_map == NULL){
+        if (access(index_path, F_OK) == 0 && access(_pack_path, F_OK) == 0){
+            _pack_add_bad(_pack_path);
+        }
+        return;
+    }
+    _pack.pack_map = _map_file(_pack_path, &_pack.pack_size);
+    if (_pack.pack_map == NULL){
+        munmap((void *)_pack.index_map, _pack.index_size);
+        if (access(_pack_path, F_OK) == 0){
+            _pack_add_bad(_pack_path);
+        }
+        return;
+    }
+
+    // validate the header of the index and the pack
+    size_t _minimum_index_size = PACK_INDEX_HEADER_SIZE + PACK_FANOUT_SIZE * 4 + SHA_DIGEST_LENGTH * 2;
+    bool _valid = _pack.index_size >= _minimum_index_size 
+        && _get_be32(_pack.index_map) == PACK_INDEX_SIGNATURE
+        && _get_be32(_pack.index_map + 4) == PACK_INDEX_VERSION;
+    if (_valid){
+        _pack.object_count = _get_be32(_pack.index_map + PACK_INDEX_HEADER_SIZE + (PACK_FANOUT_SIZE - 1) * 4);
+        _valid = _pack.index_size >= _minimum_index_size + (size_t)_pack.object_count * (SHA_DIGEST_LENGTH + 8)
+            && _pack.pack_size >= PACK_HEADER_SIZE + SHA_DIGEST_LENGTH
+            && _get_be32(_pack.pack_map) == PACK_SIGNATURE
+            && _get_be32(_pack.pack_map + 4) == PACK_VERSION
+            && _get_be32(_pack.pack_map + 8) == _pack.object_count;
+    }
+    if (!_valid){
+        munmap((void *)_pack.index_map, _pack.index_size);
+        munmap((void *)_pack.pack_map, _pack.pack_size);
+        _pack_add_bad(_pack_path);
+        return;
+    }
+
+    struct pack * _new_pack = (struct pack *)malloc(sizeof(struct pack));
+    if (_new_pack == NULL){
+        gitlet_panic("Failed to allocate memory for pack");
+    }
+    *_new_pack = _pack;
+    _new_pack->name = strdup(index_path);
+    _new_pack->next = _packs;
+    _packs = _new_pack;
+}
+
+void pack_prepare(void){
+    if (atomic_load(&_packs_prepared)){
+        return;
+    }
+    pthread_mutex_lock(&_packs_prepare_lock);
+    if (atomic_load(&_packs_prepared)){
+        pthread_mutex_unlock(&_packs_prepare_lock);
+        return;
+    }
+
+    char _pack_directory[PATH_MAX];
+    memset(_pack_directory, 0, PATH_MAX);
+    _get_pack_directory(_pack_directory);
+
+    DIR * _directory = opendir(_pack_directory);
+    if (_directory == NULL){
+        atomic_store(&_packs_prepared, true);
+        pthread_mutex_unlock(&_packs_prepare_lock);
+        return;
+    }
+    struct dirent * _entry = NULL;
+    while ((_entry = readdir(_directory)) != NULL){
+        if (!str_start_with(_entry->d_name, "pack-") || !str_end_with(_entry->d_name, ".idx")){
+            continue;
+        }
+        char _index_path[PATH_MAX];
+        if (snprintf(_index_path, PATH_MAX, "%s/%s", _pack_directory, _entry->d_name) >= PATH_MAX){
+            continue;
+        }
+        _pack_add(_index_path);
+    }
+    closedir(_directory);
+    atomic_store(&_packs_prepared, true);
+    pthread_mutex_unlock(&_packs_prepare_lock);
+}
+
+/**
+ * @brief: Search the object in the fanout table and the sorted object ids of the pack index
+ * @param pack: The pack to search
+ * @param oid: The id of the object
+ * @param position: The pointer to store the position of the object in the index
+ * @return: true if the object is found, false otherwise
+ */
+static bool _pack_index_search(const struct pack * pack, const struct object_id * oid, uint32_t * position){
+    const unsigned char * _fanout = pack->index_map + PACK_INDEX_HEADER_SIZE;
+    const unsigned char * _sha1_table = _fanout + PACK_FANOUT_SIZE * 4;
+
+    uint32_t _low = oid->hash[0] == 0 ? 0 : _get_be32(_fanout + (oid->hash[0] - 1) * 4);
+    uint32_t _high = _get_be32(_fanout + oid->hash[0] * 4);
+    while (_low < _high){
+        uint32_t _middle = _low + (_high - _low) / 2;
+        int _compare = memcmp(_sha1_table + (size_t)_middle * OBJECT_ID_RAW_SIZE, oid->hash, OBJECT_ID_RAW_SIZE);
+        if (_compare == 0){
+            *position = _middle;
+            return true;
+        }else if (_compare < 0){
+            _low = _middle + 1;
+        }else{
+            _high = _middle;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief: Get the offset of the object in the pack data
+ * @param pack: The pack
+ * @param position: The position of the object in the index
+ * @return: The offset of the object in the pack data
+ */
+static uint64_t _pack_index_offset(const struct pack * pack, uint32_t position){
+    const unsigned char * _offset_table = pack->index_map + PACK_INDEX_HEADER_SIZE + PACK_FANOUT_SIZE * 4
+        + (size_t)pack->object_count * (SHA_DIGEST_LENGTH + 4);
+    uint32_t _offset = _get_be32(_offset_table + (size_t)position * 4);
+    if (!(_offset & PACK_LARGE_OFFSET_FLAG)){
+        return _offset;
+    }
+
+    const unsigned char * _large_offset_table = _offset_table + (size_t)pack->object_count * 4;
+    size_t _large_position = _offset & ~PACK_LARGE_OFFSET_FLAG;
+    if (_large_offset_table + (_large_position + 1) * 8 > pack->index_map + pack->index_size - SHA_DIGEST_LENGTH * 2){
+        gitlet_panic("Invalid large offset in pack index: %s", pack->name);
+    }
+    return _get_be64(_large_offset_table + _large_position * 8);
+}
+
+/**
+ * @brief: Find the object in all the packs by the object id
+ * @param oid: The id of the object
+ * @param pack: The pointer to store the pack of the object
+ * @param offset: The pointer to store the offset of the object in the pack
+ * @return: true if the object is found, false otherwise
+ */
+static bool _pack_locate(const struct object_id * oid, const struct pack ** pack, uint64_t * offset){
+    pack_prepare();
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        uint32_t _position = 0;
+        if (_pack_index_search(_pack, oid, &_position)){
+            *pack = _pack;
+            *offset = _pack_index_offset(_pack, _position);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief: Parse the type and size header of the pack entry, and the base 
+ *         reference of the delta entry.
+ * @param pack: The pack
+ * @param offset: The offset of the entry
+ * @param entry: The pack entry to store the result
+ */
+static void _pack_parse_entry(const struct pack * pack, uint64_t offset, struct pack_entry * entry){
+    size_t _limit = pack->pack_size - SHA_DIGEST_LENGTH;
+    if (offset < PACK_HEADER_SIZE || offset >= _limit){
+        gitlet_panic("Invalid object offset in pack: %s", pack->name);
+    }
+
+    const unsigned char * _end = pack->pack_map + _limit;
+    const unsigned char * _current = pack->pack_map + offset;
+    unsigned char _byte = *_current++;
+    unsigned int _type = (_byte >> 4) & 0x7;
+    uint64_t _size = _byte & 0xf;
+    unsigned int _shift = 4;
+    while (_byte & 0x80){
+        if (_current >= _end || _shift > 57){
+            gitlet_panic("Invalid object header in pack: %s", pack->name);
+        }
+        _byte = *_current++;
+        _size |= (uint64_t)(_byte & 0x7f) << _shift;
+        _shift += 7;
+    }
+
+    entry->type = _type;
+    entry->size = _size;
+    entry->base_pack = NULL;
+    entry->base_offset = 0;
+
+    switch (_type){
+        case PACK_TYPE_COMMIT:
+        case PACK_TYPE_TREE:
+        case PACK_TYPE_BLOB:
+        case PACK_TYPE_TAG:
+            break;
+        case PACK_TYPE_OFS_DELTA: {
+            // the base is stored as the negative offset from this entry
+            if (_current >= _end){
+                gitlet_panic("Invalid delta base offset in pack: %s", pack->name);
+            }
+            _byte = *_current++;
+            uint64_t _distance = _byte & 0x7f;
+            while (_byte & 0x80){
+                if (_current >= _end || _distance >= ((uint64_t)1 << 56)){
+                    gitlet_panic("Invalid delta base offset in pack: %s", pack->name);
+                }
+                _byte = *_current++;
+                _distance = ((_distance + 1) << 7) | (_byte & 0x7f);
+            }
+            if (_distance == 0 || _distance > offset){
+                gitlet_panic("Invalid delta base offset in pack: %s", pack->name);
+            }
+            entry->base_pack = pack;
+            entry->base_offset = offset - _distance;
+            break;
+        }
+        case PACK_TYPE_REF_DELTA:
+            // the base is stored as the object id, and can live in any pack
+            if ((size_t)(_end - _current) < OBJECT_ID_RAW_SIZE){
+                gitlet_panic("Invalid delta base in pack: %s", pack->name);
+            }
+            struct object_id _base_oid;
+            memcpy(_base_oid.hash, _current, OBJECT_ID_RAW_SIZE);
+            if (!_pack_locate(&_base_oid, &entry->base_pack, &entry->base_offset)){
+                gitlet_panic("Delta base object not found in pack: %s", pack->name);
+            }
+            _current += OBJECT_ID_RAW_SIZE;
+            break;
+        default:
+            gitlet_panic("Unsupported object type %u in pack: %s", _type, pack->name);
+    }
+    entry->data = _current;
+    entry->data_size = (size_t)(_end - _current);
+}
+
+/**
+ * @brief: Convert the type code of the pack entry to the object type
+ */
+static enum object_type _pack_object_type(unsigned int type){
+    switch (type){
+        case PACK_TYPE_COMMIT:
+            return OBJECT_TYPE_COMMIT;
+        case PACK_TYPE_TREE:
+            return OBJECT_TYPE_TREE;
+        case PACK_TYPE_BLOB:
+            return OBJECT_TYPE_BLOB;
+        case PACK_TYPE_TAG:
+            return OBJECT_TYPE_TAG;
+        default:
+            return OBJECT_TYPE_UNKNOWN;
+    }
+}
+
+/**
+ * @brief: Inflate the compressed data of the pack entry into the buffer
+ * @param entry: The pack entry
+ * @param buffer: The buffer to store the inflated data
+ * @param size: The size of the buffer
+ * @param partial: true to stop once the buffer is full, false to require the 
+ *                 data to end exactly at the size of the buffer
+ * @return: The number of the inflated bytes
+ */
+static size_t _pack_inflate_entry(const struct pack_entry * entry, unsigned char * buffer, size_t size, bool partial){
+    z_stream _zstream;
+    memset(&_zstream, 0, sizeof(z_stream));
+    if (inflateInit(&_zstream) != Z_OK){
+        gitlet_panic("Failed to initialize the inflate stream");
+    }
+
+    const unsigned char * _input = entry->data;
+    size_t _input_size = entry->data_size;
+    size_t _output_size = 0;
+    int _status = Z_OK;
+    while (_status != Z_STREAM_END && _output_size < size){
+        if (_zstream.avail_in == 0){
+            if (_input_size == 0){
+                gitlet_panic("Unexpected end of the packed object");
+            }
+            size_t _piece_size = _input_size < PACK_MAX_INPUT_PIECE ? _input_size : PACK_MAX_INPUT_PIECE;
+            _zstream.next_in = (Bytef *)_input;
+            _zstream.avail_in = (uInt)_piece_size;
+            _input += _piece_size;
+            _input_size -= _piece_size;
+        }
+        size_t _chunk_size = size - _output_size < PACK_MAX_INPUT_PIECE ? size - _output_size : PACK_MAX_INPUT_PIECE;
+        _zstream.next_out = buffer + _output_size;
+        _zstream.avail_out = (uInt)_chunk_size;
+        _status = inflate(&_zstream, Z_NO_FLUSH);
+        if (_status != Z_OK && _status != Z_STREAM_END){
+            gitlet_panic("Failed to decompress the packed object");
+        }
+        _output_size += _chunk_size - _zstream.avail_out;
+    }
+
+    // an exact inflate must also reach the end of the compressed stream
+    while (!partial && _status != Z_STREAM_END){
+        unsigned char _trailing;
+        if (_zstream.avail_in == 0){
+            if (_input_size == 0){
+                gitlet_panic("Unexpected end of the packed object");
+            }
+            size_t _piece_size = _input_size < PACK_MAX_INPUT_PIECE ? _input_size : PACK_MAX_INPUT_PIECE;
+            _zstream.next_in = (Bytef *)_input;
+            _zstream.avail_in = (uInt)_piece_size;
+            _input += _piece_size;
+            _input_size -= _piece_size;
+        }
+        _zstream.next_out = &_trailing;
+        _zstream.avail_out = 1;
+        _status = inflate(&_zstream, Z_NO_FLUSH);
+        if ((_status != Z_OK && _status != Z_STREAM_END) || _zstream.avail_out == 0){
+            gitlet_panic("Packed object size mismatch");
+        }
+    }
+    inflateEnd(&_zstream);
+    if (!partial && _output_size != size){
+        gitlet_panic("Packed object size mismatch");
+    }
+    return _output_size;
+}
+
+/**
+ * @brief: Fill the pack object from the entry at the offset, the delta entry 
+ *         only reads the header of the delta and the types along its chain.
+ * @param pack: The pack
+ * @param offset: The offset of the entry
+ * @param obj: The pack object to store the result
+ */
+static void _pack_read_object(const struct pack * pack, uint64_t offset, struct pack_object * obj){
+    struct pack_entry _entry;
+    _pack_parse_entry(pack, offset, &_entry);
+    obj->_pack = pack;
+    obj->_offset = offset;
+
+    if (_entry.base_pack == NULL){
+        obj->type = _pack_object_type(_entry.type);
+        obj->file_size = _entry.size;
+        obj->data = _entry.data;
+        obj->data_size = _entry.data_size;
+        obj->is_delta = false;
+        return;
+    }
+
+    // the size of the result is in the header at the beginning of the delta
+    unsigned char _header[PACK_DELTA_HEADER_SIZE];
+    size_t _header_size = _pack_inflate_entry(&_entry, _header, 
+        _entry.size < PACK_DELTA_HEADER_SIZE ? (size_t)_entry.size : PACK_DELTA_HEADER_SIZE, true);
+    uint64_t _base_size = 0;
+    if (!delta_header(_header, _header_size, &_base_size, &obj->file_size)){
+        gitlet_panic("Invalid delta header in pack: %s", pack->name);
+    }
+
+    // the type of the object is the type of the base at the end of the chain
+    unsigned int _depth = 0;
+    while (_entry.base_pack != NULL){
+        if (++_depth > PACK_MAX_DELTA_CHAIN){
+            gitlet_panic("Delta chain too long in pack: %s", pack->name);
+        }
+        _pack_parse_entry(_entry.base_pack, _entry.base_offset, &_entry);
+    }
+    obj->type = _pack_object_type(_entry.type);
+    obj->data = NULL;
+    obj->data_size = 0;
+    obj->is_delta = true;
+}
+
+bool pack_find_object(struct pack_object * obj, const struct object_id * oid){
+    const struct pack * _pack = NULL;
+    uint64_t _offset = 0;
+    if (!_pack_locate(oid, &_pack, &_offset)){
+        return false;
+    }
+    if (obj != NULL){
+        _pack_read_object(_pack, _offset, obj);
+    }
+    return true;
+}
+
+bool pack_freshen_object(const struct object_id * oid){
+    pack_prepare();
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        uint32_t _position = 0;
+        if (!_pack_index_search(_pack, oid, &_position)){
+            continue;
+        }
+        if (atomic_load(&_pack->freshened)){
+            return true;
+        }
+        // the name is the path of the index, the pack data is next to it
+        char _pack_path[PATH_MAX];
+        size_t _length = strlen(_pack->name) - strlen(".idx");
+        memcpy(_pack_path, _pack->name, _length);
+        strcpy(_pack_path + _length, ".pack");
+        if (utimensat(AT_FDCWD, _pack_path, NULL, 0) == 0){
+            atomic_store(&_pack->freshened, true);
+            return true;
+        }
+    }
+    return false;
+}
+
+void pack_find_prefix(const struct object_id * prefix, size_t hex_length, struct object_id * matches, 
+    size_t * count, size_t max_count){
+    pack_prepare();
+    for (struct pack * _pack = _packs; _pack != NULL && *count < max_count; _pack = _pack->next){
+        const unsigned char * _fanout = _pack->index_map + PACK_INDEX_HEADER_SIZE;
+        const unsigned char * _sha1_table = _fanout + PACK_FANOUT_SIZE * 4;
+
+        // the lower bound of the prefix among the ids under its fanout
+        uint32_t _low = prefix->hash[0] == 0 ? 0 : _get_be32(_fanout + (prefix->hash[0] - 1) * 4);
+        uint32_t _high = _get_be32(_fanout + prefix->hash[0] * 4);
+        uint32_t _end = _high;
+        while (_low < _high){
+            uint32_t _middle = _low + (_high - _low) / 2;
+            if (memcmp(_sha1_table + (size_t)_middle * OBJECT_ID_RAW_SIZE, prefix->hash, OBJECT_ID_RAW_SIZE) < 0){
+                _low = _middle + 1;
+            }else{
+                _high = _middle;
+            }
+        }
+
+        for (uint32_t i = _low; i < _end && *count < max_count; i++){
+            struct object_id _oid;
+            memcpy(_oid.hash, _sha1_table + (size_t)i * OBJECT_ID_RAW_SIZE, OBJECT_ID_RAW_SIZE);
+            if (!oid_has_prefix(&_oid, prefix, hex_length)){
+                break;
+            }
+            bool _known = false;
+            for (size_t j = 0; j < *count && !_known; j++){
+                _known = oid_equals(&matches[j], &_oid);
+            }
+            if (!_known){
+                matches[(*count)++] = _oid;
+            }
+        }
+    }
+}
+
+void pack_for_each_object(object_each_callback callback, void * data){
+    pack_prepare();
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        const unsigned char * _sha1_table = _pack->index_map + PACK_INDEX_HEADER_SIZE + PACK_FANOUT_SIZE * 4;
+        for (uint32_t i = 0; i < _pack->object_count; i++){
+            struct object_id _oid;
+            memcpy(_oid.hash, _sha1_table + (size_t)i * OBJECT_ID_RAW_SIZE, OBJECT_ID_RAW_SIZE);
+
+            // the object in more than one pack is reported with the first pack holding it
+            const struct pack * _first_pack = NULL;
+            uint64_t _offset = 0;
+            if (_pack != _packs && _pack_locate(&_oid, &_first_pack, &_offset) && _first_pack != _pack){
+                continue;
+            }
+            callback(&_oid, data);
+        }
+    }
+}
+
+unsigned char * pack_object_unpack(const struct pack_object * obj){
+    /**
+     * Walk the chain down to the base first, then apply the deltas from 
+     * the base upward, only the current result and one delta are in memory.
+     */
+    size_t _chain_capacity = 16;
+    size_t _chain_size = 0;
+    struct pack_entry * _chain = (struct pack_entry *)malloc(_chain_capacity * sizeof(struct pack_entry));
+    if (_chain == NULL){
+        gitlet_panic("Failed to allocate memory for delta chain");
+    }
+    struct pack_entry _entry;
+    _pack_parse_entry(obj->_pack, obj->_offset, &_entry);
+    while (_entry.base_pack != NULL){
+        if (_chain_size == PACK_MAX_DELTA_CHAIN){
+            gitlet_panic("Delta chain too long in pack: %s", obj->_pack->name);
+        }
+        if (_chain_size == _chain_capacity){
+            _chain_capacity *= 2;
+            _chain = (struct pack_entry *)realloc(_chain, _chain_capacity * sizeof(struct pack_entry));
+            if (_chain == NULL){
+                gitlet_panic("Failed to allocate memory for delta chain");
+            }
+        }
+        _chain[_chain_size++] = _entry;
+        _pack_parse_entry(_entry.base_pack, _entry.base_offset, &_entry);
+    }
+
+    size_t _result_size = (size_t)_entry.size;
+    unsigned char * _result = (unsigned char *)malloc(_result_size + 1);
+    if (_result == NULL){
+        gitlet_panic("Failed to allocate memory for object content");
+    }
+    _pack_inflate_entry(&_entry, _result, _result_size, false);
+
+    while (_chain_size > 0){
+        const struct pack_entry * _delta_entry = &_chain[--_chain_size];
+        unsigned char * _delta = (unsigned char *)malloc((size_t)_delta_entry->size + 1);
+        if (_delta == NULL){
+            gitlet_panic("Failed to allocate memory for delta");
+        }
+        _pack_inflate_entry(_delta_entry, _delta, (size_t)_delta_entry->size, false);
+
+        size_t _next_size = 0;
+        unsigned char * _next = delta_apply(_result, _result_size, _delta, (size_t)_delta_entry->size, &_next_size);
+        free(_delta);
+        free(_result);
+        _result = _next;
+        _result_size = _next_size;
+    }
+    free(_chain);
+
+    if (_result_size != obj->file_size){
+        gitlet_panic("Packed object size mismatch");
+    }
+    _result[_result_size] = '\0';
+    return _result;
+}
+
+/**
+ * @brief: Write the data into the pack, and update the checksum of the pack and the entry
+ * @param writer: The pack file writer
+ * @param data: The data to be written
+ * @param size: The size of the data
+ */
+static void _pack_file_write(struct pack_file_writer * writer, const void * data, size_t size){
+    if (size == 0){
+        return;
+    }
+    if (fwrite(data, 1, size, writer->file) != size){
+        gitlet_panic("Failed to write the pack file");
+    }
+    EVP_DigestUpdate(writer->sha1_context, data, size);
+    writer->crc32 = (uint32_t)crc32(writer->crc32, (const Bytef *)data, (uInt)size);
+    writer->offset += size;
+}
+
+/**
+ * @brief: Convert the object type to the type code of the pack entry
+ */
+static unsigned int _pack_type_code(enum object_type type){
+    switch (type){
+        case OBJECT_TYPE_COMMIT:
+            return PACK_TYPE_COMMIT;
+        case OBJECT_TYPE_TREE:
+            return PACK_TYPE_TREE;
+        case OBJECT_TYPE_BLOB:
+            return PACK_TYPE_BLOB;
+        case OBJECT_TYPE_TAG:
+            return PACK_TYPE_TAG;
+        default:
+            gitlet_panic("Invalid object type: %d", type);
+    }
+    return 0;
+}
+
+/**
+ * @brief: Write the type and size header of the pack entry
+ * @param writer: The pack file writer
+ * @param type: The type code of the entry
+ * @param size: The size of the object content, or the size of the delta
+ */
+static void _pack_write_entry_header(struct pack_file_writer * writer, unsigned int type, uint64_t size){
+    unsigned char _header[16];
+    size_t _length = 0;
+    unsigned char _byte = (unsigned char)((type << 4) | (size & 0xf));
+    size >>= 4;
+    while (size != 0){
+        _header[_length++] = _byte | 0x80;
+        _byte = size & 0x7f;
+        size >>= 7;
+    }
+    _header[_length++] = _byte;
+    _pack_file_write(writer, _header, _length);
+}
+
+/**
+ * @brief: Write the offset from the delta entry back to its base, encoded
+ *         as the big endian base-128 varint where every continuation adds one.
+ * @param writer: The pack file writer
+ * @param distance: The entry offset minus the base offset
+ */
+static void _pack_write_delta_offset(struct pack_file_writer * writer, uint64_t distance){
+    unsigned char _buffer[16];
+    size_t _position = sizeof(_buffer) - 1;
+    _buffer[_position] = distance & 0x7f;
+    while (distance >>= 7){
+        _buffer[--_position] = 0x80 | (--distance & 0x7f);
+    }
+    _pack_file_write(writer, _buffer + _position, sizeof(_buffer) - _position);
+}
+
+/**
+ * @brief: Compress the input through the deflate stream into the pack
+ * @param writer: The pack file writer
+ * @param zstream: The deflate stream
+ * @param input: The input data
+ * @param size: The size of the input data
+ * @param flush: The flush mode of deflate
+ */
+static void _pack_deflate(struct pack_file_writer * writer, z_stream * zstream, 
+    const unsigned char * input, size_t size, int flush){
+    unsigned char _output_buffer[PACK_CHUNK_SIZE];
+    do {
+        size_t _piece_size = size < PACK_MAX_INPUT_PIECE ? size : PACK_MAX_INPUT_PIECE;
+        int _piece_flush = _piece_size == size ? flush : Z_NO_FLUSH;
+        zstream->next_in = (Bytef *)input;
+        zstream->avail_in = (uInt)_piece_size;
+        do {
+            zstream->next_out = _output_buffer;
+            zstream->avail_out = PACK_CHUNK_SIZE;
+            if (deflate(zstream, _piece_flush) == Z_STREAM_ERROR){
+                gitlet_panic("Failed to compress the pack entry");
+            }
+            _pack_file_write(writer, _output_buffer, PACK_CHUNK_SIZE - zstream->avail_out);
+        } while (zstream->avail_out == 0);
+        input += _piece_size;
+        size -= _piece_size;
+    } while (size != 0);
+}
+
+/**
+ * @brief: Compress the data in memory as the body of the pack entry
+ * @param writer: The pack file writer
+ * @param data: The data to be compressed
+ * @param size: The size of the data
+ * @param level: The zlib compression level
+ */
+static void _pack_write_data(struct pack_file_writer * writer, const unsigned char * data, size_t size, int level){
+    z_stream _zstream;
+    memset(&_zstream, 0, sizeof(z_stream));
+    if (deflateInit(&_zstream, level) != Z_OK){
+        gitlet_panic("Failed to initialize the deflate stream");
+    }
+    _pack_deflate(writer, &_zstream, data, size, Z_FINISH);
+    deflateEnd(&_zstream);
+}
+
+/**
+ * @brief: Stream the object content through deflate into the pack
+ * @param writer: The pack file writer
+ * @param oid: The id of the object
+ */
+static void _pack_write_object(struct pack_file_writer * writer, const struct object_id * oid){
+    struct object_stream _stream;
+    object_stream_open(&_stream, oid);
+    _pack_write_entry_header(writer, _pack_type_code(_stream.type), _stream.file_size);
+
+    // the level is picked from the first chunk before the stream is set up
+    unsigned char _input_buffer[PACK_CHUNK_SIZE];
+    size_t _read_size = object_stream_read(&_stream, _input_buffer, PACK_CHUNK_SIZE);
+    int _level = compress_choose_level(compress_policy_get()->pack_level, _stream.file_size, 
+        _input_buffer, _read_size);
+
+    z_stream _zstream;
+    memset(&_zstream, 0, sizeof(z_stream));
+    if (deflateInit(&_zstream, _level) != Z_OK){
+        gitlet_panic("Failed to initialize the deflate stream");
+    }
+
+    while (true){
+        _pack_deflate(writer, &_zstream, _input_buffer, _read_size, _read_size == 0 ? Z_FINISH : Z_NO_FLUSH);
+        if (_read_size == 0){
+            break;
+        }
+        _read_size = object_stream_read(&_stream, _input_buffer, PACK_CHUNK_SIZE);
+    }
+
+    deflateEnd(&_zstream);
+    object_stream_close(&_stream);
+}
+
+/**
+ * @brief: Compare two objects by the type and then by the size from the largest,
+ *         so the candidates of the delta base sit right before the object
+ */
+static int _pack_delta_object_compare(const void * left, const void * right){
+    const struct pack_delta_object * _left = (const struct pack_delta_object *)left;
+    const struct pack_delta_object * _right = (const struct pack_delta_object *)right;
+    if (_left->type != _right->type){
+        return _left->type < _right->type ? -1 : 1;
+    }
+    if (_left->file_size != _right->file_size){
+        return _left->file_size > _right->file_size ? -1 : 1;
+    }
+    return _left->entry < _right->entry ? -1 : (_left->entry > _right->entry);
+}
+
+/**
+ * @brief: Release the object held by the slot of the delta window
+ */
+static void _pack_delta_window_clear(struct pack_delta_window * slot){
+    object_content_release(slot->content);
+    delta_index_free(slot->index);
+    memset(slot, 0, sizeof(struct pack_delta_window));
+}
+
+/**
+ * @brief: Write the objects in the delta order, every object small enough 
+ *         is compared against the objects in the window before it, and 
+ *         written as the delta against the base giving the smallest delta.
+ * @param writer: The pack file writer
+ * @param entries: The index entries, the offset and crc32 are filled in
+ * @param order: The objects in the delta order
+ * @param count: The number of the objects
+ * @param window: The number of the slots of the delta window
+ * @param depth: The longest delta chain to be written
+ */
+static void _pack_write_objects(struct pack_file_writer * writer, struct pack_index_entry * entries,
+    const struct pack_delta_object * order, size_t count, unsigned int window, unsigned int depth){
+    struct pack_delta_window * _window = (struct pack_delta_window *)calloc(window == 0 ? 1 : window, 
+        sizeof(struct pack_delta_window));
+    if (_window == NULL){
+        gitlet_panic("Failed to allocate memory for delta window");
+    }
+    size_t _next_slot = 0;
+
+    for (size_t i = 0; i < count; i++){
+        struct pack_index_entry * _entry = &entries[order[i].entry];
+        _entry->offset = writer->offset;
+        writer->crc32 = (uint32_t)crc32(0L, Z_NULL, 0);
+
+        // the objects too large for the window are streamed as they are
+        if (window == 0 || order[i].file_size > PACK_DELTA_MAX_SIZE){
+            _pack_write_object(writer, &_entry->oid);
+            _entry->crc32 = writer->crc32;
+            continue;
+        }
+
+        struct object _obj;
+        object_read(&_obj, &_entry->oid);
+        size_t _size = (size_t)_obj.file_size;
+
+        // a delta is only worth it when it is at most half of the object
+        unsigned char * _best_delta = NULL;
+        size_t _best_size = _size / 2;
+        struct pack_delta_window * _best_base = NULL;
+        for (unsigned int j = 0; j < window; j++){
+            struct pack_delta_window * _slot = &_window[j];
+            if (_slot->content == NULL || _slot->type != _obj.type || _slot->depth >= depth){
+                continue;
+            }
+            if (_slot->index == NULL){
+                _slot->index = delta_index_create(_slot->content, _slot->size);
+            }
+            size_t _delta_size = 0;
+            unsigned char * _delta = delta_create(_slot->index, _obj.content, _size, _best_size, &_delta_size);
+            if (_delta != NULL){
+                free(_best_delta);
+                _best_delta = _delta;
+                _best_size = _delta_size;
+                _best_base = _slot;
+            }
+        }
+
+        unsigned int _depth = 0;
+        if (_best_delta != NULL){
+            _pack_write_entry_header(writer, PACK_TYPE_OFS_DELTA, _best_size);
+            _pack_write_delta_offset(writer, _entry->offset - entries[_best_base->entry].offset);
+            _pack_write_data(writer, _best_delta, _best_size, compress_policy_get()->pack_level);
+            _depth = _best_base->depth + 1;
+            free(_best_delta);
+        }else{
+            _pack_write_entry_header(writer, _pack_type_code(_obj.type), _size);
+            _pack_write_data(writer, _obj.content, _size, compress_choose_level(compress_policy_get()->pack_level, 
+                _size, _obj.content, _size));
+        }
+        _entry->crc32 = writer->crc32;
+
+        // the object replaces the oldest one in the window
+        struct pack_delta_window * _slot = &_window[_next_slot];
+        _pack_delta_window_clear(_slot);
+        _slot->entry = order[i].entry;
+        _slot->type = _obj.type;
+        _slot->content = _obj.content;
+        _slot->size = _size;
+        _slot->depth = _depth;
+        _next_slot = (_next_slot + 1) % window;
+    }
+
+    for (unsigned int j = 0; j < window; j++){
+        _pack_delta_window_clear(&_window[j]);
+    }
+    free(_window);
+}
+
+/**
+ * @brief: Compare two pack index entries by the object id
+ */
+static int _pack_index_entry_compare(const void * left, const void * right){
+    return oid_compare(&((const struct pack_index_entry *)left)->oid, 
+        &((const struct pack_index_entry *)right)->oid);
+}
+
+/**
+ * @brief: Create a temporary file in the pack directory
+ * @param buffer: The buffer to store the path, the length of the buffer is PATH_MAX
+ * @param pack_directory: The pack directory
+ * @param prefix: The prefix of the temporary file
+ * @return: The opened temporary file
+ */
+static FILE * _pack_create_temp_file(char * buffer, const char * pack_directory, const char * prefix){
+    if (snprintf(buffer, PATH_MAX, "%s/%sXXXXXX", pack_directory, prefix) >= PATH_MAX){
+        gitlet_panic("Pack path too long: %s", pack_directory);
+    }
+    int _fd = mkstemp(buffer);
+    if (_fd < 0){
+        gitlet_panic("Failed to create temporary pack file: %s", buffer);
+    }
+    // mkstemp creates the file 0600, a pack is read only and readable by all like git
+    if (fchmod(_fd, 0444) != 0){
+        close(_fd);
+        unlink(buffer);
+        gitlet_panic("Failed to set the mode of temporary pack file: %s", buffer);
+    }
+    FILE * _file = fdopen(_fd, "wb");
+    if (_file == NULL){
+        gitlet_panic("Failed to open temporary pack file: %s", buffer);
+    }
+    return _file;
+}
+
+/**
+ * @brief: Close the temporary pack file, syncing it to the disk first unless
+ *         the fsync method is none, a pack is already a batch of objects.
+ * @param file: The temporary pack file
+ * @param sync: Whether to sync the file
+ * @return: true on success, false otherwise
+ */
+static bool _pack_close_temp_file(FILE * file, bool sync){
+    bool _synced = !sync || (fflush(file) == 0 && fsync(fileno(file)) == 0);
+    return fclose(file) == 0 && _synced;
+}
+
+/**
+ * @brief: Write the pack index for the sorted entries
+ * @param file: The file of the pack index
+ * @param entries: The sorted index entries
+ * @param count: The number of the entries
+ * @param pack_sha1: The checksum of the pack data
+ */
+static void _pack_write_index(FILE * file, const struct pack_index_entry * entries, size_t count, 
+    const unsigned char * pack_sha1){
+    struct pack_file_writer _writer;
+    memset(&_writer, 0, sizeof(struct pack_file_writer));
+    _writer.file = file;
+    _writer.sha1_context = EVP_MD_CTX_new();
+    if (_writer.sha1_context == NULL || EVP_DigestInit_ex(_writer.sha1_context, EVP_sha1(), NULL) != 1){
+        gitlet_panic("Failed to initialize the SHA1 context");
+    }
+
+    unsigned char _buffer[8];
+    _put_be32(_buffer, PACK_INDEX_SIGNATURE);
+    _put_be32(_buffer + 4, PACK_INDEX_VERSION);
+    _pack_file_write(&_writer, _buffer, 8);
+
+    // fanout table: the number of objects whose first byte is less or equal to the index
+    size_t _position = 0;
+    for (unsigned int i = 0; i < PACK_FANOUT_SIZE; i++){
+        while (_position < count && entries[_position].oid.hash[0] <= i){
+            _position++;
+        }
+        _put_be32(_buffer, (uint32_t)_position);
+        _pack_file_write(&_writer, _buffer, 4);
+    }
+    for (size_t i = 0; i < count; i++){
+        _pack_file_write(&_writer, entries[i].oid.hash, OBJECT_ID_RAW_SIZE);
+    }
+    for (size_t i = 0; i < count; i++){
+        _put_be32(_buffer, entries[i].crc32);
+        _pack_file_write(&_writer, _buffer, 4);
+    }
+
+    // offsets that do not fit in 31 bits are stored in the large offset table
+    uint32_t _large_count = 0;
+    for (size_t i = 0; i < count; i++){
+        if (entries[i].offset & ~(uint64_t)0x7fffffff){
+            _put_be32(_buffer, PACK_LARGE_OFFSET_FLAG | _large_count++);
+        }else{
+            _put_be32(_buffer, (uint32_t)entries[i].offset);
+        }
+        _pack_file_write(&_writer, _buffer, 4);
+    }
+    for (size_t i = 0; i < count; i++){
+        if (entries[i].offset & ~(uint64_t)0x7fffffff){
+            _put_be32(_buffer, (uint32_t)(entries[i].offset >> 32));
+            _put_be32(_buffer + 4, (uint32_t)entries[i].offset);
+            _pack_file_write(&_writer, _buffer, 8);
+        }
+    }
+
+    _pack_file_write(&_writer, pack_sha1, SHA_DIGEST_LENGTH);
+
+    unsigned char _index_sha1[SHA_DIGEST_LENGTH];
+    EVP_DigestFinal_ex(_writer.sha1_context, _index_sha1, NULL);
+    EVP_MD_CTX_free(_writer.sha1_context);
+    if (fwrite(_index_sha1, 1, SHA_DIGEST_LENGTH, file) != SHA_DIGEST_LENGTH){
+        gitlet_panic("Failed to write the pack index");
+    }
+}
+
+void pack_write(struct object_id * pack_id, const struct object_id * oid_list, size_t count, 
+    unsigned int window, unsigned int depth){
+    struct pack_index_entry * _entries = (struct pack_index_entry *)calloc(count == 0 ? 1 : count, 
+        sizeof(struct pack_index_entry));
+    if (_entries == NULL){
+        gitlet_panic("Failed to allocate memory for pack index");
+    }
+    for (size_t i = 0; i < count; i++){
+        _entries[i].oid = oid_list[i];
+    }
+
+    // sort the object ids and drop the duplicates
+    qsort(_entries, count, sizeof(struct pack_index_entry), _pack_index_entry_compare);
+    size_t _unique_count = 0;
+    for (size_t i = 0; i < count; i++){
+        if (_unique_count == 0 || !oid_equals(&_entries[_unique_count - 1].oid, &_entries[i].oid)){
+            _entries[_unique_count++] = _entries[i];
+        }
+    }
+
+    char _pack_directory[PATH_MAX];
+    memset(_pack_directory, 0, PATH_MAX);
+    _get_pack_directory(_pack_directory);
+    if (!is_directory(_pack_directory) && !create_directory(_pack_directory)){
+        gitlet_panic("Failed to create directory: %s", _pack_directory);
+    }
+
+    struct pack_file_writer _writer;
+    memset(&_writer, 0, sizeof(struct pack_file_writer));
+    char _temp_pack_path[PATH_MAX];
+    _writer.file = _pack_create_temp_file(_temp_pack_path, _pack_directory, "tmp_pack_");
+    _writer.sha1_context = EVP_MD_CTX_new();
+    if (_writer.sha1_context == NULL || EVP_DigestInit_ex(_writer.sha1_context, EVP_sha1(), NULL) != 1){
+        gitlet_panic("Failed to initialize the SHA1 context");
+    }
+
+    unsigned char _header[PACK_HEADER_SIZE];
+    _put_be32(_header, PACK_SIGNATURE);
+    _put_be32(_header + 4, PACK_VERSION);
+    _put_be32(_header + 8, (uint32_t)_unique_count);
+    _pack_file_write(&_writer, _header, PACK_HEADER_SIZE);
+
+    // the types and sizes only need the object headers to order the objects
+    struct pack_delta_object * _order = (struct pack_delta_object *)malloc(
+        (_unique_count == 0 ? 1 : _unique_count) * sizeof(struct pack_delta_object));
+    if (_order == NULL){
+        gitlet_panic("Failed to allocate memory for pack order");
+    }
+    for (size_t i = 0; i < _unique_count; i++){
+        struct object _obj;
+        object_read_header(&_obj, &_entries[i].oid);
+        _order[i].entry = i;
+        _order[i].type = _obj.type;
+        _order[i].file_size = _obj.file_size;
+    }
+    qsort(_order, _unique_count, sizeof(struct pack_delta_object), _pack_delta_object_compare);
+
+    _pack_write_objects(&_writer, _entries, _order, _unique_count, window, depth);
+    free(_order);
+
+    // the trailer of the pack is the checksum of all the content before it
+    EVP_DigestFinal_ex(_writer.sha1_context, pack_id->hash, NULL);
+    EVP_MD_CTX_free(_writer.sha1_context);
+    bool _sync = object_get_fsync_method() != OBJECT_FSYNC_NONE;
+    if (fwrite(pack_id->hash, 1, OBJECT_ID_RAW_SIZE, _writer.file) != OBJECT_ID_RAW_SIZE 
+        || !_pack_close_temp_file(_writer.file, _sync)){
+        gitlet_panic("Failed to write the pack file: %s", _temp_pack_path);
+    }
+
+    char _temp_index_path[PATH_MAX];
+    FILE * _index_file = _pack_create_temp_file(_temp_index_path, _pack_directory, "tmp_idx_");
+    _pack_write_index(_index_file, _entries, _unique_count, pack_id->hash);
+    if (!_pack_close_temp_file(_index_file, _sync)){
+        gitlet_panic("Failed to write the pack index: %s", _temp_index_path);
+    }
+    free(_entries);
+
+    /**
+     * Publish the pack before the index, the packs are discovered through
+     * the index so a reader never sees an index without its pack.
+     */
+    char _pack_hex[OBJECT_ID_HEX_SIZE + 1];
+    oid_to_hex(_pack_hex, pack_id);
+    char _pack_path[PATH_MAX];
+    char _index_path[PATH_MAX];
+    if (snprintf(_pack_path, PATH_MAX, "%s/pack-%s.pack", _pack_directory, _pack_hex) >= PATH_MAX
+        || snprintf(_index_path, PATH_MAX, "%s/pack-%s.idx", _pack_directory, _pack_hex) >= PATH_MAX){
+        gitlet_panic("Pack path too long: %s", _pack_directory);
+    }
+    if (rename(_temp_pack_path, _pack_path) != 0){
+        gitlet_panic("Failed to write the pack file: %s", _pack_path);
+    }
+    if (rename(_temp_index_path, _index_path) != 0){
+        gitlet_panic("Failed to write the pack index: %s", _index_path);
+    }
+
+    if (atomic_load(&_packs_prepared)){
+        _pack_add(_index_path);
+    }
+}
+
+/**
+ * @brief: The state of the pack verification shared by the worker threads
+ * @param packs: The packs to verify
+ * @param broken: Whether every pack is broken
+ */
+struct pack_verification{
+    struct pack ** packs;
+    bool * broken;
+};
+
+/**
+ * @brief: Verify the checksums of one pack on the worker thread
+ * @param index: The index of the pack
+ * @param worker: The index of the worker thread
+ * @param data: The pack verification
+ */
+static void _pack_verify_one(size_t index, unsigned int worker, void * data){
+    (void)worker;
+    struct pack_verification * _verification = (struct pack_verification *)data;
+    const struct pack * _pack = _verification->packs[index];
+
+    /**
+     * The pack ends with the SHA1 of everything before it, and the index ends
+     * with the SHA1 of the pack followed by the SHA1 of the index itself.
+     */
+    unsigned char _pack_sha1[SHA_DIGEST_LENGTH];
+    unsigned char _index_sha1[SHA_DIGEST_LENGTH];
+    const unsigned char * _pack_trailer = _pack->pack_map + _pack->pack_size - SHA_DIGEST_LENGTH;
+    const unsigned char * _index_trailer = _pack->index_map + _pack->index_size - SHA_DIGEST_LENGTH;
+    bool _valid = EVP_Digest(_pack->pack_map, _pack->pack_size - SHA_DIGEST_LENGTH, _pack_sha1, NULL, EVP_sha1(), NULL) == 1
+        && EVP_Digest(_pack->index_map, _pack->index_size - SHA_DIGEST_LENGTH, _index_sha1, NULL, EVP_sha1(), NULL) == 1
+        && memcmp(_pack_sha1, _pack_trailer, SHA_DIGEST_LENGTH) == 0
+        && memcmp(_index_sha1, _index_trailer, SHA_DIGEST_LENGTH) == 0
+        && memcmp(_index_trailer - SHA_DIGEST_LENGTH, _pack_trailer, SHA_DIGEST_LENGTH) == 0;
+    _verification->broken[index] = !_valid;
+}
+
+size_t pack_verify(pack_broken_callback callback, void * data){
+    pack_prepare();
+    // the packs left out when they were mapped are broken as well
+    for (size_t i = 0; i < _bad_pack_count; i++){
+        callback(_bad_packs[i], data);
+    }
+    size_t _count = 0;
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        _count++;
+    }
+    if (_count == 0){
+        return _bad_pack_count;
+    }
+
+    struct pack_verification _verification;
+    _verification.packs = (struct pack **)malloc(_count * sizeof(struct pack *));
+    _verification.broken = (bool *)calloc(_count, sizeof(bool));
+    if (_verification.packs == NULL || _verification.broken == NULL){
+        gitlet_panic("Failed to allocate memory for the pack verification");
+    }
+    size_t _position = 0;
+    for (struct pack * _pack = _packs; _pack != NULL; _pack = _pack->next){
+        _verification.packs[_position++] = _pack;
+    }
+    parallel_for(parallel_cpu_count(), _count, _pack_verify_one, &_verification);
+
+    // the broken packs are reported in the order of the list, then unlinked
+    size_t _broken = 0;
+    struct pack ** _link = &_packs;
+    for (size_t i = 0; i < _count; i++){
+        struct pack * _pack = _verification.packs[i];
+        if (!_verification.broken[i]){
+            _link = &_pack->next;
+            continue;
+        }
+        char _pack_path[PATH_MAX];
+        memset(_pack_path, 0, PATH_MAX);
+        strncpy(_pack_path, _pack->name, strlen(_pack->name) - strlen(".idx"));
+        strcat(_pack_path, ".pack");
+        callback(_pack_path, data);
+
+        munmap((void *)_pack->index_map, _pack->index_size);
+        munmap((void *)_pack->pack_map, _pack->pack_size);
+        *_link = _pack->next;
+        free(_pack->name);
+        free(_pack);
+        _broken++;
+    }
+    free(_verification.packs);
+    free(_verification.broken);
+    return _bad_pack_count + _broken;
+}
+
+/**
+ * @brief: Check whether every object of the pack is among the kept ids
+ * @param pack: The pack
+ * @param kept: The sorted kept ids
+ * @param kept_count: The number of the kept ids
+ * @return: true if all the objects of the pack are kept, false otherwise
+ */
+static bool _pack_is_covered(const struct pack * pack, const struct object_id * kept, size_t kept_count){
+    // both the index and the kept ids are sorted, so they are merged in one pass
+    const unsigned char * _sha1_table = pack->index_map + PACK_INDEX_HEADER_SIZE + PACK_FANOUT_SIZE * 4;
+    size_t _position = 0;
+    for (uint32_t i = 0; i < pack->object_count; i++){
+        const unsigned char * _hash = _sha1_table + (size_t)i * OBJECT_ID_RAW_SIZE;
+        while (_position < kept_count && memcmp(kept[_position].hash, _hash, OBJECT_ID_RAW_SIZE) < 0){
+            _position++;
+        }
+        if (_position == kept_count || memcmp(kept[_position].hash, _hash, OBJECT_ID_RAW_SIZE) != 0){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief: Get the last modification time of the file
+ * @param path: The path of the file
+ * @param mtime: The pointer to store the time
+ * @return: true if the file is found, false otherwise
+ */
+static bool _pack_file_mtime(const char * path, time_t * mtime){
+    struct stat _status;
+    if (stat(path, &_status) != 0){
+        return false;
+    }
+    *mtime = _status.st_mtime;
+    return true;
+}
+
+size_t pack_remove_redundant(const struct object_id * keep_pack, const struct object_id * kept, 
+    size_t kept_count, time_t expire){
+    pack_prepare();
+
+    char _keep_name[OBJECT_ID_HEX_SIZE + sizeof("pack-.idx")];
+    _keep_name[0] = '\0';
+    if (keep_pack != NULL){
+        char _pack_hex[OBJECT_ID_HEX_SIZE + 1];
+        snprintf(_keep_name, sizeof(_keep_name), "pack-%s.idx", oid_to_hex(_pack_hex, keep_pack));
+    }
+
+    size_t _removed = 0;
+    struct pack ** _link = &_packs;
+    while (*_link != NULL){
+        struct pack * _pack = *_link;
+        char _pack_path[PATH_MAX];
+        memset(_pack_path, 0, PATH_MAX);
+        strncpy(_pack_path, _pack->name, strlen(_pack->name) - strlen(".idx"));
+        strcat(_pack_path, ".pack");
+
+        time_t _mtime = 0;
+        bool _redundant = !(_keep_name[0] != '\0' && str_end_with(_pack->name, _keep_name))
+            && ((_pack_file_mtime(_pack_path, &_mtime) && _mtime < expire) 
+                || _pack_is_covered(_pack, kept, kept_count));
+        if (!_redundant){
+            _link = &_pack->next;
+            continue;
+        }
+
+        // the index goes first, a reader never finds an index without its pack
+        if (!remove_file(_pack->name) || !remove_file(_pack_path)){
+            gitlet_panic("Failed to remove the pack: %s", _pack_path);
+        }
+        munmap((void *)_pack->index_map, _pack->index_size);
+        munmap((void *)_pack->pack_map, _pack->pack_size);
+        *_link = _pack->next;
+        free(_pack->name);
+        free(_pack);
+        _removed++;
+    }
+
+    // the temporary files of the writers which never finished
+    char _pack_directory[PATH_MAX];
+    memset(_pack_directory, 0, PATH_MAX);
+    _get_pack_directory(_pack_directory);
+    DIR * _directory = opendir(_pack_directory);
+    if (_directory == NULL){
+        return _removed;
+    }
+    struct dirent * _entry = NULL;
+    while ((_entry = readdir(_directory)) != NULL){
+        if (!str_start_with(_entry->d_name, "tmp_pack_") && !str_start_with(_entry->d_name, "tmp_idx_")){
+            continue;
+        }
+        char _temp_path[PATH_MAX];
+        time_t _mtime = 0;
+        if (snprintf(_temp_path, PATH_MAX, "%s/%s", _pack_directory, _entry->d_name) < PATH_MAX
+            && _pack_file_mtime(_temp_path, &_mtime) && _mtime < expire){
+            remove_file(_temp_path);
+        }
+    }
+    closedir(_directory);
+    return _removed;
+}
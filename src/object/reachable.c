@@ -0,0 +1,412 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <object/reachable.h>
+#include <util/error.h>
+#include <util/parallel.h>
+
+// the number of the slots of the seen set at the beginning, always a power of two
+#define REACHABLE_SET_INITIAL_CAPACITY  1024
+// the mode of the submodule entry in the tree
+#define REACHABLE_MODE_GITLINK          0160000
+
+/**
+ * @brief: The object waiting to be parsed or found by the walk
+ * @param oid: The id of the object
+ * @param type: The type the object is referred to as
+ */
+struct _reachable_item{
+    struct object_id oid;
+    enum object_type type;
+};
+
+/**
+ * @brief: The growable list of the items
+ * @param items: The items
+ * @param count: The number of the items
+ * @param capacity: The capacity of the list
+ */
+struct _reachable_list{
+    struct _reachable_item * items;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The set of the objects seen by the walk, an open addressing hash table
+ * @param slots: The ids in the table
+ * @param used: Whether every slot holds an id
+ * @param capacity: The number of the slots, always a power of two
+ * @param count: The number of the ids in the table
+ */
+struct _reachable_set{
+    struct object_id * slots;
+    bool * used;
+    size_t capacity;
+    size_t count;
+};
+
+/**
+ * @brief: The state of the walk shared by the worker threads
+ * @param level: The objects of the current level
+ * @param found: The objects referred to by the level, one list for every worker
+ * @param buffers: The content buffer of every worker
+ * @param buffer_sizes: The size of the content buffer of every worker
+ */
+struct _reachable_walk{
+    const struct _reachable_item * level;
+    struct _reachable_list * found;
+    unsigned char ** buffers;
+    size_t * buffer_sizes;
+};
+
+/**
+ * @brief: Append the item to the list
+ * @param list: The list
+ * @param oid: The id of the object
+ * @param type: The type of the object
+ */
+static void _reachable_list_append(struct _reachable_list * list, const struct object_id * oid, enum object_type type){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 64 : list->capacity * 2;
+        list->items = (struct _reachable_item *)realloc(list->items, list->capacity * sizeof(struct _reachable_item));
+        if (list->items == NULL){
+            gitlet_panic("Failed to allocate memory for the object list");
+        }
+    }
+    list->items[list->count].oid = *oid;
+    list->items[list->count].type = type;
+    list->count++;
+}
+
+/**
+ * @brief: Allocate the slots of the set
+ * @param set: The set
+ * @param capacity: The number of the slots, a power of two
+ */
+static void _reachable_set_init(struct _reachable_set * set, size_t capacity){
+    set->slots = (struct object_id *)malloc(capacity * sizeof(struct object_id));
+    set->used = (bool *)calloc(capacity, sizeof(bool));
+    if (set->slots == NULL || set->used == NULL){
+        gitlet_panic("Failed to allocate memory for the object set");
+    }
+    set->capacity = capacity;
+    set->count = 0;
+}
+
+/**
+ * @brief: Insert the id into the set, the table is doubled once it is half full
+ * @param set: The set
+ * @param oid: The id of the object
+ * @return: true if the id is new to the set, false if it is already in the set
+ */
+static bool _reachable_set_insert(struct _reachable_set * set, const struct object_id * oid){
+    if ((set->count + 1) * 2 > set->capacity){
+        struct _reachable_set _grown;
+        _reachable_set_init(&_grown, set->capacity * 2);
+        for (size_t i = 0; i < set->capacity; i++){
+            if (set->used[i]){
+                _reachable_set_insert(&_grown, &set->slots[i]);
+            }
+        }
+        free(set->slots);
+        free(set->used);
+        *set = _grown;
+    }
+
+    size_t _mask = set->capacity - 1;
+    for (size_t _slot = oid_hash(oid) & _mask; ; _slot = (_slot + 1) & _mask){
+        if (!set->used[_slot]){
+            set->slots[_slot] = *oid;
+            set->used[_slot] = true;
+            set->count++;
+            return true;
+        }
+        if (oid_equals(&set->slots[_slot], oid)){
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief: Decode the hex id in the content, which is followed by the end of the line
+ * @param oid: The object id to store the result
+ * @param hex: The hex id in the content
+ * @param end: The end of the content
+ * @return: true if a valid hex id is found, false otherwise
+ */
+static bool _reachable_parse_hex(struct object_id * oid, const unsigned char * hex, const unsigned char * end){
+    if ((size_t)(end - hex) < OBJECT_ID_HEX_SIZE){
+        return false;
+    }
+    char _hex_buffer[OBJECT_ID_HEX_SIZE + 1];
+    memcpy(_hex_buffer, hex, OBJECT_ID_HEX_SIZE);
+    _hex_buffer[OBJECT_ID_HEX_SIZE] = '\0';
+    return oid_from_hex(oid, _hex_buffer);
+}
+
+/**
+ * @brief: Collect the trees and the parents in the header of the commit
+ * @param content: The content of the commit
+ * @param size: The size of the content
+ * @param found: The list to append the referred objects to
+ * @return: true if the commit is well formed, false otherwise
+ */
+static bool _reachable_parse_commit(const unsigned char * content, size_t size, struct _reachable_list * found){
+    const unsigned char * _end = content + size;
+    const unsigned char * _line = content;
+    // the header ends at the first empty line, the message after it is skipped
+    while (_line < _end && *_line != '\n'){
+        const unsigned char * _line_end = memchr(_line, '\n', (size_t)(_end - _line));
+        if (_line_end == NULL){
+            _line_end = _end;
+        }
+        struct object_id _oid;
+        if ((size_t)(_line_end - _line) > 5 && memcmp(_line, "tree ", 5) == 0){
+            if (!_reachable_parse_hex(&_oid, _line + 5, _line_end)){
+                return false;
+            }
+            _reachable_list_append(found, &_oid, OBJECT_TYPE_TREE);
+        }else if ((size_t)(_line_end - _line) > 7 && memcmp(_line, "parent ", 7) == 0){
+            if (!_reachable_parse_hex(&_oid, _line + 7, _line_end)){
+                return false;
+            }
+            _reachable_list_append(found, &_oid, OBJECT_TYPE_COMMIT);
+        }
+        _line = _line_end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief: Collect the tagged object in the header of the tag
+ * @param content: The content of the tag
+ * @param size: The size of the content
+ * @param found: The list to append the referred object to
+ * @return: true if the tag is well formed, false otherwise
+ */
+static bool _reachable_parse_tag(const unsigned char * content, size_t size, struct _reachable_list * found){
+    // the tag starts with "object <hex>\ntype <type>\n"
+    struct object_id _oid;
+    const unsigned char * _end = content + size;
+    if (size < 7 + OBJECT_ID_HEX_SIZE + 6 || memcmp(content, "object ", 7) != 0 
+        || !_reachable_parse_hex(&_oid, content + 7, _end)){
+        return false;
+    }
+    const unsigned char * _type = content + 7 + OBJECT_ID_HEX_SIZE + 1;
+    if (memcmp(_type - 1, "\ntype ", 6) != 0){
+        return false;
+    }
+    _type += 5;
+    const unsigned char * _type_end = memchr(_type, '\n', (size_t)(_end - _type));
+    if (_type_end == NULL){
+        _type_end = _end;
+    }
+    for (enum object_type _candidate = OBJECT_TYPE_BLOB; _candidate < OBJECT_TYPE_UNKNOWN; _candidate++){
+        const char * _name = object_type_name(_candidate);
+        if (strlen(_name) == (size_t)(_type_end - _type) && memcmp(_name, _type, strlen(_name)) == 0){
+            _reachable_list_append(found, &_oid, _candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief: Collect the entries of the tree, the submodule commits are skipped
+ * @param content: The content of the tree
+ * @param size: The size of the content
+ * @param found: The list to append the referred objects to
+ * @return: true if the tree is well formed, false otherwise
+ */
+static bool _reachable_parse_tree(const unsigned char * content, size_t size, struct _reachable_list * found){
+    // every entry is "<mode> <name>\0" followed by the raw id
+    const unsigned char * _current = content;
+    const unsigned char * _end = content + size;
+    while (_current < _end){
+        const unsigned char * _name_end = memchr(_current, '\0', (size_t)(_end - _current));
+        if (_name_end == NULL || (size_t)(_end - _name_end - 1) < OBJECT_ID_RAW_SIZE){
+            return false;
+        }
+        unsigned int _mode = (unsigned int)strtoul((const char *)_current, NULL, 8);
+        struct object_id _oid;
+        memcpy(_oid.hash, _name_end + 1, OBJECT_ID_RAW_SIZE);
+        _current = _name_end + 1 + OBJECT_ID_RAW_SIZE;
+
+        if (_mode == REACHABLE_MODE_GITLINK){
+            continue;
+        }
+        _reachable_list_append(found, &_oid, S_ISDIR(_mode) ? OBJECT_TYPE_TREE : OBJECT_TYPE_BLOB);
+    }
+    return true;
+}
+
+/**
+ * @brief: Read and parse one object of the level on a worker thread
+ * @param index: The index of the object in the level
+ * @param worker: The index of the worker thread
+ * @param data: The state of the walk
+ */
+static void _reachable_parse(size_t index, unsigned int worker, void * data){
+    struct _reachable_walk * _walk = (struct _reachable_walk *)data;
+    const struct _reachable_item * _item = &_walk->level[index];
+    char _hex[OBJECT_ID_HEX_SIZE + 1];
+
+    /**
+     * The stream reads the object without the shared object cache, so the 
+     * workers never touch each other, and the content goes into the buffer 
+     * kept by the worker across the objects.
+     */
+    struct object_stream _stream;
+    object_stream_open(&_stream, &_item->oid);
+    if (_stream.type != _item->type){
+        gitlet_panic("object %s is a %s, not a %s", oid_to_hex(_hex, &_item->oid), 
+            object_type_name(_stream.type), object_type_name(_item->type));
+    }
+    size_t _size = (size_t)_stream.file_size;
+    if (_size + 1 > _walk->buffer_sizes[worker]){
+        free(_walk->buffers[worker]);
+        _walk->buffers[worker] = (unsigned char *)malloc(_size + 1);
+        if (_walk->buffers[worker] == NULL){
+            gitlet_panic("Failed to allocate memory for the object content");
+        }
+        _walk->buffer_sizes[worker] = _size + 1;
+    }
+    unsigned char * _content = _walk->buffers[worker];
+    size_t _read_size = 0;
+    for (size_t _offset = 0; _offset < _size; _offset += _read_size){
+        _read_size = object_stream_read(&_stream, _content + _offset, _size - _offset);
+    }
+    object_stream_close(&_stream);
+
+    bool _valid = true;
+    struct _reachable_list * _found = &_walk->found[worker];
+    switch (_item->type){
+        case OBJECT_TYPE_COMMIT:
+            _valid = _reachable_parse_commit(_content, _size, _found);
+            break;
+        case OBJECT_TYPE_TAG:
+            _valid = _reachable_parse_tag(_content, _size, _found);
+            break;
+        case OBJECT_TYPE_TREE:
+            _valid = _reachable_parse_tree(_content, _size, _found);
+            break;
+        default:
+            break;
+    }
+    if (!_valid){
+        gitlet_panic("Invalid %s object: %s", object_type_name(_item->type), oid_to_hex(_hex, &_item->oid));
+    }
+}
+
+static int _reachable_id_compare(const void * left, const void * right){
+    return oid_compare((const struct object_id *)left, (const struct object_id *)right);
+}
+
+struct object_id * reachable_list(const struct object_id * roots, size_t root_count, 
+    unsigned int threads, size_t * count){
+    if (threads == 0){
+        threads = parallel_cpu_count();
+    }
+
+    // the packs are mapped and the types of the roots are read before the workers start
+    struct _reachable_set _seen;
+    _reachable_set_init(&_seen, REACHABLE_SET_INITIAL_CAPACITY);
+    struct _reachable_list _level;
+    memset(&_level, 0, sizeof(struct _reachable_list));
+    for (size_t i = 0; i < root_count; i++){
+        if (!object_exists(&roots[i])){
+            char _hex[OBJECT_ID_HEX_SIZE + 1];
+            gitlet_panic("bad object %s", oid_to_hex(_hex, &roots[i]));
+        }
+        if (_reachable_set_insert(&_seen, &roots[i])){
+            struct object _obj;
+            object_read_header(&_obj, &roots[i]);
+            if (_obj.type != OBJECT_TYPE_BLOB){
+                _reachable_list_append(&_level, &roots[i], _obj.type);
+            }
+        }
+    }
+
+    struct _reachable_walk _walk;
+    _walk.found = (struct _reachable_list *)calloc(threads, sizeof(struct _reachable_list));
+    _walk.buffers = (unsigned char **)calloc(threads, sizeof(unsigned char *));
+    _walk.buffer_sizes = (size_t *)calloc(threads, sizeof(size_t));
+    if (_walk.found == NULL || _walk.buffers == NULL || _walk.buffer_sizes == NULL){
+        gitlet_panic("Failed to allocate memory for the reachability walk");
+    }
+
+    /**
+     * Every level is parsed in parallel, then the objects found by the workers
+     * are merged on this thread. Only the objects new to the set make up the
+     * next level, and the blobs are never read since they refer to nothing.
+     */
+    struct _reachable_list _next;
+    memset(&_next, 0, sizeof(struct _reachable_list));
+    while (_level.count > 0){
+        _walk.level = _level.items;
+        parallel_for(threads, _level.count, _reachable_parse, &_walk);
+
+        _next.count = 0;
+        for (unsigned int i = 0; i < threads; i++){
+            struct _reachable_list * _found = &_walk.found[i];
+            for (size_t j = 0; j < _found->count; j++){
+                if (_reachable_set_insert(&_seen, &_found->items[j].oid) && _found->items[j].type != OBJECT_TYPE_BLOB){
+                    _reachable_list_append(&_next, &_found->items[j].oid, _found->items[j].type);
+                }
+            }
+            _found->count = 0;
+        }
+
+        struct _reachable_list _swap = _level;
+        _level = _next;
+        _next = _swap;
+    }
+
+    for (unsigned int i = 0; i < threads; i++){
+        free(_walk.found[i].items);
+        free(_walk.buffers[i]);
+    }
+    free(_walk.found);
+    free(_walk.buffers);
+    free(_walk.buffer_sizes);
+    free(_level.items);
+    free(_next.items);
+
+    // the slots are compacted in place and sorted
+    size_t _count = 0;
+    for (size_t i = 0; i < _seen.capacity; i++){
+        if (_seen.used[i]){
+            _seen.slots[_count++] = _seen.slots[i];
+        }
+    }
+    free(_seen.used);
+    qsort(_seen.slots, _count, sizeof(struct object_id), _reachable_id_compare);
+    *count = _count;
+    return _seen.slots;
+}
@@ -23,9 +23,15 @@
  */
 
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdlib.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <dirent.h>
+
+#include <configparse.h>
 
 #include <object/repository.h>
 #include <util/error.h>
@@ -34,7 +40,23 @@
 #include <global/config.h>
 
 
+/**
+ * @brief: The entry of the parsed config file
+ * @param section: The section of the entry
+ * @param key: The key of the entry
+ * @param value: The value of the entry
+ * @param next: The next entry
+ */
+struct repository_config_entry{
+    char * section;
+    char * key;
+    char * value;
+    struct repository_config_entry * next;
+};
+
 static char gitlet_repo_path[PATH_MAX];
+static struct repository_config_entry * config_entries = NULL;
+static bool config_loaded = false;
 
 void repository_object_init(struct repository * this, const char * path, bool check){
     this->working_tree_path = path;
@@ -109,6 +131,13 @@ void repository_create(const char * path){
         gitlet_panic("fatal: unable to mkdir %s", path_buffer);
     }
 
+    // create .gitlet/objects/pack directory
+    strcpy(path_buffer, this.gitlet_repo_path);
+    strcat(path_buffer, "/objects/pack");
+    if (!create_directory(path_buffer)){
+        gitlet_panic("fatal: unable to mkdir %s", path_buffer);
+    }
+
     // create .gitlet/refs directory
     strcpy(path_buffer, this.gitlet_repo_path);
     strcat(path_buffer, "/refs");
@@ -157,3 +186,297 @@ void repository_create(const char * path){
     fprintf(file_description, "Unnamed repository; edit this file 'description' to name the repository.\n");
     fclose(file_description);
 }
+
+/**
+ * @brief: Keep the entry parsed from the config file, the later entry of 
+ *         the same key overrides the earlier one like git.
+ */
+static void repository_config_add(void * data, const char * section, const char * key, const char * value){
+    (void)data;
+    struct repository_config_entry * entry = (struct repository_config_entry *)malloc(
+        sizeof(struct repository_config_entry));
+    if (entry == NULL){
+        gitlet_panic("Failed to allocate memory for config");
+    }
+    entry->section = strdup(section);
+    entry->key = strdup(key);
+    entry->value = strdup(value);
+    if (entry->section == NULL || entry->key == NULL || entry->value == NULL){
+        gitlet_panic("Failed to allocate memory for config");
+    }
+    entry->next = config_entries;
+    config_entries = entry;
+}
+
+const char * repository_config_get(const char * section, const char * key){
+    if (!config_loaded){
+        config_loaded = true;
+        char path_buffer[PATH_MAX];
+        memset(path_buffer, 0, PATH_MAX);
+        if (getcwd(path_buffer, PATH_MAX) == NULL){
+            gitlet_panic("Failed to get the current working directory");
+        }
+        strcat(path_buffer, "/.gitlet/config");
+
+        struct configparse config;
+        if (init_configparse(&config, path_buffer)){
+            configparse_parse_all(&config, repository_config_add, NULL);
+            fclose(config.ini_file);
+        }
+    }
+
+    for (struct repository_config_entry * entry = config_entries; entry != NULL; entry = entry->next){
+        if (strcasecmp(entry->section, section) == 0 && strcasecmp(entry->key, key) == 0){
+            return entry->value;
+        }
+    }
+    return NULL;
+}
+
+uint64_t repository_config_get_size(const char * section, const char * key, uint64_t default_value){
+    const char * value = repository_config_get(section, key);
+    if (value == NULL){
+        return default_value;
+    }
+
+    char * end = NULL;
+    unsigned long long size = strtoull(value, &end, 10);
+    if (end == value){
+        gitlet_panic("Invalid size value for %s.%s: %s", section, key, value);
+    }
+    switch (*end){
+        case 'k': case 'K':
+            size <<= 10;
+            end++;
+            break;
+        case 'm': case 'M':
+            size <<= 20;
+            end++;
+            break;
+        case 'g': case 'G':
+            size <<= 30;
+            end++;
+            break;
+        default:
+            break;
+    }
+    while (isspace((unsigned char)*end)){
+        end++;
+    }
+    if (*end != '\0'){
+        gitlet_panic("Invalid size value for %s.%s: %s", section, key, value);
+    }
+    return (uint64_t)size;
+}
+
+bool repository_config_get_bool(const char * section, const char * key, bool default_value){
+    const char * value = repository_config_get(section, key);
+    if (value == NULL){
+        return default_value;
+    }
+    if (strcasecmp(value, "true") == 0 || strcasecmp(value, "yes") == 0 
+        || strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0){
+        return true;
+    }
+    if (strcasecmp(value, "false") == 0 || strcasecmp(value, "no") == 0 
+        || strcasecmp(value, "off") == 0 || strcmp(value, "0") == 0){
+        return false;
+    }
+    gitlet_panic("Invalid boolean value for %s.%s: %s", section, key, value);
+    return default_value;
+}
+
+/**
+ * @brief: Read the object id stored in the ref file
+ * @param path: The path of the ref file
+ * @param oid: The object id to store the result
+ * @return: true if the file holds an object id, false for a symbolic ref or a broken file
+ */
+static bool repository_read_ref(const char * path, struct object_id * oid){
+    FILE * file = fopen(path, "r");
+    if (file == NULL){
+        return false;
+    }
+    char line_buffer[OBJECT_ID_HEX_SIZE + 2];
+    bool found = fgets(line_buffer, sizeof(line_buffer), file) != NULL;
+    fclose(file);
+    if (!found || strlen(line_buffer) < OBJECT_ID_HEX_SIZE){
+        return false;
+    }
+    line_buffer[OBJECT_ID_HEX_SIZE] = '\0';
+    return oid_from_hex(oid, line_buffer);
+}
+
+/**
+ * @brief: Report the loose refs under the directory, and recurse into the sub-directories
+ * @param path: The path of the directory, the entry names are appended to it
+ * @param path_length: The length of the path
+ * @param name_offset: The offset of the ref name in the path
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ */
+static void repository_for_each_loose_ref(char * path, size_t path_length, size_t name_offset,
+    repository_ref_callback callback, void * data){
+    DIR * directory = opendir(path);
+    if (directory == NULL){
+        return;
+    }
+    struct dirent * entry = NULL;
+    while ((entry = readdir(directory)) != NULL){
+        if (entry->d_name[0] == '.'){
+            continue;
+        }
+        size_t name_length = strlen(entry->d_name);
+        if (path_length + name_length + 2 > PATH_MAX){
+            continue;
+        }
+        path[path_length] = '/';
+        memcpy(path + path_length + 1, entry->d_name, name_length + 1);
+
+        struct object_id oid;
+        if (is_directory(path)){
+            repository_for_each_loose_ref(path, path_length + name_length + 1, name_offset, callback, data);
+        }else if (repository_read_ref(path, &oid)){
+            callback(path + name_offset, &oid, data);
+        }
+    }
+    path[path_length] = '\0';
+    closedir(directory);
+}
+
+void repository_for_each_ref(repository_ref_callback callback, void * data){
+    char path_buffer[PATH_MAX];
+    memset(path_buffer, 0, PATH_MAX);
+    if (getcwd(path_buffer, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+    strcat(path_buffer, "/.gitlet/");
+    size_t name_offset = strlen(path_buffer);
+    if (name_offset + strlen("packed-refs") + 1 > PATH_MAX){
+        gitlet_panic("Repository path too long: %s", path_buffer);
+    }
+    struct object_id oid;
+
+    // HEAD is only reported when it is detached, otherwise its branch is a loose or packed ref
+    strcpy(path_buffer + name_offset, "HEAD");
+    if (repository_read_ref(path_buffer, &oid)){
+        callback("HEAD", &oid, data);
+    }
+
+    strcpy(path_buffer + name_offset, "refs");
+    repository_for_each_loose_ref(path_buffer, strlen(path_buffer), name_offset, callback, data);
+
+    /**
+     * Every line of packed-refs is "<hex> <name>", and the line starting 
+     * with '^' holds the peeled id of the annotated tag on the line before.
+     */
+    strcpy(path_buffer + name_offset, "packed-refs");
+    FILE * file = fopen(path_buffer, "r");
+    if (file == NULL){
+        return;
+    }
+    char line_buffer[PATH_MAX + OBJECT_ID_HEX_SIZE + 2];
+    char name_buffer[PATH_MAX];
+    name_buffer[0] = '\0';
+    while (fgets(line_buffer, sizeof(line_buffer), file) != NULL){
+        size_t length = strlen(line_buffer);
+        while (length > 0 && isspace((unsigned char)line_buffer[length - 1])){
+            line_buffer[--length] = '\0';
+        }
+        const char * hex = line_buffer[0] == '^' ? line_buffer + 1 : line_buffer;
+        if (line_buffer[0] == '#' || strlen(hex) < OBJECT_ID_HEX_SIZE){
+            continue;
+        }
+        if (hex == line_buffer){
+            if (hex[OBJECT_ID_HEX_SIZE] != ' '){
+                continue;
+            }
+            strncpy(name_buffer, hex + OBJECT_ID_HEX_SIZE + 1, PATH_MAX - 1);
+            name_buffer[PATH_MAX - 1] = '\0';
+        }
+        line_buffer[hex - line_buffer + OBJECT_ID_HEX_SIZE] = '\0';
+        if (oid_from_hex(&oid, hex)){
+            callback(name_buffer, &oid, data);
+        }
+    }
+    fclose(file);
+}
+
+/**
+ * @brief: Find the ref in packed-refs
+ * @param path: The path of packed-refs
+ * @param name: The name of the ref
+ * @param oid: The object id to store the result
+ * @return: true if the ref is found
+ */
+static bool repository_read_packed_ref(const char * path, const char * name, struct object_id * oid){
+    FILE * file = fopen(path, "r");
+    if (file == NULL){
+        return false;
+    }
+    char line_buffer[PATH_MAX + OBJECT_ID_HEX_SIZE + 2];
+    bool found = false;
+    while (!found && fgets(line_buffer, sizeof(line_buffer), file) != NULL){
+        size_t length = strlen(line_buffer);
+        while (length > 0 && isspace((unsigned char)line_buffer[length - 1])){
+            line_buffer[--length] = '\0';
+        }
+        if (length <= OBJECT_ID_HEX_SIZE + 1 || line_buffer[OBJECT_ID_HEX_SIZE] != ' '
+            || !str_equals(line_buffer + OBJECT_ID_HEX_SIZE + 1, name)){
+            continue;
+        }
+        line_buffer[OBJECT_ID_HEX_SIZE] = '\0';
+        found = oid_from_hex(oid, line_buffer);
+    }
+    fclose(file);
+    return found;
+}
+
+bool repository_resolve_head(char * ref, struct object_id * oid){
+    char path_buffer[PATH_MAX];
+    memset(path_buffer, 0, PATH_MAX);
+    if (getcwd(path_buffer, PATH_MAX) == NULL){
+        gitlet_panic("Failed to get the current working directory");
+    }
+    strcat(path_buffer, "/.gitlet/");
+    size_t name_offset = strlen(path_buffer);
+    if (name_offset + strlen("packed-refs") + 1 > PATH_MAX){
+        gitlet_panic("Repository path too long: %s", path_buffer);
+    }
+    ref[0] = '\0';
+
+    strcpy(path_buffer + name_offset, "HEAD");
+    FILE * file = fopen(path_buffer, "r");
+    if (file == NULL){
+        gitlet_panic("Failed to read HEAD: %s", path_buffer);
+    }
+    char line_buffer[PATH_MAX];
+    bool read = fgets(line_buffer, sizeof(line_buffer), file) != NULL;
+    fclose(file);
+    if (!read){
+        gitlet_panic("Invalid HEAD: %s", path_buffer);
+    }
+    size_t length = strlen(line_buffer);
+    while (length > 0 && isspace((unsigned char)line_buffer[length - 1])){
+        line_buffer[--length] = '\0';
+    }
+
+    // a detached HEAD holds the id itself
+    if (!str_start_with(line_buffer, "ref: ")){
+        if (length != OBJECT_ID_HEX_SIZE || !oid_from_hex(oid, line_buffer)){
+            gitlet_panic("Invalid HEAD: %s", path_buffer);
+        }
+        return true;
+    }
+    const char * name = line_buffer + strlen("ref: ");
+    if (name_offset + strlen(name) + 1 > PATH_MAX){
+        gitlet_panic("Invalid HEAD: %s", path_buffer);
+    }
+    strcpy(ref, name);
+    strcpy(path_buffer + name_offset, name);
+    if (repository_read_ref(path_buffer, oid)){
+        return true;
+    }
+    strcpy(path_buffer + name_offset, "packed-refs");
+    return repository_read_packed_ref(path_buffer, name, oid);
+}
@@ -0,0 +1,923 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <object/ignore.h>
+#include <object/index.h>
+#include <object/repository.h>
+#include <object/untracked.h>
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the version of the untracked cache extension
+#define UNTRACKED_CACHE_VERSION     1
+// the flag of the cache listing every untracked file
+#define UNTRACKED_CACHE_FLAG_ALL    0x1
+// the flags of the node in the extension
+#define UNTRACKED_NODE_VALID        0x1
+#define UNTRACKED_NODE_CHECK_ONLY   0x2
+#define UNTRACKED_NODE_HAS_FILE     0x4
+// the size of the node in the extension after its name, before its lists
+#define UNTRACKED_NODE_FIXED_SIZE   (12 + OBJECT_ID_RAW_SIZE + 1 + 8)
+// the deepest directory accepted from the extension, every level takes a name and a '/'
+#define UNTRACKED_MAX_DEPTH         (PATH_MAX / 2)
+
+/**
+ * @brief: The growable buffer of the serialized cache
+ */
+struct _untracked_buffer{
+    unsigned char * data;
+    size_t size;
+    size_t capacity;
+};
+
+/**
+ * @brief: The directory of the current level of the scan
+ * @param node: The node of the directory
+ * @param path: The path of the directory, "" for the top
+ * @param length: The length of the path
+ * @param rules: The ignore rules of the parent directory
+ */
+struct _untracked_item{
+    struct untracked_node * node;
+    char * path;
+    size_t length;
+    const struct ignore_rules * rules;
+};
+
+/**
+ * @brief: The growable list of the directories of a level
+ */
+struct _untracked_items{
+    struct _untracked_item * items;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The ignore rules read by a worker, kept for the next levels
+ */
+struct _untracked_rules{
+    struct ignore_rules ** rules;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The state of the scan shared by the worker threads
+ * @param index: The index
+ * @param all: Whether to list every untracked file
+ * @param level: The directories of the current level
+ * @param next: The directories of the next level found by every worker
+ * @param lists: The untracked paths found by every worker
+ * @param rules: The ignore rules read by every worker
+ * @param changed: Whether every worker changed any node
+ */
+struct _untracked_scan_state{
+    const struct index * index;
+    bool all;
+    struct _untracked_items level;
+    struct _untracked_items * next;
+    struct untracked_list * lists;
+    struct _untracked_rules * rules;
+    bool * changed;
+};
+
+/**
+ * @brief: The entries of a directory being read, split into the untracked 
+ *         files and the sub-directories, the ignored ones are dropped
+ * @param index: The index, NULL to take every file as untracked
+ * @param rules: The ignore rules of the directory
+ * @param path: The path of the directory, the names are appended to it
+ * @param length: The length of the path
+ * @param files: The untracked files
+ * @param directories: The sub-directories
+ */
+struct _untracked_read{
+    const struct index * index;
+    const struct ignore_rules * rules;
+    char * path;
+    size_t length;
+    struct untracked_list files;
+    struct untracked_list directories;
+};
+
+static inline uint32_t _get_be32(const unsigned char * buffer){
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) 
+        | ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+}
+
+static inline void _put_be32(unsigned char * buffer, uint32_t value){
+    buffer[0] = (unsigned char)(value >> 24);
+    buffer[1] = (unsigned char)(value >> 16);
+    buffer[2] = (unsigned char)(value >> 8);
+    buffer[3] = (unsigned char)value;
+}
+
+/**
+ * @brief: Append the path to the list
+ */
+static void _untracked_list_append(struct untracked_list * list, const char * path, size_t length){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->paths = (char **)realloc(list->paths, list->capacity * sizeof(char *));
+        if (list->paths == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked files");
+        }
+    }
+    if ((list->paths[list->count++] = strndup(path, length)) == NULL){
+        gitlet_panic("Failed to allocate memory for the untracked files");
+    }
+}
+
+/**
+ * @brief: Compare the paths for the sort
+ */
+static int _untracked_compare_path(const void * left, const void * right){
+    return strcmp(*(const char * const *)left, *(const char * const *)right);
+}
+
+/**
+ * @brief: Compare the nodes by the names for the sort
+ */
+static int _untracked_compare_node(const void * left, const void * right){
+    return strcmp((*(const struct untracked_node * const *)left)->name, 
+        (*(const struct untracked_node * const *)right)->name);
+}
+
+/**
+ * @brief: Create an invalid node of the directory
+ */
+static struct untracked_node * _untracked_node_create(const char * name, size_t length){
+    struct untracked_node * _node = (struct untracked_node *)calloc(1, sizeof(struct untracked_node));
+    if (_node == NULL || (_node->name = strndup(name, length)) == NULL){
+        gitlet_panic("Failed to allocate memory for the untracked cache");
+    }
+    return _node;
+}
+
+/**
+ * @brief: Free the node and everything under it
+ */
+static void _untracked_node_free(struct untracked_node * node){
+    if (node == NULL){
+        return;
+    }
+    for (size_t i = 0; i < node->untracked_count; i++){
+        free(node->untracked[i]);
+    }
+    for (size_t i = 0; i < node->child_count; i++){
+        _untracked_node_free(node->children[i]);
+    }
+    free(node->untracked);
+    free(node->children);
+    free(node->name);
+    free(node);
+}
+
+/**
+ * @brief: Drop the untracked names of the node
+ */
+static void _untracked_node_clear_names(struct untracked_node * node){
+    for (size_t i = 0; i < node->untracked_count; i++){
+        free(node->untracked[i]);
+    }
+    free(node->untracked);
+    node->untracked = NULL;
+    node->untracked_count = 0;
+}
+
+/**
+ * @brief: Drop everything the node knows, the sub-directories included
+ */
+static void _untracked_node_clear(struct untracked_node * node){
+    _untracked_node_clear_names(node);
+    for (size_t i = 0; i < node->child_count; i++){
+        _untracked_node_free(node->children[i]);
+    }
+    free(node->children);
+    node->children = NULL;
+    node->child_count = 0;
+    node->valid = false;
+    node->has_file = false;
+}
+
+/**
+ * @brief: Find the sub-directory of the node by binary search
+ * @return: The position of the sub-directory, or where it would be inserted
+ */
+static size_t _untracked_node_position(const struct untracked_node * node, const char * name, size_t length, bool * found){
+    size_t _low = 0;
+    size_t _high = node->child_count;
+    while (_low < _high){
+        size_t _middle = _low + (_high - _low) / 2;
+        const char * _name = node->children[_middle]->name;
+        int _result = strncmp(_name, name, length);
+        _result = _result != 0 ? _result : (_name[length] == '\0' ? 0 : 1);
+        if (_result == 0){
+            *found = true;
+            return _middle;
+        }
+        if (_result < 0){
+            _low = _middle + 1;
+        }else{
+            _high = _middle;
+        }
+    }
+    *found = false;
+    return _low;
+}
+
+/**
+ * @brief: Take the sub-directory out of the node to be reused, or create a new one
+ * @param node: The node, whose taken child is set to NULL
+ * @param name: The name of the sub-directory
+ * @param length: The length of the name
+ */
+static struct untracked_node * _untracked_node_take_child(struct untracked_node * node, const char * name, size_t length){
+    bool _found = false;
+    size_t _position = _untracked_node_position(node, name, length, &_found);
+    if (!_found){
+        return _untracked_node_create(name, length);
+    }
+    struct untracked_node * _child = node->children[_position];
+    // the taken child is kept in place so the binary search still works
+    node->children[_position] = _untracked_node_create(name, length);
+    return _child;
+}
+
+/**
+ * @brief: Replace the sub-directories of the node, the old ones not taken are freed
+ * @param node: The node
+ * @param children: The new sub-directories, sorted by the names
+ * @param count: The number of the new sub-directories
+ */
+static void _untracked_node_set_children(struct untracked_node * node, struct untracked_node ** children, size_t count){
+    for (size_t i = 0; i < node->child_count; i++){
+        _untracked_node_free(node->children[i]);
+    }
+    free(node->children);
+    node->children = children;
+    node->child_count = count;
+}
+
+/**
+ * @brief: Check whether the directory read is still the one of the node
+ */
+static bool _untracked_node_stat_matches(const struct untracked_node * node, const struct stat * status){
+    return node->mtime_sec == (uint32_t)status->st_mtim.tv_sec && node->mtime_nsec == (uint32_t)status->st_mtim.tv_nsec
+        && node->ino == (uint32_t)status->st_ino;
+}
+
+/**
+ * @brief: Store the stat data of the directory read in the node
+ */
+static void _untracked_node_fill_stat(struct untracked_node * node, const struct stat * status){
+    node->mtime_sec = (uint32_t)status->st_mtim.tv_sec;
+    node->mtime_nsec = (uint32_t)status->st_mtim.tv_nsec;
+    node->ino = (uint32_t)status->st_ino;
+}
+
+/**
+ * @brief: Check whether the directory may have changed in the same tick the
+ *         index was written, after it was read, like a racily clean entry
+ */
+static bool _untracked_node_is_racy(const struct index * index, const struct untracked_node * node){
+    if (index->timestamp_sec == 0){
+        return false;
+    }
+    return node->mtime_sec > index->timestamp_sec 
+        || (node->mtime_sec == index->timestamp_sec && node->mtime_nsec >= index->timestamp_nsec);
+}
+
+/**
+ * @brief: Check whether the index has any entry under the directory
+ */
+static bool _untracked_has_tracked(const struct index * index, const char * path, size_t length){
+    char _prefix[PATH_MAX + 1];
+    memcpy(_prefix, path, length);
+    _prefix[length] = '/';
+    bool _found = false;
+    size_t _position = index_position(index, _prefix, length + 1, &_found);
+    if (_position >= index->count){
+        return false;
+    }
+    const struct index_entry * _entry = index->entries[_position];
+    return _entry->path_length > length && memcmp(_entry->path, _prefix, length + 1) == 0;
+}
+
+/**
+ * @brief: Sort the entry of the directory read into the files or the 
+ *         sub-directories, unless it is ignored or tracked
+ */
+static void _untracked_read_entry(const char * name, size_t length, bool is_directory, void * data){
+    struct _untracked_read * _read = (struct _untracked_read *)data;
+    size_t _path_length = _read->length == 0 ? length : _read->length + 1 + length;
+    if (_path_length + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s/%s", _read->path, name);
+    }
+    if (_read->length != 0){
+        _read->path[_read->length] = '/';
+    }
+    memcpy(_read->path + _path_length - length, name, length + 1);
+
+    if (!ignore_rules_match(_read->rules, _read->path, _path_length, is_directory, NULL, NULL)){
+        if (is_directory){
+            _untracked_list_append(&_read->directories, name, length);
+        }else{
+            bool _found = false;
+            if (_read->index != NULL){
+                index_position(_read->index, _read->path, _path_length, &_found);
+            }
+            if (!_found){
+                _untracked_list_append(&_read->files, name, length);
+            }
+        }
+    }
+    _read->path[_read->length] = '\0';
+}
+
+/**
+ * @brief: Read the directory, and sort the sub-directories by the names
+ */
+static void _untracked_read_directory(struct _untracked_read * read){
+    worktree_read_directory(read->path, _untracked_read_entry, read);
+    qsort(read->directories.paths, read->directories.count, sizeof(char *), _untracked_compare_path);
+}
+
+/**
+ * @brief: Build the path of the sub-directory
+ * @param buffer: The buffer of PATH_MAX bytes
+ * @return: The length of the path
+ */
+static size_t _untracked_child_path(char * buffer, const char * path, size_t length, const char * name){
+    size_t _name_length = strlen(name);
+    size_t _length = length == 0 ? _name_length : length + 1 + _name_length;
+    if (_length + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s/%s", path, name);
+    }
+    memmove(buffer, path, length);
+    if (length != 0){
+        buffer[length] = '/';
+    }
+    memcpy(buffer + _length - _name_length, name, _name_length + 1);
+    return _length;
+}
+
+/**
+ * @brief: Tell whether the directory without tracked files holds any file 
+ *         which is not ignored, the node is read again only when it changed
+ * @param index: The index
+ * @param node: The node of the directory, check_only
+ * @param path: The path of the directory
+ * @param length: The length of the path
+ * @param parent_rules: The ignore rules of the parent directory
+ * @param changed: The flag to set when any node changed
+ * @return: Whether the directory holds an untracked file
+ * @note: The files of the directory are looked at before its sub-directories,
+ *        and the sub-directories are read in order until one holds a file. 
+ *        The node keeps the ones read, the answer depends on nothing else.
+ */
+static bool _untracked_check(const struct index * index, struct untracked_node * node, 
+    const char * path, size_t length, const struct ignore_rules * parent_rules, bool * changed){
+    struct stat _status;
+    if (lstat(path, &_status) != 0 || !S_ISDIR(_status.st_mode)){
+        _untracked_node_clear(node);
+        *changed = true;
+        return false;
+    }
+    struct ignore_rules * _rules = ignore_rules_load(parent_rules, path, length);
+    if (!oid_equals(&_rules->oid, &node->ignore_oid)){
+        _untracked_node_clear(node);
+    }
+
+    char _path[PATH_MAX];
+    bool _reuse = node->valid && node->check_only && _untracked_node_stat_matches(node, &_status) 
+        && !_untracked_node_is_racy(index, node);
+    if (_reuse && node->child_count != 0){
+        // the answer holds while every sub-directory read still gives its own answer
+        bool _has_file = false;
+        for (size_t i = 0; i < node->child_count; i++){
+            size_t _length = _untracked_child_path(_path, path, length, node->children[i]->name);
+            _has_file = _untracked_check(index, node->children[i], _path, _length, _rules, changed) || _has_file;
+        }
+        _reuse = _has_file == node->has_file;
+    }
+    if (_reuse){
+        ignore_rules_free(_rules);
+        return node->has_file;
+    }
+
+    memcpy(_path, path, length + 1);
+    struct _untracked_read _read;
+    memset(&_read, 0, sizeof(struct _untracked_read));
+    _read.rules = _rules;
+    _read.path = _path;
+    _read.length = length;
+    _untracked_read_directory(&_read);
+
+    _untracked_node_clear_names(node);
+    node->check_only = true;
+    node->has_file = _read.files.count != 0;
+    struct untracked_node ** _children = NULL;
+    size_t _child_count = 0;
+    if (!node->has_file && _read.directories.count != 0){
+        _children = (struct untracked_node **)malloc(_read.directories.count * sizeof(struct untracked_node *));
+        if (_children == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked cache");
+        }
+    }
+    for (size_t i = 0; !node->has_file && i < _read.directories.count; i++){
+        const char * _name = _read.directories.paths[i];
+        struct untracked_node * _child = _untracked_node_take_child(node, _name, strlen(_name));
+        _children[_child_count++] = _child;
+        size_t _length = _untracked_child_path(_path, path, length, _name);
+        node->has_file = _untracked_check(index, _child, _path, _length, _rules, changed);
+    }
+    _untracked_node_set_children(node, _children, _child_count);
+    _untracked_node_fill_stat(node, &_status);
+    node->ignore_oid = _rules->oid;
+    node->valid = true;
+    *changed = true;
+
+    untracked_list_release(&_read.files);
+    untracked_list_release(&_read.directories);
+    ignore_rules_free(_rules);
+    return node->has_file;
+}
+
+/**
+ * @brief: Read the directory of the node again, its sub-directories without 
+ *         tracked files are checked for the untracked files right away
+ * @param state: The state of the scan
+ * @param node: The node of the directory
+ * @param path: The path of the directory, used as the buffer of the paths
+ * @param length: The length of the path
+ * @param rules: The ignore rules of the directory
+ * @param status: The lstat result of the directory
+ * @param changed: The flag to set when any node changed
+ */
+static void _untracked_rebuild(const struct _untracked_scan_state * state, struct untracked_node * node, 
+    char * path, size_t length, const struct ignore_rules * rules, const struct stat * status, bool * changed){
+    struct _untracked_read _read;
+    memset(&_read, 0, sizeof(struct _untracked_read));
+    _read.index = state->index;
+    _read.rules = rules;
+    _read.path = path;
+    _read.length = length;
+    _untracked_read_directory(&_read);
+
+    _untracked_node_clear_names(node);
+    node->check_only = false;
+    node->has_file = false;
+    struct untracked_list _untracked = _read.files;
+    struct untracked_node ** _children = NULL;
+    if (_read.directories.count != 0){
+        _children = (struct untracked_node **)malloc(_read.directories.count * sizeof(struct untracked_node *));
+        if (_children == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked cache");
+        }
+    }
+    char _path[PATH_MAX];
+    for (size_t i = 0; i < _read.directories.count; i++){
+        const char * _name = _read.directories.paths[i];
+        size_t _name_length = strlen(_name);
+        struct untracked_node * _child = _untracked_node_take_child(node, _name, _name_length);
+        _children[i] = _child;
+        size_t _length = _untracked_child_path(_path, path, length, _name);
+        if (state->all || _untracked_has_tracked(state->index, _path, _length)){
+            // the directory is scanned on the next level, its node is checked there
+            if (_child->check_only){
+                _untracked_node_clear(_child);
+                _child->check_only = false;
+            }
+            continue;
+        }
+        if (!_child->check_only){
+            _untracked_node_clear(_child);
+            _child->check_only = true;
+        }
+        if (_untracked_check(state->index, _child, _path, _length, rules, changed)){
+            // the untracked directory is listed once with a trailing '/'
+            memcpy(_path, _name, _name_length);
+            _path[_name_length] = '/';
+            _untracked_list_append(&_untracked, _path, _name_length + 1);
+        }
+    }
+    _untracked_node_set_children(node, _children, _read.directories.count);
+    node->untracked = _untracked.paths;
+    node->untracked_count = _untracked.count;
+    _untracked_node_fill_stat(node, status);
+    node->ignore_oid = rules->oid;
+    node->valid = true;
+    *changed = true;
+    untracked_list_release(&_read.directories);
+}
+
+/**
+ * @brief: Append the directory to the next level of the worker
+ */
+static void _untracked_items_append(struct _untracked_items * items, struct untracked_node * node, 
+    const char * path, size_t length, const struct ignore_rules * rules){
+    if (items->count == items->capacity){
+        items->capacity = items->capacity == 0 ? 16 : items->capacity * 2;
+        items->items = (struct _untracked_item *)realloc(items->items, items->capacity * sizeof(struct _untracked_item));
+        if (items->items == NULL){
+            gitlet_panic("Failed to allocate memory for the directories");
+        }
+    }
+    struct _untracked_item * _item = &items->items[items->count++];
+    _item->node = node;
+    _item->length = length;
+    _item->rules = rules;
+    if ((_item->path = strndup(path, length)) == NULL){
+        gitlet_panic("Failed to allocate memory for the directories");
+    }
+}
+
+/**
+ * @brief: Keep the ignore rules read by the worker until the scan ends
+ */
+static void _untracked_rules_append(struct _untracked_rules * list, struct ignore_rules * rules){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->rules = (struct ignore_rules **)realloc(list->rules, list->capacity * sizeof(struct ignore_rules *));
+        if (list->rules == NULL){
+            gitlet_panic("Failed to allocate memory for the ignore rules");
+        }
+    }
+    list->rules[list->count++] = rules;
+}
+
+/**
+ * @brief: Scan the directory of the current level on the worker thread, 
+ *         from its node when the node is still valid
+ * @param item_index: The index of the directory in the level
+ * @param worker: The index of the worker
+ * @param data: The state of the scan
+ */
+static void _untracked_scan_directory(size_t item_index, unsigned int worker, void * data){
+    struct _untracked_scan_state * _state = (struct _untracked_scan_state *)data;
+    const struct _untracked_item * _item = &_state->level.items[item_index];
+    struct untracked_node * _node = _item->node;
+    bool * _changed = &_state->changed[worker];
+    char _path[PATH_MAX];
+    memcpy(_path, _item->path, _item->length + 1);
+
+    struct stat _status;
+    if (lstat(_item->length == 0 ? "." : _path, &_status) != 0 || !S_ISDIR(_status.st_mode)){
+        _untracked_node_clear(_node);
+        *_changed = true;
+        return;
+    }
+    struct ignore_rules * _rules = ignore_rules_load(_item->rules, _path, _item->length);
+    _untracked_rules_append(&_state->rules[worker], _rules);
+    if (!oid_equals(&_rules->oid, &_node->ignore_oid)){
+        // the rules of every directory under it may change as well
+        _untracked_node_clear(_node);
+    }
+
+    bool _reuse = _node->valid && !_node->check_only && _untracked_node_stat_matches(_node, &_status) 
+        && !_untracked_node_is_racy(_state->index, _node);
+    for (size_t i = 0; _reuse && i < _node->child_count; i++){
+        struct untracked_node * _child = _node->children[i];
+        if (!_child->check_only){
+            continue;
+        }
+        // a directory listed as untracked depends on what is under it
+        bool _has_file = _child->has_file;
+        char _child_path[PATH_MAX];
+        size_t _length = _untracked_child_path(_child_path, _path, _item->length, _child->name);
+        _reuse = _untracked_check(_state->index, _child, _child_path, _length, _rules, _changed) == _has_file;
+    }
+    if (!_reuse){
+        _untracked_rebuild(_state, _node, _path, _item->length, _rules, &_status, _changed);
+    }
+
+    for (size_t i = 0; i < _node->untracked_count; i++){
+        char _untracked[PATH_MAX];
+        size_t _length = _untracked_child_path(_untracked, _path, _item->length, _node->untracked[i]);
+        _untracked_list_append(&_state->lists[worker], _untracked, _length);
+    }
+    for (size_t i = 0; i < _node->child_count; i++){
+        struct untracked_node * _child = _node->children[i];
+        if (!_child->check_only){
+            char _child_path[PATH_MAX];
+            size_t _length = _untracked_child_path(_child_path, _path, _item->length, _child->name);
+            _untracked_items_append(&_state->next[worker], _child, _child_path, _length, _rules);
+        }
+    }
+}
+
+bool untracked_cache_enabled(void){
+    return repository_config_get_bool("core", "untrackedCache", true);
+}
+
+/**
+ * @brief: Parse the node and everything under it
+ * @param data: The cursor of the data, moved past the node
+ * @param end: The end of the data
+ * @param depth: The depth of the node
+ * @return: The node, NULL if the data is broken
+ */
+static struct untracked_node * _untracked_parse_node(const unsigned char ** data, const unsigned char * end, size_t depth){
+    const unsigned char * _cursor = *data;
+    const unsigned char * _name_end = memchr(_cursor, '\0', (size_t)(end - _cursor));
+    if (depth > UNTRACKED_MAX_DEPTH || _name_end == NULL || (size_t)(end - _name_end - 1) < UNTRACKED_NODE_FIXED_SIZE){
+        return NULL;
+    }
+    struct untracked_node * _node = _untracked_node_create((const char *)_cursor, (size_t)(_name_end - _cursor));
+    _cursor = _name_end + 1;
+    _node->mtime_sec = _get_be32(_cursor);
+    _node->mtime_nsec = _get_be32(_cursor + 4);
+    _node->ino = _get_be32(_cursor + 8);
+    memcpy(_node->ignore_oid.hash, _cursor + 12, OBJECT_ID_RAW_SIZE);
+    _cursor += 12 + OBJECT_ID_RAW_SIZE;
+    _node->valid = (*_cursor & UNTRACKED_NODE_VALID) != 0;
+    _node->check_only = (*_cursor & UNTRACKED_NODE_CHECK_ONLY) != 0;
+    _node->has_file = (*_cursor & UNTRACKED_NODE_HAS_FILE) != 0;
+    size_t _untracked_count = _get_be32(_cursor + 1);
+    size_t _child_count = _get_be32(_cursor + 5);
+    _cursor += 9;
+
+    // every name takes a byte at least, and every node its fixed part, before anything is allocated
+    if (_untracked_count > (size_t)(end - _cursor) || _child_count > (size_t)(end - _cursor) / UNTRACKED_NODE_FIXED_SIZE){
+        _untracked_node_free(_node);
+        return NULL;
+    }
+    _node->untracked = (char **)calloc(_untracked_count + 1, sizeof(char *));
+    _node->children = (struct untracked_node **)calloc(_child_count + 1, sizeof(struct untracked_node *));
+    if (_node->untracked == NULL || _node->children == NULL){
+        gitlet_panic("Failed to allocate memory for the untracked cache");
+    }
+    for (size_t i = 0; i < _untracked_count; i++){
+        const unsigned char * _end = memchr(_cursor, '\0', (size_t)(end - _cursor));
+        if (_end == NULL){
+            _untracked_node_free(_node);
+            return NULL;
+        }
+        if ((_node->untracked[i] = strdup((const char *)_cursor)) == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked cache");
+        }
+        _node->untracked_count++;
+        _cursor = _end + 1;
+    }
+    for (size_t i = 0; i < _child_count; i++){
+        struct untracked_node * _child = _untracked_parse_node(&_cursor, end, depth + 1);
+        if (_child == NULL){
+            _untracked_node_free(_node);
+            return NULL;
+        }
+        _node->children[_node->child_count++] = _child;
+        // the binary search depends on the order, so it is checked once here
+        if (i > 0 && strcmp(_node->children[i - 1]->name, _child->name) >= 0){
+            _untracked_node_free(_node);
+            return NULL;
+        }
+    }
+    *data = _cursor;
+    return _node;
+}
+
+struct untracked_cache * untracked_cache_parse(const unsigned char * data, size_t size){
+    if (size < 8 + OBJECT_ID_RAW_SIZE || _get_be32(data) != UNTRACKED_CACHE_VERSION){
+        return NULL;
+    }
+    struct untracked_cache * _cache = (struct untracked_cache *)calloc(1, sizeof(struct untracked_cache));
+    if (_cache == NULL){
+        gitlet_panic("Failed to allocate memory for the untracked cache");
+    }
+    _cache->all = (_get_be32(data + 4) & UNTRACKED_CACHE_FLAG_ALL) != 0;
+    memcpy(_cache->exclude_oid.hash, data + 8, OBJECT_ID_RAW_SIZE);
+    const unsigned char * _cursor = data + 8 + OBJECT_ID_RAW_SIZE;
+    _cache->root = _untracked_parse_node(&_cursor, data + size, 0);
+    if (_cache->root == NULL || _cursor != data + size){
+        untracked_cache_free(_cache);
+        return NULL;
+    }
+    return _cache;
+}
+
+/**
+ * @brief: Append the bytes to the buffer
+ */
+static void _untracked_buffer_append(struct _untracked_buffer * buffer, const void * data, size_t size){
+    if (buffer->size + size > buffer->capacity){
+        size_t _capacity = buffer->capacity == 0 ? 4096 : buffer->capacity;
+        while (_capacity < buffer->size + size){
+            _capacity *= 2;
+        }
+        buffer->data = (unsigned char *)realloc(buffer->data, _capacity);
+        if (buffer->data == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked cache");
+        }
+        buffer->capacity = _capacity;
+    }
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+/**
+ * @brief: Serialize the node and everything under it, before the children
+ */
+static void _untracked_serialize_node(struct _untracked_buffer * buffer, const struct untracked_node * node){
+    _untracked_buffer_append(buffer, node->name, strlen(node->name) + 1);
+    unsigned char _fixed[UNTRACKED_NODE_FIXED_SIZE];
+    _put_be32(_fixed, node->mtime_sec);
+    _put_be32(_fixed + 4, node->mtime_nsec);
+    _put_be32(_fixed + 8, node->ino);
+    memcpy(_fixed + 12, node->ignore_oid.hash, OBJECT_ID_RAW_SIZE);
+    unsigned char * _rest = _fixed + 12 + OBJECT_ID_RAW_SIZE;
+    _rest[0] = (unsigned char)((node->valid ? UNTRACKED_NODE_VALID : 0) 
+        | (node->check_only ? UNTRACKED_NODE_CHECK_ONLY : 0) | (node->has_file ? UNTRACKED_NODE_HAS_FILE : 0));
+    _put_be32(_rest + 1, (uint32_t)node->untracked_count);
+    _put_be32(_rest + 5, (uint32_t)node->child_count);
+    _untracked_buffer_append(buffer, _fixed, UNTRACKED_NODE_FIXED_SIZE);
+    for (size_t i = 0; i < node->untracked_count; i++){
+        _untracked_buffer_append(buffer, node->untracked[i], strlen(node->untracked[i]) + 1);
+    }
+    for (size_t i = 0; i < node->child_count; i++){
+        _untracked_serialize_node(buffer, node->children[i]);
+    }
+}
+
+unsigned char * untracked_cache_serialize(const struct untracked_cache * cache, size_t * size){
+    struct _untracked_buffer _buffer = {NULL, 0, 0};
+    unsigned char _header[8 + OBJECT_ID_RAW_SIZE];
+    _put_be32(_header, UNTRACKED_CACHE_VERSION);
+    _put_be32(_header + 4, cache->all ? UNTRACKED_CACHE_FLAG_ALL : 0);
+    memcpy(_header + 8, cache->exclude_oid.hash, OBJECT_ID_RAW_SIZE);
+    _untracked_buffer_append(&_buffer, _header, sizeof(_header));
+    _untracked_serialize_node(&_buffer, cache->root);
+    *size = _buffer.size;
+    return _buffer.data;
+}
+
+void untracked_cache_invalidate(struct untracked_cache * cache, const char * path, size_t length){
+    if (cache == NULL){
+        return;
+    }
+    struct untracked_node * _node = cache->root;
+    size_t _start = 0;
+    while (_node != NULL){
+        _node->valid = false;
+        const char * _slash = memchr(path + _start, '/', length - _start);
+        if (_slash == NULL){
+            break;
+        }
+        bool _found = false;
+        size_t _end = (size_t)(_slash - path);
+        size_t _position = _untracked_node_position(_node, path + _start, _end - _start, &_found);
+        _node = _found ? _node->children[_position] : NULL;
+        _start = _end + 1;
+    }
+}
+
+void untracked_cache_free(struct untracked_cache * cache){
+    if (cache == NULL){
+        return;
+    }
+    _untracked_node_free(cache->root);
+    free(cache);
+}
+
+void untracked_scan(struct index * index, bool all, unsigned int threads, struct untracked_list * list){
+    if (threads == 0){
+        threads = 1;
+    }
+    struct ignore_rules * _exclude = ignore_rules_load_exclude();
+    bool _had_cache = index->untracked != NULL;
+    bool _changed = false;
+
+    // the cache of the other mode, or of the other exclude file, starts over
+    struct untracked_cache * _cache = index->untracked;
+    if (_cache != NULL && (_cache->all != all || !oid_equals(&_cache->exclude_oid, &_exclude->oid))){
+        untracked_cache_free(_cache);
+        _cache = NULL;
+    }
+    if (_cache == NULL){
+        _cache = (struct untracked_cache *)calloc(1, sizeof(struct untracked_cache));
+        if (_cache == NULL){
+            gitlet_panic("Failed to allocate memory for the untracked cache");
+        }
+        _cache->all = all;
+        _cache->exclude_oid = _exclude->oid;
+        _cache->root = _untracked_node_create("", 0);
+        _changed = true;
+    }
+    index->untracked = _cache;
+
+    struct _untracked_scan_state _state;
+    memset(&_state, 0, sizeof(struct _untracked_scan_state));
+    _state.index = index;
+    _state.all = all;
+    _state.next = (struct _untracked_items *)calloc(threads, sizeof(struct _untracked_items));
+    _state.lists = (struct untracked_list *)calloc(threads, sizeof(struct untracked_list));
+    _state.rules = (struct _untracked_rules *)calloc(threads, sizeof(struct _untracked_rules));
+    _state.changed = (bool *)calloc(threads, sizeof(bool));
+    if (_state.next == NULL || _state.lists == NULL || _state.rules == NULL || _state.changed == NULL){
+        gitlet_panic("Failed to allocate memory for the scan of the untracked files");
+    }
+
+    _untracked_items_append(&_state.level, _cache->root, "", 0, _exclude);
+    while (_state.level.count != 0){
+        parallel_for(threads, _state.level.count, _untracked_scan_directory, &_state);
+
+        // the sub-directories found by all the workers make the next level
+        for (size_t i = 0; i < _state.level.count; i++){
+            free(_state.level.items[i].path);
+        }
+        _state.level.count = 0;
+        for (unsigned int i = 0; i < threads; i++){
+            struct _untracked_items * _next = &_state.next[i];
+            for (size_t j = 0; j < _next->count; j++){
+                if (_state.level.count == _state.level.capacity){
+                    _state.level.capacity = _state.level.capacity * 2 + _next->count;
+                    _state.level.items = (struct _untracked_item *)realloc(_state.level.items, 
+                        _state.level.capacity * sizeof(struct _untracked_item));
+                    if (_state.level.items == NULL){
+                        gitlet_panic("Failed to allocate memory for the directories");
+                    }
+                }
+                _state.level.items[_state.level.count++] = _next->items[j];
+            }
+            _next->count = 0;
+        }
+    }
+
+    // the paths found by the workers are merged and sorted for the same output every time
+    for (unsigned int i = 0; i < threads; i++){
+        for (size_t j = 0; j < _state.lists[i].count; j++){
+            if (list->count == list->capacity){
+                list->capacity = list->capacity * 2 + _state.lists[i].count;
+                list->paths = (char **)realloc(list->paths, list->capacity * sizeof(char *));
+                if (list->paths == NULL){
+                    gitlet_panic("Failed to allocate memory for the untracked files");
+                }
+            }
+            list->paths[list->count++] = _state.lists[i].paths[j];
+        }
+        free(_state.lists[i].paths);
+        for (size_t j = 0; j < _state.rules[i].count; j++){
+            ignore_rules_free(_state.rules[i].rules[j]);
+        }
+        free(_state.rules[i].rules);
+        free(_state.next[i].items);
+        _changed = _changed || _state.changed[i];
+    }
+    qsort(list->paths, list->count, sizeof(char *), _untracked_compare_path);
+
+    /**
+     * The cache is kept only when it is enabled and there is an index file,
+     * the racy check of the directories needs the time the index is written.
+     */
+    if (untracked_cache_enabled() && index->timestamp_sec != 0){
+        index->changed = index->changed || _changed;
+    }else{
+        index->changed = index->changed || _had_cache;
+        untracked_cache_free(_cache);
+        index->untracked = NULL;
+    }
+
+    free(_state.level.items);
+    free(_state.next);
+    free(_state.lists);
+    free(_state.rules);
+    free(_state.changed);
+    ignore_rules_free(_exclude);
+}
+
+void untracked_list_release(struct untracked_list * list){
+    for (size_t i = 0; i < list->count; i++){
+        free(list->paths[i]);
+    }
+    free(list->paths);
+    memset(list, 0, sizeof(struct untracked_list));
+}
@@ -0,0 +1,391 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <object/worktree.h>
+#include <util/error.h>
+#include <util/parallel.h>
+#include <util/str.h>
+#include <global/config.h>
+
+// the size of the buffer of getdents64, large enough for most directories at once
+#define WORKTREE_SCAN_BUFFER_SIZE   (32 * 1024)
+
+#ifdef __linux__
+/**
+ * @brief: The directory entry returned by getdents64
+ */
+struct _linux_dirent64{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/**
+ * @brief: The growable list of the directories of the next level
+ * @param paths: The paths of the directories
+ * @param count: The number of the directories
+ * @param capacity: The capacity of the list
+ */
+struct _worktree_list{
+    char ** paths;
+    size_t count;
+    size_t capacity;
+};
+
+/**
+ * @brief: The state of the scan shared by the worker threads
+ * @param level: The directories of the current level
+ * @param next: The directories of the next level found by every worker
+ * @param buffers: The getdents64 buffer of every worker
+ * @param callback: The callback function
+ * @param data: The user data passed to the callback
+ */
+struct _worktree_scan_state{
+    struct _worktree_list level;
+    struct _worktree_list * next;
+    uint64_t ** buffers;
+    worktree_scan_callback callback;
+    void * data;
+};
+
+/**
+ * @brief: The callback for every raw entry of the directory read
+ * @param name: The name of the entry, maybe "." or ".."
+ * @param type: The type of the entry from the directory, DT_UNKNOWN if unknown
+ * @param data: The user data
+ */
+typedef void (*_worktree_entry_callback)(const char * name, unsigned char type, void * data);
+
+/**
+ * @brief: The directory of the scan being read on the worker thread
+ */
+struct _worktree_scan_directory_state{
+    struct _worktree_scan_state * state;
+    unsigned int worker;
+    char * path;
+    size_t length;
+};
+
+/**
+ * @brief: The callback of worktree_read_directory and its data
+ */
+struct _worktree_read_state{
+    worktree_read_callback callback;
+    void * data;
+    char * path;
+    size_t length;
+};
+
+/**
+ * @brief: The callback of worktree_walk and its data, to walk with the scan
+ */
+struct _worktree_walk_adapter{
+    worktree_walk_callback callback;
+    void * data;
+};
+
+/**
+ * @brief: Append the path to the list
+ * @param list: The list
+ * @param path: The path
+ * @param length: The length of the path
+ */
+static void _worktree_list_append(struct _worktree_list * list, const char * path, size_t length){
+    if (list->count == list->capacity){
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->paths = (char **)realloc(list->paths, list->capacity * sizeof(char *));
+        if (list->paths == NULL){
+            gitlet_panic("Failed to allocate memory for the directories");
+        }
+    }
+    if ((list->paths[list->count++] = strndup(path, length)) == NULL){
+        gitlet_panic("Failed to allocate memory for the directories");
+    }
+}
+
+/**
+ * @brief: Report the entry of the directory, and keep the directory to be scanned
+ * @param state: The state of the scan
+ * @param worker: The index of the worker
+ * @param path: The path of the directory, the name is appended to it
+ * @param length: The length of the path
+ * @param name: The name of the entry
+ * @param type: The type of the entry from the directory, DT_UNKNOWN if unknown
+ */
+static void _worktree_scan_entry(struct _worktree_scan_state * state, unsigned int worker, 
+    char * path, size_t length, const char * name, unsigned char type){
+    if (str_equals(name, ".") || str_equals(name, "..") 
+        || str_equals(name, ".gitlet") || str_equals(name, ".git")){
+        return;
+    }
+    size_t _name_length = strlen(name);
+    size_t _path_length = length == 0 ? _name_length : length + 1 + _name_length;
+    if (_path_length + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s/%s", path, name);
+    }
+    if (length != 0){
+        path[length] = '/';
+    }
+    memcpy(path + _path_length - _name_length, name, _name_length + 1);
+
+    // the type from the directory saves the lstat, except on the file systems without it
+    bool _is_directory = type == DT_DIR;
+    if (type == DT_UNKNOWN){
+        struct stat _status;
+        _is_directory = lstat(path, &_status) == 0 && S_ISDIR(_status.st_mode);
+    }
+    if (state->callback(path, _path_length, _is_directory, worker, state->data) && _is_directory){
+        _worktree_list_append(&state->next[worker], path, _path_length);
+    }
+    path[length] = '\0';
+}
+
+/**
+ * @brief: Read the raw entries of the directory
+ * @param directory: The path of the directory, "." for the top
+ * @param buffer: The getdents64 buffer of WORKTREE_SCAN_BUFFER_SIZE bytes, unused without linux
+ * @param callback: The callback for every entry
+ * @param data: The user data passed to the callback
+ * @note: On linux the directory is read with getdents64 in large batches, and
+ *        the type of every entry comes with it. A directory which cannot be
+ *        opened reads as empty.
+ */
+static void _worktree_read(const char * directory, uint64_t * buffer, _worktree_entry_callback callback, void * data){
+#ifdef __linux__
+    int _fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (_fd < 0){
+        return;
+    }
+    long _read_size = 0;
+    while ((_read_size = syscall(SYS_getdents64, _fd, buffer, WORKTREE_SCAN_BUFFER_SIZE)) > 0){
+        for (long _offset = 0; _offset < _read_size; ){
+            struct _linux_dirent64 * _entry = (struct _linux_dirent64 *)((char *)buffer + _offset);
+            _offset += _entry->d_reclen;
+            callback(_entry->d_name, _entry->d_type, data);
+        }
+    }
+    close(_fd);
+#else
+    (void)buffer;
+    DIR * _directory = opendir(directory);
+    if (_directory == NULL){
+        return;
+    }
+    struct dirent * _entry = NULL;
+    while ((_entry = readdir(_directory)) != NULL){
+        callback(_entry->d_name, _entry->d_type, data);
+    }
+    closedir(_directory);
+#endif
+}
+
+/**
+ * @brief: Report the raw entry of the directory of the scan
+ */
+static void _worktree_scan_raw_entry(const char * name, unsigned char type, void * data){
+    struct _worktree_scan_directory_state * _directory = (struct _worktree_scan_directory_state *)data;
+    _worktree_scan_entry(_directory->state, _directory->worker, _directory->path, _directory->length, name, type);
+}
+
+/**
+ * @brief: Read the directory of the current level on the worker thread
+ * @param index: The index of the directory in the level
+ * @param worker: The index of the worker
+ * @param data: The state of the scan
+ */
+static void _worktree_scan_directory(size_t index, unsigned int worker, void * data){
+    struct _worktree_scan_state * state = (struct _worktree_scan_state *)data;
+    char _path[PATH_MAX];
+    size_t _length = strlen(state->level.paths[index]);
+    memcpy(_path, state->level.paths[index], _length + 1);
+    struct _worktree_scan_directory_state _directory = {state, worker, _path, _length};
+    _worktree_read(_length == 0 ? "." : _path, state->buffers[worker], _worktree_scan_raw_entry, &_directory);
+}
+
+void worktree_scan(const char * directory, unsigned int threads, worktree_scan_callback callback, void * data){
+    if (threads == 0){
+        threads = 1;
+    }
+    struct _worktree_scan_state _state;
+    memset(&_state, 0, sizeof(struct _worktree_scan_state));
+    _state.callback = callback;
+    _state.data = data;
+    _state.next = (struct _worktree_list *)calloc(threads, sizeof(struct _worktree_list));
+    _state.buffers = (uint64_t **)calloc(threads, sizeof(uint64_t *));
+    if (_state.next == NULL || _state.buffers == NULL){
+        gitlet_panic("Failed to allocate memory for the scan of the working tree");
+    }
+    for (unsigned int i = 0; i < threads; i++){
+        _state.buffers[i] = (uint64_t *)malloc(WORKTREE_SCAN_BUFFER_SIZE);
+        if (_state.buffers[i] == NULL){
+            gitlet_panic("Failed to allocate memory for the scan of the working tree");
+        }
+    }
+
+    if (strlen(directory) + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s", directory);
+    }
+    _worktree_list_append(&_state.level, directory, strlen(directory));
+    while (_state.level.count != 0){
+        parallel_for(threads, _state.level.count, _worktree_scan_directory, &_state);
+
+        // the sub-directories found by all the workers make the next level
+        for (size_t i = 0; i < _state.level.count; i++){
+            free(_state.level.paths[i]);
+        }
+        _state.level.count = 0;
+        for (unsigned int i = 0; i < threads; i++){
+            struct _worktree_list * _next = &_state.next[i];
+            for (size_t j = 0; j < _next->count; j++){
+                if (_state.level.count == _state.level.capacity){
+                    _state.level.capacity = _state.level.capacity * 2 + _next->count;
+                    _state.level.paths = (char **)realloc(_state.level.paths, _state.level.capacity * sizeof(char *));
+                    if (_state.level.paths == NULL){
+                        gitlet_panic("Failed to allocate memory for the directories");
+                    }
+                }
+                _state.level.paths[_state.level.count++] = _next->paths[j];
+            }
+            _next->count = 0;
+        }
+    }
+
+    for (unsigned int i = 0; i < threads; i++){
+        free(_state.next[i].paths);
+        free(_state.buffers[i]);
+    }
+    free(_state.level.paths);
+    free(_state.next);
+    free(_state.buffers);
+}
+
+/**
+ * @brief: Call the callback of worktree_walk, there is only one worker
+ */
+static bool _worktree_walk_entry(const char * path, size_t length, bool is_directory, unsigned int worker, void * data){
+    (void)worker;
+    struct _worktree_walk_adapter * _adapter = (struct _worktree_walk_adapter *)data;
+    return _adapter->callback(path, length, is_directory, _adapter->data);
+}
+
+void worktree_walk(const char * directory, worktree_walk_callback callback, void * data){
+    struct _worktree_walk_adapter _adapter = {callback, data};
+    worktree_scan(directory, 1, _worktree_walk_entry, &_adapter);
+}
+
+/**
+ * @brief: Report the raw entry of the directory read by worktree_read_directory
+ */
+static void _worktree_read_raw_entry(const char * name, unsigned char type, void * data){
+    struct _worktree_read_state * _state = (struct _worktree_read_state *)data;
+    if (str_equals(name, ".") || str_equals(name, "..") 
+        || str_equals(name, ".gitlet") || str_equals(name, ".git")){
+        return;
+    }
+    size_t _name_length = strlen(name);
+    bool _is_directory = type == DT_DIR;
+    if (type == DT_UNKNOWN){
+        size_t _path_length = _state->length == 0 ? _name_length : _state->length + 1 + _name_length;
+        if (_path_length + 1 > PATH_MAX){
+            gitlet_panic("Path too long in the working tree: %s/%s", _state->path, name);
+        }
+        if (_state->length != 0){
+            _state->path[_state->length] = '/';
+        }
+        memcpy(_state->path + _path_length - _name_length, name, _name_length + 1);
+        struct stat _status;
+        _is_directory = lstat(_state->path, &_status) == 0 && S_ISDIR(_status.st_mode);
+        _state->path[_state->length] = '\0';
+    }
+    _state->callback(name, _name_length, _is_directory, _state->data);
+}
+
+void worktree_read_directory(const char * directory, worktree_read_callback callback, void * data){
+    char _path[PATH_MAX];
+    size_t _length = strlen(directory);
+    if (_length + 1 > PATH_MAX){
+        gitlet_panic("Path too long in the working tree: %s", directory);
+    }
+    memcpy(_path, directory, _length + 1);
+    uint64_t * _buffer = (uint64_t *)malloc(WORKTREE_SCAN_BUFFER_SIZE);
+    if (_buffer == NULL){
+        gitlet_panic("Failed to allocate memory for the scan of the working tree");
+    }
+    struct _worktree_read_state _state = {callback, data, _path, _length};
+    _worktree_read(_length == 0 ? "." : _path, _buffer, _worktree_read_raw_entry, &_state);
+    free(_buffer);
+}
+
+void worktree_normalize_pathspec(char * buffer, const char * pathspec){
+    size_t _length = 0;
+    const char * _current = pathspec;
+    if (*_current == '/'){
+        gitlet_panic("%s: '%s' is outside repository", pathspec, pathspec);
+    }
+    while (*_current != '\0'){
+        const char * _end = strchr(_current, '/');
+        size_t _component_length = _end == NULL ? strlen(_current) : (size_t)(_end - _current);
+        if (_component_length == 2 && _current[0] == '.' && _current[1] == '.'){
+            gitlet_panic("%s: '%s' is outside repository", pathspec, pathspec);
+        }
+        if (_component_length != 0 && !(_component_length == 1 && _current[0] == '.')){
+            if (_length + _component_length + 2 > PATH_MAX){
+                gitlet_panic("Path too long: %s", pathspec);
+            }
+            if (_length != 0){
+                buffer[_length++] = '/';
+            }
+            memcpy(buffer + _length, _current, _component_length);
+            _length += _component_length;
+        }
+        _current += _component_length;
+        if (*_current == '/'){
+            _current++;
+        }
+    }
+    buffer[_length] = '\0';
+}
+
+bool worktree_path_matches(const char * path, size_t length, const char * pathspec, size_t pathspec_length){
+    if (pathspec_length == 0){
+        return true;
+    }
+    return length >= pathspec_length && memcmp(path, pathspec, pathspec_length) == 0
+        && (length == pathspec_length || path[pathspec_length] == '/');
+}
@@ -0,0 +1,285 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Qiu Yixiang
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <util/parallel.h>
+#include <util/error.h>
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/**
+ * @brief: The slot of the ring of the items in flight
+ * @param item: The item
+ * @param done: Whether the item is processed
+ */
+struct parallel_slot{
+    void * item;
+    bool done;
+};
+
+/**
+ * @brief: The ordered pipeline
+ * @param slots: The ring of the items in flight
+ * @param capacity: The number of the slots
+ * @param head: The sequence of the oldest item not output yet
+ * @param next_claim: The sequence of the next item for the workers
+ * @param tail: The sequence of the next item to be pushed
+ * @param stopping: Whether the workers should exit once the ring is drained
+ */
+struct parallel_pipeline{
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready;
+    pthread_cond_t item_done;
+    pthread_t * threads;
+    unsigned int workers;
+
+    struct parallel_slot * slots;
+    size_t capacity;
+    uint64_t head;
+    uint64_t next_claim;
+    uint64_t tail;
+    bool stopping;
+
+    parallel_process_function process;
+    parallel_output_function output;
+    void * data;
+};
+
+/**
+ * @brief: The argument of the worker thread
+ */
+struct parallel_worker{
+    struct parallel_pipeline * pipeline;
+    unsigned int index;
+};
+
+unsigned int parallel_cpu_count(void){
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count < 1 ? 1 : (unsigned int)count;
+}
+
+static void * parallel_worker_main(void * argument){
+    struct parallel_worker * worker = (struct parallel_worker *)argument;
+    struct parallel_pipeline * pipeline = worker->pipeline;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;){
+        while (pipeline->next_claim == pipeline->tail && !pipeline->stopping){
+            pthread_cond_wait(&pipeline->work_ready, &pipeline->mutex);
+        }
+        if (pipeline->next_claim == pipeline->tail){
+            break;
+        }
+        struct parallel_slot * slot = &pipeline->slots[pipeline->next_claim++ % pipeline->capacity];
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        pipeline->process(slot->item, worker->index, pipeline->data);
+
+        pthread_mutex_lock(&pipeline->mutex);
+        slot->done = true;
+        pthread_cond_signal(&pipeline->item_done);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    free(worker);
+    return NULL;
+}
+
+/**
+ * @brief: Output the processed items at the head of the ring
+ * @param pipeline: The pipeline, the mutex is held by the caller
+ * @param wait_count: Keep waiting until the number of the items in flight drops below it
+ */
+static void parallel_pipeline_drain(struct parallel_pipeline * pipeline, uint64_t wait_count){
+    for (;;){
+        while (pipeline->head != pipeline->tail && pipeline->slots[pipeline->head % pipeline->capacity].done){
+            struct parallel_slot * slot = &pipeline->slots[pipeline->head % pipeline->capacity];
+            void * item = slot->item;
+            slot->done = false;
+            pipeline->head++;
+
+            // the output runs without the lock so the workers keep going
+            pthread_mutex_unlock(&pipeline->mutex);
+            pipeline->output(item, pipeline->data);
+            pthread_mutex_lock(&pipeline->mutex);
+        }
+        if (pipeline->tail - pipeline->head < wait_count){
+            return;
+        }
+        pthread_cond_wait(&pipeline->item_done, &pipeline->mutex);
+    }
+}
+
+struct parallel_pipeline * parallel_pipeline_create(unsigned int workers, size_t capacity,
+    parallel_process_function process, parallel_output_function output, void * data){
+    struct parallel_pipeline * pipeline = (struct parallel_pipeline *)calloc(1, sizeof(struct parallel_pipeline));
+    if (pipeline == NULL){
+        gitlet_panic("Failed to allocate memory for pipeline");
+    }
+    pipeline->workers = workers == 0 ? 1 : workers;
+    pipeline->capacity = capacity == 0 ? 1 : capacity;
+    pipeline->process = process;
+    pipeline->output = output;
+    pipeline->data = data;
+    pipeline->slots = (struct parallel_slot *)calloc(pipeline->capacity, sizeof(struct parallel_slot));
+    pipeline->threads = (pthread_t *)calloc(pipeline->workers, sizeof(pthread_t));
+    if (pipeline->slots == NULL || pipeline->threads == NULL){
+        gitlet_panic("Failed to allocate memory for pipeline");
+    }
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->work_ready, NULL);
+    pthread_cond_init(&pipeline->item_done, NULL);
+
+    for (unsigned int i = 0; i < pipeline->workers; i++){
+        struct parallel_worker * worker = (struct parallel_worker *)malloc(sizeof(struct parallel_worker));
+        if (worker == NULL){
+            gitlet_panic("Failed to allocate memory for pipeline");
+        }
+        worker->pipeline = pipeline;
+        worker->index = i;
+        if (pthread_create(&pipeline->threads[i], NULL, parallel_worker_main, worker) != 0){
+            gitlet_panic("Failed to create the worker thread");
+        }
+    }
+    return pipeline;
+}
+
+void parallel_pipeline_push(struct parallel_pipeline * pipeline, void * item){
+    pthread_mutex_lock(&pipeline->mutex);
+    // make room for the item, the finished items at the head are output meanwhile
+    parallel_pipeline_drain(pipeline, pipeline->capacity);
+
+    struct parallel_slot * slot = &pipeline->slots[pipeline->tail % pipeline->capacity];
+    slot->item = item;
+    slot->done = false;
+    pipeline->tail++;
+    pthread_cond_signal(&pipeline->work_ready);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void parallel_pipeline_finish(struct parallel_pipeline * pipeline){
+    pthread_mutex_lock(&pipeline->mutex);
+    parallel_pipeline_drain(pipeline, 1);
+    pipeline->stopping = true;
+    pthread_cond_broadcast(&pipeline->work_ready);
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    for (unsigned int i = 0; i < pipeline->workers; i++){
+        pthread_join(pipeline->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pipeline->mutex);
+    pthread_cond_destroy(&pipeline->work_ready);
+    pthread_cond_destroy(&pipeline->item_done);
+    free(pipeline->threads);
+    free(pipeline->slots);
+    free(pipeline);
+}
+
+/**
+ * @brief: The shared state of the parallel loop
+ * @param next: The next index to be claimed
+ * @param count: The number of the indexes
+ */
+struct parallel_loop{
+    pthread_mutex_t mutex;
+    size_t next;
+    size_t count;
+    parallel_for_function function;
+    void * data;
+};
+
+/**
+ * @brief: The argument of the worker thread of the parallel loop
+ */
+struct parallel_loop_worker{
+    struct parallel_loop * loop;
+    unsigned int index;
+};
+
+/**
+ * @brief: Claim and run the indexes of the loop until all of them are claimed
+ * @param argument: The parallel loop worker
+ * @return: NULL
+ */
+static void * parallel_loop_worker_main(void * argument){
+    struct parallel_loop_worker * worker = (struct parallel_loop_worker *)argument;
+    struct parallel_loop * loop = worker->loop;
+
+    while (true){
+        pthread_mutex_lock(&loop->mutex);
+        size_t index = loop->next;
+        if (index < loop->count){
+            loop->next++;
+        }
+        pthread_mutex_unlock(&loop->mutex);
+        if (index >= loop->count){
+            return NULL;
+        }
+        loop->function(index, worker->index, loop->data);
+    }
+}
+
+void parallel_for(unsigned int workers, size_t count, parallel_for_function function, void * data){
+    if (workers > count){
+        workers = (unsigned int)count;
+    }
+    if (workers <= 1){
+        for (size_t i = 0; i < count; i++){
+            function(i, 0, data);
+        }
+        return;
+    }
+
+    struct parallel_loop loop;
+    pthread_mutex_init(&loop.mutex, NULL);
+    loop.next = 0;
+    loop.count = count;
+    loop.function = function;
+    loop.data = data;
+
+    pthread_t * threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    struct parallel_loop_worker * arguments = (struct parallel_loop_worker *)malloc(
+        workers * sizeof(struct parallel_loop_worker));
+    if (threads == NULL || arguments == NULL){
+        gitlet_panic("Failed to allocate memory for parallel loop");
+    }
+    for (unsigned int i = 0; i < workers; i++){
+        arguments[i].loop = &loop;
+        arguments[i].index = i;
+    }
+    // the calling thread works as the worker 0
+    for (unsigned int i = 1; i < workers; i++){
+        if (pthread_create(&threads[i], NULL, parallel_loop_worker_main, &arguments[i]) != 0){
+            gitlet_panic("Failed to create the worker thread");
+        }
+    }
+    parallel_loop_worker_main(&arguments[0]);
+    for (unsigned int i = 1; i < workers; i++){
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&loop.mutex);
+    free(threads);
+    free(arguments);
+}
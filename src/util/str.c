@@ -57,9 +57,40 @@ void str_hash_sha1_n(char * restrict buffer, const char * str, size_t len){
     }
     
     // Convert binary hash to hex string
-    for (int i = 0; i < SHA_DIGEST_LENGTH; i++) {
-        sprintf(buffer + (i * 2), "%02x", hash[i]);
+    str_hex_encode(buffer, hash, SHA_DIGEST_LENGTH);
+}
+
+// the hex digit of every nibble
+static const char _hex_digits[] = "0123456789abcdef";
+
+/**
+ * The value of every hex digit character with the 0x10 bit set, the other
+ * characters are 0, so one AND tells whether both digits are valid.
+ */
+static const unsigned char _hex_values[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14, ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17,
+    ['8'] = 0x18, ['9'] = 0x19, ['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+    ['A'] = 0x1a, ['B'] = 0x1b, ['C'] = 0x1c, ['D'] = 0x1d, ['E'] = 0x1e, ['F'] = 0x1f,
+};
+
+void str_hex_encode(char * restrict buffer, const unsigned char * data, size_t len){
+    for (size_t i = 0; i < len; i++){
+        buffer[i * 2] = _hex_digits[data[i] >> 4];
+        buffer[i * 2 + 1] = _hex_digits[data[i] & 0xf];
     }
+    buffer[len * 2] = '\0';
+}
+
+bool str_hex_decode(unsigned char * restrict buffer, const char * hex, size_t len){
+    for (size_t i = 0; i < len; i++){
+        unsigned char _high = _hex_values[(unsigned char)hex[i * 2]];
+        unsigned char _low = _hex_values[(unsigned char)hex[i * 2 + 1]];
+        if (!(_high & _low & 0x10)){
+            return false;
+        }
+        buffer[i] = (unsigned char)((_high << 4) | (_low & 0xf));
+    }
+    return true;
 }
 
 unsigned long str_decompress(const char * src_buffer, size_t src_size, 
@@ -84,12 +115,17 @@ unsigned long str_decompress(const char * src_buffer, size_t src_size,
 }
 
 unsigned long str_compress(const char * src_buffer, size_t src_size, char * dest_buffer, size_t dest_size){
+    return str_compress_level(src_buffer, src_size, dest_buffer, dest_size, Z_DEFAULT_COMPRESSION);
+}
+
+unsigned long str_compress_level(const char * src_buffer, size_t src_size, char * dest_buffer, 
+    size_t dest_size, int level){
     // compress the content
     if (src_size == 0 || dest_size == 0 || src_buffer == NULL || dest_buffer == NULL){
         return 0;
     }
     uLongf compressed_size = dest_size;
-    int result = compress((Bytef *)dest_buffer, &compressed_size, (Bytef *)src_buffer, src_size);
+    int result = compress2((Bytef *)dest_buffer, &compressed_size, (Bytef *)src_buffer, src_size, level);
     if (result != Z_OK){
         if (result == Z_MEM_ERROR){
             fprintf(stderr, "Out of memory\n");
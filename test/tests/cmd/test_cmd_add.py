@@ -0,0 +1,233 @@
+"""
+Test the add command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+def __write(path: str, content: str) -> None:
+    """Write the file under the test directory, creating its directories"""
+
+    full_path = os.path.join(_global.TEST_DIR, path)
+    os.makedirs(os.path.dirname(full_path), exist_ok=True)
+    with open(full_path, "w") as file:
+        file.write(content)
+
+def __add_both(paths: list[str]) -> None:
+    """Add the paths with both gitlet and git"""
+
+    assert subprocess.run([_global.PROGRAM_GITLET, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+
+def __assert_same_index() -> None:
+    """The index of gitlet has the same entries and stat data as the index of git, byte for byte"""
+
+    with open(os.path.join(_global.GITLET_DIR, "index"), "rb") as file:
+        gitlet_index = file.read()
+    with open(os.path.join(_global.GIT_DIR, "index"), "rb") as file:
+        git_index = file.read()
+    assert gitlet_index == git_index
+
+def _case_add_files() -> None:
+    """Test the add command with the files, the directories, the executables and the symbolic links"""
+
+    __write("f", "f\n")
+    __write("a/g", "g\n")
+    __write("a/b/h", "h\n")
+    __write("a.txt", "a\n")
+    __write("run.sh", "#!/bin/sh\n")
+    os.chmod(os.path.join(_global.TEST_DIR, "run.sh"), 0o755)
+    os.symlink("a/g", os.path.join(_global.TEST_DIR, "link"))
+
+    __add_both(["f", "a"])
+    __assert_same_index()
+    __add_both(["."])
+    __assert_same_index()
+
+    # the blobs are written to the repository
+    oid = subprocess.run(["git", "rev-parse", ":a/b/h"], capture_output=True, text=True,
+                         cwd=_global.TEST_DIR).stdout.strip()
+    result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "-p", oid], capture_output=True, text=True,
+                            cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert result.stdout == "h\n"
+
+def _case_add_changes() -> None:
+    """Test the add command with the modified and the deleted files"""
+
+    __write("f", "changed\n")
+    __write("a/b/new", "new\n")
+    os.remove(os.path.join(_global.TEST_DIR, "a/g"))
+    os.chmod(os.path.join(_global.TEST_DIR, "a.txt"), 0o755)
+    __add_both(["f", "a", "a.txt"])
+    __assert_same_index()
+
+    # the deletion of a tracked file is staged by its path
+    os.remove(os.path.join(_global.TEST_DIR, "f"))
+    __add_both(["f"])
+    __assert_same_index()
+
+    shutil.rmtree(os.path.join(_global.TEST_DIR, "a"))
+    __add_both(["a/"])
+    __assert_same_index()
+
+def _case_add_invalid() -> None:
+    """Test the add command with the pathspecs matching nothing"""
+
+    for pathspec in ["missing", "../outside"]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "add", pathspec], capture_output=True, text=True,
+                                cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+
+def __ls_files(program: str) -> str:
+    """List the index, with the ignore file of gitlet under the name of the one of git"""
+
+    result = subprocess.run([program, "ls-files", "-s"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    return result.stdout.replace(".gitletignore", ".gitignore")
+
+def _case_add_ignored() -> None:
+    """Test the add command with the ignore rules, the same for gitlet and git"""
+
+    os.makedirs(os.path.join(_global.GITLET_DIR, "info"), exist_ok=True)
+    with open(os.path.join(_global.GITLET_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitignore\n")
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n.gitletignore\n")
+    for name in [".gitignore", ".gitletignore"]:
+        __write(name, "*.o\nbuild/\n")
+        __write(f"src/{name}", "!keep.o\n")
+    __write("x.o", "x\n")
+    __write("build/y", "y\n")
+    __write("src/z.c", "z\n")
+    __write("src/w.o", "w\n")
+    __write("src/keep.o", "keep\n")
+    __add_both(["."])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    assert "x.o" not in __ls_files(_global.PROGRAM_GITLET)
+    assert "src/keep.o" in __ls_files(_global.PROGRAM_GITLET)
+
+    # an ignored pathspec is refused, the others are still added
+    __write("src/more.c", "more\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "add", "x.o", "src/more.c"], capture_output=True, text=True,
+                            cwd=_global.TEST_DIR)
+    assert result.returncode != 0
+    assert "x.o" in result.stderr
+    assert "src/more.c" in __ls_files(_global.PROGRAM_GITLET)
+
+    # a forced file stays tracked, and is updated by the later adds of its directory
+    assert subprocess.run([_global.PROGRAM_GITLET, "add", "-f", "x.o", "build"], cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add", "-f", "x.o", "src/more.c", "build"], cwd=_global.TEST_DIR).returncode == 0
+    __write("x.o", "changed\n")
+    __write("build/y", "changed\n")
+    __add_both(["."])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+
+def __shared_indexes() -> list[str]:
+    """List the shared index files of gitlet"""
+
+    return sorted(name for name in os.listdir(_global.GITLET_DIR) if name.startswith("sharedindex."))
+
+def __set_config(content: str) -> None:
+    """Append to the config of gitlet, the later values win"""
+
+    with open(os.path.join(_global.GITLET_DIR, "config"), "a") as file:
+        file.write(content)
+
+def _case_add_split_index() -> None:
+    """Test the add command with the split index, the entries are the same as the ones of git"""
+
+    __set_config("[core]\n\tsplitIndex = true\n[splitIndex]\n\tmaxPercentChange = 50\n")
+    __write("split/a", "split a\n")
+    __add_both(["split/a"])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    shared = __shared_indexes()
+    assert len(shared) == 1
+
+    # the small changes only go to the index, the shared index stays
+    for name in ["b", "c"]:
+        __write(f"split/{name}", f"split {name}\n")
+        __add_both([f"split/{name}"])
+        assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    __write("split/a", "changed\n")
+    os.remove(os.path.join(_global.TEST_DIR, "x.o"))
+    __add_both(["split/a", "x.o"])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    assert __shared_indexes() == shared
+    assert os.path.getsize(os.path.join(_global.GITLET_DIR, "index")) \
+        < os.path.getsize(os.path.join(_global.GITLET_DIR, shared[0]))
+
+    # too many changes write a new shared index, and the old one is removed
+    __set_config("[splitIndex]\n\tmaxPercentChange = 0\n")
+    __write("split/d", "split d\n")
+    __add_both(["split/d"])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    assert len(__shared_indexes()) == 1 and __shared_indexes() != shared
+
+    # without the split index the whole index is written again
+    __set_config("[core]\n\tsplitIndex = false\n")
+    __write("split/e", "split e\n")
+    __add_both(["split/e"])
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+    assert __shared_indexes() == []
+
+def _case_add_index_version() -> None:
+    """Test the add command with the prefix compressed paths of the version 4, byte for byte the index of git"""
+
+    __set_config("[index]\n\tversion = 4\n")
+    assert subprocess.run([_global.PROGRAM_GIT, "update-index", "--index-version", "4"],
+                          cwd=_global.TEST_DIR).returncode == 0
+    for path in ["deep/dir/tree/a", "deep/dir/tree/ab", "deep/dir/treeb/c", "deep/dir/z", "deep/e", "g"]:
+        __write(path, f"{path}\n")
+    __add_both(["."])
+    __assert_same_index()
+    with open(os.path.join(_global.GITLET_DIR, "index"), "rb") as file:
+        assert file.read(8) == b"DIRC\x00\x00\x00\x04"
+
+    __write("deep/dir/tree/ab", "changed\n")
+    os.remove(os.path.join(_global.TEST_DIR, "deep/dir/treeb/c"))
+    __add_both(["deep"])
+    __assert_same_index()
+    assert __ls_files(_global.PROGRAM_GITLET) == __ls_files(_global.PROGRAM_GIT)
+
+    # the version 2 is written again once it is set
+    __set_config("[index]\n\tversion = 2\n")
+    assert subprocess.run([_global.PROGRAM_GIT, "update-index", "--index-version", "2"],
+                          cwd=_global.TEST_DIR).returncode == 0
+    __write("deep/e", "changed\n")
+    __add_both(["deep/e"])
+    __assert_same_index()
+
+def test_cmd_add():
+    """
+    Test the add command
+    """
+
+    _global.global_setup(True)
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n")
+
+    # test the add command with the new files
+    _case_add_files()
+
+    # test the add command with the changed files
+    _case_add_changes()
+
+    # test the add command with the invalid pathspecs
+    _case_add_invalid()
+
+    # test the add command with the index version 4
+    _case_add_index_version()
+
+    # test the add command with the ignored files
+    _case_add_ignored()
+
+    # test the add command with the split index
+    _case_add_split_index()
+
+    _global.global_teardown()
@@ -71,6 +71,61 @@ def _case_cat_file_flag_e() -> None:
         assert result_map["gitlet_result"].returncode == result_map["git_result"].returncode
         assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
 
+def _case_cat_file_batch() -> None:
+    """Test the cat-file command with the --batch and --batch-check flags"""
+
+    # the missing and invalid names are reported in place
+    names = SHA1_LIST + ["0" * 40, "not-an-object"] + SHA1_LIST[:2]
+    for flags in [["--batch"], ["--batch-check"], ["--batch", "--buffer"], ["--buffer", "--batch-check"]]:
+        git_result = subprocess.run([_global.PROGRAM_GIT, "cat-file"] + flags, input="\n".join(names) + "\n",
+                                    capture_output=True, text=True, cwd=_global.TEST_DIR)
+        gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "cat-file"] + flags, input="\n".join(names) + "\n",
+                                       capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert gitlet_result.returncode == 0
+        assert gitlet_result.stdout == git_result.stdout
+
+    # every answer is flushed before the next name is read
+    process = subprocess.Popen([_global.PROGRAM_GITLET, "cat-file", "--batch-check"], stdin=subprocess.PIPE,
+                               stdout=subprocess.PIPE, text=True, cwd=_global.TEST_DIR)
+    for sha1 in SHA1_LIST:
+        process.stdin.write(sha1 + "\n")
+        process.stdin.flush()
+        assert process.stdout.readline().startswith(sha1 + " blob ")
+    process.stdin.close()
+    assert process.wait() == 0
+
+    for flags in [["--batch", "--batch-check"], ["--buffer"], ["-p", "--batch"]]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "cat-file"] + flags, input="", capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+def _case_cat_file_batch_all_objects() -> None:
+    """Test the cat-file command with the --batch-all-objects flag"""
+
+    for flags in [["--batch-check"], ["--batch", "--buffer"]]:
+        git_result = subprocess.run([_global.PROGRAM_GIT, "cat-file", "--batch-all-objects"] + flags,
+                                    capture_output=True, text=True, cwd=_global.TEST_DIR)
+        gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "--batch-all-objects"] + flags,
+                                       capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert gitlet_result.returncode == 0
+        assert gitlet_result.stdout == git_result.stdout
+
+    # the objects both packed and loose are listed once
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input="\n".join(SHA1_LIST[:3]) + "\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    git_result = subprocess.run([_global.PROGRAM_GIT, "cat-file", "--batch-check", "--batch-all-objects"],
+                                capture_output=True, text=True, cwd=_global.TEST_DIR)
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "--batch-check", "--batch-all-objects"],
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.stdout == git_result.stdout
+
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "--batch-check", "--batch-all-objects", "--unordered"],
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.returncode == 0
+    assert sorted(gitlet_result.stdout.splitlines()) == git_result.stdout.splitlines()
+
+    for flags in [["--batch-all-objects"], ["--batch-check", "--unordered"]]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "cat-file"] + flags, capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
 
 def test_cmd_cat_file():
     """
@@ -104,4 +159,10 @@ def test_cmd_cat_file():
     # test the cat-file command with the -e flag
     _case_cat_file_flag_e()
 
+    # test the cat-file command with the --batch and --batch-check flags
+    _case_cat_file_batch()
+
+    # test the cat-file command with the --batch-all-objects flag
+    _case_cat_file_batch_all_objects()
+
     _global.global_teardown()
\ No newline at end of file
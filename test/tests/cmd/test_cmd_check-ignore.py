@@ -0,0 +1,77 @@
+"""
+Test the check-ignore command
+"""
+
+# from standard library
+import os
+import subprocess
+
+# from local modules
+from util import _global
+
+def __write(path: str, content: str) -> None:
+    """Write the file under the test directory, creating its directories"""
+
+    full_path = os.path.join(_global.TEST_DIR, path)
+    os.makedirs(os.path.dirname(full_path), exist_ok=True)
+    with open(full_path, "w") as file:
+        file.write(content)
+
+def __write_ignore(path: str, content: str) -> None:
+    """Write the same ignore rules for gitlet and git"""
+
+    directory = os.path.dirname(path)
+    __write(os.path.join(directory, ".gitletignore"), content)
+    __write(os.path.join(directory, ".gitignore"), content)
+
+def __assert_same_check_ignore(flags: list[str]) -> None:
+    """The output of gitlet is the one of git, with the ignore file of gitlet under the name of the one of git"""
+
+    result_map = _global.compare_output(["check-ignore"] + flags)
+    assert result_map["gitlet_result"].returncode == result_map["git_result"].returncode
+    assert result_map["gitlet_result"].stdout.replace(".gitletignore", ".gitignore") \
+        == result_map["git_result"].stdout
+
+def _case_check_ignore_patterns() -> None:
+    """Test the check-ignore command with the patterns of the ignore files"""
+
+    __write_ignore(".gitignore", "*.o\n!keep.o\nbuild/\n/top\ndocs/**/draft\n\\#hash\nf?le.[ch]\n")
+    __write_ignore("sub/.gitignore", "keep.o\n!*.c\n")
+    os.makedirs(os.path.join(_global.TEST_DIR, "build"), exist_ok=True)
+
+    paths = ["x.o", "keep.o", "sub/keep.o", "build", "build/out", "top", "sub/top", "docs/a/b/draft",
+             "docs/draft", "#hash", "file.c", "sub/fele.c", "fille.c", "plain"]
+    for flags in [[], ["-v"], ["-v", "-n"], ["--"]]:
+        for path in paths:
+            __assert_same_check_ignore(flags + [path])
+        __assert_same_check_ignore(flags + paths)
+
+def _case_check_ignore_tracked() -> None:
+    """Test the check-ignore command with the tracked paths, which are never ignored"""
+
+    __write("tracked.o", "tracked\n")
+    assert subprocess.run([_global.PROGRAM_GITLET, "add", "-f", "tracked.o"], cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add", "-f", "tracked.o"], cwd=_global.TEST_DIR).returncode == 0
+    for flags in [[], ["-v"]]:
+        __assert_same_check_ignore(flags + ["tracked.o", "other.o"])
+        __assert_same_check_ignore(flags + ["tracked.o"])
+
+def test_cmd_check_ignore():
+    """
+    Test the check-ignore command
+    """
+
+    _global.global_setup(True)
+    os.makedirs(os.path.join(_global.GITLET_DIR, "info"), exist_ok=True)
+    with open(os.path.join(_global.GITLET_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitignore\n")
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n.gitletignore\n")
+
+    # test the check-ignore command with the patterns
+    _case_check_ignore_patterns()
+
+    # test the check-ignore command with the tracked paths
+    _case_check_ignore_tracked()
+
+    _global.global_teardown()
@@ -0,0 +1,218 @@
+"""
+Test the fsck command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+GIT_IDENTITY = ["-c", "user.name=gitlet", "-c", "user.email=gitlet@example.com"]
+
+def __git(commands: list[str], input_text: str = None) -> str:
+    """Run the git command in the test directory and return its output"""
+
+    result = subprocess.run([_global.PROGRAM_GIT] + GIT_IDENTITY + commands, input=input_text, capture_output=True,
+                            text=True, check=True, cwd=_global.TEST_DIR)
+    return result.stdout.strip()
+
+def __fsck(flags: list[str] = []) -> subprocess.CompletedProcess[str]:
+    """Run gitlet fsck in the test directory"""
+
+    return subprocess.run([_global.PROGRAM_GITLET, "fsck"] + flags, capture_output=True, text=True, cwd=_global.TEST_DIR)
+
+def __loose_path(sha1: str) -> str:
+    """Get the path of the loose object of gitlet"""
+
+    return os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:])
+
+def __copy_git() -> None:
+    """Make the objects and the refs of git the ones of gitlet"""
+
+    for name in ["objects", "refs"]:
+        shutil.rmtree(os.path.join(_global.GITLET_DIR, name))
+        shutil.copytree(os.path.join(_global.GIT_DIR, name), os.path.join(_global.GITLET_DIR, name))
+    for root, _, files in os.walk(os.path.join(_global.GITLET_DIR, "objects")):
+        for name in files:
+            os.chmod(os.path.join(root, name), 0o644)
+
+def __generate_history() -> None:
+    """Make a commit and an annotated tag with git"""
+
+    os.makedirs(os.path.join(_global.TEST_DIR, "dir"), exist_ok=True)
+    for index in range(8):
+        with open(os.path.join(_global.TEST_DIR, "dir", f"file_{index}"), "w") as file:
+            file.write(f"content {index}\n")
+    __git(["add", "dir"])
+    __git(["commit", "-q", "-m", "first"])
+    __git(["tag", "-a", "v1", "-m", "tag"])
+    __copy_git()
+
+def _case_fsck_clean() -> None:
+    """Test the fsck command on the valid loose and packed objects"""
+
+    for flags in [[], ["--threads", "1"], ["--threads", "3"]]:
+        result = __fsck(flags)
+        assert result.returncode == 0
+        assert result.stdout == ""
+
+    result = __fsck(["--progress"])
+    assert result.returncode == 0
+    assert "Checking objects: 100%" in result.stderr
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "-q", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    result = __fsck()
+    assert result.returncode == 0
+    assert result.stdout == ""
+
+def _case_fsck_corrupt_objects() -> None:
+    """Test the fsck command on the corrupt, mismatched and missing loose objects"""
+
+    __copy_git()
+    blobs = [__git(["rev-parse", f"HEAD:dir/file_{index}"]) for index in range(4)]
+    tree = __git(["rev-parse", "HEAD:dir"])
+
+    # one blob holds another one, one is truncated and two are gone
+    shutil.copy(__loose_path(blobs[1]), __loose_path(blobs[0]))
+    with open(__loose_path(blobs[1]), "r+b") as file:
+        file.truncate(6)
+    os.remove(__loose_path(blobs[2]))
+    os.remove(__loose_path(blobs[3]))
+
+    result = __fsck()
+    assert result.returncode != 0
+    lines = result.stdout.splitlines()
+    assert f"hash mismatch {blobs[0]}" in lines
+    assert f"corrupt object {blobs[1]}" in lines
+    assert f"broken link from {tree} to {blobs[2]}" in lines
+    assert f"broken link from {tree} to {blobs[3]}" in lines
+    assert len(lines) == 4
+
+    # the problems of the same object come out in the same order whatever the threads
+    tree_lines = [line for line in lines if line.startswith(f"broken link from {tree}")]
+    assert tree_lines == sorted(tree_lines)
+    for flags in [["--threads", "1"], ["--threads", "3"], ["--threads", "8"]]:
+        assert __fsck(flags).stdout == result.stdout
+
+def _case_fsck_bad_structure() -> None:
+    """Test the fsck command on the malformed commits, tags and trees"""
+
+    __copy_git()
+    tree = __git(["rev-parse", "HEAD^{tree}"])
+    blob = __git(["rev-parse", "HEAD:dir/file_0"])
+    bad_objects = {
+        "commit": f"tree {tree}\nauthor gitlet <gitlet@example.com> 0 +0000\n\nno committer\n",
+        "tag": f"object {tree}\ntype unknown\ntag v2\n\nbad type\n",
+    }
+    expected = []
+    for object_type, content in bad_objects.items():
+        sha1 = __git(["hash-object", "-t", object_type, "--literally", "-w", "--stdin"], content)
+        expected.append(sha1)
+
+    # the entries of the tree are out of order
+    bad_tree = b"100644 b\0" + bytes.fromhex(blob) + b"100644 a\0" + bytes.fromhex(blob)
+    result = subprocess.run([_global.PROGRAM_GIT, "hash-object", "-t", "tree", "--literally", "-w", "--stdin"],
+                            input=bad_tree, capture_output=True, check=True, cwd=_global.TEST_DIR)
+    expected.append(result.stdout.decode().strip())
+    __copy_git()
+
+    result = __fsck()
+    assert result.returncode != 0
+    lines = result.stdout.splitlines()
+    assert len(lines) == 3
+    for sha1, problem in zip(expected, ["invalid committer line", "invalid type line", "entries not sorted"]):
+        assert any(line.startswith("error in ") and sha1 in line and line.endswith(problem) for line in lines)
+
+def _case_fsck_broken_pack() -> None:
+    """Test the fsck command on a pack with a broken checksum"""
+
+    __copy_git()
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "-q", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    pack_dir = os.path.join(_global.GITLET_DIR, "objects", "pack")
+    pack = [name for name in os.listdir(pack_dir) if name.endswith(".pack")][0]
+    os.chmod(os.path.join(pack_dir, pack), 0o644)
+    with open(os.path.join(pack_dir, pack), "r+b") as file:
+        file.seek(40)
+        byte = file.read(1)
+        file.seek(40)
+        file.write(bytes([byte[0] ^ 0xff]))
+
+    result = __fsck()
+    assert result.returncode != 0
+    assert result.stdout.splitlines() == [f"broken pack {os.path.join(pack_dir, pack)}"]
+
+def _case_fsck_bad_pack_header() -> None:
+    """Test the fsck command on a pack index with a bad header, the loose objects are still checked"""
+
+    __copy_git()
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "-q", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    pack_dir = os.path.join(_global.GITLET_DIR, "objects", "pack")
+    pack = [name for name in os.listdir(pack_dir) if name.endswith(".pack")][0]
+    index = os.path.join(pack_dir, pack[:-len(".pack")] + ".idx")
+    os.chmod(index, 0o644)
+    with open(index, "r+b") as file:
+        file.write(b"XXXX")
+
+    with open(os.path.join(_global.TEST_DIR, "loose"), "w") as file:
+        file.write("loose content\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", "loose"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    sha1 = result.stdout.strip()
+    os.chmod(__loose_path(sha1), 0o644)
+    with open(__loose_path(sha1), "r+b") as file:
+        file.truncate(6)
+
+    result = __fsck()
+    assert result.returncode != 0
+    assert result.stdout.splitlines() == [f"broken pack {os.path.join(pack_dir, pack)}", f"corrupt object {sha1}"]
+
+def _case_fsck_index() -> None:
+    """Test the fsck command on the blobs of the index, which must be in the repository"""
+
+    __copy_git()
+    with open(os.path.join(_global.TEST_DIR, "staged"), "w") as file:
+        file.write("staged content\n")
+    assert subprocess.run([_global.PROGRAM_GITLET, "add", "staged"], cwd=_global.TEST_DIR).returncode == 0
+    # the malformed objects of the cases before are still reported
+    result = __fsck()
+    assert not any("in index" in line for line in result.stdout.splitlines())
+
+    sha1 = __git(["hash-object", "staged"])
+    os.remove(__loose_path(sha1))
+    result = __fsck()
+    assert result.returncode != 0
+    assert f"missing blob {sha1} in index for staged" in result.stdout.splitlines()
+
+def test_cmd_fsck():
+    """
+    Test the fsck command
+    """
+
+    _global.global_setup(True)
+
+    __generate_history()
+
+    # test the fsck command on the valid objects
+    _case_fsck_clean()
+
+    # test the fsck command on the corrupt loose objects
+    _case_fsck_corrupt_objects()
+
+    # test the fsck command on the malformed objects
+    _case_fsck_bad_structure()
+
+    # test the fsck command on the broken pack
+    _case_fsck_broken_pack()
+
+    # test the fsck command on the pack with a bad header
+    _case_fsck_bad_pack_header()
+
+    # test the fsck command on the index
+    _case_fsck_index()
+
+    _global.global_teardown()
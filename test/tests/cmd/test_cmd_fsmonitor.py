@@ -0,0 +1,126 @@
+"""
+Test the fsmonitor command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+def __write(path: str, content: str) -> None:
+    """Write the file under the test directory, creating its directories"""
+
+    full_path = os.path.join(_global.TEST_DIR, path)
+    os.makedirs(os.path.dirname(full_path), exist_ok=True)
+    with open(full_path, "w") as file:
+        file.write(content)
+
+def __add_both(paths: list[str]) -> None:
+    """Add the paths with both gitlet and git"""
+
+    assert subprocess.run([_global.PROGRAM_GITLET, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+
+def __fsmonitor(action: str) -> subprocess.CompletedProcess:
+    """Run the fsmonitor command with the action"""
+
+    return subprocess.run([_global.PROGRAM_GITLET, "fsmonitor", action], capture_output=True, text=True,
+                          cwd=_global.TEST_DIR)
+
+def __assert_same_status() -> None:
+    """The short format of gitlet is the one of git, twice so the flags saved by the first run are used"""
+
+    for _ in range(2):
+        for flags in [["-s"], ["-s", "-uall"]]:
+            result_map = _global.compare_output(["status"] + flags)
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def _case_fsmonitor_start() -> None:
+    """Test starting the fsmonitor, and the status right after it"""
+
+    result = __fsmonitor("status")
+    assert result.returncode != 0
+    assert "not running" in result.stdout
+
+    assert __fsmonitor("start").returncode == 0
+    assert __fsmonitor("start").returncode != 0
+    result = __fsmonitor("status")
+    assert result.returncode == 0
+    assert "watching" in result.stdout
+    __assert_same_status()
+
+def _case_fsmonitor_changes() -> None:
+    """Test the status with the changes seen by the fsmonitor"""
+
+    __write("f", "changed\n")
+    os.remove(os.path.join(_global.TEST_DIR, "a/g"))
+    os.chmod(os.path.join(_global.TEST_DIR, "a/b/h"), 0o755)
+    __write("new/dir/file", "new\n")
+    __assert_same_status()
+
+    # the content changed under the same size and mtime is still seen
+    stat = os.stat(os.path.join(_global.TEST_DIR, "a/b/h"))
+    __write("a/b/h", "H\n")
+    os.utime(os.path.join(_global.TEST_DIR, "a/b/h"), ns=(stat.st_atime_ns, stat.st_mtime_ns))
+    __assert_same_status()
+
+    # the directories moved in and out of the working tree
+    shutil.move(os.path.join(_global.TEST_DIR, "a/b"), os.path.join(_global.TEST_DIR, "moved"))
+    __assert_same_status()
+    __write("moved/later", "later\n")
+    shutil.move(os.path.join(_global.TEST_DIR, "moved"), os.path.join(_global.TEST_DIR, "a/b"))
+    __write("a/b/h", "h\n")
+    __assert_same_status()
+
+    __add_both(["."])
+    __assert_same_status()
+
+def _case_fsmonitor_restart() -> None:
+    """Test the status with the token of a stopped fsmonitor"""
+
+    result = __fsmonitor("stop")
+    assert result.returncode == 0
+    assert __fsmonitor("stop").returncode != 0
+    __write("f", "stopped\n")
+    __write("u/v", "untracked\n")
+    __assert_same_status()
+
+    assert __fsmonitor("start").returncode == 0
+    __assert_same_status()
+    __write("f", "restarted\n")
+    __assert_same_status()
+    assert __fsmonitor("stop").returncode == 0
+    assert not os.path.exists(os.path.join(_global.GITLET_DIR, "fsmonitor.sock"))
+
+def test_cmd_fsmonitor():
+    """
+    Test the fsmonitor command
+    """
+
+    _global.global_setup(True)
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n")
+    with open(os.path.join(_global.GITLET_DIR, "config"), "a") as file:
+        file.write("[core]\n\tfsmonitor = true\n")
+    __write("f", "f\n")
+    __write("a/g", "g\n")
+    __write("a/b/h", "h\n")
+    __add_both(["f", "a"])
+
+    try:
+        # test starting the fsmonitor
+        _case_fsmonitor_start()
+
+        # test the status with the changes
+        _case_fsmonitor_changes()
+
+        # test the status across the restart of the fsmonitor
+        _case_fsmonitor_restart()
+    finally:
+        __fsmonitor("stop")
+
+    _global.global_teardown()
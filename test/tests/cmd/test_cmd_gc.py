@@ -0,0 +1,191 @@
+"""
+Test the gc command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+import time
+
+# from local modules
+from util import _global
+
+JUNK_SHA1_LIST = []
+
+GIT_IDENTITY = ["-c", "user.name=gitlet", "-c", "user.email=gitlet@example.com"]
+
+def __git(commands: list[str]) -> str:
+    """Run the git command in the test directory and return its output"""
+
+    result = subprocess.run([_global.PROGRAM_GIT] + GIT_IDENTITY + commands, capture_output=True, text=True,
+                            check=True, cwd=_global.TEST_DIR)
+    return result.stdout.strip()
+
+def __generate_history() -> None:
+    """Make two commits and an annotated tag with git, plus the unreachable blobs"""
+
+    for index in range(20):
+        os.makedirs(os.path.join(_global.TEST_DIR, "dir", "sub"), exist_ok=True)
+        with open(os.path.join(_global.TEST_DIR, "dir", f"file_{index}"), "w") as file:
+            file.write(f"content {index}\n")
+    with open(os.path.join(_global.TEST_DIR, "dir", "sub", "nested"), "w") as file:
+        file.write("nested\n")
+    __git(["add", "dir"])
+    __git(["commit", "-q", "-m", "first"])
+    with open(os.path.join(_global.TEST_DIR, "dir", "file_0"), "a") as file:
+        file.write("changed\n")
+    __git(["add", "dir"])
+    __git(["commit", "-q", "-m", "second"])
+    __git(["tag", "-a", "v1", "-m", "tag", "HEAD~1"])
+    __git(["pack-refs", "--all"])
+
+    for index in range(3):
+        path = os.path.join(_global.TEST_DIR, f"junk_{index}")
+        with open(path, "w") as file:
+            file.write(f"junk {index}\n")
+        JUNK_SHA1_LIST.append(__git(["hash-object", "-w", path]))
+
+    # the objects and the refs of git become the ones of gitlet
+    shutil.rmtree(os.path.join(_global.GITLET_DIR, "objects"))
+    shutil.copytree(os.path.join(_global.GIT_DIR, "objects"), os.path.join(_global.GITLET_DIR, "objects"))
+    shutil.rmtree(os.path.join(_global.GITLET_DIR, "refs"))
+    shutil.copytree(os.path.join(_global.GIT_DIR, "refs"), os.path.join(_global.GITLET_DIR, "refs"))
+    for name in ["HEAD", "packed-refs"]:
+        shutil.copy(os.path.join(_global.GIT_DIR, name), os.path.join(_global.GITLET_DIR, name))
+
+def __loose_objects() -> list[str]:
+    """List the ids of the loose objects of gitlet"""
+
+    objects_dir = os.path.join(_global.GITLET_DIR, "objects")
+    return sorted(fanout + name for fanout in os.listdir(objects_dir) if len(fanout) == 2
+                  for name in os.listdir(os.path.join(objects_dir, fanout)))
+
+def __packs() -> list[str]:
+    """List the packs of gitlet"""
+
+    return sorted(name for name in os.listdir(os.path.join(_global.GITLET_DIR, "objects", "pack")) if name.endswith(".pack"))
+
+def __check_reachable() -> None:
+    """Check that every object reachable from the refs is still readable"""
+
+    for line in __git(["rev-list", "--objects", "--all"]).splitlines():
+        sha1 = line[:40]
+        for flag in ["-t", "-s"]:
+            result_map = _global.compare_output(["cat-file", flag, sha1])
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def _case_gc_default() -> None:
+    """Test the gc command with the default grace period"""
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    __check_reachable()
+
+    # the reachable objects are packed, the recent unreachable ones stay loose
+    assert __loose_objects() == sorted(JUNK_SHA1_LIST)
+    assert len(__packs()) == 1
+
+    # a pack holding a recent unreachable object stays too
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input=JUNK_SHA1_LIST[0] + "\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "-q", "--threads", "2"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert result.stdout == ""
+    assert len(__packs()) == 2
+    assert __loose_objects() == sorted(JUNK_SHA1_LIST[1:])
+    __check_reachable()
+
+def _case_gc_temp_files() -> None:
+    """Test the gc command with the temporary files left behind by the writers"""
+
+    objects_dir = os.path.join(_global.GITLET_DIR, "objects")
+    stale_files = [os.path.join(objects_dir, "tmp_obj_stale"), os.path.join(objects_dir, "pack", "tmp_pack_stale")]
+    fresh_file = os.path.join(objects_dir, "tmp_obj_fresh")
+    for path in stale_files + [fresh_file]:
+        with open(path, "w") as file:
+            file.write("partial")
+    month_ago = time.time() - 30 * 24 * 60 * 60
+    for path in stale_files:
+        os.utime(path, (month_ago, month_ago))
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "--no-prune"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert all(os.path.exists(path) for path in stale_files + [fresh_file])
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert not any(os.path.exists(path) for path in stale_files)
+    assert os.path.exists(fresh_file)
+
+def _case_gc_prune_now() -> None:
+    """Test the gc command pruning all the unreachable objects"""
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert __loose_objects() == []
+    assert len(__packs()) == 1
+    assert not os.path.exists(os.path.join(_global.GITLET_DIR, "objects", "tmp_obj_fresh"))
+    __check_reachable()
+
+    for sha1 in JUNK_SHA1_LIST:
+        result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "-e", sha1], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+
+    # a second run finds nothing to do
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert len(__packs()) == 1
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "--prune=yesterday"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode != 0
+
+def _case_gc_index() -> None:
+    """Test the gc command keeping the blobs of the staged files"""
+
+    path = os.path.join(_global.TEST_DIR, "staged")
+    with open(path, "w") as file:
+        file.write("staged\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "add", "staged"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    sha1 = __git(["hash-object", path])
+
+    # an old staged blob survives the grace period too
+    fanout_path = os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:])
+    old_time = time.time() - 30 * 24 * 3600
+    os.utime(fanout_path, (old_time, old_time))
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert sha1 not in __loose_objects()
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "gc", "--prune=now"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "-p", sha1], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert result.stdout == "staged\n"
+    __check_reachable()
+
+def test_cmd_gc():
+    """
+    Test the gc command
+    """
+
+    _global.global_setup(True)
+
+    __generate_history()
+
+    # test the gc command with the default grace period
+    _case_gc_default()
+
+    # test the gc command with the temporary files
+    _case_gc_temp_files()
+
+    # test the gc command with --prune=now
+    _case_gc_prune_now()
+
+    # test the gc command keeping the staged files
+    _case_gc_index()
+
+    _global.global_teardown()
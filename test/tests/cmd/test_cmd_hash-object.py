@@ -2,6 +2,8 @@
 
 # from standard library
 import os
+import subprocess
+import time
 
 # from local modules
 from util import _global
@@ -122,7 +124,211 @@ def _case_hash_object_flag_w() -> None:
     assert result["gitlet_result"].stdout == result["git_result"].stdout
     __compare_using_cat_file(result["gitlet_result"].stdout[:40])
 
-
+    # the object is read only and readable by all, like the ones of git
+    SHA1 = result["gitlet_result"].stdout[:40]
+    mode = os.stat(os.path.join(_global.GITLET_DIR, "objects", SHA1[:2], SHA1[2:])).st_mode & 0o777
+    assert mode == 0o444
+
+def _case_hash_object_stdin_paths() -> None:
+    """Test the hash-object command reading the paths from stdin"""
+    paths = [__file__, os.path.join(_global.ROOT_DIR, "util", "_global.py")]
+    for i in range(20):
+        path = os.path.join(_global.TEST_DIR, f"batch file {i}.txt")
+        with open(path, "w") as f:
+            f.write(f"batch content {i}\n" * (i + 1))
+        paths.append(path)
+
+    git_result = subprocess.run([_global.PROGRAM_GIT, "hash-object", "-w", "--stdin-paths"], input="\n".join(paths) + "\n",
+                                capture_output=True, text=True, cwd=_global.TEST_DIR)
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", "--stdin-paths"], input="\n".join(paths) + "\n",
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.returncode == 0
+    assert gitlet_result.stdout == git_result.stdout
+    for sha1 in gitlet_result.stdout.split():
+        __compare_using_cat_file(sha1)
+
+    # the NUL separated paths give the same ids in the same order
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "--stdin-paths", "-z"], input="\0".join(paths),
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.returncode == 0
+    assert gitlet_result.stdout == git_result.stdout
+
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "--stdin-paths"], input="no-such-file\n",
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.returncode != 0
+
+def _case_hash_object_stdin_paths_threads() -> None:
+    """Test the hash-object command hashing the paths from stdin on the worker threads"""
+    paths = []
+    for i in range(300):
+        path = os.path.join(_global.TEST_DIR, f"thread file {i}.txt")
+        with open(path, "w") as f:
+            f.write(f"thread content {i}\n" * (i * 7 % 500 + 1))
+        paths.append(path)
+
+    git_result = subprocess.run([_global.PROGRAM_GIT, "hash-object", "-w", "--stdin-paths"], input="\n".join(paths) + "\n",
+                                capture_output=True, text=True, cwd=_global.TEST_DIR)
+    for threads in ["1", "4", "0"]:
+        # the ids are printed in the input order whatever the number of the threads
+        gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", "--stdin-paths", "--threads", threads],
+                                       input="\n".join(paths) + "\n", capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert gitlet_result.returncode == 0
+        assert gitlet_result.stdout == git_result.stdout
+    for sha1 in gitlet_result.stdout.split()[::37]:
+        __compare_using_cat_file(sha1)
+
+def _case_hash_object_skip_existing() -> None:
+    """Test the hash-object command skipping the objects already stored"""
+    small_path = os.path.join(_global.TEST_DIR, "existing small.txt")
+    with open(small_path, "w") as f:
+        f.write("existing content\n")
+    large_path = os.path.join(_global.TEST_DIR, "existing large.txt")
+    with open(large_path, "w") as f:
+        f.write("".join(f"existing line {i}\n" for i in range(20000)))
+
+    for path in [small_path, large_path]:
+        subprocess.run([_global.PROGRAM_GIT, "hash-object", "-w", path], capture_output=True, cwd=_global.TEST_DIR)
+        result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode == 0
+        sha1 = result.stdout.strip()
+        object_path = os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:])
+        os.utime(object_path, (1000000000, 1000000000))
+        inode = os.stat(object_path).st_ino
+
+        # the stored object is not written again, but freshened for the expiry of gc
+        result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode == 0
+        assert result.stdout.strip() == sha1
+        assert os.stat(object_path).st_ino == inode
+        assert os.stat(object_path).st_mtime > 1000000000
+        __compare_using_cat_file(sha1)
+
+    # the packed object is not written as a loose object again
+    result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", large_path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    sha1 = result.stdout.strip()
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input=sha1 + "\n", capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    pack_path = os.path.join(_global.GITLET_DIR, "objects", "pack", f"pack-{result.stdout.strip()}.pack")
+    os.utime(pack_path, (1000000000, 1000000000))
+    os.remove(os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:]))
+    result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", large_path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.stdout.strip() == sha1
+    assert not os.path.exists(os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:]))
+    assert os.stat(pack_path).st_mtime > 1000000000
+    __compare_using_cat_file(sha1)
+
+def _case_hash_object_pruned_existing() -> None:
+    """Test the hash-object command writing again an object pruned after its fan-out was read"""
+    path = os.path.join(_global.TEST_DIR, "pruned.txt")
+    with open(path, "w") as f:
+        f.write("pruned content\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    sha1 = result.stdout.strip()
+    object_path = os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:])
+    os.utime(object_path, (1000000000, 1000000000))
+
+    process = subprocess.Popen([_global.PROGRAM_GITLET, "hash-object", "-w", "--stdin-paths", "--threads", "1"],
+                               stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, cwd=_global.TEST_DIR)
+    process.stdin.write(path + "\n")
+    process.stdin.flush()
+    # the freshened mtime tells the fan-out has been read
+    deadline = time.time() + 10
+    while os.stat(object_path).st_mtime == 1000000000 and time.time() < deadline:
+        time.sleep(0.01)
+    assert os.stat(object_path).st_mtime > 1000000000
+
+    # a concurrent gc prunes the object, the next write must not trust the set
+    os.remove(object_path)
+    stdout, _ = process.communicate(path + "\n")
+    assert process.returncode == 0
+    assert stdout.split() == [sha1, sha1]
+    assert os.path.exists(object_path)
+    result = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "-p", sha1], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert result.stdout == "pruned content\n"
+
+def _case_hash_object_compression() -> None:
+    """Test the hash-object command compressing the objects with the compression policy"""
+    config_path = os.path.join(_global.GITLET_DIR, "config")
+    with open(config_path) as f:
+        config = f.read()
+
+    def hash_object(path: str, text: bool = True) -> int:
+        subprocess.run([_global.PROGRAM_GIT, "hash-object", "-w", path], capture_output=True, cwd=_global.TEST_DIR)
+        result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode == 0
+        sha1 = result.stdout.strip()
+        if text:
+            __compare_using_cat_file(sha1)
+        else:
+            content = subprocess.run([_global.PROGRAM_GITLET, "cat-file", "-p", sha1], capture_output=True, cwd=_global.TEST_DIR).stdout
+            with open(path, "rb") as f:
+                assert content == f.read()
+        return os.path.getsize(os.path.join(_global.GITLET_DIR, "objects", sha1[:2], sha1[2:]))
+
+    # the incompressible data is stored, and the text is still compressed
+    random_path = os.path.join(_global.TEST_DIR, "random.bin")
+    with open(random_path, "wb") as f:
+        f.write(os.urandom(200000))
+    text_path = os.path.join(_global.TEST_DIR, "compressible.txt")
+    with open(text_path, "w") as f:
+        f.write("".join(f"compressible line {i}\n" for i in range(10000)))
+    assert hash_object(random_path, False) > 200000
+    assert hash_object(text_path) < os.path.getsize(text_path) // 4
+
+    # the level from the config and the stored objects over the threshold
+    with open(config_path, "a") as f:
+        f.write("[core]\n\tcompression = 0\n")
+    text_path = os.path.join(_global.TEST_DIR, "stored.txt")
+    with open(text_path, "w") as f:
+        f.write("stored line\n" * 1000)
+    assert hash_object(text_path) > os.path.getsize(text_path)
+
+    with open(config_path, "w") as f:
+        f.write(config + "[core]\n\tstoreThreshold = 10k\n")
+    with open(text_path, "w") as f:
+        f.write("threshold line\n" * 1000)
+    assert hash_object(text_path) > os.path.getsize(text_path)
+
+    with open(config_path, "w") as f:
+        f.write(config + "[core]\n\tcompression = 10\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", text_path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode != 0
+
+    with open(config_path, "w") as f:
+        f.write(config)
+
+def _case_hash_object_fsync_method() -> None:
+    """Test the hash-object command syncing the objects with the core.fsyncMethod config"""
+    paths = []
+    for i in range(50):
+        path = os.path.join(_global.TEST_DIR, f"fsync file {i}.txt")
+        with open(path, "w") as f:
+            f.write(f"fsync content {i}\n" * (i + 1))
+        paths.append(path)
+
+    git_result = subprocess.run([_global.PROGRAM_GIT, "hash-object", "-w", "--stdin-paths"], input="\n".join(paths) + "\n",
+                                capture_output=True, text=True, cwd=_global.TEST_DIR)
+    objects_dir = os.path.join(_global.GITLET_DIR, "objects")
+    for method in ["fsync", "batch"]:
+        with open(os.path.join(_global.GITLET_DIR, "config"), "a") as f:
+            f.write(f"[core]\n\tfsyncMethod = {method}\n")
+        for threads in ["1", "4"]:
+            gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", "--stdin-paths", "--threads", threads],
+                                           input="\n".join(paths) + "\n", capture_output=True, text=True, cwd=_global.TEST_DIR)
+            assert gitlet_result.returncode == 0
+            assert gitlet_result.stdout == git_result.stdout
+            for sha1 in gitlet_result.stdout.split():
+                assert os.path.isfile(os.path.join(objects_dir, sha1[:2], sha1[2:]))
+            # every temporary file is published or removed
+            assert not [name for name in os.listdir(objects_dir) if name.startswith("tmp_obj_")]
+        __compare_using_cat_file(gitlet_result.stdout.split()[-1])
+
+    with open(os.path.join(_global.GITLET_DIR, "config"), "a") as f:
+        f.write("[core]\n\tfsyncMethod = sometimes\n")
+    gitlet_result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", paths[0]],
+                                   capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert gitlet_result.returncode != 0
 
 def test_cmd_hash_object():
     """Test the hash-object command"""
@@ -131,5 +337,11 @@ def test_cmd_hash_object():
     _case_hash_object_no_flag()
     _case_hash_object_flag_file()
     _case_hash_object_flag_w()
+    _case_hash_object_stdin_paths()
+    _case_hash_object_stdin_paths_threads()
+    _case_hash_object_skip_existing()
+    _case_hash_object_pruned_existing()
+    _case_hash_object_compression()
+    _case_hash_object_fsync_method()
 
     _global.global_teardown()
\ No newline at end of file
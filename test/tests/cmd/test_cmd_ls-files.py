@@ -0,0 +1,39 @@
+"""
+Test the ls-files command
+"""
+
+# from standard library
+import os
+import subprocess
+
+# from local modules
+from util import _global
+
+def _case_ls_files_flags() -> None:
+    """Test the ls-files command with the flags and the pathspecs"""
+
+    for path, content in [("f", "f\n"), ("a/g", "g\n"), ("a/b/h", "h\n"), ("a.txt", "a\n")]:
+        os.makedirs(os.path.dirname(os.path.join(_global.TEST_DIR, path)), exist_ok=True)
+        with open(os.path.join(_global.TEST_DIR, path), "w") as file:
+            file.write(content)
+    assert subprocess.run([_global.PROGRAM_GITLET, "add", "."], cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add", "."], cwd=_global.TEST_DIR).returncode == 0
+
+    for flags in [[], ["-s"], ["-z"], ["-s", "a"], ["a/b", "f"], ["--", "a.txt"], ["missing"]]:
+        result_map = _global.compare_output(["ls-files"] + flags)
+        assert result_map["gitlet_result"].returncode == 0
+        assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def test_cmd_ls_files():
+    """
+    Test the ls-files command
+    """
+
+    _global.global_setup(True)
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n")
+
+    # test the ls-files command with the flags
+    _case_ls_files_flags()
+
+    _global.global_teardown()
@@ -0,0 +1,73 @@
+"""
+Test the ls-tree command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+COMMIT_SHA1 = []
+
+def __generate_commit() -> str:
+    """Commit a small nested tree with git and return the id of the commit"""
+
+    for path, content in [("f", "f\n"), ("a/g", "g\n"), ("a/b/h", "h\n"), ("a/b/c/i", "i\n")]:
+        os.makedirs(os.path.dirname(os.path.join(_global.TEST_DIR, path)), exist_ok=True)
+        with open(os.path.join(_global.TEST_DIR, path), "w") as file:
+            file.write(content)
+
+    subprocess.run(["git", "add", "f", "a"], check=True, cwd=_global.TEST_DIR)
+    subprocess.run(["git", "-c", "user.name=gitlet", "-c", "user.email=gitlet@example.com", "commit", "-q", "-m", "tree"],
+                   check=True, cwd=_global.TEST_DIR)
+    result = subprocess.run(["git", "rev-parse", "HEAD"], capture_output=True, text=True, check=True, cwd=_global.TEST_DIR)
+    return result.stdout.strip()
+
+def __copy_objs() -> None:
+    """Remove .gitlet/objs then copy the objs from .git/objects to .gitlet/objects"""
+
+    if os.path.exists(os.path.join(_global.GITLET_DIR, "objects")):
+        shutil.rmtree(os.path.join(_global.GITLET_DIR, "objects"))
+
+    shutil.copytree(os.path.join(_global.GIT_DIR, "objects"), os.path.join(_global.GITLET_DIR, "objects"))
+
+def _case_ls_tree_flags() -> None:
+    """Test the ls-tree command with the commit, the tree and the abbreviated ids"""
+
+    tree = subprocess.run(["git", "rev-parse", COMMIT_SHA1[0] + "^{tree}"], capture_output=True, text=True,
+                          cwd=_global.TEST_DIR).stdout.strip()
+    for name in [COMMIT_SHA1[0], tree, COMMIT_SHA1[0][:8], tree[:6]]:
+        for flags in [[], ["-r"], ["-d"], ["-r", "-d"], ["-r", "-t"], ["-r", "--name-only"]]:
+            result_map = _global.compare_output(["ls-tree"] + flags + [name])
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def _case_ls_tree_not_tree() -> None:
+    """Test the ls-tree command with the names which are not trees"""
+
+    blob = subprocess.run(["git", "rev-parse", COMMIT_SHA1[0] + ":f"], capture_output=True, text=True,
+                          cwd=_global.TEST_DIR).stdout.strip()
+    for name in [blob, "0" * 40, "zzzz"]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "ls-tree", name], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+
+def test_cmd_ls_tree():
+    """
+    Test the ls-tree command
+    """
+
+    _global.global_setup(True)
+
+    COMMIT_SHA1.append(__generate_commit())
+    __copy_objs()
+
+    # test the ls-tree command with the different flags
+    _case_ls_tree_flags()
+
+    # test the ls-tree command with the invalid names
+    _case_ls_tree_not_tree()
+
+    _global.global_teardown()
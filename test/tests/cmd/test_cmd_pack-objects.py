@@ -0,0 +1,101 @@
+"""Test the pack-objects command"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+SHA1_LIST = []
+
+def __write_objects() -> None:
+    """Write the objects into both the git and the gitlet object database"""
+    with open(os.path.join(_global.TEST_DIR, "small_file.txt"), "w") as f:
+        f.write("Hello, world!")
+    with open(os.path.join(_global.TEST_DIR, "large_file.txt"), "w") as f:
+        f.write("Hello, world!" * 100000)
+    with open(os.path.join(_global.TEST_DIR, "empty_file.txt"), "w") as f:
+        pass
+    # revisions of the same file, packed as the deltas against each other
+    lines = [f"line {i}: the quick brown fox jumps over the lazy dog\n" for i in range(2000)]
+    for revision in range(4):
+        lines[revision * 300] = f"revision {revision} changed this line\n"
+        with open(os.path.join(_global.TEST_DIR, f"revision_{revision}.txt"), "w") as f:
+            f.writelines(lines)
+
+    files = [
+        os.path.join(_global.TEST_DIR, "small_file.txt"),
+        os.path.join(_global.TEST_DIR, "large_file.txt"),
+        os.path.join(_global.TEST_DIR, "empty_file.txt"),
+        *[os.path.join(_global.TEST_DIR, f"revision_{revision}.txt") for revision in range(4)],
+        os.path.join(_global.ROOT_DIR, "tests", "cmd", "test_cmd_pack-objects.py"),
+        os.path.join(_global.ROOT_DIR, "util", "_global.py"),
+    ]
+    for file in files:
+        result = _global.compare_output(["hash-object", "-w", file])
+        assert result["gitlet_result"].returncode == 0
+        assert result["gitlet_result"].stdout == result["git_result"].stdout
+        SHA1_LIST.append(result["gitlet_result"].stdout.strip())
+
+def __remove_loose_objects() -> None:
+    """Remove the loose objects of gitlet, so only the pack is left"""
+    objects_dir = os.path.join(_global.GITLET_DIR, "objects")
+    for name in os.listdir(objects_dir):
+        if len(name) == 2:
+            shutil.rmtree(os.path.join(objects_dir, name))
+
+def _case_pack_objects_all() -> None:
+    """Test the pack-objects command with the --all flag"""
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects", "--all"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+
+    pack_name = result.stdout.strip()
+    assert len(pack_name) == 40
+
+    pack_dir = os.path.join(_global.GITLET_DIR, "objects", "pack")
+    assert os.path.isfile(os.path.join(pack_dir, f"pack-{pack_name}.pack"))
+    assert os.path.isfile(os.path.join(pack_dir, f"pack-{pack_name}.idx"))
+    # the pack and index are read only and readable by all, like the ones of git
+    for suffix in [".pack", ".idx"]:
+        assert os.stat(os.path.join(pack_dir, f"pack-{pack_name}{suffix}")).st_mode & 0o777 == 0o444
+
+    # the pack and index must be readable by git itself
+    verify = subprocess.run([_global.PROGRAM_GIT, "verify-pack", "-v", os.path.join(pack_dir, f"pack-{pack_name}.idx")], 
+                            capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert verify.returncode == 0
+    # the revisions must be stored as deltas
+    assert "chain length = 1" in verify.stdout
+
+def _case_read_packed_objects() -> None:
+    """Test reading the objects from the pack after the loose objects are removed"""
+    __remove_loose_objects()
+
+    for sha1 in SHA1_LIST:
+        for flag in ["-p", "-t", "-s", "-e"]:
+            result = _global.compare_output(["cat-file", flag, sha1])
+            assert result["gitlet_result"].returncode == result["git_result"].returncode
+            assert result["gitlet_result"].stdout == result["git_result"].stdout
+
+def _case_pack_objects_stdin() -> None:
+    """Test the pack-objects command reading the object ids from stdin"""
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input="\n".join(SHA1_LIST[:2]) + "\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert len(result.stdout.strip()) == 40
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input="not-an-object\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode != 0
+
+def test_cmd_pack_objects():
+    """Test the pack-objects command"""
+    _global.global_setup(True)
+
+    __write_objects()
+    _case_pack_objects_all()
+    _case_read_packed_objects()
+    _case_pack_objects_stdin()
+
+    _global.global_teardown()
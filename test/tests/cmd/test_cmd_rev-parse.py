@@ -0,0 +1,91 @@
+"""
+Test the rev-parse command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+
+# from local modules
+from util import _global
+
+SHA1_LIST = []
+
+def __generate_objs(count: int) -> None:
+    """Write the blobs with git hash-object -w, enough to share the short prefixes"""
+
+    for index in range(count):
+        path = os.path.join(_global.TEST_DIR, f"file_{index}")
+        with open(path, "w") as file:
+            file.write(f"content {index}\n")
+
+    result = subprocess.run(["git", "hash-object", "-w", "--stdin-paths"], input="\n".join(
+        os.path.join(_global.TEST_DIR, f"file_{index}") for index in range(count)) + "\n",
+        capture_output=True, text=True, check=True, cwd=_global.TEST_DIR)
+    SHA1_LIST.extend(result.stdout.split())
+
+    if os.path.exists(os.path.join(_global.GITLET_DIR, "objects")):
+        shutil.rmtree(os.path.join(_global.GITLET_DIR, "objects"))
+    shutil.copytree(os.path.join(_global.GIT_DIR, "objects"), os.path.join(_global.GITLET_DIR, "objects"))
+
+def _case_rev_parse_names() -> None:
+    """Test the rev-parse command with the full and the abbreviated ids"""
+
+    for sha1 in SHA1_LIST[:50]:
+        for name in [sha1, sha1[:12], sha1.upper()]:
+            result_map = _global.compare_output(["rev-parse", name])
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def _case_rev_parse_short() -> None:
+    """Test the rev-parse command with the --short flag"""
+
+    for sha1 in SHA1_LIST[::5]:
+        for flag in ["--short", "--short=4", "--short=10"]:
+            result_map = _global.compare_output(["rev-parse", flag, sha1])
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+    # the --short flag applies to the names after it and verifies a single one
+    result_map = _global.compare_output(["rev-parse", SHA1_LIST[0], "--short", SHA1_LIST[1]])
+    assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+    result = subprocess.run([_global.PROGRAM_GITLET, "rev-parse", "--short"] + SHA1_LIST[:2], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode != 0
+
+def _case_rev_parse_ambiguous() -> None:
+    """Test the rev-parse and cat-file commands with the ambiguous and unknown names"""
+
+    # with a thousand objects some four digit prefixes are shared
+    prefixes = [sha1[:4] for sha1 in SHA1_LIST]
+    shared = [prefix for prefix in prefixes if prefixes.count(prefix) > 1]
+    assert shared != []
+
+    for command in [["rev-parse"], ["cat-file", "-t"]]:
+        result = subprocess.run([_global.PROGRAM_GITLET] + command + [shared[0]], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+        assert "ambiguous" in result.stderr + result.stdout
+
+    for name in ["fff", "zzzzzz", "0" * 40 + "0"]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "rev-parse", name], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode != 0
+
+def test_cmd_rev_parse():
+    """
+    Test the rev-parse command
+    """
+
+    _global.global_setup(True)
+
+    __generate_objs(1000)
+
+    # test the rev-parse command with the full and the abbreviated ids
+    _case_rev_parse_names()
+
+    # test the rev-parse command with the --short flag
+    _case_rev_parse_short()
+
+    # test the rev-parse command with the ambiguous names
+    _case_rev_parse_ambiguous()
+
+    _global.global_teardown()
@@ -0,0 +1,230 @@
+"""
+Test the status command
+"""
+
+# from standard library
+import os
+import shutil
+import subprocess
+import time
+
+# from local modules
+from util import _global
+
+def __write(path: str, content: str) -> None:
+    """Write the file under the test directory, creating its directories"""
+
+    full_path = os.path.join(_global.TEST_DIR, path)
+    os.makedirs(os.path.dirname(full_path), exist_ok=True)
+    with open(full_path, "w") as file:
+        file.write(content)
+
+def __add_both(paths: list[str]) -> None:
+    """Add the paths with both gitlet and git"""
+
+    assert subprocess.run([_global.PROGRAM_GITLET, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+    assert subprocess.run([_global.PROGRAM_GIT, "add"] + paths, cwd=_global.TEST_DIR).returncode == 0
+
+def __commit() -> None:
+    """Commit the index of git, and copy the objects and the branch to gitlet"""
+
+    subprocess.run(["git", "-c", "user.name=gitlet", "-c", "user.email=gitlet@example.com", "commit", "-q", "-m", "status"],
+                   check=True, cwd=_global.TEST_DIR)
+    shutil.rmtree(os.path.join(_global.GITLET_DIR, "objects"))
+    shutil.copytree(os.path.join(_global.GIT_DIR, "objects"), os.path.join(_global.GITLET_DIR, "objects"))
+    shutil.copy(os.path.join(_global.GIT_DIR, "refs", "heads", "master"),
+                os.path.join(_global.GITLET_DIR, "refs", "heads", "master"))
+
+def __assert_same_status() -> None:
+    """The short and the porcelain formats of gitlet are the ones of git"""
+
+    for flags in [["-s"], ["--porcelain"], ["-s", "-uall"], ["-s", "-uno"], ["--porcelain", "--untracked-files=all"]]:
+        result_map = _global.compare_output(["status"] + flags)
+        assert result_map["gitlet_result"].returncode == 0
+        assert result_map["gitlet_result"].stdout == result_map["git_result"].stdout
+
+def _case_status_no_commits() -> None:
+    """Test the status command before the first commit"""
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "status"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.returncode == 0
+    assert "No commits yet" in result.stdout
+    assert "nothing to commit" in result.stdout
+
+    __write("f", "f\n")
+    __write("a/g", "g\n")
+    __write("a/b/h", "h\n")
+    __write("u/v/w", "w\n")
+    __add_both(["f", "a"])
+    __assert_same_status()
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "status"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert "Changes to be committed:" in result.stdout
+    assert "\tnew file:   a/b/h\n" in result.stdout
+    assert "Untracked files:" in result.stdout
+    assert "\tu/\n" in result.stdout
+
+def _case_status_changes() -> None:
+    """Test the status command with the staged and the unstaged changes after a commit"""
+
+    __commit()
+    __assert_same_status()
+    result = subprocess.run([_global.PROGRAM_GITLET, "status"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert result.stdout.startswith("On branch master\n")
+
+    __write("f", "changed\n")
+    __write("a/new", "new\n")
+    os.remove(os.path.join(_global.TEST_DIR, "a/g"))
+    os.chmod(os.path.join(_global.TEST_DIR, "a/b/h"), 0o755)
+    __assert_same_status()
+
+    __add_both(["a"])
+    __write("a/new", "newer\n")
+    os.symlink("f", os.path.join(_global.TEST_DIR, "link"))
+    __assert_same_status()
+
+    result = subprocess.run([_global.PROGRAM_GITLET, "status"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert "\tdeleted:    a/g\n" in result.stdout
+    assert "Changes not staged for commit:" in result.stdout
+    assert "\tmodified:   f\n" in result.stdout
+
+def _case_status_same_stat() -> None:
+    """Test the status command with the content changed under the same size and mtime"""
+
+    __write("same", "aaa\n")
+    stat = os.stat(os.path.join(_global.TEST_DIR, "same"))
+    __add_both(["same"])
+    __assert_same_status()
+
+    __write("same", "bbb\n")
+    os.utime(os.path.join(_global.TEST_DIR, "same"), ns=(stat.st_atime_ns, stat.st_mtime_ns))
+    result = subprocess.run([_global.PROGRAM_GITLET, "status", "-s"], capture_output=True, text=True, cwd=_global.TEST_DIR)
+    assert "AM same\n" in result.stdout
+
+    # a clean file stays clean after the stat data is refreshed
+    __write("same", "aaa\n")
+    for _ in range(2):
+        result = subprocess.run([_global.PROGRAM_GITLET, "status", "-s"], capture_output=True, text=True,
+                                cwd=_global.TEST_DIR)
+        assert "A  same\n" in result.stdout
+
+def _case_status_threads() -> None:
+    """Test the status command scanning a wider tree with the different numbers of the threads"""
+
+    for directory in range(40):
+        for file in range(10):
+            __write(f"wide/d{directory}/f{file}", f"{directory} {file}\n")
+    __add_both(["wide"])
+    for directory in range(0, 40, 3):
+        __write(f"wide/d{directory}/f0", "changed\n")
+        __write(f"wide/d{directory}/new/file", "new\n")
+    __write("wide/d1/untracked", "untracked\n")
+    __assert_same_status()
+
+    expected = None
+    for threads in ["1", "2", "5", "0"]:
+        result = subprocess.run([_global.PROGRAM_GITLET, "status", "-s", "-uall", "--threads", threads],
+                                capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode == 0
+        expected = result.stdout if expected is None else expected
+        assert result.stdout == expected
+
+def __assert_same_status_ignored() -> None:
+    """Like __assert_same_status, with the ignore file of gitlet under the name of the one of git"""
+
+    for _ in range(2):
+        for flags in [["-s"], ["-s", "-uall"]]:
+            result_map = _global.compare_output(["status"] + flags)
+            assert result_map["gitlet_result"].returncode == 0
+            assert result_map["gitlet_result"].stdout.replace(".gitletignore", ".gitignore") \
+                == result_map["git_result"].stdout
+
+def __write_ignore(path: str, content: str) -> None:
+    """Write the same ignore rules for gitlet and git"""
+
+    directory = os.path.dirname(path)
+    __write(os.path.join(directory, ".gitletignore"), content)
+    __write(os.path.join(directory, ".gitignore"), content)
+
+def _case_status_ignored() -> None:
+    """Test the status command with the ignore rules"""
+
+    os.makedirs(os.path.join(_global.GITLET_DIR, "info"), exist_ok=True)
+    with open(os.path.join(_global.GITLET_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitignore\n")
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n.gitletignore\n")
+    __write_ignore(".gitignore", "*.o\nbuild/\n/top\ndocs/**/draft\n")
+    __write_ignore("ig/.gitignore", "!keep.o\n")
+    for path in ["x.o", "ig/keep.o", "ig/y.o", "build/out", "top", "ig/top", "docs/a/b/draft",
+                 "docs/draft", "only/ignored.o", "only/build/z"]:
+        __write(path, "ignored?\n")
+    __assert_same_status_ignored()
+
+    # the exclude file of the repository applies everywhere
+    with open(os.path.join(_global.GITLET_DIR, "info", "exclude"), "a") as file:
+        file.write("keep.o\n")
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "a") as file:
+        file.write("keep.o\n")
+    __assert_same_status_ignored()
+
+def _case_status_untracked_cache() -> None:
+    """Test the status command with the untracked cache after the changes"""
+
+    __write("cache/a/f", "cached f\n")
+    __write("cache/b/g", "cached g\n")
+    __add_both(["cache"])
+    __assert_same_status_ignored()
+
+    # the new files in the directories read before, in the same second or not
+    __write("cache/a/new", "new\n")
+    __write("cache/b/sub/deep/new", "new\n")
+    __assert_same_status_ignored()
+    time.sleep(0.05)
+    __write("cache/c/new.o", "new\n")
+    os.remove(os.path.join(_global.TEST_DIR, "cache/a/new"))
+    __assert_same_status_ignored()
+
+    # the ignore rules changed in place, and the paths added to the index
+    __write_ignore("cache/.gitignore", "new\n")
+    __assert_same_status_ignored()
+    __write_ignore("cache/.gitignore", "*.c\n")
+    __add_both(["cache/b"])
+    __assert_same_status_ignored()
+
+    # the cache is dropped when it is disabled
+    with open(os.path.join(_global.GITLET_DIR, "config"), "a") as file:
+        file.write("[core]\n\tuntrackedCache = false\n")
+    __write("cache/b/later", "later\n")
+    __assert_same_status_ignored()
+    with open(os.path.join(_global.GITLET_DIR, "index"), "rb") as file:
+        assert b"UNTG" not in file.read()
+
+def test_cmd_status():
+    """
+    Test the status command
+    """
+
+    _global.global_setup(True)
+    with open(os.path.join(_global.GIT_DIR, "info", "exclude"), "w") as file:
+        file.write(".gitlet\n")
+
+    # test the status command without commits
+    _case_status_no_commits()
+
+    # test the status command with the changes
+    _case_status_changes()
+
+    # test the status command with the same stat data
+    _case_status_same_stat()
+
+    # test the status command with the threads
+    _case_status_threads()
+
+    # test the status command with the ignore rules
+    _case_status_ignored()
+
+    # test the status command with the untracked cache
+    _case_status_untracked_cache()
+
+    _global.global_teardown()
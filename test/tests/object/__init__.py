@@ -0,0 +1 @@
+"""Test Suite for object module"""
\ No newline at end of file
@@ -0,0 +1,154 @@
+"""Test Suite for object/cache.c module"""
+
+# from standard library
+import ctypes
+import os
+import subprocess
+import threading
+
+# from local modules
+from util import _global
+from util._global import gitlet_lib
+
+class ObjectId(ctypes.Structure):
+    _fields_ = [("hash", ctypes.c_ubyte * 20)]
+
+class Object(ctypes.Structure):
+    _fields_ = [("type", ctypes.c_int), ("file_size", ctypes.c_uint64), ("content", ctypes.c_void_p)]
+
+class ObjectCacheStats(ctypes.Structure):
+    _fields_ = [("hits", ctypes.c_uint64), ("misses", ctypes.c_uint64), ("evictions", ctypes.c_uint64),
+                ("entries", ctypes.c_size_t), ("bytes", ctypes.c_uint64), ("budget", ctypes.c_uint64)]
+
+gitlet_lib.object_content_alloc.restype = ctypes.c_void_p
+gitlet_lib.object_content_alloc.argtypes = [ctypes.c_uint64]
+gitlet_lib.object_content_release.argtypes = [ctypes.c_void_p]
+gitlet_lib.object_cache_set_budget.argtypes = [ctypes.c_uint64]
+gitlet_lib.object_cache_get.restype = ctypes.c_bool
+gitlet_lib.object_cache_get.argtypes = [ctypes.POINTER(Object), ctypes.POINTER(ObjectId)]
+gitlet_lib.object_cache_put.argtypes = [ctypes.POINTER(ObjectId), ctypes.POINTER(Object)]
+gitlet_lib.object_cache_get_stats.argtypes = [ctypes.POINTER(ObjectCacheStats)]
+
+def __oid(index: int) -> ObjectId:
+    """Make the object id from the index"""
+    oid = ObjectId()
+    for i, byte in enumerate(index.to_bytes(4, "big")):
+        oid.hash[i] = byte
+    oid.hash[19] = 0x5a
+    return oid
+
+def __put(index: int, size: int) -> None:
+    """Put the object of the size filled with the low byte of the index into the cache"""
+    obj = Object(0, size, gitlet_lib.object_content_alloc(size))
+    ctypes.memset(obj.content, index & 0xff, size)
+    gitlet_lib.object_cache_put(ctypes.byref(__oid(index)), ctypes.byref(obj))
+    gitlet_lib.object_content_release(obj.content)
+
+def __get(index: int) -> bytes | None:
+    """Get the content of the object from the cache, None when missing"""
+    obj = Object()
+    if not gitlet_lib.object_cache_get(ctypes.byref(obj), ctypes.byref(__oid(index))):
+        return None
+    content = ctypes.string_at(obj.content, obj.file_size)
+    gitlet_lib.object_content_release(obj.content)
+    return content
+
+def __stats() -> ObjectCacheStats:
+    """Get the counters of the cache"""
+    stats = ObjectCacheStats()
+    gitlet_lib.object_cache_get_stats(ctypes.byref(stats))
+    return stats
+
+def _case_object_cache_lru() -> None:
+    """Test the hits, the misses and the eviction of the least recently used objects"""
+    gitlet_lib.object_cache_clear()
+    gitlet_lib.object_cache_set_budget(1024)
+    before = __stats()
+
+    __put(1, 400)
+    __put(2, 400)
+    assert __get(1) == b"\x01" * 400
+    # the object 2 is now the least recently used one
+    __put(3, 400)
+    assert __get(2) is None
+    assert __get(3) == b"\x03" * 400
+    # the object over the budget is not cached
+    __put(4, 2048)
+    assert __get(4) is None
+
+    stats = __stats()
+    assert stats.hits - before.hits == 2
+    assert stats.misses - before.misses == 2
+    assert stats.evictions - before.evictions == 1
+    assert stats.entries == 2
+    assert stats.bytes == 800
+
+def _case_object_cache_threads() -> None:
+    """Test the cache shared by the readers on several threads"""
+    gitlet_lib.object_cache_clear()
+    gitlet_lib.object_cache_set_budget(16 * 1024)
+    before = __stats()
+
+    thread_count = 8
+    rounds = 2000
+    errors = []
+
+    def reader(seed: int) -> None:
+        for i in range(rounds):
+            index = (seed * 31 + i * 7) % 97
+            content = __get(index)
+            if content is None:
+                __put(index, 512 + index)
+            elif content != bytes([index & 0xff]) * (512 + index):
+                errors.append(index)
+
+    # the calls into the library release the GIL, so the threads really race
+    threads = [threading.Thread(target=reader, args=(seed,)) for seed in range(thread_count)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+
+    stats = __stats()
+    assert errors == []
+    assert (stats.hits - before.hits) + (stats.misses - before.misses) == thread_count * rounds
+    assert stats.evictions > before.evictions
+    assert stats.bytes <= stats.budget
+    gitlet_lib.object_cache_clear()
+    assert __stats().entries == 0
+
+def _case_object_cache_stats() -> None:
+    """Test the object cache counters and the budget from the config"""
+    sha1_list = []
+    for i in range(4):
+        path = os.path.join(_global.TEST_DIR, f"cached_{i}.txt")
+        with open(path, "w") as f:
+            f.write(f"cached content {i}\n" * (i + 1))
+        result = subprocess.run([_global.PROGRAM_GITLET, "hash-object", "-w", path], capture_output=True, text=True, cwd=_global.TEST_DIR)
+        assert result.returncode == 0
+        sha1_list.append(result.stdout.strip())
+
+    # pack-objects reads every object through the cache
+    env = dict(os.environ, GITLET_OBJECT_CACHE_STATS="1")
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input="\n".join(sha1_list) + "\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR, env=env)
+    assert result.returncode == 0
+    assert f"0 hits, {len(sha1_list)} misses" in result.stderr
+    assert f"/{32 * 1024 * 1024} bytes" in result.stderr
+
+    with open(os.path.join(_global.GITLET_DIR, "config"), "a") as f:
+        f.write("[core]\n\tobjectCacheSize = 1k\n")
+    result = subprocess.run([_global.PROGRAM_GITLET, "pack-objects"], input="\n".join(sha1_list) + "\n",
+                            capture_output=True, text=True, cwd=_global.TEST_DIR, env=env)
+    assert result.returncode == 0
+    assert "/1024 bytes" in result.stderr
+
+def test_object_cache():
+    """Run all object cache tests"""
+    _global.global_setup(True)
+
+    _case_object_cache_lru()
+    _case_object_cache_threads()
+    _case_object_cache_stats()
+
+    _global.global_teardown()